@@ -136,6 +136,7 @@ bool CAdjustMeshInterference::CheckInitialIntersections( CTextile &Textile, vect
 		if ( dDist > dMaxDist ) // Find max interference depth
 			dMaxDist = dDist;
 
+		YarnMeshes[YarnIndices[i]].BuildNodeIndex();
 		iIndex = YarnMeshes[YarnIndices[i]].GetClosestNode( InterferencePoints.GetNode( i ) );
 		
 		if ( iIndex != -1 )
@@ -368,8 +369,8 @@ void CAdjustMeshInterference::AdjustSectionMeshes( CTextile &Textile, vector<CMe
 		
 		//sort( TempNodes.begin(), TempNodes.end() );
 		
-		//list<int> &PolygonIndices = m_YarnMeshes[i].GetIndices( CMesh::POLYGON );
-		//list<int>::iterator itInt;
+		//vector<int> &PolygonIndices = m_YarnMeshes[i].GetIndices( CMesh::POLYGON );
+		//vector<int>::iterator itInt;
 		//for ( itNodes = TempNodes.begin(); itNodes != TempNodes.end(); ++itNodes )
 		for ( itNodes = Nodes.begin(); itNodes != Nodes.end(); ++itNodes )
 		{
@@ -765,9 +766,9 @@ void CMeshIntersectionData::FindElements( vector<int> &IndexArray, CMesh::ELEMEN
 	}
 }
 
-void CMeshIntersectionData::FindPolygonPoints( list<int> &Polygons )
+void CMeshIntersectionData::FindPolygonPoints( vector<int> &Polygons )
 {
-	list<int>::iterator itPolygons;
+	vector<int>::iterator itPolygons;
 	int iFoundIndex = -1;
 
 	for ( itPolygons = Polygons.begin(); itPolygons != Polygons.end(); )
@@ -67,7 +67,7 @@ namespace TexGen
 			void AdjustInterpolationNode( CMesh &YarnMesh );
 
 			/// Find surface point in polygon & points on either side
-			void FindPolygonPoints( list<int> &Polygons );
+			void FindPolygonPoints( vector<int> &Polygons );
 
 		protected:
 			
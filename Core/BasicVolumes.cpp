@@ -158,8 +158,8 @@ void CBasicVolumes::SaveProjectedContoursToVTK(string Filename)
 	vector<PROJECTED_REGION>::iterator itRegion;
 	int i = 0, j, k;
 	int iSegment, i1, i2;
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	for (itRegion = m_ProjectedRegions.begin(), j=0; itRegion != m_ProjectedRegions.end(); ++itRegion, ++j)
 	{
 		for (k=0; k<(int)itRegion->SegmentIndices.size(); ++k)
@@ -235,25 +235,26 @@ bool CBasicVolumes::GetCommonEdgeIndices(int Indices1[3], int Indices2[3], int C
 int CBasicVolumes::MergeStraightLines(CMesh &Mesh)
 {
 	int iMergeCount = 0;
-	list<int>::iterator itIndex, itStart;
-	list<int>::iterator itCompareIndex, itCompareStart;
-	list<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<int> &Indices = Mesh.GetIndices(CMesh::LINE);
 	int a, b;
 	int i[2];
 	int j[2];
 	int iCommon;
 	int iEnd1, iEnd2;
+	int iIndex, iCompareIndex;
+	bool bMerged;
 	XYZ P, P1, P2, V1, V2;
-	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
+	// Segments are addressed by position since merging removes segments and appends new ones,
+	// when a segment is removed the next one takes its place so iIndex is not incremented
+	for (iIndex = 0; iIndex < (int)Indices.size(); )
 	{
-		itStart = itIndex;
-		i[0] = *(itIndex++);
-		i[1] = *(itIndex++);
-		for (itCompareIndex = itIndex; itCompareIndex != Indices.end(); )
+		i[0] = Indices[iIndex];
+		i[1] = Indices[iIndex+1];
+		bMerged = false;
+		for (iCompareIndex = iIndex+2; iCompareIndex < (int)Indices.size(); iCompareIndex += 2)
 		{
-			itCompareStart = itCompareIndex;
-			j[0] = *(itCompareIndex++);
-			j[1] = *(itCompareIndex++);
+			j[0] = Indices[iCompareIndex];
+			j[1] = Indices[iCompareIndex+1];
 			iCommon = -1;
 			for (a=0; a<2; ++a)
 			{
@@ -280,20 +281,20 @@ int CBasicVolumes::MergeStraightLines(CMesh &Mesh)
 				if (DotProduct(V1, V2)+1 <= m_dTolerance)
 				{
 					// Ok merge them
-					Indices.erase(itStart, itIndex);
-					if (itIndex == itCompareStart)
-						itIndex = Indices.erase(itCompareStart, itCompareIndex);
-					else
-						Indices.erase(itCompareStart, itCompareIndex);
+					Indices.erase(Indices.begin()+iCompareIndex, Indices.begin()+iCompareIndex+2);
+					Indices.erase(Indices.begin()+iIndex, Indices.begin()+iIndex+2);
 
 					Indices.push_back(iEnd1);
 					Indices.push_back(iEnd2);
 
 					++iMergeCount;
+					bMerged = true;
 					break;
 				}
 			}
 		}
+		if (!bMerged)
+			iIndex += 2;
 	}
 
 	Mesh.RemoveUnreferencedNodes();
@@ -303,15 +304,16 @@ int CBasicVolumes::MergeStraightLines(CMesh &Mesh)
 
 int CBasicVolumes::RemoveDuplicateSegments(CMesh &Mesh)
 {
-	list<int>::iterator itIndex, itStart;
-	list<int>::iterator itCompareIndex;
-	list<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int>::iterator itCompareIndex;
+	vector<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<bool> Removed(Indices.size()/2, false);
 	int i1, i2;
 	int j1, j2;
+	int iSegment;
 	int iDuplicateCount = 0;
-	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
+	for (itIndex = Indices.begin(), iSegment = 0; itIndex != Indices.end(); ++iSegment)
 	{
-		itStart = itIndex;
 		i1 = *(itIndex++);
 		i2 = *(itIndex++);
 		for (itCompareIndex = itIndex; itCompareIndex != Indices.end(); )
@@ -320,51 +322,57 @@ int CBasicVolumes::RemoveDuplicateSegments(CMesh &Mesh)
 			j2 = *(itCompareIndex++);
 			if ((i1 == j1 && i2 == j2) || (i1 == j2 && i2 == j1))
 			{
-				Indices.erase(itStart, itIndex);
+				Removed[iSegment] = true;
 				++iDuplicateCount;
 				break;
 			}
 		}
 	}
+	Mesh.RemoveElements(CMesh::LINE, Removed);
 	return iDuplicateCount;
 }
 
 int CBasicVolumes::RemoveDegenerateSegments(CMesh &Mesh)
 {
-	list<int>::iterator itIndex, itStart;
-	list<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<bool> Removed(Indices.size()/2, false);
 	int i1, i2;
+	int iSegment;
 	int iDegenerateCount = 0;
-	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
+	for (itIndex = Indices.begin(), iSegment = 0; itIndex != Indices.end(); ++iSegment)
 	{
-		itStart = itIndex;
 		i1 = *(itIndex++);
 		i2 = *(itIndex++);
 		if (i1 == i2)
 		{
-			Indices.erase(itStart, itIndex);
+			Removed[iSegment] = true;
 			++iDegenerateCount;
 		}
 	}
+	Mesh.RemoveElements(CMesh::LINE, Removed);
 	return iDegenerateCount;
 }
 
 int CBasicVolumes::SplitLinesByNodes(CMesh &Mesh)
 {
 	int iSplitCount = 0;
-	list<int>::iterator itIndex, itStart;
 	vector<XYZ>::const_iterator itNode;
-	list<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<int> &Indices = Mesh.GetIndices(CMesh::LINE);
 	int j, i1, i2;
+	int iIndex;
+	bool bSplit;
 	XYZ P, L1, L2;
 	double dU, dUMin;
 	double dDistanceSquared, dToleranceSquared = m_dTolerance*m_dTolerance;
 	double dLengthSquared;
-	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
+	// Split segments are removed and the next segment takes their place, so iIndex is only
+	// incremented when no split occurs. The new segments are appended and will be checked in turn.
+	for (iIndex = 0; iIndex < (int)Indices.size(); )
 	{
-		itStart = itIndex;
-		i1 = *(itIndex++);
-		i2 = *(itIndex++);
+		i1 = Indices[iIndex];
+		i2 = Indices[iIndex+1];
+		bSplit = false;
 		L1 = Mesh.GetNode(i1);
 		L2 = Mesh.GetNode(i2);
 		dLengthSquared = GetLengthSquared(L1, L2);
@@ -388,25 +396,24 @@ int CBasicVolumes::SplitLinesByNodes(CMesh &Mesh)
 				{
 					// OK! Let's split this sucker...
 					// Remove the current segment
-					Indices.erase(itStart, itIndex);
+					Indices.erase(Indices.begin()+iIndex, Indices.begin()+iIndex+2);
 
 					// Add the new split segments
 					Indices.push_back(i1);
-					// If the line segment was the last in the list, some trickery is needed to
-					// ensure the newly inserted line is checked for splits
-					if (itIndex == Indices.end())
-						--itIndex;
 					Indices.push_back(j);
 
 					Indices.push_back(j);
 					Indices.push_back(i2);
 
 					++iSplitCount;
+					bSplit = true;
 
 					break;
 				}
 			}
 		}
+		if (!bSplit)
+			iIndex += 2;
 	}
 	return iSplitCount;
 }
@@ -415,29 +422,28 @@ int CBasicVolumes::SplitLinesByLines(CMesh &Mesh)
 {
 	int iSplitCount = 0;
 
-	list<int>::iterator itIndex, itStart;
-	list<int>::iterator itCompareIndex, itCompareStart;
-	list<int> &Indices = Mesh.GetIndices(CMesh::LINE);
+	vector<int> &Indices = Mesh.GetIndices(CMesh::LINE);
 	int i1, i2;
 	int j1, j2;
+	int iIndex, iCompareIndex;
+	bool bSplit;
 	int iNewNodeIndex;
 	XYZ P1, P2, P3, P4, P;
 	double dU1, dU2;
 	double dUMin1, dUMin2;
 	double dClosestDistSquared;
 	double dToleranceSquared = m_dTolerance*m_dTolerance;
-	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
+	for (iIndex = 0; iIndex < (int)Indices.size(); )
 	{
-		itStart = itIndex;
-		i1 = *(itIndex++);
-		i2 = *(itIndex++);
+		i1 = Indices[iIndex];
+		i2 = Indices[iIndex+1];
 		P1 = Mesh.GetNode(i1);
 		P2 = Mesh.GetNode(i2);
-		for (itCompareIndex = itIndex; itCompareIndex != Indices.end(); )
+		bSplit = false;
+		for (iCompareIndex = iIndex+2; iCompareIndex < (int)Indices.size(); iCompareIndex += 2)
 		{
-			itCompareStart = itCompareIndex;
-			j1 = *(itCompareIndex++);
-			j2 = *(itCompareIndex++);
+			j1 = Indices[iCompareIndex];
+			j2 = Indices[iCompareIndex+1];
 			if (i1 != j1 && i1 != j2 && i2 != j1 && i2 != j2)
 			{
 				P3 = Mesh.GetNode(j1);
@@ -451,11 +457,8 @@ int CBasicVolumes::SplitLinesByLines(CMesh &Mesh)
 					if (dClosestDistSquared > dToleranceSquared)
 					{
 						P = P1 + (P2-P1)*dU1;
-						Indices.erase(itStart, itIndex);
-						if (itIndex == itCompareStart)
-							itIndex = Indices.erase(itCompareStart, itCompareIndex);
-						else
-							Indices.erase(itCompareStart, itCompareIndex);
+						Indices.erase(Indices.begin()+iCompareIndex, Indices.begin()+iCompareIndex+2);
+						Indices.erase(Indices.begin()+iIndex, Indices.begin()+iIndex+2);
 						
 						iNewNodeIndex = Mesh.AddNode(P); //Mesh.m_Nodes.size()-1;
 
@@ -472,11 +475,14 @@ int CBasicVolumes::SplitLinesByLines(CMesh &Mesh)
 						Indices.push_back(j2);
 
 						++iSplitCount;
+						bSplit = true;
 						break;
 					}
 				}
 			}
 		}
+		if (!bSplit)
+			iIndex += 2;
 	}
 
 	return iSplitCount;
@@ -486,9 +492,9 @@ bool CBasicVolumes::ValidProjectedMesh()
 {
 	// For the mesh to be valid, each line segment should
 	// at least be connected at both ends
-	list<int>::iterator itIndex;
-	list<int>::iterator itCompareIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int>::iterator itCompareIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	int i1, i2;
 	int j1, j2;
 	bool bEnd1, bEnd2;
@@ -522,11 +528,11 @@ bool CBasicVolumes::CreateProjectedAreas()
 	// Follow segments always following the one with the greatest clockwise angle
 	vector<int> LineState;
 	LineState.resize(m_ProjectedMesh.GetIndices(CMesh::LINE).size()/2, 0);
-	list<int>::iterator itIndex, itStartIndex;
-	list<int>::iterator itFollowIndex;
-	list<int>::iterator itCompareIndex, itStartCompareIndex;
-	list<int>::iterator itBestFind;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex, itStartIndex;
+	vector<int>::iterator itFollowIndex;
+	vector<int>::iterator itCompareIndex, itStartCompareIndex;
+	vector<int>::iterator itBestFind;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	int iDir, iCurrentDir;
 	int i1, i2;
 	int j1, j2;
@@ -648,11 +654,11 @@ bool CBasicVolumes::SeedOuterBoundary()
 	// The area should be negative
 	assert(itOuterRegion->dArea <= 0);
 
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	XYZ P;
 	double u;
 	int i, i1, i2, iPrevIndex, iNewIndex;
-	list<int>::iterator itIndex, itStart;
+	vector<int>::iterator itIndex;
 	vector<int>::iterator itSegment;
 	double dLength;
 	// Apply a small distorition to the seed to prevent the likelyhood of the segment length being equal
@@ -696,23 +702,13 @@ bool CBasicVolumes::SeedOuterBoundary()
 	}
 
 	// Erase the segments that were split
-	for (itIndex=Indices.begin(), i=0; itIndex!=Indices.end(); ++i)
+	vector<bool> Removed(Indices.size()/2, false);
+	set<int>::iterator itDelete;
+	for (itDelete = DeleteSegments.begin(); itDelete != DeleteSegments.end(); ++itDelete)
 	{
-		if (DeleteSegments.count(i))
-		{
-			// Needs erasing
-			itStart = itIndex;
-			++itIndex;
-			++itIndex;
-			itIndex = Indices.erase(itStart, itIndex);
-		}
-		else
-		{
-			// Increment indices
-			++itIndex;
-			++itIndex;
-		}
+		Removed[*itDelete] = true;
 	}
+	m_ProjectedMesh.RemoveElements(CMesh::LINE, Removed);
 
 	// The projected areas will have been invalidated by the splitting so calculate them again
 	return CreateProjectedAreas();
@@ -733,7 +729,7 @@ bool CBasicVolumes::RemoveOuterBoundary()
 double CBasicVolumes::GetRegionArea(const PROJECTED_REGION &Region)
 {
 	vector<int>::const_iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	vector<XYZ> Nodes;
 	for (itIndex = Region.ContourNodes.begin(); itIndex != Region.ContourNodes.end(); ++itIndex)
 	{
@@ -746,8 +742,8 @@ bool CBasicVolumes::CreateProjectedCenters()
 {
 	vector<PROJECTED_REGION>::iterator itRegion;
 	vector<int>::iterator itSegment;
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 	int i, i1, i2;
 	XYZ Min, Max, P1, P2;
 	for (itRegion = m_ProjectedRegions.begin(), i=0; itRegion != m_ProjectedRegions.end(); ++itRegion, ++i)
@@ -901,8 +897,8 @@ bool CBasicVolumes::MeshProjectedAreas()
 	}
 
 	// Input Segments
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::LINE);
 
 	TriangleInput.segmentlist = new int [Indices.size()];
 	TriangleInput.numberofsegments = (int)Indices.size()/2;
@@ -1008,9 +1004,9 @@ CMesh CBasicVolumes::GetProjectedMesh(const CMesh &Mesh)
 {
 	CMesh ProjectedMesh = Mesh;
 //	ProjectedMesh.ConvertQuadstoTriangles();
-	list<int>::iterator itIndex;
-	list<int>::iterator itCompareIndex;
-	list<int> &Indices = ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int>::iterator itCompareIndex;
+	vector<int> &Indices = ProjectedMesh.GetIndices(CMesh::TRI);
 	int i[3];
 	int j[3];
 	int CommonIndices[2];
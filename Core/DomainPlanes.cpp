@@ -200,8 +200,9 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 	double d1, d2, d3, d4;	// d represents the distance of the point to the plane (i.e. +ve inside, -ve outside, 0 on top)
 	double dTemp;
@@ -214,8 +215,9 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	// Deal with surface elements
 	for (itPlane = m_Planes.begin(); itPlane != m_Planes.end(); ++itPlane)
 	{
-		list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-		for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+		vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+		vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+		for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -231,7 +233,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL && d4 <= TOL) // The quad lies completely on or outside the plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL && d4 >= -TOL) // The quad lies completely inside the plane
 			{
@@ -239,7 +241,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if ( d1 < TOL && d2 < TOL && d3 > TOL && d4 > TOL ) // Points 1 & 2 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d4 / (d4-d1);
 				NewQuads.push_back(*p4 + (*p1-*p4) * u);
 				u = d3 / (d3-d2);
@@ -249,7 +251,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if ( d2 < TOL && d3 < TOL && d4 > TOL && d1 > TOL ) // Points 2 & 3 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				u = d1 / (d1-d2);
 				NewQuads.push_back(*p1 + (*p2-*p1) * u);
@@ -259,7 +261,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if ( d3 < TOL && d4 < TOL && d1 > TOL && d2 > TOL )  // Points 3 & 4 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				NewQuads.push_back(*p2);
 				u = d2 / (d2-d3);
@@ -269,7 +271,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if ( d4 < TOL && d1 < TOL && d2 > TOL && d3 > TOL )  // Points 4 & 1 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d2 / (d2-d1);
 				NewQuads.push_back(*p2 + (*p1-*p2) * u);	
 				NewQuads.push_back(*p2);
@@ -280,9 +282,11 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else // Convert the quad to a triangle for trimming if 1 or 3 points inside plane
 			{
-				itInt = Mesh.ConvertQuadtoTriangles(itStart);
+				Mesh.AddQuadTriangles(itStart);
+				RemovedQuads[iElement] = true;
 			}
 		}
+		Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 		// Add the new quads to the mesh, and clear the new quad list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -300,8 +304,9 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 		}
 		NewQuads.clear();
 
-		list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-		for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+		vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+		vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+		for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -315,7 +320,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL) // The triangle lies completely outside or on the plane
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+				RemovedTriangles[iElement] = true; // Delete the triangle
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL) // The triangle lies completely inside the plane
 			{
@@ -323,7 +328,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle, will need to be seperated into smaller ones
+				RemovedTriangles[iElement] = true; // Delete the triangle, will need to be seperated into smaller ones
 				// Order points such that d1 >= d2 >= d3
 				bFlipped = false; // Keep track of whether the triangle is flipped or not
 				if (d2 > d1)
@@ -370,6 +375,7 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 				}
 			}
 		}
+		Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 		// Add the new triangles to the mesh, and clear the new triangles list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -418,8 +424,9 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	{
 		for (itElementType = VolumeElements.begin(); itElementType != VolumeElements.end(); ++itElementType)
 		{
-			list<int> &Indices = Mesh.GetIndices(*itElementType);
-			for (itInt = Indices.begin(); itInt != Indices.end(); )
+			vector<int> &Indices = Mesh.GetIndices(*itElementType);
+			vector<bool> RemovedElements(Indices.size()/CMesh::GetNumNodes(*itElementType), false);
+			for (itInt = Indices.begin(), iElement = 0; itInt != Indices.end(); ++iElement)
 			{
 				iNumNodes = CMesh::GetNumNodes(*itElementType);
 				itStart = itInt;
@@ -433,18 +440,19 @@ void CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 				d = DotProduct(itPlane->Normal, Center) - itPlane->d;
 				if (d < 0)
-					itInt = Indices.erase(itStart, itInt); // Delete the volume element
+					RemovedElements[iElement] = true; // Delete the volume element
 			}
+			Mesh.RemoveElements(*itElementType, RemovedElements);
 		}
 	}
 
 	for (itPlane = m_Planes.begin(); itPlane != m_Planes.end(); ++itPlane)
 	{
-		list<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
-		list<int>::iterator itIndices;
+		vector<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
+		vector<int>::iterator itIndices;
 		int StartIndex, NewStartIndex;
 		bool bResetStart = true;
-		list<int>::iterator itStartIndex;
+		vector<int>::iterator itStartIndex;
 		bool bDelete = true;
 
 		for ( itIndices = Indices.begin(); itIndices != Indices.end(); )
@@ -499,8 +507,9 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 	double d1, d2, d3, d4;	// d represents the distance of the point to the plane (i.e. +ve inside, -ve outside, 0 on top)
 	double dTemp;
@@ -521,8 +530,9 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 	// Deal with surface elements
 	for (itPlane = m_Planes.begin(); itPlane != m_Planes.end(); ++itPlane)
 	{
-		list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-		for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+		vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+		vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+		for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -538,7 +548,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL && d4 <= TOL) // The quad lies completely on or outside the plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL && d4 >= -TOL) // The quad lies completely inside the plane
 			{
@@ -546,7 +556,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else if ( d1 < TOL && d2 < TOL && d3 > TOL && d4 > TOL ) // Points 1 & 2 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d4 / (d4-d1);
 				NewQuads.push_back(*p4 + (*p1-*p4) * u);
 				u = d3 / (d3-d2);
@@ -556,7 +566,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else if ( d2 < TOL && d3 < TOL && d4 > TOL && d1 > TOL ) // Points 2 & 3 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				u = d1 / (d1-d2);
 				NewQuads.push_back(*p1 + (*p2-*p1) * u);
@@ -566,7 +576,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else if ( d3 < TOL && d4 < TOL && d1 > TOL && d2 > TOL )  // Points 3 & 4 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				NewQuads.push_back(*p2);
 				u = d2 / (d2-d3);
@@ -576,7 +586,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else if ( d4 < TOL && d1 < TOL && d2 > TOL && d3 > TOL )  // Points 4 & 1 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d2 / (d2-d1);
 				NewQuads.push_back(*p2 + (*p1-*p2) * u);	
 				NewQuads.push_back(*p2);
@@ -587,9 +597,11 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else // Convert the quad to a triangle for trimming if 1 or 3 points inside plane
 			{
-				itInt = Mesh.ConvertQuadtoTriangles(itStart);
+				Mesh.AddQuadTriangles(itStart);
+				RemovedQuads[iElement] = true;
 			}
 		}
+		Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 		// Add the new quads to the mesh, and clear the new quad list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -607,8 +619,9 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 		}
 		NewQuads.clear();
 
-		list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-		for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+		vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+		vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+		for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -622,7 +635,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL) // The triangle lies completely outside or on the plane
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+				RemovedTriangles[iElement] = true; // Delete the triangle
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL) // The triangle lies completely inside the plane
 			{
@@ -630,7 +643,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 			}
 			else
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle, will need to be seperated into smaller ones
+				RemovedTriangles[iElement] = true; // Delete the triangle, will need to be seperated into smaller ones
 				// Order points such that d1 >= d2 >= d3
 				bFlipped = false; // Keep track of whether the triangle is flipped or not
 				if (d2 > d1)
@@ -677,6 +690,7 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 				}
 			}
 		}
+		Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 		// Add the new triangles to the mesh, and clear the new triangles list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -771,8 +785,9 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 	{
 		for (itElementType = VolumeElements.begin(); itElementType != VolumeElements.end(); ++itElementType)
 		{
-			list<int> &Indices = Mesh.GetIndices(*itElementType);
-			for (itInt = Indices.begin(); itInt != Indices.end(); )
+			vector<int> &Indices = Mesh.GetIndices(*itElementType);
+			vector<bool> RemovedElements(Indices.size()/CMesh::GetNumNodes(*itElementType), false);
+			for (itInt = Indices.begin(), iElement = 0; itInt != Indices.end(); ++iElement)
 			{
 				iNumNodes = CMesh::GetNumNodes(*itElementType);
 				itStart = itInt;
@@ -786,19 +801,20 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 
 				d = DotProduct(itPlane->Normal, Center) - itPlane->d;
 				if (d < 0)
-					itInt = Indices.erase(itStart, itInt); // Delete the volume element
+					RemovedElements[iElement] = true; // Delete the volume element
 			}
+			Mesh.RemoveElements(*itElementType, RemovedElements);
 		}
 	}
 
 	// Deal with polygon elements
 /*	for (itPlane = m_Planes.begin(); itPlane != m_Planes.end(); ++itPlane)
 	{
-		list<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
-		list<int>::iterator itIndices;
+		vector<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
+		vector<int>::iterator itIndices;
 		int StartIndex, NewStartIndex;
 		bool bResetStart = true;
-		list<int>::iterator itStartIndex;
+		vector<int>::iterator itStartIndex;
 
 		for ( itIndices = Indices.begin(); itIndices != Indices.end(); )
 		{
@@ -838,11 +854,11 @@ bool CDomainPlanes::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, b
 	// Deal with polygon elements
 	for (itPlane = m_Planes.begin(); itPlane != m_Planes.end(); ++itPlane)
 	{
-		list<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
-		list<int>::iterator itIndices;
+		vector<int> &Indices = Mesh.GetIndices(CMesh::POLYGON);
+		vector<int>::iterator itIndices;
 		int StartIndex, NewStartIndex;
 		bool bResetStart = true;
-		list<int>::iterator itStartIndex;
+		vector<int>::iterator itStartIndex;
 		bool bDelete = true;
 
 		for ( itIndices = Indices.begin(); itIndices != Indices.end(); )
@@ -972,9 +988,9 @@ bool CDomainPlanes::FillGaps(CMesh &Mesh, const PLANE &Plane, vector<int> &Polyg
 	Mesh.RemoveDegenerateTriangles();
 
 	// Build a list of segments which lie on the plane
-	list<int>::iterator itInt;
+	vector<int>::iterator itInt;
 	// Check each quad to see if any of the edges lie on the plane
-	list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+	vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
 	for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
 	{
 		i1 = *(itInt++);
@@ -1019,7 +1035,7 @@ bool CDomainPlanes::FillGaps(CMesh &Mesh, const PLANE &Plane, vector<int> &Polyg
 		}
 	}
 	// Check each triangle to find edges that lie on the plane
-	list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+	vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
 	for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
 	{
 		i1 = *(itInt++);
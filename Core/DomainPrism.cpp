@@ -82,12 +82,12 @@ void CDomainPrism::GeneratePlanes()
 
 	// Generate set of planes to form the domain, one for each element of the surface mesh of the domain 'yarn'
 
-	list<int>::iterator itInt;
-	list<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	vector<int>::iterator itStart;
 	XYZ points[4];
 	m_ElementPlanes.clear();
 
-	list<int> &QuadIndices = m_Mesh.GetIndices(CMesh::QUAD);
+	vector<int> &QuadIndices = m_Mesh.GetIndices(CMesh::QUAD);
 	for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
 	{
 		itStart = itInt;
@@ -102,7 +102,7 @@ void CDomainPrism::GeneratePlanes()
 			m_ElementPlanes.push_back(ElementPlane);
 	}
 
-	list<int> &TriIndices = m_Mesh.GetIndices(CMesh::TRI);
+	vector<int> &TriIndices = m_Mesh.GetIndices(CMesh::TRI);
 	for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
 	{
 		itStart = itInt;
@@ -116,10 +116,10 @@ void CDomainPrism::GeneratePlanes()
 			m_ElementPlanes.push_back(ElementPlane);
 	}
 
-	list<int> &Indices = m_Mesh.GetIndices(CMesh::POLYGON);
-	list<int>::iterator itIndices;
+	vector<int> &Indices = m_Mesh.GetIndices(CMesh::POLYGON);
+	vector<int>::iterator itIndices;
 	int StartIndex;
-	list<int>::iterator itStartIndex;
+	vector<int>::iterator itStartIndex;
 
 	for (itIndices = Indices.begin(); itIndices != Indices.end(); )
 	{
@@ -203,8 +203,9 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 	double d1, d2, d3, d4;	// d represents the distance of the point to the plane (i.e. +ve inside, -ve outside, 0 on top)
 	double dTemp;
@@ -217,8 +218,9 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	// Deal with surface elements
 	for (itPlane = m_ElementPlanes.begin(); itPlane != m_ElementPlanes.end(); ++itPlane)
 	{
-		list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-		for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+		vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+		vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+		for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -235,7 +237,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL && d4 <= TOL) // The quad lies completely on or outside the plane
 			{
 				if ( fabs(d1) < TOL || fabs(d2) < TOL || fabs(d3) < TOL || fabs(d4) < TOL)
-					itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+					RemovedQuads[iElement] = true; // Delete the quad
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL && d4 >= -TOL) // The quad lies completely inside the plane
 			{
@@ -243,7 +245,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if (d1 < TOL && d2 < TOL && d3 > TOL && d4 > TOL) // Points 1 & 2 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d4 / (d4 - d1);
 				NewQuads.push_back(*p4 + (*p1 - *p4) * u);
 				u = d3 / (d3 - d2);
@@ -253,7 +255,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if (d2 < TOL && d3 < TOL && d4 > TOL && d1 > TOL) // Points 2 & 3 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				u = d1 / (d1 - d2);
 				NewQuads.push_back(*p1 + (*p2 - *p1) * u);
@@ -263,7 +265,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if (d3 < TOL && d4 < TOL && d1 > TOL && d2 > TOL)  // Points 3 & 4 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				NewQuads.push_back(*p2);
 				u = d2 / (d2 - d3);
@@ -273,7 +275,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else if (d4 < TOL && d1 < TOL && d2 > TOL && d3 > TOL)  // Points 4 & 1 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d2 / (d2 - d1);
 				NewQuads.push_back(*p2 + (*p1 - *p2) * u);
 				NewQuads.push_back(*p2);
@@ -284,9 +286,11 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else // Convert the quad to a triangle for trimming if 1 or 3 points inside plane
 			{
-				itInt = Mesh.ConvertQuadtoTriangles(itStart);
+				Mesh.AddQuadTriangles(itStart);
+				RemovedQuads[iElement] = true;
 			}
 		}
+		Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 		// Add the new quads to the mesh, and clear the new quad list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -304,8 +308,9 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 		}
 		NewQuads.clear();
 
-		list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-		for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+		vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+		vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+		for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -319,7 +324,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL) // The triangle lies completely outside or on the plane
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+				RemovedTriangles[iElement] = true; // Delete the triangle
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL) // The triangle lies completely inside the plane
 			{
@@ -327,7 +332,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			}
 			else
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle, will need to be seperated into smaller ones
+				RemovedTriangles[iElement] = true; // Delete the triangle, will need to be seperated into smaller ones
 														  // Order points such that d1 >= d2 >= d3
 				bFlipped = false; // Keep track of whether the triangle is flipped or not
 				if (d2 > d1)
@@ -374,6 +379,7 @@ void CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 				}
 			}
 		}
+		Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 		// Add the new triangles to the mesh, and clear the new triangles list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -430,8 +436,9 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 	double d1, d2, d3, d4;	// d represents the distance of the point to the plane (i.e. +ve inside, -ve outside, 0 on top)
 	double dTemp;
@@ -449,8 +456,9 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 	// Deal with surface elements
 	for (itPlane = m_ElementPlanes.begin(); itPlane != m_ElementPlanes.end(); ++itPlane)
 	{
-		list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-		for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+		vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+		vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+		for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -467,7 +475,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL && d4 <= TOL) // The quad lies completely on or outside the plane
 			{
 				if (fabs(d1) < TOL || fabs(d2) < TOL || fabs(d3) < TOL || fabs(d4) < TOL)
-					itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+					RemovedQuads[iElement] = true; // Delete the quad
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL && d4 >= -TOL) // The quad lies completely inside the plane
 			{
@@ -475,7 +483,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else if (d1 < TOL && d2 < TOL && d3 > TOL && d4 > TOL) // Points 1 & 2 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d4 / (d4 - d1);
 				NewQuads.push_back(*p4 + (*p1 - *p4) * u);
 				u = d3 / (d3 - d2);
@@ -485,7 +493,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else if (d2 < TOL && d3 < TOL && d4 > TOL && d1 > TOL) // Points 2 & 3 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				u = d1 / (d1 - d2);
 				NewQuads.push_back(*p1 + (*p2 - *p1) * u);
@@ -495,7 +503,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else if (d3 < TOL && d4 < TOL && d1 > TOL && d2 > TOL)  // Points 3 & 4 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				NewQuads.push_back(*p1);
 				NewQuads.push_back(*p2);
 				u = d2 / (d2 - d3);
@@ -505,7 +513,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else if (d4 < TOL && d1 < TOL && d2 > TOL && d3 > TOL)  // Points 4 & 1 outside plane
 			{
-				itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+				RemovedQuads[iElement] = true; // Delete the quad
 				u = d2 / (d2 - d1);
 				NewQuads.push_back(*p2 + (*p1 - *p2) * u);
 				NewQuads.push_back(*p2);
@@ -516,9 +524,11 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else // Convert the quad to a triangle for trimming if 1 or 3 points inside plane
 			{
-				itInt = Mesh.ConvertQuadtoTriangles(itStart);
+				Mesh.AddQuadTriangles(itStart);
+				RemovedQuads[iElement] = true;
 			}
 		}
+		Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 		// Add the new quads to the mesh, and clear the new quad list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -536,8 +546,9 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 		}
 		NewQuads.clear();
 
-		list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-		for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+		vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+		vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+		for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 		{
 			itStart = itInt;
 
@@ -551,7 +562,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 
 			if (d1 <= TOL && d2 <= TOL && d3 <= TOL) // The triangle lies completely outside or on the plane
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+				RemovedTriangles[iElement] = true; // Delete the triangle
 			}
 			else if (d1 >= -TOL && d2 >= -TOL && d3 >= -TOL) // The triangle lies completely inside the plane
 			{
@@ -559,7 +570,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 			}
 			else
 			{
-				itInt = TriIndices.erase(itStart, itInt); // Delete the triangle, will need to be seperated into smaller ones
+				RemovedTriangles[iElement] = true; // Delete the triangle, will need to be seperated into smaller ones
 														  // Order points such that d1 >= d2 >= d3
 				bFlipped = false; // Keep track of whether the triangle is flipped or not
 				if (d2 > d1)
@@ -606,6 +617,7 @@ bool CDomainPrism::ClipIntersectMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainM
 				}
 			}
 		}
+		Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 		// Add the new triangles to the mesh, and clear the new triangles list
 		iLastNodeIndex = int(Mesh.GetNumNodes());
@@ -706,8 +718,9 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 	
 	int i;
@@ -720,8 +733,9 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	// Deal with surface elements
 
 	// Quad elements
-	list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-	for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+	vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+	vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+	for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 	{
 		itStart = itInt;
 
@@ -739,7 +753,7 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 		if (!b1 && !b2 && !b3 && !b4) // The quad lies completely on or outside the plane
 		{
-			itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+			RemovedQuads[iElement] = true; // Delete the quad
 		}
 		else if (b1 && b2 && b3 && b4) // The quad lies completely inside the plane
 		{
@@ -749,16 +763,17 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 		{
 			// For concave shapes PointInsideYarn may return incorrect value (point may be on 'incorrect' side of plane for one part of shape even though actually inside)
 			// So, save points for questionable elements to IntersectQuads vector ( to allow later checking of quad against each domain plane )
-			itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+			RemovedQuads[iElement] = true; // Delete the quad
 			IntersectQuads.push_back(*p1);
 			IntersectQuads.push_back(*p2);
 			IntersectQuads.push_back(*p3);
 			IntersectQuads.push_back(*p4);
 		}	
 	}
+	Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 	// Add points for intersecting quads to intersection mesh
-	list<int> &IntersectQuadIndices = IntersectMesh.GetIndices(CMesh::QUAD);
+	vector<int> &IntersectQuadIndices = IntersectMesh.GetIndices(CMesh::QUAD);
 	for (i = 0; i < int(IntersectQuads.size() / 4); ++i)
 	{
 		IntersectQuadIndices.push_back(4 * i);
@@ -776,8 +791,9 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	// Triangle elements
 	vector<XYZ> IntersectTriangles;
 
-	list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-	for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+	vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+	vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+	for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 	{
 		itStart = itInt;
 
@@ -792,7 +808,7 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 
 		if (!b1 && !b2 && !b3) // The triangle lies completely outside or on the plane
 		{
-			itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+			RemovedTriangles[iElement] = true; // Delete the triangle
 		}
 		else if (b1 && b2 && b3) // The triangle lies completely inside the plane
 		{
@@ -800,15 +816,16 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 		}
 		else
 		{
-			itInt = TriIndices.erase(itStart, itInt);
+			RemovedTriangles[iElement] = true;
 			IntersectTriangles.push_back(*p1);
 			IntersectTriangles.push_back(*p2);
 			IntersectTriangles.push_back(*p3);
 		}
 	}
+	Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 	// Add points for intersecting triangular elements to intersection mesh
-	list<int> &IntersectTriangleIndices = IntersectMesh.GetIndices(CMesh::TRI);
+	vector<int> &IntersectTriangleIndices = IntersectMesh.GetIndices(CMesh::TRI);
 	iLastNodeIndex = IntersectMesh.GetNumNodes();
 	for (i = 0; i < int(IntersectQuads.size() / 4); ++i)
 	{
@@ -837,8 +854,9 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 	//{
 		for (itElementType = VolumeElements.begin(); itElementType != VolumeElements.end(); ++itElementType)
 		{
-			list<int> &Indices = Mesh.GetIndices(*itElementType);
-			for (itInt = Indices.begin(); itInt != Indices.end(); )
+			vector<int> &Indices = Mesh.GetIndices(*itElementType);
+			vector<bool> RemovedElements(Indices.size()/CMesh::GetNumNodes(*itElementType), false);
+			for (itInt = Indices.begin(), iElement = 0; itInt != Indices.end(); ++iElement)
 			{
 				iNumNodes = CMesh::GetNumNodes(*itElementType);
 				itStart = itInt;
@@ -854,8 +872,9 @@ void CDomainPrism::ClipMeshToDomain(CMesh &Mesh, bool bFillGaps) const
 			//	d = DotProduct(itPlane->Normal, Center) - itPlane->d;
 			//	if (d < 0)
 				if (!b1)
-					itInt = Indices.erase(itStart, itInt); // Delete the volume element
+					RemovedElements[iElement] = true; // Delete the volume element
 			}
+			Mesh.RemoveElements(*itElementType, RemovedElements);
 		}
 	//}
 
@@ -882,8 +901,9 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 	vector<XYZ> NewQuads;
 
 	vector<PLANE>::const_iterator itPlane;
-	list<int>::iterator itStart;
-	list<int>::iterator itInt;
+	vector<int>::iterator itStart;
+	vector<int>::iterator itInt;
+	int iElement;
 	const XYZ *p1, *p2, *p3, *p4;
 
 	int i;
@@ -897,8 +917,9 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 	// Deal with surface elements
 
 	// Quad elements
-	list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
-	for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
+	vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+	vector<bool> RemovedQuads(QuadIndices.size()/4, false);
+	for (itInt = QuadIndices.begin(), iElement = 0; itInt != QuadIndices.end(); ++iElement)
 	{
 		itStart = itInt;
 
@@ -916,7 +937,7 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 
 		if (!b1 && !b2 && !b3 && !b4) // The quad lies completely on or outside the plane
 		{
-			itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+			RemovedQuads[iElement] = true; // Delete the quad
 		}
 		else if (b1 && b2 && b3 && b4) // The quad lies completely inside the plane
 		{
@@ -926,16 +947,17 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 		{
 			// For concave shapes PointInsideYarn may return incorrect value (point may be on 'incorrect' side of plane for one part of shape even though actually inside)
 			// So, save points for questionable elements to IntersectQuads vector ( to allow later checking of quad against each domain plane )
-			itInt = QuadIndices.erase(itStart, itInt); // Delete the quad
+			RemovedQuads[iElement] = true; // Delete the quad
 			IntersectQuads.push_back(*p1);
 			IntersectQuads.push_back(*p2);
 			IntersectQuads.push_back(*p3);
 			IntersectQuads.push_back(*p4);
 		}
 	}
+	Mesh.RemoveElements(CMesh::QUAD, RemovedQuads);
 
 	// Add points for intersecting quads to intersection mesh
-	list<int> &IntersectQuadIndices = IntersectMesh.GetIndices(CMesh::QUAD);
+	vector<int> &IntersectQuadIndices = IntersectMesh.GetIndices(CMesh::QUAD);
 	for (i = 0; i < int(IntersectQuads.size() / 4); ++i)
 	{
 		IntersectQuadIndices.push_back(4 * i);
@@ -953,8 +975,9 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 	// Triangle elements
 	vector<XYZ> IntersectTriangles;
 
-	list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
-	for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
+	vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+	vector<bool> RemovedTriangles(TriIndices.size()/3, false);
+	for (itInt = TriIndices.begin(), iElement = 0; itInt != TriIndices.end(); ++iElement)
 	{
 		itStart = itInt;
 
@@ -969,7 +992,7 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 
 		if (!b1 && !b2 && !b3) // The triangle lies completely outside or on the plane
 		{
-			itInt = TriIndices.erase(itStart, itInt); // Delete the triangle
+			RemovedTriangles[iElement] = true; // Delete the triangle
 		}
 		else if (b1 && b2 && b3) // The triangle lies completely inside the plane
 		{
@@ -977,15 +1000,16 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 		}
 		else
 		{
-			itInt = TriIndices.erase(itStart, itInt);
+			RemovedTriangles[iElement] = true;
 			IntersectTriangles.push_back(*p1);
 			IntersectTriangles.push_back(*p2);
 			IntersectTriangles.push_back(*p3);
 		}
 	}
+	Mesh.RemoveElements(CMesh::TRI, RemovedTriangles);
 
 	// Add points for intersecting triangular elements to intersection mesh
-	list<int> &IntersectTriangleIndices = IntersectMesh.GetIndices(CMesh::TRI);
+	vector<int> &IntersectTriangleIndices = IntersectMesh.GetIndices(CMesh::TRI);
 	iLastNodeIndex = IntersectMesh.GetNumNodes();
 	for (i = 0; i < int(IntersectQuads.size() / 4); ++i)
 	{
@@ -1014,8 +1038,9 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 	//{
 	for (itElementType = VolumeElements.begin(); itElementType != VolumeElements.end(); ++itElementType)
 	{
-		list<int> &Indices = Mesh.GetIndices(*itElementType);
-		for (itInt = Indices.begin(); itInt != Indices.end(); )
+		vector<int> &Indices = Mesh.GetIndices(*itElementType);
+		vector<bool> RemovedElements(Indices.size()/CMesh::GetNumNodes(*itElementType), false);
+		for (itInt = Indices.begin(), iElement = 0; itInt != Indices.end(); ++iElement)
 		{
 			iNumNodes = CMesh::GetNumNodes(*itElementType);
 			itStart = itInt;
@@ -1031,8 +1056,9 @@ bool CDomainPrism::ClipMeshToDomain(CMesh &Mesh, vector<CMesh> &DomainMeshes, bo
 			//	d = DotProduct(itPlane->Normal, Center) - itPlane->d;
 			//	if (d < 0)
 			if (!b1)
-				itInt = Indices.erase(itStart, itInt); // Delete the volume element
+				RemovedElements[iElement] = true; // Delete the volume element
 		}
+		Mesh.RemoveElements(*itElementType, RemovedElements);
 	}
 	//}
 
@@ -1063,9 +1089,9 @@ bool CDomainPrism::FillGaps(CMesh &Mesh, const PLANE &Plane, vector<int> &Polygo
 	Mesh.RemoveDegenerateTriangles();
 
 	// Build a list of segments which lie on the plane
-	list<int>::iterator itInt;
+	vector<int>::iterator itInt;
 	// Check each quad to see if any of the edges lie on the plane
-	list<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
+	vector<int> &QuadIndices = Mesh.GetIndices(CMesh::QUAD);
 	for (itInt = QuadIndices.begin(); itInt != QuadIndices.end(); )
 	{
 		i1 = *(itInt++);
@@ -1110,7 +1136,7 @@ bool CDomainPrism::FillGaps(CMesh &Mesh, const PLANE &Plane, vector<int> &Polygo
 		}
 	}
 	// Check each triangle to find edges that lie on the plane
-	list<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
+	vector<int> &TriIndices = Mesh.GetIndices(CMesh::TRI);
 	for (itInt = TriIndices.begin(); itInt != TriIndices.end(); )
 	{
 		i1 = *(itInt++);
@@ -35,6 +35,12 @@ CGeometrySolver::CGeometrySolver(void)
 , m_dLongitudinalBendingModulus(1.0)
 , m_dTransverseBendingModulus(1.0)
 , m_dTensileStress(1.0)
+, m_LinearSolver(SOLVER_DIRECT)
+, m_Preconditioner(PRECONDITIONER_ILU)
+, m_iFillLevel(5)
+, m_dIterativeTolerance(1e-10)
+, m_iMaxIterations(10000)
+, m_dPivotTolerance(1.0)
 {
 }
 
@@ -82,6 +88,24 @@ void CGeometrySolver::SetDisabledStiffness(double dDisabledStiffness)
 	m_dDisabledStiffness = dDisabledStiffness;
 }
 
+void CGeometrySolver::SetLinearSolver(LINEAR_SOLVER Solver, PRECONDITIONER Preconditioner, int iFillLevel)
+{
+	m_LinearSolver = Solver;
+	m_Preconditioner = Preconditioner;
+	m_iFillLevel = iFillLevel;
+}
+
+void CGeometrySolver::SetIterativeTolerance(double dTolerance, int iMaxIterations)
+{
+	m_dIterativeTolerance = dTolerance;
+	m_iMaxIterations = iMaxIterations;
+}
+
+void CGeometrySolver::SetPivotTolerance(double dTolerance)
+{
+	m_dPivotTolerance = dTolerance;
+}
+
 bool CGeometrySolver::CreateSystem(string TextileName)
 {
 	CTextile* pTextile = TEXGEN.GetTextile(TextileName);
@@ -146,8 +170,8 @@ bool CGeometrySolver::CreateSystem(CTextile &Textile)
 	m_ProjectedMesh.ConvertToSegmentMesh();
 
 	// Create yarn connection springs
-//	list<int> &LineIndices = m_ProjectedMesh.m_Indices[CMesh::LINE];
-//	list<int>::iterator itIter;
+//	vector<int> &LineIndices = m_ProjectedMesh.m_Indices[CMesh::LINE];
+//	vector<int>::iterator itIter;
 /*	int i1, i2;
 	vector<RAISED_NODE>::iterator itRaised1, itRaised2;
 	for (itIter = LineIndices.begin(); itIter != LineIndices.end(); )
@@ -301,8 +325,8 @@ void CGeometrySolver::RaiseNodes(int iIndex)
 	insert_iterator<set<int> > iiYarnIndices(YarnIndices, YarnIndices.end());
 	set<int>::iterator itYarnIndex;
 
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
 	int i, j, iNode, iRegion;
 
 	// Find projected triangles which have node (iIndex) as a corner
@@ -353,8 +377,8 @@ double CGeometrySolver::GetArea(int iIndex)
 double CGeometrySolver::GetAverageLength(int iIndex)
 {
 	// Create yarn connection springs
-	list<int> &LineIndices = m_ProjectedMesh.GetIndices(CMesh::LINE);
-	list<int>::iterator itIter;
+	vector<int> &LineIndices = m_ProjectedMesh.GetIndices(CMesh::LINE);
+	vector<int>::iterator itIter;
 	int i1, i2;
 	double dAverageLength = 0;
 	int iNumConnected = 0;
@@ -374,8 +398,8 @@ double CGeometrySolver::GetAverageLength(int iIndex)
 
 void CGeometrySolver::CreateSurfaceMesh()
 {
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
 	int i1, i2, i3;
 	vector<RAISED_NODE>::iterator itRaised1, itRaised2, itRaised3;
 	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
@@ -413,8 +437,8 @@ void CGeometrySolver::CreatePlateElements()
 {
 	m_PlateElements.clear();
 	PLATE Plate;
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
 	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
 	{
 		Plate.iNode1 = *(itIndex++);
@@ -530,105 +554,519 @@ void CGeometrySolver::OutputSystem(string Filename)
 		Output << itSpring->iNode1 << " " << itSpring->iNode2 << " " << itSpring->dArea << endl;
 	}
 	Output << "[Surface]" << endl;
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
 	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
 	{
 		Output << *(itIndex++) << " " << *(itIndex++) << " " << *(itIndex++) << endl;
 	}
 }
 */
+void CGeometrySolver::CreateAssembly(SYSTEM_ASSEMBLY &Assembly, int iDOFs)
+{
+	int iNumNodes = (int)m_Nodes.size();
+	int i, j, iPlateCount;
+	int iGlob, jGlob;
+	CMatrix KeB, KeT;
+	vector<PLATE>::iterator itPlate;
+	vector<SPRING>::iterator itSpring;
+
+	// Slot of each entry of the matrix in each row
+	vector<map<int, int> > Rows(iDOFs);
+	map<int, int>::iterator itEntry;
+	vector<double> &Values = Assembly.PlateValues;
+	Values.clear();
+	auto GetSlot = [&Rows, &Values](int iRow, int iColumn) -> int
+	{
+		map<int, int>::iterator itSlot = Rows[iRow].find(iColumn);
+		if (itSlot != Rows[iRow].end())
+			return itSlot->second;
+		Values.push_back(0);
+		return Rows[iRow][iColumn] = (int)Values.size()-1;
+	};
+
+	// Populate the matrix with plate elements
+	for (itPlate = m_PlateElements.begin(), iPlateCount=0; itPlate != m_PlateElements.end(); ++itPlate, ++iPlateCount)
+	{
+		int iNodes[3];
+		iNodes[0] = itPlate->iNode1;
+		iNodes[1] = itPlate->iNode2;
+		iNodes[2] = itPlate->iNode3;
+		// Fill in bending element
+		itPlate->BendingElement.GetKeMatrix(KeB);
+		for (i=0; i<10; ++i)
+		{
+			iGlob = iNodes[i/3]*3+i%3;
+			if (i/3==3)
+				iGlob = iNumNodes*3+iPlateCount;
+			assert(iGlob < iDOFs);
+			for (j=0; j<10; ++j)
+			{
+				jGlob = iNodes[j/3]*3+j%3;
+				if (j/3==3)
+					jGlob = iNumNodes*3+iPlateCount;
+				assert(jGlob < iDOFs);
+				Values[GetSlot(iGlob, jGlob)] += KeB(i, j);
+			}
+		}
+		// Fill in tension element
+		itPlate->TensionElement.GetKeMatrix(KeT);
+		for (i=0; i<3; ++i)
+		{
+			iGlob = iNodes[i]*3;
+			assert(iGlob < iDOFs);
+			for (j=0; j<3; ++j)
+			{
+				jGlob = iNodes[j]*3;
+				assert(jGlob < iDOFs);
+				Values[GetSlot(iGlob, jGlob)] += KeT(i, j);
+			}
+		}
+	}
+	// Adjust the b matrix to get rid of initial strains
+	// This can be done by doing b = -A*x0 where x0 is the matrix of initial 
+	// node positions
+	vector<double> x(iDOFs, 0.0);
+	for (i=0; i<iNumNodes; ++i)
+	{
+		x[i*3] = m_Nodes[i].Position.z;
+	}
+	Assembly.InitialForces.assign(iDOFs, 0.0);
+	for (i=0; i<iDOFs; ++i)
+	{
+		for (itEntry = Rows[i].begin(); itEntry != Rows[i].end(); ++itEntry)
+			Assembly.InitialForces[i] -= Values[itEntry->second] * x[itEntry->first];
+	}
+
+	// Slots for the contact springs, their stiffnesses change with each iteration
+	Assembly.SpringSlots.clear();
+	for (itSpring = m_Springs.begin(); itSpring != m_Springs.end(); ++itSpring)
+	{
+		int i1 = itSpring->iNode1*3;
+		int i2 = itSpring->iNode2*3;
+		Assembly.SpringSlots.push_back(GetSlot(i1, i1));
+		Assembly.SpringSlots.push_back(GetSlot(i2, i2));
+		Assembly.SpringSlots.push_back(GetSlot(i1, i2));
+		Assembly.SpringSlots.push_back(GetSlot(i2, i1));
+	}
+
+	set<int> ConstrainedDOFs;
+	Assembly.Operations.clear();
+	Assembly.Constraints.clear();
+	Assembly.Links.clear();
+
+	// Apply constraints
+	vector<pair<int, double> >::iterator itConstraint;
+	for (itConstraint=m_DOFConstraints.begin(); itConstraint != m_DOFConstraints.end(); ++itConstraint)
+	{
+		int iDOF = itConstraint->first;
+		if (ConstrainedDOFs.count(iDOF))
+		{
+			TGERROR("Warning: Equation " << iDOF << " is already constrained! Ignoring this boundary condition.");
+			continue;
+		}
+		int iSlot = GetSlot(iDOF, iDOF);
+		Rows[iDOF].clear();
+		Rows[iDOF][iDOF] = iSlot;
+		Assembly.Operations.push_back(ASSEMBLY_OPERATION(iSlot, -1, 1));
+		Assembly.Constraints.push_back(*itConstraint);
+		ConstrainedDOFs.insert(iDOF);
+	}
+
+	// Apply periodic boundary conditions
+	vector<pair<int, int> >::iterator itDOFLink;
+	for (itDOFLink=m_DOFLinks.begin(); itDOFLink != m_DOFLinks.end(); ++itDOFLink)
+	{
+		DOF_LINK Link;
+		Link.iRemovedDOF = itDOFLink->first;
+		Link.iCombinedDOF = itDOFLink->second;
+		if (ConstrainedDOFs.count(Link.iRemovedDOF))
+		{
+			swap(Link.iRemovedDOF, Link.iCombinedDOF);
+		}
+		if (ConstrainedDOFs.count(Link.iRemovedDOF))
+		{
+			TGERROR("Warning: Degrees of freedom " << itDOFLink->first << " and " << itDOFLink->second << 
+				" are already constrained! Ignoring this boundary condition.");
+			continue;
+		}
+		Link.bCombine = !ConstrainedDOFs.count(Link.iCombinedDOF);
+		map<int, int> &RemovedRow = Rows[Link.iRemovedDOF];
+		if (Link.bCombine)
+		{
+			// Combine the stiffnesses from the removed DOF and the remaining one
+			for (itEntry = RemovedRow.begin(); itEntry != RemovedRow.end(); ++itEntry)
+				Assembly.Operations.push_back(ASSEMBLY_OPERATION(GetSlot(Link.iCombinedDOF, itEntry->first), itEntry->second));
+		}
+		int iFirstSlot = GetSlot(Link.iRemovedDOF, itDOFLink->first);
+		int iSecondSlot = GetSlot(Link.iRemovedDOF, itDOFLink->second);
+		RemovedRow.clear();
+		RemovedRow[itDOFLink->first] = iFirstSlot;
+		RemovedRow[itDOFLink->second] = iSecondSlot;
+		Assembly.Operations.push_back(ASSEMBLY_OPERATION(iFirstSlot, -1, 1));
+		Assembly.Operations.push_back(ASSEMBLY_OPERATION(iSecondSlot, -1, -1));
+		Assembly.Links.push_back(Link);
+		ConstrainedDOFs.insert(Link.iRemovedDOF);
+	}
+
+	// Create the compressed column pattern of the entries remaining
+	vector<int> ColumnCounts(iDOFs, 0);
+	for (i=0; i<iDOFs; ++i)
+	{
+		for (itEntry = Rows[i].begin(); itEntry != Rows[i].end(); ++itEntry)
+			++ColumnCounts[itEntry->first];
+	}
+	Assembly.ColumnStarts.assign(iDOFs+1, 0);
+	for (i=0; i<iDOFs; ++i)
+		Assembly.ColumnStarts[i+1] = Assembly.ColumnStarts[i] + ColumnCounts[i];
+	int iNumEntries = Assembly.ColumnStarts[iDOFs];
+	Assembly.RowIndices.resize(iNumEntries);
+	Assembly.EntrySlots.resize(iNumEntries);
+	vector<int> Next(Assembly.ColumnStarts.begin(), Assembly.ColumnStarts.end()-1);
+	for (i=0; i<iDOFs; ++i)
+	{
+		for (itEntry = Rows[i].begin(); itEntry != Rows[i].end(); ++itEntry)
+		{
+			int iIndex = Next[itEntry->first]++;
+			Assembly.RowIndices[iIndex] = i;
+			Assembly.EntrySlots[iIndex] = itEntry->second;
+		}
+	}
+}
+
+void CGeometrySolver::CreateIterativeSystem(ITERATIVE_SYSTEM &System, const SYSTEM_ASSEMBLY &Assembly)
+{
+	int n = (int)Assembly.ColumnStarts.size()-1;
+	int iNumEntries = (int)Assembly.EntrySlots.size();
+	int i, j, p, q;
+
+	// Incomplete factorisations of the plate equations in the order the nodes were meshed are poor,
+	// so the system is reordered in the same way as for the direct solver
+	System.Permutation.resize(n);
+	cs* csA = cs_spalloc(n, n, iNumEntries, 0, 0);
+	copy(Assembly.ColumnStarts.begin(), Assembly.ColumnStarts.end(), csA->p);
+	copy(Assembly.RowIndices.begin(), Assembly.RowIndices.end(), csA->i);
+	int* pPermutation = cs_amd(1, csA);
+	for (i=0; i<n; ++i)
+	{
+		System.Permutation[i] = pPermutation ? pPermutation[i] : i;
+	}
+	cs_free(pPermutation);
+	cs_spfree(csA);
+	vector<int> InversePermutation(n);
+	for (i=0; i<n; ++i)
+	{
+		InversePermutation[System.Permutation[i]] = i;
+	}
+
+	// Compressed row pattern of the reordered matrix
+	vector<vector<pair<int, int> > > Rows(n);
+	for (j=0; j<n; ++j)
+	{
+		for (p=Assembly.ColumnStarts[j]; p<Assembly.ColumnStarts[j+1]; ++p)
+		{
+			Rows[InversePermutation[Assembly.RowIndices[p]]].push_back(make_pair(InversePermutation[j], Assembly.EntrySlots[p]));
+		}
+	}
+	System.RowStarts.assign(1, 0);
+	System.ColumnIndices.clear();
+	System.EntrySlots.clear();
+	System.Diagonal.assign(n, -1);
+	for (i=0; i<n; ++i)
+	{
+		sort(Rows[i].begin(), Rows[i].end());
+		for (p=0; p<(int)Rows[i].size(); ++p)
+		{
+			if (Rows[i][p].first == i)
+				System.Diagonal[i] = (int)System.ColumnIndices.size();
+			System.ColumnIndices.push_back(Rows[i][p].first);
+			System.EntrySlots.push_back(Rows[i][p].second);
+		}
+		System.RowStarts.push_back((int)System.ColumnIndices.size());
+	}
+
+	// Pattern of the incomplete factorisation, keeping the fill-in up to the given level
+	System.FactorStarts.clear();
+	System.FactorColumns.clear();
+	System.FactorDiagonal.clear();
+	if (m_Preconditioner != PRECONDITIONER_ILU)
+		return;
+	System.FactorStarts.push_back(0);
+	System.FactorDiagonal.assign(n, -1);
+	vector<int> Levels;
+	map<int, int> Row;
+	map<int, int>::iterator itRow, itFill;
+	for (i=0; i<n; ++i)
+	{
+		Row.clear();
+		for (p=System.RowStarts[i]; p<System.RowStarts[i+1]; ++p)
+		{
+			Row[System.ColumnIndices[p]] = 0;
+		}
+		// Entries filled in are to the right of the one being eliminated so are visited later in the loop
+		for (itRow = Row.begin(); itRow != Row.end() && itRow->first < i; ++itRow)
+		{
+			int k = itRow->first;
+			if (System.FactorDiagonal[k] == -1)
+				continue;
+			for (q=System.FactorDiagonal[k]+1; q<System.FactorStarts[k+1]; ++q)
+			{
+				int iLevel = itRow->second + Levels[q] + 1;
+				if (iLevel > m_iFillLevel)
+					continue;
+				itFill = Row.find(System.FactorColumns[q]);
+				if (itFill == Row.end())
+					Row[System.FactorColumns[q]] = iLevel;
+				else if (iLevel < itFill->second)
+					itFill->second = iLevel;
+			}
+		}
+		for (itRow = Row.begin(); itRow != Row.end(); ++itRow)
+		{
+			if (itRow->first == i)
+				System.FactorDiagonal[i] = (int)System.FactorColumns.size();
+			System.FactorColumns.push_back(itRow->first);
+			Levels.push_back(itRow->second);
+		}
+		System.FactorStarts.push_back((int)System.FactorColumns.size());
+	}
+	TGLOG("Incomplete LU factorisation has " << System.FactorColumns.size() << " entries, the matrix has " << iNumEntries);
+}
+
+bool CGeometrySolver::SolveIterative(const ITERATIVE_SYSTEM &System, const vector<double> &Values, const vector<double> &bOriginal, vector<double> &xOriginal)
+{
+	const vector<int> &Starts = System.RowStarts;
+	const vector<int> &Columns = System.ColumnIndices;
+	const vector<int> &FStarts = System.FactorStarts;
+	const vector<int> &FColumns = System.FactorColumns;
+	const vector<int> &FDiagonal = System.FactorDiagonal;
+	int n = (int)Starts.size()-1;
+	int i, p, q;
+
+	vector<double> A(Columns.size());
+	for (p=0; p<(int)Columns.size(); ++p)
+	{
+		A[p] = Values[System.EntrySlots[p]];
+	}
+	vector<double> b(n), x(n);
+	for (i=0; i<n; ++i)
+	{
+		b[i] = bOriginal[System.Permutation[i]];
+		x[i] = xOriginal[System.Permutation[i]];
+	}
+
+	// Create the preconditioner
+	PRECONDITIONER Preconditioner = m_Preconditioner;
+	vector<double> LU, InvDiagonal;
+	if (Preconditioner == PRECONDITIONER_ILU)
+	{
+		LU.assign(FColumns.size(), 0.0);
+		vector<int> Marker(n, -1);
+		for (i=0; i<n && Preconditioner == PRECONDITIONER_ILU; ++i)
+		{
+			for (p=FStarts[i]; p<FStarts[i+1]; ++p)
+				Marker[FColumns[p]] = p;
+			for (p=Starts[i]; p<Starts[i+1]; ++p)
+				LU[Marker[Columns[p]]] = A[p];
+			for (p=FStarts[i]; p<FStarts[i+1] && FColumns[p]<i; ++p)
+			{
+				int k = FColumns[p];
+				if (FDiagonal[k] == -1 || LU[FDiagonal[k]] == 0)
+				{
+					Preconditioner = PRECONDITIONER_JACOBI;
+					break;
+				}
+				LU[p] /= LU[FDiagonal[k]];
+				for (q=FDiagonal[k]+1; q<FStarts[k+1]; ++q)
+				{
+					if (Marker[FColumns[q]] != -1)
+						LU[Marker[FColumns[q]]] -= LU[p]*LU[q];
+				}
+			}
+			if (FDiagonal[i] == -1 || LU[FDiagonal[i]] == 0)
+				Preconditioner = PRECONDITIONER_JACOBI;
+			for (p=FStarts[i]; p<FStarts[i+1]; ++p)
+				Marker[FColumns[p]] = -1;
+		}
+		if (Preconditioner != PRECONDITIONER_ILU)
+			TGERROR("Zero pivot in incomplete LU factorisation, using Jacobi preconditioner instead");
+	}
+	if (Preconditioner == PRECONDITIONER_JACOBI)
+	{
+		InvDiagonal.resize(n);
+		for (i=0; i<n; ++i)
+		{
+			double dDiagonal = System.Diagonal[i] == -1 ? 0 : A[System.Diagonal[i]];
+			InvDiagonal[i] = dDiagonal != 0 ? 1/dDiagonal : 1;
+		}
+	}
+
+	auto Precondition = [&](const vector<double> &r, vector<double> &z)
+	{
+		if (Preconditioner == PRECONDITIONER_ILU)
+		{
+			// Solve L*U*z = r where L has a unit diagonal
+			for (i=0; i<n; ++i)
+			{
+				double dSum = r[i];
+				for (p=FStarts[i]; p<FDiagonal[i]; ++p)
+					dSum -= LU[p]*z[FColumns[p]];
+				z[i] = dSum;
+			}
+			for (i=n-1; i>=0; --i)
+			{
+				double dSum = z[i];
+				for (p=FDiagonal[i]+1; p<FStarts[i+1]; ++p)
+					dSum -= LU[p]*z[FColumns[p]];
+				z[i] = dSum/LU[FDiagonal[i]];
+			}
+		}
+		else
+		{
+			for (i=0; i<n; ++i)
+				z[i] = r[i]*InvDiagonal[i];
+		}
+	};
+	auto Multiply = [&](const vector<double> &v, vector<double> &y)
+	{
+		for (i=0; i<n; ++i)
+		{
+			double dSum = 0;
+			for (p=Starts[i]; p<Starts[i+1]; ++p)
+				dSum += A[p]*v[Columns[p]];
+			y[i] = dSum;
+		}
+	};
+	auto Dot = [n](const vector<double> &v1, const vector<double> &v2)
+	{
+		double dSum = 0;
+		for (int k=0; k<n; ++k)
+			dSum += v1[k]*v2[k];
+		return dSum;
+	};
+
+	double dNormB = sqrt(Dot(b, b));
+	if (dNormB == 0)
+		dNormB = 1;
+	vector<double> r(n), r0(n), v(n, 0.0), pv(n, 0.0), pHat(n), s(n), sHat(n), t(n);
+	Multiply(x, r);
+	for (i=0; i<n; ++i)
+		r[i] = b[i] - r[i];
+	r0 = r;
+	double dRho = 1, dAlpha = 1, dOmega = 1;
+	double dResidual = sqrt(Dot(r, r))/dNormB;
+	int iIteration = 0;
+	while (dResidual > m_dIterativeTolerance && iIteration < m_iMaxIterations)
+	{
+		++iIteration;
+		double dRhoNew = Dot(r0, r);
+		if (dRhoNew == 0)
+			break;
+		double dBeta = (dRhoNew/dRho)*(dAlpha/dOmega);
+		for (i=0; i<n; ++i)
+			pv[i] = r[i] + dBeta*(pv[i] - dOmega*v[i]);
+		Precondition(pv, pHat);
+		Multiply(pHat, v);
+		double dR0V = Dot(r0, v);
+		if (dR0V == 0)
+			break;
+		dAlpha = dRhoNew/dR0V;
+		for (i=0; i<n; ++i)
+			s[i] = r[i] - dAlpha*v[i];
+		if (sqrt(Dot(s, s))/dNormB <= m_dIterativeTolerance)
+		{
+			for (i=0; i<n; ++i)
+				x[i] += dAlpha*pHat[i];
+			r = s;
+			dResidual = sqrt(Dot(r, r))/dNormB;
+			break;
+		}
+		Precondition(s, sHat);
+		Multiply(sHat, t);
+		double dTT = Dot(t, t);
+		if (dTT == 0)
+			break;
+		dOmega = Dot(t, s)/dTT;
+		for (i=0; i<n; ++i)
+		{
+			x[i] += dAlpha*pHat[i] + dOmega*sHat[i];
+			r[i] = s[i] - dOmega*t[i];
+		}
+		dResidual = sqrt(Dot(r, r))/dNormB;
+		dRho = dRhoNew;
+		if (dOmega == 0)
+			break;
+	}
+	// The recursively updated residual may drift from the true one
+	Multiply(x, r);
+	for (i=0; i<n; ++i)
+		r[i] = b[i] - r[i];
+	dResidual = sqrt(Dot(r, r))/dNormB;
+	bool bConverged = dResidual <= m_dIterativeTolerance;
+	for (i=0; i<n; ++i)
+	{
+		xOriginal[System.Permutation[i]] = x[i];
+	}
+
+	++m_SolverStatistics.iNumSolves;
+	m_SolverStatistics.iTotalIterations += iIteration;
+	m_SolverStatistics.iLastIterations = iIteration;
+	m_SolverStatistics.dLastResidual = dResidual;
+	TGLOG("BiCGSTAB " << (bConverged ? "converged" : "failed to converge") << " after " << iIteration << " iterations with relative residual " << dResidual);
+	return bConverged;
+}
+
 int CGeometrySolver::SolveSystem()
 {
 //	int i, j, iNumProjectedNodes = (int)m_ProjectedNodes.size();
 	int iNumNodes = (int)m_Nodes.size();
 	int iNumPlates = (int)m_PlateElements.size();
 	int iDOFs = iNumNodes*3 + iNumPlates;
-	map<pair<int, int>, double> A;
-	map<pair<int, int>, double>::iterator itA;
-	vector<double> x(iDOFs/*, 0.0*/);
+	vector<double> x(iDOFs, 0.0);
 	vector<double> b(iDOFs/*, 0.0*/);
 	int iNumSwitches, iIteration = 0;
 	double dInitialLength, dCurrentLength;
 	double dContactDistance, dSeperationDistance;
 	double dStiffness;
 	bool bEnabled;
-	int i, j, i1, i2, iPlateCount;
-	int iGlob, jGlob;
-	CMatrix KeB, KeT;
+	int i, i1, i2;
 	vector<SPRING>::iterator itSpring;
-	vector<PLATE>::iterator itPlate;
 
 //	m_bDebug = true;
 
 	TGLOGINDENT("Solving geometry with " << iNumNodes << " nodes and " << iDOFs << " degrees of freedom");
+
+	// Only the spring stiffnesses change between iterations, so the pattern of the matrix and its
+	// ordering and symbolic analysis are found once and the values are filled in for each iteration
+	SYSTEM_ASSEMBLY Assembly;
+	CreateAssembly(Assembly, iDOFs);
+	cs* csA = cs_spalloc(iDOFs, iDOFs, (int)Assembly.EntrySlots.size(), 1, 0);
+	copy(Assembly.ColumnStarts.begin(), Assembly.ColumnStarts.end(), csA->p);
+	copy(Assembly.RowIndices.begin(), Assembly.RowIndices.end(), csA->i);
+	css* csS = NULL;
+	ITERATIVE_SYSTEM IterativeSystem;
+	if (m_LinearSolver == SOLVER_ITERATIVE)
+		CreateIterativeSystem(IterativeSystem, Assembly);
+	vector<double> Values;
+	m_SolverStatistics = SOLVER_STATISTICS();
+	// The iterative solver starts from the current displacements and then from the solution of the
+	// previous iteration, which only differs by the springs that have switched
+	for (i=0; i<iNumNodes; ++i)
+	{
+		x[i*3] = m_Nodes[i].dDisplacement;
+		x[i*3+1] = m_Nodes[i].dThetaX;
+		x[i*3+2] = m_Nodes[i].dThetaY;
+	}
 	do
 	{
 		++iIteration;
 		TGLOG("Iteration " << iIteration);
 		iNumSwitches = 0;
-		A.clear();
-		fill(x.begin(), x.end(), 0.0);
-		fill(b.begin(), b.end(), 0.0);
-		// Populate the matrix A with plate elements
-		for (itPlate = m_PlateElements.begin(), iPlateCount=0; itPlate != m_PlateElements.end(); ++itPlate, ++iPlateCount)
-		{
-			int iNodes[3];
-			iNodes[0] = itPlate->iNode1;
-			iNodes[1] = itPlate->iNode2;
-			iNodes[2] = itPlate->iNode3;
-			// Fill in bending element
-			itPlate->BendingElement.GetKeMatrix(KeB);
-			for (i=0; i<10; ++i)
-			{
-				iGlob = iNodes[i/3]*3+i%3;
-				if (i/3==3)
-					iGlob = iNumNodes*3+iPlateCount;
-				assert(iGlob < iDOFs);
-				for (j=0; j<10; ++j)
-				{
-					jGlob = iNodes[j/3]*3+j%3;
-					if (j/3==3)
-						jGlob = iNumNodes*3+iPlateCount;
-					assert(jGlob < iDOFs);
-					A[make_pair(iGlob, jGlob)] += KeB(i, j);
-				}
-			}
-			// Fill in tension element
-			itPlate->TensionElement.GetKeMatrix(KeT);
-			for (i=0; i<3; ++i)
-			{
-				iGlob = iNodes[i]*3;
-				assert(iGlob < iDOFs);
-				for (j=0; j<3; ++j)
-				{
-					jGlob = iNodes[j]*3;
-					assert(jGlob < iDOFs);
-					A[make_pair(iGlob, jGlob)] += KeT(i, j);
-				}
-			}
-		}
-		// Adjust the b matrix to get rid of initial strains
-		// This can be done by doing b = -A*x0 where x0 is the matrix of initial 
-		// node positions
-		for (i=0; i<iNumNodes; ++i)
-		{
-			x[i*3] = m_Nodes[i].Position.z;
-		}
-		// This screws things up big time, not sure why...
-/*		for (i=0; i<iNumPlates; ++i)
-		{
-			x[iNumNodes+i] = (m_Nodes[m_PlateElements[i].iNode1].Position.z + 
-							  m_Nodes[m_PlateElements[i].iNode2].Position.z + 
-							  m_Nodes[m_PlateElements[i].iNode3].Position.z) / 3.0;
-		}*/
-		for (itA = A.begin(); itA != A.end(); ++itA)
-		{
-			b[itA->first.first] -= itA->second * x[itA->first.second];
-		}
+		Values = Assembly.PlateValues;
+		b = Assembly.InitialForces;
 
 		// Populate the matrix A with contact springs
-		for (itSpring = m_Springs.begin(); itSpring != m_Springs.end(); ++itSpring)
+		for (itSpring = m_Springs.begin(), i = 0; itSpring != m_Springs.end(); ++itSpring, i += 4)
 		{
 			i1 = itSpring->iNode1;
 			i2 = itSpring->iNode2;
@@ -662,72 +1100,33 @@ int CGeometrySolver::SolveSystem()
 			}
 			b[i1*3] += dStiffness*(dInitialLength-dContactDistance);
 			b[i2*3] -= dStiffness*(dInitialLength-dContactDistance);
-			A[make_pair(i1*3, i1*3)] += dStiffness;
-			A[make_pair(i2*3, i2*3)] += dStiffness;
-			A[make_pair(i1*3, i2*3)] -= dStiffness;
-			A[make_pair(i2*3, i1*3)] -= dStiffness;
+			Values[Assembly.SpringSlots[i]] += dStiffness;
+			Values[Assembly.SpringSlots[i+1]] += dStiffness;
+			Values[Assembly.SpringSlots[i+2]] -= dStiffness;
+			Values[Assembly.SpringSlots[i+3]] -= dStiffness;
 		}
 
-		set<int> ConstrainedDOFs;
-
-		// Apply constraints
-		vector<pair<int, double> >::iterator itConstraint;
-		for (itConstraint=m_DOFConstraints.begin(); itConstraint != m_DOFConstraints.end(); ++itConstraint)
+		// Apply constraints and periodic boundary conditions
+		vector<ASSEMBLY_OPERATION>::const_iterator itOperation;
+		for (itOperation = Assembly.Operations.begin(); itOperation != Assembly.Operations.end(); ++itOperation)
+		{
+			if (itOperation->iSource == -1)
+				Values[itOperation->iDest] = itOperation->dValue;
+			else
+				Values[itOperation->iDest] += Values[itOperation->iSource];
+		}
+		vector<pair<int, double> >::const_iterator itConstraint;
+		for (itConstraint = Assembly.Constraints.begin(); itConstraint != Assembly.Constraints.end(); ++itConstraint)
 		{
-			if (ConstrainedDOFs.count(itConstraint->first))
-			{
-				TGERROR("Warning: Equation " << itConstraint->first << " is already constrained! Ignoring this boundary condition.");
-				continue;
-			}
-			for (i=0; i<iDOFs; ++i)
-			{
-				pair<int, int> Index = make_pair(itConstraint->first, i);
-				if (i==itConstraint->first)
-					A[Index] = 1;
-				else
-					A.erase(Index);
-			}
 			b[itConstraint->first] = itConstraint->second;
-			ConstrainedDOFs.insert(itConstraint->first);
 		}
-
-		// Apply periodic boundary conditions
-		vector<pair<int, int> >::iterator itDOFLink;
-		for (itDOFLink=m_DOFLinks.begin(); itDOFLink != m_DOFLinks.end(); ++itDOFLink)
-//		if (0)
+		vector<DOF_LINK>::const_iterator itLink;
+		for (itLink = Assembly.Links.begin(); itLink != Assembly.Links.end(); ++itLink)
 		{
-			int iRemovedDOF = itDOFLink->first;
-			int iCombinedDOF = itDOFLink->second;
-			if (ConstrainedDOFs.count(iRemovedDOF))
-			{
-				swap(iRemovedDOF, iCombinedDOF);
-			}
-			if (ConstrainedDOFs.count(iRemovedDOF))
-			{
-				TGERROR("Warning: Degrees of freedom " << itDOFLink->first << " and " << itDOFLink->second << 
-					" are already constrained! Ignoring this boundary condition.");
-				continue;
-			}
-			for (i=0; i<iDOFs; ++i)
-			{
-				pair<int, int> Index = make_pair(iRemovedDOF, i);
-				if (!ConstrainedDOFs.count(iCombinedDOF) && A.count(Index))
-				{
-					// Combine the stiffnesses from the removed DOF and the remaining one
-					A[make_pair(iCombinedDOF, i)] += A[Index];
-				}
-				if (i==itDOFLink->first)
-					A[Index] = 1;
-				else if (i==itDOFLink->second)
-					A[Index] = -1;
-				else
-					A.erase(Index);
-			}
 			// Combine the forces from the removed DOF and the remaining one
-			if (!ConstrainedDOFs.count(iCombinedDOF))
-				b[iCombinedDOF] += b[iRemovedDOF];
-			b[iRemovedDOF] = 0;
-			ConstrainedDOFs.insert(iRemovedDOF);
+			if (itLink->bCombine)
+				b[itLink->iCombinedDOF] += b[itLink->iRemovedDOF];
+			b[itLink->iRemovedDOF] = 0;
 		}
 
 		/*if (m_bDebug && iIteration == 1)
@@ -735,22 +1134,41 @@ int CGeometrySolver::SolveSystem()
 			SaveToVTK("c://Program Files//TexGen//GeometrySolver//Initial");
 		}*/
 
-		// Solve this sucker with CSparse
-		cs* csT = cs_spalloc(iNumNodes, iNumNodes, A.size(), 1, 1);
-		for (itA = A.begin(); itA != A.end(); ++itA)
+		bool bSolved = false;
+		if (m_LinearSolver == SOLVER_ITERATIVE)
 		{
-			cs_entry(csT, itA->first.first, itA->first.second, itA->second);
+			bSolved = SolveIterative(IterativeSystem, Values, b, x);
+			if (!bSolved)
+			{
+				TGERROR("Iterative solver failed to converge, using the direct solver instead");
+				++m_SolverStatistics.iNumFallbacks;
+			}
 		}
-		cs* csA = cs_compress(csT);
-		cs_spfree(csT);
-		x = b;
-		int iSuccess = cs_lusol(1, csA, &x.front(), 1);
-		cs_spfree(csA);
-
-		if (!iSuccess)
+		if (!bSolved)
 		{
-			TGERROR("Solve failed");
-			return 0;
+			// Solve this sucker with CSparse
+			for (i=0; i<(int)Assembly.EntrySlots.size(); ++i)
+			{
+				csA->x[i] = Values[Assembly.EntrySlots[i]];
+			}
+			if (!csS)
+				csS = cs_sqr(1, csA, 0);		// Ordering and symbolic analysis
+			// Partial pivoting unless a lower threshold was chosen, the matrix is symmetric apart from the constrained
+			// rows so lower thresholds keep the fill-in given by the symmetric ordering
+			csn* csN = csS ? cs_lu(csA, csS, m_dPivotTolerance) : NULL;
+			if (!csN)
+			{
+				TGERROR("Solve failed");
+				cs_sfree(csS);
+				cs_spfree(csA);
+				return 0;
+			}
+			cs_ipvec(csN->pinv, &b.front(), &x.front(), iDOFs);	// x = b(p)
+			cs_lsolve(csN->L, &x.front());		// x = L\x
+			cs_usolve(csN->U, &x.front());		// x = U\x
+			cs_ipvec(csS->q, &x.front(), &b.front(), iDOFs);	// b(q) = x
+			cs_nfree(csN);
+			x = b;
 		}
 
 		for (i=0; i<iNumNodes; ++i)
@@ -769,6 +1187,8 @@ int CGeometrySolver::SolveSystem()
 		}
 	} while (iIteration == 1 || iNumSwitches > 0);
 
+	cs_sfree(csS);
+	cs_spfree(csA);
 	return iIteration;
 }
 
@@ -848,8 +1268,8 @@ CTextile* CGeometrySolver::GetDeformedCopyOfTextile()
 double CGeometrySolver::GetDisplacement(XYZ Pos, int iYarn, XYZ &Disp) const
 {
 	// Find out what the displacement is of the yarn at given position
-	const list<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
-	list<int>::const_iterator itIndex;
+	const vector<int> &Indices = m_SurfaceMesh.GetIndices(CMesh::TRI);
+	vector<int>::const_iterator itIndex;
 	int i1, i2, i3;
 	double dMin;
 	double dAccuracy = -1;
@@ -35,6 +35,31 @@ namespace TexGen
 	class CLASS_DECLSPEC CGeometrySolver : public CBasicVolumes, public CTextileDeformer
 	{
 	public:
+		/// Method used to solve the system of equations of each contact iteration
+		enum LINEAR_SOLVER
+		{
+			SOLVER_DIRECT,		///< Sparse LU factorisation
+			SOLVER_ITERATIVE,	///< Preconditioned BiCGSTAB, starting from the solution of the previous iteration
+		};
+
+		/// Preconditioner used by the iterative solver
+		enum PRECONDITIONER
+		{
+			PRECONDITIONER_JACOBI,	///< Diagonal of the matrix
+			PRECONDITIONER_ILU,		///< Incomplete LU factorisation keeping the fill-in up to a given level
+		};
+
+		/// Statistics of the iterative solver gathered during the last call to SolveSystem
+		struct SOLVER_STATISTICS
+		{
+			int iNumSolves;			///< Number of systems solved iteratively
+			int iTotalIterations;	///< Total number of iterations of all the solves
+			int iLastIterations;	///< Number of iterations of the last solve
+			double dLastResidual;	///< Residual of the last solve relative to the norm of the right hand side
+			int iNumFallbacks;		///< Number of solves which didn't converge and used the direct solver instead
+			SOLVER_STATISTICS():iNumSolves(0), iTotalIterations(0), iLastIterations(0), dLastResidual(0), iNumFallbacks(0) {}
+		};
+
 		CGeometrySolver(void);
 		~CGeometrySolver(void);
 
@@ -67,6 +92,34 @@ namespace TexGen
 		double GetContactStiffness() { return m_dContactStiffness; }
 		double GetDisabledStiffness() { return m_dDisabledStiffness; }
 
+		/// Set the method used to solve the system of equations
+		/**
+		The direct solver is used by default. The fill-in of its factorisation limits the size of the fabrics
+		which can be solved, the iterative solver only stores the matrix and the preconditioner. If the iterative
+		solver doesn't converge the system is solved with the direct solver instead.
+		\param iFillLevel Level of fill-in kept by the incomplete LU factorisation, 0 keeps the sparsity of the matrix.
+		Higher levels take more memory but fewer iterations.
+		*/
+		void SetLinearSolver(LINEAR_SOLVER Solver, PRECONDITIONER Preconditioner = PRECONDITIONER_ILU, int iFillLevel = 5);
+		/// Set when the iterative solver stops
+		/**
+		\param dTolerance Residual relative to the norm of the right hand side below which the solution is accepted
+		\param iMaxIterations Maximum number of iterations for each system
+		*/
+		void SetIterativeTolerance(double dTolerance, int iMaxIterations = 10000);
+		/// Set the pivoting threshold of the LU factorisation used by the direct solver
+		/**
+		\param dTolerance The default of 1 uses partial pivoting. Smaller values prefer the diagonal entries as
+		pivots as long as they are at least this fraction of the largest entry in the column. This keeps the fill-in
+		of the symmetric ordering, which can make the factorisation several times faster on large systems (1e-3 works
+		well for this system), at the cost of slightly different numerics.
+		*/
+		void SetPivotTolerance(double dTolerance);
+		LINEAR_SOLVER GetLinearSolver() const { return m_LinearSolver; }
+		PRECONDITIONER GetPreconditioner() const { return m_Preconditioner; }
+		double GetPivotTolerance() const { return m_dPivotTolerance; }
+		const SOLVER_STATISTICS &GetSolverStatistics() const { return m_SolverStatistics; }
+
 	private:
 		void CreateDebugSystem();
 
@@ -122,6 +175,53 @@ namespace TexGen
 			PLATE():iNode1(0), iNode2(0), iNode3(0), iYarnIndex(-1) {}
 		};
 
+		/// Step applied to the assembled stiffness values to apply the constraints and periodic links
+		struct ASSEMBLY_OPERATION
+		{
+			int iDest;			///< Slot which is modified
+			int iSource;		///< Slot added to the destination or -1 to set the destination to dValue
+			double dValue;
+			ASSEMBLY_OPERATION(int iDest, int iSource, double dValue = 0):iDest(iDest), iSource(iSource), dValue(dValue) {}
+		};
+
+		struct DOF_LINK
+		{
+			int iRemovedDOF;
+			int iCombinedDOF;
+			bool bCombine;		///< Whether the force on the removed DOF is added to the combined one
+		};
+
+		/// Sparsity pattern of the system and how to fill in its values, the same for every contact iteration
+		/**
+		Values are stored in slots, a slot is created for each entry of the matrix. Entries removed when
+		applying the constraints are dropped from the pattern and those created by them get new slots.
+		*/
+		struct SYSTEM_ASSEMBLY
+		{
+			vector<double> PlateValues;		///< Value of each slot from the plate elements
+			vector<int> SpringSlots;		///< Slots of the (1,1), (2,2), (1,2) and (2,1) entries of each spring
+			vector<ASSEMBLY_OPERATION> Operations;	///< Applied in order to the slots after adding the springs
+			vector<double> InitialForces;	///< Forces from the plate elements which remove the initial strains
+			vector<pair<int, double> > Constraints;	///< Constraints which are applied, ignoring the duplicates
+			vector<DOF_LINK> Links;			///< Periodic links which are applied, ignoring the ones already constrained
+			vector<int> ColumnStarts;		///< Compressed column pattern of the matrix
+			vector<int> RowIndices;
+			vector<int> EntrySlots;			///< Slot holding the value of each entry of the compressed column matrix
+		};
+
+		/// Reordered system and the pattern of its incomplete factorisation used by the iterative solver
+		struct ITERATIVE_SYSTEM
+		{
+			vector<int> Permutation;		///< Original degree of freedom of each row of the reordered system
+			vector<int> RowStarts;			///< Compressed row pattern of the reordered matrix, columns are in ascending order
+			vector<int> ColumnIndices;
+			vector<int> EntrySlots;			///< Slot holding the value of each entry of the compressed row matrix
+			vector<int> Diagonal;			///< Index of the diagonal entry of each row
+			vector<int> FactorStarts;		///< Compressed row pattern of the incomplete factorisation
+			vector<int> FactorColumns;
+			vector<int> FactorDiagonal;
+		};
+
 
 		void RaiseNodes(int iIndex);
 		double GetAverageLength(int iIndex);
@@ -131,6 +231,16 @@ namespace TexGen
 		void AssignFibreDirectionToElements();
 		void ApplyPeriodicBoundaryConditions(vector<XYZ> Repeats);
 		double GetDisplacement(XYZ Pos, int iYarn, XYZ &Disp) const;
+		/// Find the sparsity pattern of the system and the values which don't change between contact iterations
+		void CreateAssembly(SYSTEM_ASSEMBLY &Assembly, int iDOFs);
+		/// Find the ordering of the system and the pattern of the preconditioner for the iterative solver
+		void CreateIterativeSystem(ITERATIVE_SYSTEM &System, const SYSTEM_ASSEMBLY &Assembly);
+		/// Solve the system with preconditioned BiCGSTAB using x as the starting guess
+		/**
+		\param Values Values of the slots of the assembled system
+		\return false if the solution didn't converge
+		*/
+		bool SolveIterative(const ITERATIVE_SYSTEM &System, const vector<double> &Values, const vector<double> &b, vector<double> &x);
 //		void DeformTextile(CTextile* pTextile);
 
 		vector<SPRING> m_Springs;
@@ -147,6 +257,13 @@ namespace TexGen
 		double m_dTensileStress;
 		CMesh m_SurfaceMesh;
 		bool m_bAdjustThickness;
+		LINEAR_SOLVER m_LinearSolver;
+		PRECONDITIONER m_Preconditioner;
+		int m_iFillLevel;
+		double m_dIterativeTolerance;
+		int m_iMaxIterations;
+		double m_dPivotTolerance;
+		SOLVER_STATISTICS m_SolverStatistics;
 	};
 
 
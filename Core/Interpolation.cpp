@@ -129,7 +129,34 @@ double CInterpolation::GetLength(vector<CNode> &MasterNodes)
 	return dLength;
 }
 */
+shared_ptr<const CInterpolationData> CInterpolation::CreateData(const vector<CNode> &MasterNodes) const
+{
+	return make_shared<CInterpolationData>();
+}
+
+void CInterpolation::Initialise(const vector<CNode> &MasterNodes) const
+{
+	m_pData = CreateData(MasterNodes);
+}
+
+CSlaveNode CInterpolation::GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const
+{
+	// Errors may occur here if the Initialise function was not called before with the same
+	// master nodes. For performance reasons it is necessary to call initialise once at the
+	// start before making calls to this function
+	if (!m_pData)
+		Initialise(MasterNodes);
+	return GetNode(MasterNodes, *m_pData, iIndex, t);
+}
+
 CSlaveNode CInterpolation::GetNode(const vector<CNode> &MasterNodes, double t) const
+{
+	if (!m_pData)
+		Initialise(MasterNodes);
+	return GetNode(MasterNodes, *m_pData, t);
+}
+
+CSlaveNode CInterpolation::GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, double t) const
 {
 	int iNumSections = (int)MasterNodes.size()-1;
 	t *= iNumSections;
@@ -140,19 +167,24 @@ CSlaveNode CInterpolation::GetNode(const vector<CNode> &MasterNodes, double t) c
 		iIndex = iNumSections-1;
 		t = 1;
 	}
-	return GetNode(MasterNodes, iIndex, t);
+	return GetNode(MasterNodes, Data, iIndex, t);
 }
 
 vector<CSlaveNode> CInterpolation::GetSlaveNodes(const vector<CNode> &MasterNodes, int iNumPoints, bool bEquiSpaced) const
 {
-	vector<CSlaveNode> SlaveNodes;
 	Initialise(MasterNodes);
-	if (!bEquiSpaced || !CreateEquiSpacedSlaveNodes(SlaveNodes, MasterNodes, iNumPoints))
-		CreateSlaveNodes(SlaveNodes, MasterNodes, iNumPoints);
+	return GetSlaveNodes(MasterNodes, *m_pData, iNumPoints, bEquiSpaced);
+}
+
+vector<CSlaveNode> CInterpolation::GetSlaveNodes(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints, bool bEquiSpaced) const
+{
+	vector<CSlaveNode> SlaveNodes;
+	if (!bEquiSpaced || !CreateEquiSpacedSlaveNodes(SlaveNodes, MasterNodes, Data, iNumPoints))
+		CreateSlaveNodes(SlaveNodes, MasterNodes, Data, iNumPoints);
 	return SlaveNodes;
 }
 
-void CInterpolation::CreateSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, int iNumPoints) const
+void CInterpolation::CreateSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints) const
 {
 	double t;
 	int i;
@@ -160,11 +192,11 @@ void CInterpolation::CreateSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vect
 	for (i=0; i<iNumPoints; ++i)
 	{
 		t = double(i)/double(iNumPoints-1);
-		SlaveNodes.push_back(GetNode(MasterNodes, t));
+		SlaveNodes.push_back(GetNode(MasterNodes, Data, t));
 	}
 }
 
-bool CInterpolation::CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, int iNumPoints) const
+bool CInterpolation::CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints) const
 {
 	if (iNumPoints <= 1)
 	{
@@ -207,7 +239,7 @@ bool CInterpolation::CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes,
 	// so calculate an L value for each slave node then convert it to the T value
 	double dl = dTotalLength/double(iNumPoints-1);
 	SlaveNodes.clear();
-	SlaveNodes = CalcSlaveNodePositions( MasterNodes, LValues, TValues, dl, iNumNodes, iNumPoints );
+	SlaveNodes = CalcSlaveNodePositions( MasterNodes, Data, LValues, TValues, dl, iNumNodes, iNumPoints );
 	
 
 	// If there is a high curvature in the yarn the initial estimate of length will be too small
@@ -252,7 +284,7 @@ bool CInterpolation::CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes,
 		// so calculate an L value for each slave node then convert it to the T value
 		double dl = dNewTotalLength/double(iNumPoints-1);
 		SlaveNodes.clear();
-		SlaveNodes = CalcSlaveNodePositions( MasterNodes, LValues, TValues, dl, iNumNodes, iNumPoints );
+		SlaveNodes = CalcSlaveNodePositions( MasterNodes, Data, LValues, TValues, dl, iNumNodes, iNumPoints );
 	}
 
 	return true;
@@ -312,7 +344,31 @@ void CInterpolation::CalculateNodeCoordinateSystem(const vector<CNode> &MasterNo
 	}
 }
 
-vector<CSlaveNode> CInterpolation::CalcSlaveNodePositions( const vector<CNode> &MasterNodes, vector<double> &LValues, vector<double> &TValues, double dL, int iNumNodes, int iNumPoints ) const
+void CInterpolation::GetTangentAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const
+{
+	// Find the nodes whose tangent is calculated using the position of iNode, following the same rules
+	// as CalculateNodeCoordinateSystem. The yarn repeat depends on the first and last nodes.
+	vector<bool> Nodes(iNumNodes, false);
+	bool bEndNode = (iNode == 0 || iNode == iNumNodes-1);
+	int i;
+	for (i=0; i<iNumNodes; ++i)
+	{
+		if (i == iNode || i == iNode-1 || i == iNode+1)
+			Nodes[i] = true;
+		else if (m_bPeriodic && i == 0 && (iNode == iNumNodes-2 || bEndNode))
+			Nodes[i] = true;
+		else if (m_bPeriodic && i == iNumNodes-1 && (iNode == 1 || bEndNode))
+			Nodes[i] = true;
+	}
+
+	Segments.assign(iNumNodes-1, false);
+	for (i=0; i<iNumNodes-1; ++i)
+	{
+		Segments[i] = Nodes[i] || Nodes[i+1];
+	}
+}
+
+vector<CSlaveNode> CInterpolation::CalcSlaveNodePositions( const vector<CNode> &MasterNodes, const CInterpolationData &Data, vector<double> &LValues, vector<double> &TValues, double dL, int iNumNodes, int iNumPoints ) const
 {
 	
 	vector<CSlaveNode> SlaveNodes;
@@ -342,7 +398,7 @@ vector<CSlaveNode> CInterpolation::CalcSlaveNodePositions( const vector<CNode> &
 				j++;
 			}
 		}
-		CSlaveNode SlaveNode = GetNode(MasterNodes, t);             
+		CSlaveNode SlaveNode = GetNode(MasterNodes, Data, t);             
 		SlaveNodes.push_back(SlaveNode);
 	}
 	return SlaveNodes;
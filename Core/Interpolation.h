@@ -19,11 +19,31 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #pragma once
 #include "SlaveNode.h"
+#include <memory>
 
 namespace TexGen
 {
 	using namespace std;
 
+	/// Data calculated once by an interpolation for a given set of master nodes
+	/**
+	Interpolations which need to calculate things for the whole yarn store them in a class
+	derived from this. The data is never modified once created so it can be shared between
+	copies of a yarn and used by several threads at once.
+	*/
+	class CLASS_DECLSPEC CInterpolationData
+	{
+	public:
+		virtual ~CInterpolationData() {}
+	};
+
+	/// Interpolation data holding a tangent for each master node
+	class CLASS_DECLSPEC CInterpolationTangents : public CInterpolationData
+	{
+	public:
+		vector<XYZ> Tangents;
+	};
+
 	/// Abstract base class for describing the yarn path interpolations
 	/**
 	Given the master nodes of a yarn, this class should be able to interpolated
@@ -55,9 +75,41 @@ namespace TexGen
 		/// Get a list of nodes along the centre line of the yarn
 		vector<CSlaveNode> GetSlaveNodes(const vector<CNode> &MasterNodes, int iNumPoints, bool bEquiSpaced = true) const;
 
-		/// If the interpolation function needs to calculate some things just once for
-		/// the whole yarn it should be done here
-		virtual void Initialise(const vector<CNode> &MasterNodes) const {};
+		/// Get a list of nodes along the centre line of the yarn using data calculated by CreateData
+		/**
+		The interpolation isn't modified so this may be called from several threads at once.
+		*/
+		vector<CSlaveNode> GetSlaveNodes(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints, bool bEquiSpaced = true) const;
+
+		/// Calculate the things needed just once for the whole yarn
+		/**
+		The default implementation returns empty data for interpolations which don't need any.
+		*/
+		virtual shared_ptr<const CInterpolationData> CreateData(const vector<CNode> &MasterNodes) const;
+
+		/// Find the segments of the yarn which change when a single master node is modified
+		/**
+		A segment is the part of the yarn between two master nodes. The default implementation assumes
+		that every segment may change.
+		\param iNumNodes The number of master nodes
+		\param iNode Index of the master node which is modified
+		\param Segments Set to true for the segments which depend on the master node, resized to iNumNodes-1
+		\return false if the whole yarn may change, Segments is then left unmodified
+		*/
+		virtual bool GetAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const { return false; }
+
+		/// Calculate and store the data for the master nodes, used by the GetNode functions which aren't given data
+		void Initialise(const vector<CNode> &MasterNodes) const;
+
+		/// Get a node from parametric function using data calculated by CreateData
+		/**
+		The interpolation isn't modified so this may be called from several threads at once.
+		\param MasterNodes The nodes which need to be interpolated
+		\param Data The data returned by CreateData for the same master nodes
+		\param iIndex The section between which the interpolation should be made
+		\param t The interpolation parameter which is 0 to 1 from the start of the section to the end of the section
+		*/
+		virtual CSlaveNode GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const = 0;
 
 		/// Get a node from parametric function. Initialise should be called first.
 		/**
@@ -67,7 +119,7 @@ namespace TexGen
 		\param iIndex The section between which the interpolation should be made
 		\param t The interpolation parameter which is 0 to 1 from the start of the section to the end of the section
 		*/
-		virtual CSlaveNode GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const = 0;
+		CSlaveNode GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const;
 
 		/// Get a node from parametric function. Initialise should be called first.
 		/**
@@ -78,6 +130,14 @@ namespace TexGen
 		*/
 		CSlaveNode GetNode(const vector<CNode> &MasterNodes, double t) const;
 
+		/// Get a node from parametric function using data calculated by CreateData
+		/**
+		\param MasterNodes The nodes which need to be interpolated
+		\param Data The data returned by CreateData for the same master nodes
+		\param t The interpolation parameter which is 0 to 1 from the start of the yarn to the end of the yarn
+		*/
+		CSlaveNode GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, double t) const;
+
 	//	/// Get the length of the centreline by spliting up the interpolation function with straight lines
 	//	double GetLength(vector<CNode> &MasterNodes);
 
@@ -89,10 +149,10 @@ namespace TexGen
 
 	protected:
 		/// Create slave nodes with specified number of points between master nodes
-		void CreateSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, int iNumPoints) const;
+		void CreateSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints) const;
 
 		/// Create slave nodes equispaced with total specified number of points
-		bool CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, int iNumPoints) const;
+		bool CreateEquiSpacedSlaveNodes(vector<CSlaveNode> &SlaveNodes, const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iNumPoints) const;
 
 		static void InterpolateUp(const CNode &Node1, const CNode &Node2, CSlaveNode &SlaveNode, double t);
 		static void InterpolateAngle(const CNode &Node1, const CNode &Node2, CSlaveNode &SlaveNode, double t);
@@ -101,12 +161,20 @@ namespace TexGen
 		/// without user input for the parent nodes within the current yarn. It may be desirable to give more control to the user.
 		void CalculateNodeCoordinateSystem(const vector<CNode> &MasterNodes, vector<XYZ> &Tangents) const;
 
+		/// Find the segments which change when a master node is modified for interpolations using CalculateNodeCoordinateSystem
+		/**
+		Each segment depends on its two master nodes and their tangents. The tangent of a node depends on the
+		node either side of it, including the repeated nodes at the ends of periodic yarns.
+		*/
+		void GetTangentAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const;
+
 		/// 
-		vector<CSlaveNode> CalcSlaveNodePositions( const vector<CNode> &MasterNodes, vector<double> &LValues, vector<double> &TValues, double dL, int iNumNodes, int iNumPoints ) const;
+		vector<CSlaveNode> CalcSlaveNodePositions( const vector<CNode> &MasterNodes, const CInterpolationData &Data, vector<double> &LValues, vector<double> &TValues, double dL, int iNumNodes, int iNumPoints ) const;
 
 		bool m_bPeriodic;
 		bool m_bForceInPlaneTangent;  // Forces both slave and master nodes to have in-plane tangents
 		bool m_bForceMasterNodeTangent;  // Forces master nodes to have in-plane tangents
+		mutable shared_ptr<const CInterpolationData> m_pData;	///< Data stored by Initialise
 	};
 
 };	// namespace TexGen
@@ -73,9 +73,9 @@ void CInterpolationAdjusted::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_
 	Element.InsertEndChild(Interpolation);
 }
 
-CSlaveNode CInterpolationAdjusted::GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const
+CSlaveNode CInterpolationAdjusted::GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const
 {
-	CSlaveNode Node = m_pInterpolation->GetNode(MasterNodes, iIndex, t);
+	CSlaveNode Node = m_pInterpolation->GetNode(MasterNodes, Data, iIndex, t);
 
 	if (iIndex < 0 || iIndex >= (int)m_Adjustments.size())
 	{
@@ -89,9 +89,14 @@ CSlaveNode CInterpolationAdjusted::GetNode(const vector<CNode> &MasterNodes, int
 	return Node;
 }
 
-void CInterpolationAdjusted::Initialise(const vector<CNode> &MasterNodes) const
+shared_ptr<const CInterpolationData> CInterpolationAdjusted::CreateData(const vector<CNode> &MasterNodes) const
 {
-	m_pInterpolation->Initialise(MasterNodes);
+	return m_pInterpolation->CreateData(MasterNodes);
+}
+
+bool CInterpolationAdjusted::GetAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const
+{
+	return m_pInterpolation->GetAffectedSegments(iNumNodes, iNode, Segments);
 }
 
 void CInterpolationAdjusted::AddAdjustment(int iIndex, double t, XYZ Vector)
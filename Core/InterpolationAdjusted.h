@@ -36,11 +36,15 @@ namespace TexGen
 		string GetType() const { return "CInterpolationAdjusted"; }
 		void PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType) const;
 
-		/// Calculate the node tangents (use node tangents of they exist) and store them in m_Tangents
-		void Initialise(const vector<CNode> &MasterNodes) const;
+		/// Calculate the data of the interpolation being adjusted
+		shared_ptr<const CInterpolationData> CreateData(const vector<CNode> &MasterNodes) const;
+
+		/// The adjustments belong to the segments so the same segments change as for the interpolation being adjusted
+		bool GetAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const;
 
 		/// Get a node from parametric function where t is specified
-		CSlaveNode GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const;
+		CSlaveNode GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const;
+		using CInterpolation::GetNode;
 
 		/// At given index and value t the position of the node should be adjusted by given vector
 		void AddAdjustment(int iIndex, double t, XYZ Vector);
@@ -36,14 +36,15 @@ namespace TexGen
 		string GetType() const { return "CInterpolationBezier"; }
 //		void PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType) const;
 
-		/// Calculate the node tangents (use node tangents of they exist) and store them in m_Tangents
-		void Initialise(const vector<CNode> &MasterNodes) const;
+		/// Calculate the node tangents (use node tangents of they exist)
+		shared_ptr<const CInterpolationData> CreateData(const vector<CNode> &MasterNodes) const;
 
-		/// Get a node from parametric function where t is specified
-		CSlaveNode GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const;
+		/// Segments change only near the modified node since the tangents are found from the neighbouring nodes
+		bool GetAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const;
 
-	protected:
-		mutable vector<XYZ> m_Tangents;
+		/// Get a node from parametric function where t is specified
+		CSlaveNode GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const;
+		using CInterpolation::GetNode;
 	};
 
 };	// namespace TexGen
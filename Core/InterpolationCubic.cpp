@@ -42,25 +42,23 @@ void CInterpolationCubic::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYP
 {
 }*/
 
-CSlaveNode CInterpolationCubic::GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const
+CSlaveNode CInterpolationCubic::GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const
 {
 	assert(iIndex >= 0 && iIndex < int(MasterNodes.size()-1));
-	// Errors may occur here if the Initialise function was not called before
-	// calling this function. For performance reasons it is necessary to call
-	// initialise once at the start before making calls to this function
-	assert(m_XCubics.size() == MasterNodes.size()-1);
-	assert(m_YCubics.size() == MasterNodes.size()-1);
-	assert(m_ZCubics.size() == MasterNodes.size()-1);
+	const CCubicData &Cubics = static_cast<const CCubicData&>(Data);
+	assert(Cubics.XCubics.size() == MasterNodes.size()-1);
+	assert(Cubics.YCubics.size() == MasterNodes.size()-1);
+	assert(Cubics.ZCubics.size() == MasterNodes.size()-1);
 
 	XYZ Pos, Tangent;
 
-	Pos.x = m_XCubics[iIndex].Evaluate(t);
-	Pos.y = m_YCubics[iIndex].Evaluate(t);
-	Pos.z = m_ZCubics[iIndex].Evaluate(t);
+	Pos.x = Cubics.XCubics[iIndex].Evaluate(t);
+	Pos.y = Cubics.YCubics[iIndex].Evaluate(t);
+	Pos.z = Cubics.ZCubics[iIndex].Evaluate(t);
 
-	Tangent.x = m_XCubics[iIndex].EvaluateDerivative(t);
-	Tangent.y = m_YCubics[iIndex].EvaluateDerivative(t);
-	Tangent.z = m_ZCubics[iIndex].EvaluateDerivative(t);
+	Tangent.x = Cubics.XCubics[iIndex].EvaluateDerivative(t);
+	Tangent.y = Cubics.YCubics[iIndex].EvaluateDerivative(t);
+	Tangent.z = Cubics.ZCubics[iIndex].EvaluateDerivative(t);
 
 	if (m_bForceInPlaneTangent)
 		Tangent.z = 0;
@@ -78,8 +76,9 @@ CSlaveNode CInterpolationCubic::GetNode(const vector<CNode> &MasterNodes, int iI
 	return NewNode;
 }
 
-void CInterpolationCubic::Initialise(const vector<CNode> &MasterNodes) const
+shared_ptr<const CInterpolationData> CInterpolationCubic::CreateData(const vector<CNode> &MasterNodes) const
 {
+	shared_ptr<CCubicData> pCubics = make_shared<CCubicData>();
 	vector<double> X;
 	vector<double> Y;
 	vector<double> Z;
@@ -92,16 +91,17 @@ void CInterpolationCubic::Initialise(const vector<CNode> &MasterNodes) const
 	}
 	if (m_bPeriodic)
 	{
-		GetPeriodicCubicSplines(X, m_XCubics);
-		GetPeriodicCubicSplines(Y, m_YCubics);
-		GetPeriodicCubicSplines(Z, m_ZCubics);
+		GetPeriodicCubicSplines(X, pCubics->XCubics);
+		GetPeriodicCubicSplines(Y, pCubics->YCubics);
+		GetPeriodicCubicSplines(Z, pCubics->ZCubics);
 	}
 	else
 	{
-		GetNaturalCubicSplines(X, m_XCubics);
-		GetNaturalCubicSplines(Y, m_YCubics);
-		GetNaturalCubicSplines(Z, m_ZCubics);
+		GetNaturalCubicSplines(X, pCubics->XCubics);
+		GetNaturalCubicSplines(Y, pCubics->YCubics);
+		GetNaturalCubicSplines(Z, pCubics->ZCubics);
 	}
+	return pCubics;
 }
 
 void CInterpolationCubic::GetPeriodicCubicSplines(const vector<double> &Knots, vector<CUBICEQUATION> &Cubics)
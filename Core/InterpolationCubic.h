@@ -25,6 +25,10 @@ namespace TexGen
 	using namespace std;
 
 	/// Cubic spline interpolation for yarn paths
+	/**
+	The splines are continuous in their second derivative through all the master nodes, so moving one
+	master node changes every segment. GetAffectedSegments is therefore not overridden.
+	*/
 	class CLASS_DECLSPEC CInterpolationCubic :	public CInterpolation
 	{
 	public:
@@ -36,11 +40,12 @@ namespace TexGen
 		string GetType() const { return "CInterpolationCubic"; }
 //		void PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType) const;
 
-		/// Create the spline cubic equations and store them in m_?Cubics
-		void Initialise(const vector<CNode> &MasterNodes) const;
+		/// Create the spline cubic equations
+		shared_ptr<const CInterpolationData> CreateData(const vector<CNode> &MasterNodes) const;
 
 		/// Get a node from parametric function where t is specified
-		CSlaveNode GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const;
+		CSlaveNode GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const;
+		using CInterpolation::GetNode;
 
 	protected:
 		/// Struct to represent a cubic equation
@@ -67,12 +72,17 @@ namespace TexGen
 			double m_a, m_b, m_c, m_d;
 		};
 
+		/// The spline cubic equations for each section of the yarn
+		class CCubicData : public CInterpolationData
+		{
+		public:
+			vector<CUBICEQUATION> XCubics;
+			vector<CUBICEQUATION> YCubics;
+			vector<CUBICEQUATION> ZCubics;
+		};
+
 		static void GetPeriodicCubicSplines(const vector<double> &Knots, vector<CUBICEQUATION> &Cubics);
 		static void GetNaturalCubicSplines(const vector<double> &Knots, vector<CUBICEQUATION> &Cubics);
-
-		mutable vector<CUBICEQUATION> m_XCubics;
-		mutable vector<CUBICEQUATION> m_YCubics;
-		mutable vector<CUBICEQUATION> m_ZCubics;
 	};
 
 };	// namespace TexGen
@@ -41,15 +41,11 @@ void CInterpolationLinear::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TY
 {
 }*/
 
-CSlaveNode CInterpolationLinear::GetNode(const vector<CNode> &MasterNodes, int iIndex, double t) const
+CSlaveNode CInterpolationLinear::GetNode(const vector<CNode> &MasterNodes, const CInterpolationData &Data, int iIndex, double t) const
 {
 	assert(iIndex >= 0 && iIndex < int(MasterNodes.size()-1));
-	// Errors may occur here if the Initialise function was not called before
-	// calling this function. For performance reasons it is necessary to call
-	// initialise once at the start before making calls to this function
-	if ( m_Tangents.empty() )
-		Initialise( MasterNodes );
-	assert(m_Tangents.size() == MasterNodes.size());
+	const vector<XYZ> &Tangents = static_cast<const CInterpolationTangents&>(Data).Tangents;
+	assert(Tangents.size() == MasterNodes.size());
 
 	const CNode &Node1 = MasterNodes[iIndex];
 	const CNode &Node2 = MasterNodes[iIndex+1];
@@ -62,8 +58,8 @@ CSlaveNode CInterpolationLinear::GetNode(const vector<CNode> &MasterNodes, int i
 	// in the initialise function (optimise if this becomes an issue)
 	P1 = Node1.GetPosition();
 	P2 = Node2.GetPosition();
-	T1 = m_Tangents[iIndex];
-	T2 = m_Tangents[iIndex+1];
+	T1 = Tangents[iIndex];
+	T2 = Tangents[iIndex+1];
 
 	SlaveNodePos = P1 + (P2-P1)*t;
 	SlaveTangent = T1 + (T2-T1)*t;
@@ -84,9 +80,17 @@ CSlaveNode CInterpolationLinear::GetNode(const vector<CNode> &MasterNodes, int i
 	return NewNode;
 }
 
-void CInterpolationLinear::Initialise(const vector<CNode> &MasterNodes) const
+shared_ptr<const CInterpolationData> CInterpolationLinear::CreateData(const vector<CNode> &MasterNodes) const
 {
-	CalculateNodeCoordinateSystem(MasterNodes, m_Tangents);
+	shared_ptr<CInterpolationTangents> pTangents = make_shared<CInterpolationTangents>();
+	CalculateNodeCoordinateSystem(MasterNodes, pTangents->Tangents);
+	return pTangents;
+}
+
+bool CInterpolationLinear::GetAffectedSegments(int iNumNodes, int iNode, vector<bool> &Segments) const
+{
+	GetTangentAffectedSegments(iNumNodes, iNode, Segments);
+	return true;
 }
 
 
@@ -58,12 +58,53 @@ void CLoggerScreen::TexGenLog(std::string FileName, int iLineNumber, std::string
 	std::cout << Message << std::endl;
 }
 
+void CLoggerBuffer::TexGenError(std::string FileName, int iLineNumber, std::string Message)
+{
+	MESSAGE Stored = { true, FileName, iLineNumber, Message, m_iIndent };
+	m_Messages.push_back(Stored);
+}
+
+void CLoggerBuffer::TexGenLog(std::string FileName, int iLineNumber, std::string Message)
+{
+	MESSAGE Stored = { false, FileName, iLineNumber, Message, m_iIndent };
+	m_Messages.push_back(Stored);
+}
+
+void CLoggerBuffer::Flush()
+{
+	CLogger &Logger = GetLogger();
+	std::vector<MESSAGE>::const_iterator itMessage;
+	for (itMessage = m_Messages.begin(); itMessage != m_Messages.end(); ++itMessage)
+	{
+		int i;
+		for (i=0; i<itMessage->iIndent; ++i)
+			Logger.IncreaseIndent();
+		if (itMessage->bError)
+			Logger.TexGenError(itMessage->FileName, itMessage->iLineNumber, itMessage->Message);
+		else
+			Logger.TexGenLog(itMessage->FileName, itMessage->iLineNumber, itMessage->Message);
+		for (i=0; i<itMessage->iIndent; ++i)
+			Logger.DecreaseIndent();
+	}
+	m_Messages.clear();
+}
+
 namespace TexGen
 {
+	// Logger that replaces the TexGen logger on the current thread, if any
+	static thread_local CLogger *t_pThreadLogger = NULL;
+
 	CLogger &GetLogger()
 	{
+		if (t_pThreadLogger)
+			return *t_pThreadLogger;
 		return TEXGEN.GetLogger();
 	}
+
+	void SetThreadLogger(CLogger *pLogger)
+	{
+		t_pThreadLogger = pLogger;
+	}
 }
 
 
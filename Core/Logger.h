@@ -119,7 +119,41 @@ namespace TexGen
 	protected:
 	};
 
+	/// Logger used to hold on to log and error messages until they are passed on to another logger
+	/**
+	Messages are stored with the indentation they were logged with relative to this logger and
+	Flush passes them on to the logger returned by GetLogger() at the time it is called.
+	*/
+	class CLASS_DECLSPEC CLoggerBuffer : public CLogger
+	{
+	public:
+		CLogger *Copy() const { return new CLoggerBuffer(*this); }
+		void TexGenError(std::string FileName, int iLineNumber, std::string Message);
+		void TexGenLog(std::string FileName, int iLineNumber, std::string Message);
+		/// Pass the stored messages on to the current logger in the order they were logged
+		void Flush();
+
+	protected:
+		struct MESSAGE
+		{
+			bool bError;
+			std::string FileName;
+			int iLineNumber;
+			std::string Message;
+			int iIndent;
+		};
+		std::vector<MESSAGE> m_Messages;
+	};
+
+	/// Get the logger that messages logged on the calling thread are sent to
 	CLASS_DECLSPEC CLogger &GetLogger();
+
+	/// Send the messages logged on the calling thread to pLogger rather than the TexGen logger
+	/**
+	This is used to keep loggers, which need not be thread safe, from being called by worker threads.
+	\param pLogger Logger owned by the caller, or NULL to go back to using the TexGen logger
+	*/
+	CLASS_DECLSPEC void SetThreadLogger(CLogger *pLogger);
 };	// namespace TexGen
 
 
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "MeshOctreeClasses.h"
 #include "Textile.h"
 #include "TexGen.h"
+#include <unordered_map>
 
 using namespace TexGen;
 extern "C"
@@ -64,7 +65,7 @@ void CMesh::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType)
 		Element.InsertEndChild(Node);
 	}
 	int i;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	for (i=0; i<NUM_ELEMENT_TYPES; ++i)
 	{
 		TiXmlElement Indices("Element");
@@ -94,7 +95,7 @@ void CMesh::InsertMesh(const CMesh &Mesh, XYZ Offset)
 {
 	int iOffset = InsertNodes(Mesh, Offset);
 	int i;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	for (i=0; i<NUM_ELEMENT_TYPES; ++i)
 	{
 		for (itIndex = Mesh.m_Indices[i].begin(); itIndex != Mesh.m_Indices[i].end(); ++itIndex)
@@ -107,7 +108,7 @@ void CMesh::InsertMesh(const CMesh &Mesh, XYZ Offset)
 void CMesh::ChangeNodeIndices(int iChangeTo, int iChangeFrom)
 {
 	int i;
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	for (i=0; i<NUM_ELEMENT_TYPES; ++i)
 	{
 		for (itIndex = m_Indices[i].begin(); itIndex != m_Indices[i].end(); ++itIndex)
@@ -133,208 +134,270 @@ void CMesh::ChangeNodeIndices(int iChangeTo, int iChangeFrom, vector<vector<int*
 	ChangeFromPointers.clear();
 }
 
-void CMesh::RemoveOpposingTriangles()
+void CMesh::GetElementKeys(ELEMENT_TYPE ElementType, KEY_TYPE KeyType, vector<int> &Keys) const
 {
-	list<int> &TriangleIndices = m_Indices[TRI];
-	int i1[3];
-	int i2[3];
-	list<int>::iterator itIter1, itIter2;
-	list<int>::iterator itTriStart1, itTriStart2;
-//	int iCommonNodes;
-//	int i, j;
-	for (itIter1 = TriangleIndices.begin(); itIter1 != TriangleIndices.end(); )
-	{
-		itTriStart1 = itIter1;
-		i1[0] = *(itIter1++);
-		i1[1] = *(itIter1++);
-		i1[2] = *(itIter1++);
-		for (itIter2 = itIter1; itIter2 != TriangleIndices.end(); )
+	const vector<int> &Indices = m_Indices[ElementType];
+	int iNumNodes = GetNumNodes(ElementType);
+	Keys = Indices;
+	if (KeyType == KEY_ORDERED)
+		return;
+	int iNumElements = (int)Keys.size()/iNumNodes;
+	vector<int> Rotation(iNumNodes);
+	int i, j, k;
+	for (i = 0; i < iNumElements; ++i)
+	{
+		vector<int>::iterator itKey = Keys.begin()+i*iNumNodes;
+		if (KeyType == KEY_SORTED)
 		{
-			itTriStart2 = itIter2;
-			i2[0] = *(itIter2++);
-			i2[1] = *(itIter2++);
-			i2[2] = *(itIter2++);
-
-			if (i1[0] == i2[0] && i1[1] == i2[2] && i1[2] == i2[1] ||
-				i1[0] == i2[1] && i1[1] == i2[0] && i1[2] == i2[2] ||
-				i1[0] == i2[2] && i1[1] == i2[1] && i1[2] == i2[0])
+			sort(itKey, itKey+iNumNodes);
+			continue;
+		}
+		if (KeyType == KEY_REVERSED_CYCLE)
+			reverse(itKey, itKey+iNumNodes);
+		// Start the cycle from the rotation which is lexicographically smallest
+		int iStart = 0;
+		for (j = 1; j < iNumNodes; ++j)
+		{
+			for (k = 0; k < iNumNodes; ++k)
 			{
-				TriangleIndices.erase(itTriStart1, itIter1);
-				if (itIter1 == itTriStart2)
-					itIter1 = TriangleIndices.erase(itTriStart2, itIter2);
-				else
-					TriangleIndices.erase(itTriStart2, itIter2);
-				//continue;
-				break;
+				int iCompare = *(itKey+(j+k)%iNumNodes) - *(itKey+(iStart+k)%iNumNodes);
+				if (iCompare < 0)
+					iStart = j;
+				if (iCompare)
+					break;
 			}
-		}		
+		}
+		for (k = 0; k < iNumNodes; ++k)
+			Rotation[k] = *(itKey+(iStart+k)%iNumNodes);
+		copy(Rotation.begin(), Rotation.end(), itKey);
+	}
+}
+
+/// Hashes a key of fixed size stored contiguously in a vector, identified by its position
+struct ElementKeyHash
+{
+	ElementKeyHash(const vector<int> &Keys, int iKeySize) : m_Keys(Keys), m_iKeySize(iKeySize) {}
+	size_t operator()(int iKey) const
+	{
+		size_t Hash = 14695981039346656037ULL;
+		const int *pKey = &m_Keys[iKey*m_iKeySize];
+		for (int i = 0; i < m_iKeySize; ++i)
+		{
+			Hash ^= (size_t)(unsigned int)pKey[i];
+			Hash *= 1099511628211ULL;
+		}
+		return Hash;
+	}
+	const vector<int> &m_Keys;
+	int m_iKeySize;
+};
+
+/// Checks whether two keys of fixed size stored contiguously in a vector are equal
+struct ElementKeyEqual
+{
+	ElementKeyEqual(const vector<int> &Keys, int iKeySize) : m_Keys(Keys), m_iKeySize(iKeySize) {}
+	bool operator()(int iKey1, int iKey2) const
+	{
+		return equal(m_Keys.begin()+iKey1*m_iKeySize, m_Keys.begin()+(iKey1+1)*m_iKeySize, m_Keys.begin()+iKey2*m_iKeySize);
+	}
+	const vector<int> &m_Keys;
+	int m_iKeySize;
+};
+
+int CMesh::GetKeyIds(const vector<int> &Keys, int iKeySize, vector<int> &Ids)
+{
+	int iNumKeys = (int)Keys.size()/iKeySize;
+	unordered_map<int, int, ElementKeyHash, ElementKeyEqual> KeyIds(iNumKeys, ElementKeyHash(Keys, iKeySize), ElementKeyEqual(Keys, iKeySize));
+	Ids.resize(iNumKeys);
+	int i;
+	for (i = 0; i < iNumKeys; ++i)
+	{
+		Ids[i] = KeyIds.insert(make_pair(i, (int)KeyIds.size())).first->second;
+	}
+	return (int)KeyIds.size();
+}
+
+int CMesh::GetOpposingKeyIds(ELEMENT_TYPE ElementType, vector<int> &Ids, vector<int> &OpposingIds) const
+{
+	int iNumNodes = GetNumNodes(ElementType);
+	int iNumElements = (int)m_Indices[ElementType].size()/iNumNodes;
+	// Put the keys of the elements and of the reversed elements in the same list so that
+	// the ids of both can be compared
+	vector<int> Keys, ReversedKeys;
+	GetElementKeys(ElementType, KEY_CYCLE, Keys);
+	GetElementKeys(ElementType, KEY_REVERSED_CYCLE, ReversedKeys);
+	Keys.insert(Keys.end(), ReversedKeys.begin(), ReversedKeys.end());
+	int iNumIds = GetKeyIds(Keys, iNumNodes, Ids);
+	OpposingIds.assign(Ids.begin()+iNumElements, Ids.end());
+	Ids.resize(iNumElements);
+	return iNumIds;
+}
+
+void CMesh::RemoveOpposingElements(ELEMENT_TYPE ElementType)
+{
+	if (ElementType != TRI && ElementType != QUAD)
+	{
+		TGERROR("Unable to remove opposing elements, only supported for triangles and quads");
+		return;
+	}
+	vector<int> Ids, OpposingIds;
+	int iNumIds = GetOpposingKeyIds(ElementType, Ids, OpposingIds);
+	int iNumElements = (int)Ids.size();
+	vector<bool> Removed(iNumElements, false);
+	// Each element cancels out the earliest element before it with the opposite orientation which
+	// hasn't already been cancelled. The elements waiting to be cancelled are stored per key.
+	vector<vector<int> > Unmatched(iNumIds);
+	vector<int> FirstUnmatched(iNumIds, 0);
+	int i;
+	for (i = 0; i < iNumElements; ++i)
+	{
+		int iOpposingId = OpposingIds[i];
+		if (FirstUnmatched[iOpposingId] < (int)Unmatched[iOpposingId].size())
+		{
+			Removed[Unmatched[iOpposingId][FirstUnmatched[iOpposingId]++]] = true;
+			Removed[i] = true;
+		}
+		else
+			Unmatched[Ids[i]].push_back(i);
 	}
+	RemoveElements(ElementType, Removed);
+}
+
+void CMesh::RemoveOpposingTriangles()
+{
+	RemoveOpposingElements(TRI);
 }
 
 void CMesh::RemoveOpposingQuads()
 {
-	list<int> &QuadIndices = m_Indices[QUAD];
-	int i1[4];
-	int i2[4];
-	list<int>::iterator itIter1, itIter2;
-	list<int>::iterator itQuadStart1, itQuadStart2;
-//	int iCommonNodes;
-//	int i, j;
-	for (itIter1 = QuadIndices.begin(); itIter1 != QuadIndices.end(); )
-	{
-		itQuadStart1 = itIter1;
-		i1[0] = *(itIter1++);
-		i1[1] = *(itIter1++);
-		i1[2] = *(itIter1++);
-		i1[3] = *(itIter1++);
-		for (itIter2 = itIter1; itIter2 != QuadIndices.end(); )
+	vector<int> Ids, OpposingIds;
+	int iNumIds = GetOpposingKeyIds(QUAD, Ids, OpposingIds);
+	int iNumElements = (int)Ids.size();
+	vector<bool> Removed(iNumElements, false);
+	// The first quad of each set with the same nodes is removed along with all the quads
+	// opposing it
+	vector<int> Count(iNumIds, 0);
+	vector<bool> Visited(iNumIds, false), RemoveId(iNumIds, false);
+	int i;
+	for (i = 0; i < iNumElements; ++i)
+		++Count[Ids[i]];
+	for (i = 0; i < iNumElements; ++i)
+	{
+		int iId = Ids[i], iOpposingId = OpposingIds[i];
+		if (Visited[iId] || Visited[iOpposingId])
+			continue;
+		Visited[iId] = Visited[iOpposingId] = true;
+		if (Count[iOpposingId] > (iId == iOpposingId ? 1 : 0))
 		{
-			itQuadStart2 = itIter2;
-			i2[0] = *(itIter2++);
-			i2[1] = *(itIter2++);
-			i2[2] = *(itIter2++);
-			i2[3] = *(itIter2++);
-
-			if (i1[0] == i2[0] && i1[1] == i2[3] && i1[2] == i2[2] && i1[3] == i2[1] ||
-				i1[0] == i2[1] && i1[1] == i2[0] && i1[2] == i2[3] && i1[3] == i2[2] ||
-				i1[0] == i2[2] && i1[1] == i2[1] && i1[2] == i2[0] && i1[3] == i2[3] ||
-				i1[0] == i2[3] && i1[1] == i2[2] && i1[2] == i2[1] && i1[3] == i2[0])
-			{
-				QuadIndices.erase(itQuadStart1, itIter1);
-				if (itIter1 == itQuadStart2)
-					itIter1 = QuadIndices.erase(itQuadStart2, itIter2);
-				else
-					QuadIndices.erase(itQuadStart2, itIter2);
-				continue;
-			}
-		}		
+			Removed[i] = true;
+			RemoveId[iOpposingId] = true;
+		}
 	}
+	for (i = 0; i < iNumElements; ++i)
+	{
+		if (RemoveId[Ids[i]])
+			Removed[i] = true;
+	}
+	RemoveElements(QUAD, Removed);
 }
 
 void CMesh::RemoveDegenerateTriangles()
 {
-	list<int> &TriangleIndices = m_Indices[TRI];
-	list<int>::iterator itIter, itTriStart;
+	const vector<int> &TriangleIndices = m_Indices[TRI];
+	int iNumTriangles = (int)TriangleIndices.size()/3;
+	vector<bool> Removed(iNumTriangles, false);
 	int i1;
 	int i2;
 	int i3;
-	for (itIter = TriangleIndices.begin(); itIter != TriangleIndices.end(); )
+	int iTri;
+	for (iTri = 0; iTri < iNumTriangles; ++iTri)
 	{
-		itTriStart = itIter;
-		i1 = *(itIter++);
-		i2 = *(itIter++);
-		i3 = *(itIter++);
+		i1 = TriangleIndices[iTri*3];
+		i2 = TriangleIndices[iTri*3+1];
+		i3 = TriangleIndices[iTri*3+2];
 		if (i1 == i2 || i2 == i3 || i3 == i1)
 		{
-			itIter = TriangleIndices.erase(itTriStart, itIter);
+			Removed[iTri] = true;
 		}
 	}
+	RemoveElements(TRI, Removed);
 }
 
 void CMesh::RemoveDuplicateElements(CMesh::ELEMENT_TYPE ElementType)
 {
-	list<int> &ElementIndices = m_Indices[ElementType];
-	vector<int> Index1;
-	vector<int> Index2;
-	list<int>::iterator itIter1, itIter2;
-	list<int>::iterator itStart1, itStart2;
-
-	for (itIter1 = ElementIndices.begin(); itIter1 != ElementIndices.end(); )
+	int iNumNodes = GetNumNodes(ElementType);
+	if (iNumNodes <= 0)
 	{
-		itStart1 = itIter1;
-		Index1.clear();
-		for ( int i=0; i < GetNumNodes(ElementType); ++i )
-		{
-			Index1.push_back( *(itIter1++));
-		}
-		sort( Index1.begin(), Index1.end() ); 
-		for (itIter2 = itIter1; itIter2 != ElementIndices.end(); )
-		{
-			itStart2 = itIter2;
-			Index2.clear();
-			for ( int j=0; j < GetNumNodes(ElementType); ++j )
-			{
-				Index2.push_back( *(itIter2++));
-			}
-			sort( Index2.begin(), Index2.end() );
-
-			if ( equal( Index1.begin(), Index1.end(), Index2.begin() ) )
-			{
-				if (itIter1 == itStart2)
-				{
-					itIter1 = ElementIndices.erase(itStart2, itIter2);
-					itIter2 = itIter1;
-				}
-				else
-					itIter2 = ElementIndices.erase(itStart2, itIter2);
-				//continue;
-			}
-		}		
+		TGERROR("Unable to remove duplicate elements of variable size");
+		return;
 	}
+	vector<int> Keys, Ids;
+	GetElementKeys(ElementType, KEY_SORTED, Keys);
+	int iNumIds = GetKeyIds(Keys, iNumNodes, Ids);
+	// Keep the first copy of each element
+	vector<bool> Removed(Ids.size(), false), Found(iNumIds, false);
+	int i;
+	for (i = 0; i < (int)Ids.size(); ++i)
+	{
+		if (Found[Ids[i]])
+			Removed[i] = true;
+		Found[Ids[i]] = true;
+	}
+	RemoveElements(ElementType, Removed);
 }
 
 void CMesh::RemoveDuplicateTriangles()
 {
-	list<int> &TriangleIndices = m_Indices[TRI];
-	int i1[3];
-	int i2[3];
-	list<int>::iterator itIter1, itIter2;
-	list<int>::iterator itTriStart1, itTriStart2;
-//	int iCommonNodes;
-//	int i, j;
-	for (itIter1 = TriangleIndices.begin(); itIter1 != TriangleIndices.end(); )
-	{
-		itTriStart1 = itIter1;
-		i1[0] = *(itIter1++);
-		i1[1] = *(itIter1++);
-		i1[2] = *(itIter1++);
-		for (itIter2 = itIter1; itIter2 != TriangleIndices.end(); )
-		{
-			itTriStart2 = itIter2;
-			i2[0] = *(itIter2++);
-			i2[1] = *(itIter2++);
-			i2[2] = *(itIter2++);
-
-			if ( i1[0] == i2[0] && i1[1] == i2[1] && i1[2] == i2[2] )
-			{
-				//TriangleIndices.erase(itTriStart1, itIter1);
-				if (itIter1 == itTriStart2)
-				{
-					itIter1 = TriangleIndices.erase(itTriStart2, itIter2);
-					itIter2 = itIter1;
-				}
-				else
-					itIter2 = TriangleIndices.erase(itTriStart2, itIter2);
-				//continue;
-			}
-		}		
+	vector<int> Keys, Ids;
+	GetElementKeys(TRI, KEY_ORDERED, Keys);
+	int iNumIds = GetKeyIds(Keys, 3, Ids);
+	// Keep the first copy of each triangle
+	vector<bool> Removed(Ids.size(), false), Found(iNumIds, false);
+	int i;
+	for (i = 0; i < (int)Ids.size(); ++i)
+	{
+		if (Found[Ids[i]])
+			Removed[i] = true;
+		Found[Ids[i]] = true;
 	}
+	RemoveElements(TRI, Removed);
 }
 
 void CMesh::RemoveDuplicateSegments()
 {
-	list<int> &LineIndices = m_Indices[LINE];
-	list<int>::iterator itIter, itLineStart;
-	list<int>::iterator itCompare;
-	int i1, i2;
-	int j1, j2;
-	for (itIter = LineIndices.begin(); itIter != LineIndices.end(); )
+	vector<int> Keys, Ids;
+	GetElementKeys(LINE, KEY_SORTED, Keys);
+	int iNumIds = GetKeyIds(Keys, 2, Ids);
+	// Keep the last copy of each segment
+	vector<bool> Removed(Ids.size(), false), Found(iNumIds, false);
+	int i;
+	for (i = (int)Ids.size()-1; i >= 0; --i)
 	{
-		itLineStart = itIter;
-		i1 = *(itIter++);
-		i2 = *(itIter++);
-		for (itCompare = itIter; itCompare != LineIndices.end(); )
+		if (Found[Ids[i]])
+			Removed[i] = true;
+		Found[Ids[i]] = true;
+	}
+	RemoveElements(LINE, Removed);
+}
+
+void CMesh::RemoveElements(ELEMENT_TYPE ElementType, const vector<bool> &Removed)
+{
+	vector<int> &Indices = m_Indices[ElementType];
+	int iNumNodes = GetNumNodes(ElementType);
+	int iNumElements = (int)Indices.size()/iNumNodes;
+	int i, j, iNumKept = 0;
+	for (i = 0; i < iNumElements; ++i)
+	{
+		if (i < (int)Removed.size() && Removed[i])
+			continue;
+		if (iNumKept != i)
 		{
-			j1 = *(itCompare++);
-			j2 = *(itCompare++);
-			if ((i1 == j1 && i2 == j2) ||
-				(i1 == j2 && i2 == j1))
-			{
-				itIter = LineIndices.erase(itLineStart, itIter);
-				break;
-			}
+			for (j = 0; j < iNumNodes; ++j)
+				Indices[iNumKept*iNumNodes+j] = Indices[i*iNumNodes+j];
 		}
+		++iNumKept;
 	}
+	Indices.resize(iNumKept*iNumNodes);
 }
 
 pair<XYZ, XYZ> CMesh::GetAABB(double dGrowDistance) const
@@ -434,7 +497,7 @@ int CMesh::MergeNodes(const double TOL)
 	set<int> DeletedNodes;
 	//DeletedNodes.resize(m_Nodes.size(), false);
 	
-	map<ELEMENT_TYPE, list<int> >::iterator itType;
+	map<ELEMENT_TYPE, vector<int> >::iterator itType;
 	vector<XYZ>::iterator itNode1;
 	vector<XYZ>::iterator itNode2;
 	int iNode1, iNode2;
@@ -463,74 +526,144 @@ int CMesh::MergeNodes(const double TOL)
 vector<pair<int, int> > CMesh::GetNodePairs(XYZ Vector, const double TOL) const
 {
 	vector<pair<int, int> > NodePairs;
-	vector<XYZ>::const_iterator itNode1;
-	vector<XYZ>::const_iterator itNode2;
-	int iNode1, iNode2;
-	double dTolSquared = TOL*TOL;
-	for (itNode1 = m_Nodes.begin(), iNode1=0; itNode1 != m_Nodes.end(); ++itNode1, ++iNode1)
-	{
-		for (itNode2 = m_Nodes.begin(), iNode2=0; itNode2 != m_Nodes.end(); ++itNode2, ++iNode2)
-		{
-			if (GetLengthSquared(*itNode1, *itNode2-Vector) < dTolSquared)
-			{
-				NodePairs.push_back(make_pair(iNode1, iNode2));
-				break;
-			}
-		}
-	}
+	FindNodePairs(Vector, NodePairs, TOL, false);
 	return NodePairs;
 }
 
- void CMesh::GetNodePairs(XYZ Vector, vector<pair<int, int> > &NodePairs, const double TOL ) const
+void CMesh::GetNodePairs(XYZ Vector, vector<pair<int, int> > &NodePairs, const double TOL ) const
 {
-	vector<XYZ>::const_iterator itNode1;
-	vector<XYZ>::const_iterator itNode2;
+	// Matching node normally later in mesh than the node being checked so prefer those
+	FindNodePairs(Vector, NodePairs, TOL, true);
+}
 
-	vector<XYZ> OffsetNodes;
-	for ( itNode2 = m_Nodes.begin(); itNode2 != m_Nodes.end(); ++itNode2 )
-	{
-		OffsetNodes.push_back( *itNode2 - Vector );
+/// Get the index of the grid cell containing a coordinate, clamped to the grid
+static int GetNodeGridCell(double dValue, double dMin, double dInvCellSize, int iNumCells)
+{
+	int iCell = (int)floor((dValue-dMin)*dInvCellSize);
+	return max(0, min(iNumCells-1, iCell));
+}
+
+void CMesh::FindNodePairs(XYZ Vector, vector<pair<int, int> > &NodePairs, double TOL, bool bPreferLaterNodes) const
+{
+	if (m_Nodes.empty())
+		return;
+
+	// A pair can only be formed from nodes in the overlap of the mesh bounding box and the same box
+	// offset by -Vector. For periodic meshes this is a thin slab around the faces joined by Vector
+	// so only those nodes are placed in the grid and queried.
+	pair<XYZ, XYZ> AABB = GetAABB();
+	XYZ Size = AABB.second - AABB.first;
+	double dMaxSize = max(Size.x, max(Size.y, Size.z));
+	double dGrow = TOL + 1e-9*dMaxSize;
+	XYZ Min, Max;
+	int i, iAxis;
+	for (iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		Min[iAxis] = max(AABB.first[iAxis], AABB.first[iAxis]-Vector[iAxis]) - dGrow;
+		Max[iAxis] = min(AABB.second[iAxis], AABB.second[iAxis]-Vector[iAxis]) + dGrow;
+		if (Min[iAxis] > Max[iAxis])
+			return;
 	}
 
-	bool bProgress = m_Nodes.size() > 10000;
-	int iProgressInc = m_Nodes.size()/10;
+	vector<XYZ> OffsetNodes(m_Nodes.size());
+	vector<int> Candidates;
+	for (i = 0; i < (int)m_Nodes.size(); ++i)
+	{
+		OffsetNodes[i] = m_Nodes[i] - Vector;
+		if (OffsetNodes[i].x >= Min.x && OffsetNodes[i].y >= Min.y && OffsetNodes[i].z >= Min.z &&
+			OffsetNodes[i].x <= Max.x && OffsetNodes[i].y <= Max.y && OffsetNodes[i].z <= Max.z)
+			Candidates.push_back(i);
+	}
+	if (Candidates.empty())
+		return;
 
-	int iNode1, iNode2;
+	// Bin the offset candidate nodes in a uniform grid with roughly two cells per candidate,
+	// cells are never made smaller than the tolerance
+	XYZ GridSize = Max - Min;
+	double dMinSize = max(TOL, 1e-9*max(dMaxSize, 1.0));
+	for (iAxis = 0; iAxis < 3; ++iAxis)
+		GridSize[iAxis] = max(GridSize[iAxis], dMinSize);
+	double dTargetCells = min(2.0*Candidates.size(), 4.0e6);
+	double dCellSize = pow(GridSize.x*GridSize.y*GridSize.z/dTargetCells, 1.0/3.0);
+	int iNumCells[3];
+	double dInvCellSize[3];
+	for (iAxis = 0; iAxis < 3; ++iAxis)
+	{
+		iNumCells[iAxis] = max(1, min(1024, (int)(GridSize[iAxis]/max(dCellSize, TOL))));
+		dInvCellSize[iAxis] = iNumCells[iAxis]/GridSize[iAxis];
+	}
+
+	vector<int> CandidateCells(Candidates.size());
+	vector<int> CellStart(iNumCells[0]*iNumCells[1]*iNumCells[2]+1, 0);
+	for (i = 0; i < (int)Candidates.size(); ++i)
+	{
+		const XYZ &P = OffsetNodes[Candidates[i]];
+		CandidateCells[i] = (GetNodeGridCell(P.z, Min.z, dInvCellSize[2], iNumCells[2])*iNumCells[1] +
+			GetNodeGridCell(P.y, Min.y, dInvCellSize[1], iNumCells[1]))*iNumCells[0] +
+			GetNodeGridCell(P.x, Min.x, dInvCellSize[0], iNumCells[0]);
+		++CellStart[CandidateCells[i]+1];
+	}
+	for (i = 1; i < (int)CellStart.size(); ++i)
+		CellStart[i] += CellStart[i-1];
+	vector<int> CellEntries(Candidates.size());
+	vector<int> CellFill(CellStart.begin(), CellStart.end()-1);
+	for (i = 0; i < (int)Candidates.size(); ++i)
+		CellEntries[CellFill[CandidateCells[i]]++] = Candidates[i];
+
+	// For each node find the first matching node in the same search order as a linear scan, that is
+	// the lowest index or, if bPreferLaterNodes, the lowest index from the node itself onwards wrapping
+	// round to the start
+	int iNumNodes = (int)m_Nodes.size();
 	double dTolSquared = TOL*TOL;
-	bool bFound;
-	for (itNode1 = m_Nodes.begin(), iNode1=0; itNode1 != m_Nodes.end(); ++itNode1, ++iNode1)
+	int iRange[6];
+	int x, y, z, j;
+	int iNode1, iNode2, iRank, iBestRank, iBest;
+	for (iNode1 = 0; iNode1 < iNumNodes; ++iNode1)
 	{
-		if ( bProgress && !(iNode1 % iProgressInc) )
+		const XYZ &P = m_Nodes[iNode1];
+		if (P.x < Min.x || P.y < Min.y || P.z < Min.z || P.x > Max.x || P.y > Max.y || P.z > Max.z)
+			continue;
+		for (iAxis = 0; iAxis < 3; ++iAxis)
 		{
-			TGLOG( "GetNodePairs " << iNode1/iProgressInc*10 << "% complete");
+			iRange[iAxis] = GetNodeGridCell(P[iAxis]-TOL, Min[iAxis], dInvCellSize[iAxis], iNumCells[iAxis]);
+			iRange[iAxis+3] = GetNodeGridCell(P[iAxis]+TOL, Min[iAxis], dInvCellSize[iAxis], iNumCells[iAxis]);
 		}
-		bFound = false;
-		for ( iNode2 = iNode1; iNode2 < OffsetNodes.size(); ++ iNode2 )  // Matching node normally later in mesh than itNode1 so start checking here
-		{                                                                // to improve speed
-			if (GetLengthSquared(*itNode1, OffsetNodes[iNode2]) < dTolSquared)
-			{
-				NodePairs.push_back(make_pair(iNode1, iNode2));
-				bFound = true;
-				break;
-			}
-		}
-		if ( !bFound )
+		iBest = -1;
+		iBestRank = iNumNodes;
+		for (z = iRange[2]; z <= iRange[5]; ++z)
 		{
-			for ( iNode2 = 0; iNode2 < iNode1; ++iNode2 )   // Check from beginning if node earlier in mesh than one checking against
+			for (y = iRange[1]; y <= iRange[4]; ++y)
 			{
-				if (GetLengthSquared(*itNode1, OffsetNodes[iNode2]) < dTolSquared)
+				for (x = iRange[0]; x <= iRange[3]; ++x)
 				{
-					NodePairs.push_back(make_pair(iNode1, iNode2));
-					break;
+					int iCell = (z*iNumCells[1]+y)*iNumCells[0]+x;
+					for (j = CellStart[iCell]; j < CellStart[iCell+1]; ++j)
+					{
+						iNode2 = CellEntries[j];
+						iRank = iNode2;
+						if (bPreferLaterNodes)
+							iRank = iNode2 >= iNode1 ? iNode2-iNode1 : iNode2-iNode1+iNumNodes;
+						if (iRank < iBestRank && GetLengthSquared(P, OffsetNodes[iNode2]) < dTolSquared)
+						{
+							iBestRank = iRank;
+							iBest = iNode2;
+						}
+					}
 				}
 			}
 		}
+		if (iBest != -1)
+			NodePairs.push_back(make_pair(iNode1, iBest));
 	}
-	//return NodePairs;
 }
 
 int CMesh::GetClosestNode(XYZ Position) const
 {
+	if (UpdateNodeIndex())
+	{
+		double dDistSqrd;
+		return FindIndexedClosestNode(Position, dDistSqrd);
+	}
 	vector<XYZ>::const_iterator itNode;
 	double dClosestDistSqrd = -1;
 	double dDistSqrd;
@@ -549,6 +682,14 @@ int CMesh::GetClosestNode(XYZ Position) const
 
 int CMesh::GetClosestNodeDistance(XYZ Position, double dTol ) const
 {
+	if (UpdateNodeIndex())
+	{
+		double dDistSqrd;
+		int iClosestNode = FindIndexedClosestNode(Position, dDistSqrd);
+		if (iClosestNode != -1 && dDistSqrd <= dTol)
+			return iClosestNode;
+		return -1;
+	}
 	vector<XYZ>::const_iterator itNode;
 	double dClosestDistSqrd = -1;
 	double dDistSqrd;
@@ -566,6 +707,94 @@ int CMesh::GetClosestNodeDistance(XYZ Position, double dTol ) const
 	return iClosestNode;
 }
 
+void CMesh::BuildNodeIndex() const
+{
+	if (!m_NodeIndex.IsBuilt() || m_NodeIndex.GetNumNodes() != (int)m_Nodes.size())
+		m_NodeIndex.Build(m_Nodes);
+}
+
+void CMesh::ClearNodeIndex() const
+{
+	m_NodeIndex.Clear();
+}
+
+bool CMesh::UpdateNodeIndex() const
+{
+	if (!m_NodeIndex.IsBuilt())
+		return false;
+	int iNumIndexed = m_NodeIndex.GetNumNodes();
+	if (iNumIndexed > (int)m_Nodes.size())
+	{
+		m_NodeIndex.Clear();
+		return false;
+	}
+	// Appended nodes are searched linearly, rebuild once there are as many of them as indexed nodes
+	if ((int)m_Nodes.size() - iNumIndexed > max(1024, iNumIndexed))
+		m_NodeIndex.Build(m_Nodes);
+	return true;
+}
+
+int CMesh::FindIndexedClosestNode(const XYZ &Position, double &dDistSqrd) const
+{
+	int iClosestNode = m_NodeIndex.GetClosestNode(m_Nodes, Position, dDistSqrd);
+	double dNodeDistSqrd;
+	int i;
+	for (i = m_NodeIndex.GetNumNodes(); i < (int)m_Nodes.size(); ++i)
+	{
+		dNodeDistSqrd = GetLengthSquared(Position, m_Nodes[i]);
+		if (iClosestNode == -1 || dNodeDistSqrd < dDistSqrd)
+		{
+			dDistSqrd = dNodeDistSqrd;
+			iClosestNode = i;
+		}
+	}
+	return iClosestNode;
+}
+
+vector<int> CMesh::GetClosestNodes(const vector<XYZ> &Positions) const
+{
+	BuildNodeIndex();
+	vector<int> Closest(Positions.size());
+	double dDistSqrd;
+	int i;
+	for (i = 0; i < (int)Positions.size(); ++i)
+	{
+		Closest[i] = FindIndexedClosestNode(Positions[i], dDistSqrd);
+	}
+	return Closest;
+}
+
+vector<int> CMesh::GetClosestNodesDistance(const vector<XYZ> &Positions, double dTol) const
+{
+	BuildNodeIndex();
+	vector<int> Closest(Positions.size());
+	double dDistSqrd;
+	int i;
+	for (i = 0; i < (int)Positions.size(); ++i)
+	{
+		Closest[i] = FindIndexedClosestNode(Positions[i], dDistSqrd);
+		if (Closest[i] != -1 && dDistSqrd > dTol)
+			Closest[i] = -1;
+	}
+	return Closest;
+}
+
+vector<int> CMesh::GetNodesInRadius(XYZ Position, double dRadius) const
+{
+	if (!UpdateNodeIndex())
+		BuildNodeIndex();
+	vector<int> Indices;
+	m_NodeIndex.GetNodesInRadius(m_Nodes, Position, dRadius, Indices);
+	int i;
+	for (i = m_NodeIndex.GetNumNodes(); i < (int)m_Nodes.size(); ++i)
+	{
+		if (GetLengthSquared(Position, m_Nodes[i]) <= dRadius*dRadius)
+			Indices.push_back(i);
+	}
+	sort(Indices.begin(), Indices.end());
+	return Indices;
+}
+
 void CMesh::ConvertToSurfaceMesh()
 {
 	Convert3Dto2D();
@@ -605,30 +834,33 @@ void CMesh::ConvertToSegmentMesh()
 
 void CMesh::ConvertTriToQuad( double Tolerance )
 {
-	list<int> &TriangleIndices = m_Indices[TRI];
+	const vector<int> &TriangleIndices = m_Indices[TRI];
 	vector<int> i1;
 	int i2[3];
-	list<int>::iterator itIter1, itIter2;
-	list<int>::iterator itTriStart1, itTriStart2;
 	vector<int>::iterator iti1;
 
 	int iNumNodes = GetNumNodes(TRI);
-	for (itIter1 = TriangleIndices.begin(); itIter1 != TriangleIndices.end(); )
+	int iNumTriangles = (int)TriangleIndices.size()/iNumNodes;
+	vector<bool> Removed(iNumTriangles, false);
+	int iTri1, iTri2;
+	for (iTri1 = 0; iTri1 < iNumTriangles; ++iTri1)
 	{
-		itTriStart1 = itIter1;
+		if (Removed[iTri1])
+			continue;
 		i1.clear();
-		i1.push_back(*(itIter1++));
-		i1.push_back(*(itIter1++));
-		i1.push_back(*(itIter1++));
-		for ( itIter2 = itIter1; itIter2 != TriangleIndices.end(); )
+		i1.push_back(TriangleIndices[iTri1*3]);
+		i1.push_back(TriangleIndices[iTri1*3+1]);
+		i1.push_back(TriangleIndices[iTri1*3+2]);
+		for ( iTri2 = iTri1+1; iTri2 < iNumTriangles; ++iTri2 )
 		{
-			itTriStart2 = itIter2;
+			if (Removed[iTri2])
+				continue;
 			list<int> RemInd;
-			i2[0] = *(itIter2++);
+			i2[0] = TriangleIndices[iTri2*3];
 			RemInd.push_back(i2[0]);
-			i2[1] = *(itIter2++);
+			i2[1] = TriangleIndices[iTri2*3+1];
 			RemInd.push_back(i2[1]);
-			i2[2] = *(itIter2++);
+			i2[2] = TriangleIndices[iTri2*3+2];
 			RemInd.push_back(i2[2]);
 			vector<int> CommonInd;
 			
@@ -668,13 +900,8 @@ void CMesh::ConvertTriToQuad( double Tolerance )
 					else
 						i1.insert( i1.begin()+CommonInd[1],*(RemInd.begin()));
 					AddElement(	QUAD, i1 );
-					if ( itIter1 == itTriStart2 )
-						itIter1 = TriangleIndices.erase( itTriStart1, itIter2 );
-					else
-					{
-						TriangleIndices.erase( itTriStart2, itIter2 );
-						itIter1 = TriangleIndices.erase( itTriStart1, itIter1 );
-					}
+					Removed[iTri1] = true;
+					Removed[iTri2] = true;
 					
 					break;
 				}
@@ -682,6 +909,7 @@ void CMesh::ConvertTriToQuad( double Tolerance )
 			}
 		}
 	}
+	RemoveElements(TRI, Removed);
 }
 
 int CMesh::RemoveUnreferencedNodes()
@@ -695,7 +923,7 @@ int CMesh::RemoveUnreferencedNodes()
 		UnreferencedNodes.insert(i);
 	}
 
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
 		for (itIndex = m_Indices[i].begin(); itIndex != m_Indices[i].end(); ++itIndex)
@@ -740,7 +968,7 @@ int CMesh::DeleteNodes(const set<int> &Nodes)
 			++j;
 	}
 
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
 		for (itIndex = m_Indices[i].begin(); itIndex != m_Indices[i].end(); ++itIndex)
@@ -758,13 +986,14 @@ int CMesh::DeleteNodes(const set<int> &Nodes)
 			NewNodes.push_back(*itNode);
 	}
 	m_Nodes = NewNodes;
+	m_NodeIndex.Clear();
 
 	return iNumNodesDeleted;
 }
 
 void CMesh::ConvertHextoQuad()
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i1, i2, i3, i4, i5, i6, i7, i8;
 	for (itIter = m_Indices[HEX].begin(); itIter != m_Indices[HEX].end(); )
 	{
@@ -812,7 +1041,7 @@ void CMesh::ConvertHextoQuad()
 
 void CMesh::ConvertWedgeto2D()
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i1, i2, i3, i4, i5, i6;
 	for (itIter = m_Indices[WEDGE].begin(); itIter != m_Indices[WEDGE].end(); )
 	{
@@ -851,7 +1080,7 @@ void CMesh::ConvertWedgeto2D()
 
 void CMesh::ConvertTettoTriangle()
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i1, i2, i3, i4;
 	for (itIter = m_Indices[TET].begin(); itIter != m_Indices[TET].end(); )
 	{
@@ -881,7 +1110,7 @@ void CMesh::ConvertTettoTriangle()
 
 void CMesh::ConvertHextoWedge(bool bQuality)
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2, i3, i4, i5, i6, i7;
 	for (itIter = m_Indices[HEX].begin(); itIter != m_Indices[HEX].end(); )
 	{
@@ -917,7 +1146,7 @@ void CMesh::ConvertHextoWedge(bool bQuality)
 
 void CMesh::ConvertWedgetoTetandPyramid(bool bQuality)
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2, i3, i4, i5;
 	for (itIter = m_Indices[WEDGE].begin(); itIter != m_Indices[WEDGE].end(); )
 	{
@@ -948,7 +1177,7 @@ void CMesh::ConvertWedgetoTetandPyramid(bool bQuality)
 
 void CMesh::ConvertPyramidtoTet(bool bQuality)
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2, i3, i4;
 	for (itIter = m_Indices[PYRAMID].begin(); itIter != m_Indices[PYRAMID].end(); )
 	{
@@ -1007,7 +1236,7 @@ void CMesh::ConvertHextoTet(bool bQuality)
 
 void CMesh::ConvertPyramidto2D()
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2, i3, i4;
 	for (itIter = m_Indices[PYRAMID].begin(); itIter != m_Indices[PYRAMID].end(); )
 	{
@@ -1041,16 +1270,21 @@ void CMesh::ConvertPyramidto2D()
 	m_Indices[PYRAMID].clear();
 }
 
-list<int>::iterator CMesh::ConvertQuadtoTriangles(list<int>::iterator itQuad)
+vector<int>::iterator CMesh::ConvertQuadtoTriangles(vector<int>::iterator itQuad)
 {
-	int i0, i1, i2, i3;
+	AddQuadTriangles(itQuad);
 
-	list<int>::iterator itEnd = itQuad;
+	return m_Indices[QUAD].erase(itQuad, itQuad+4);
+}
 
-	i0 = *(itEnd++);
-	i1 = *(itEnd++);
-	i2 = *(itEnd++);
-	i3 = *(itEnd++);
+void CMesh::AddQuadTriangles(vector<int>::const_iterator itQuad)
+{
+	int i0, i1, i2, i3;
+
+	i0 = *(itQuad++);
+	i1 = *(itQuad++);
+	i2 = *(itQuad++);
+	i3 = *(itQuad++);
 
 	m_Indices[TRI].push_back(i0);
 	m_Indices[TRI].push_back(i1);
@@ -1059,13 +1293,11 @@ list<int>::iterator CMesh::ConvertQuadtoTriangles(list<int>::iterator itQuad)
 	m_Indices[TRI].push_back(i0);
 	m_Indices[TRI].push_back(i2);
 	m_Indices[TRI].push_back(i3);
-
-	return m_Indices[QUAD].erase(itQuad, itEnd);
 }
 
 void CMesh::ConvertTrianglestoSegments()
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2;
 	for (itIter = m_Indices[TRI].begin(); itIter != m_Indices[TRI].end(); )
 	{
@@ -1087,7 +1319,7 @@ void CMesh::ConvertTrianglestoSegments()
 
 void CMesh::ConvertQuadstoTriangles(bool bQuality)
 {
-	list<int>::iterator itIter;
+	vector<int>::iterator itIter;
 	int i0, i1, i2, i3;
 	for (itIter = m_Indices[QUAD].begin(); itIter != m_Indices[QUAD].end(); )
 	{
@@ -1143,6 +1375,7 @@ void CMesh::Translate(XYZ Vector)
 	{
 		*itNode += Vector;
 	}
+	m_NodeIndex.Clear();
 }
 
 void CMesh::Rotate(WXYZ Rotation, XYZ Origin)
@@ -1152,6 +1385,7 @@ void CMesh::Rotate(WXYZ Rotation, XYZ Origin)
 	{
 		(*itNode) = Rotation * (*itNode-Origin) + Origin;
 	}	
+	m_NodeIndex.Clear();
 }
 /*
 void CMesh::Rotate(XYZ X, XYZ Y, XYZ Z)
@@ -1165,8 +1399,8 @@ void CMesh::Rotate(XYZ X, XYZ Y, XYZ Z)
 */
 void CMesh::FlipNormals()
 {
-	list<int>::iterator itIter;
-	list<int>::iterator it0, it1, it2, it3;
+	vector<int>::iterator itIter;
+	vector<int>::iterator it0, it1, it2, it3;
 	int i0, i1, i2, i3;
 	for (itIter = m_Indices[QUAD].begin(); itIter != m_Indices[QUAD].end(); )
 	{
@@ -1205,7 +1439,7 @@ void CMesh::MeshClosedLoop(const XYZ &Normal, const vector<int> &ClosedLoopVecto
 
 	list<int> ClosedLoop(ClosedLoopVector.begin(), ClosedLoopVector.end());
 
-	list<int> &TriIndices = m_Indices[CMesh::TRI];
+	vector<int> &TriIndices = m_Indices[CMesh::TRI];
 
 	list<int>::iterator itPrev;
 	list<int>::iterator itCurrent;
@@ -1404,7 +1638,7 @@ void CMesh::MeshClosedLoop(const XYZ &Normal, const vector<int> &ClosedLoopVecto
 	delete [] TriangleInput.pointlist;
 	delete [] TriangleInput.segmentlist;
 
-	list<int> &TriIndices = m_Indices[CMesh::TRI];
+	vector<int> &TriIndices = m_Indices[CMesh::TRI];
 
 	int i1, i2, i3;
 	for (i=0; i<TriangleOutput.numberoftriangles; ++i)
@@ -1448,12 +1682,13 @@ void CMesh::CopySelfToRange(XYZ Vector, int iLowerLimit, int iUpperLimit)
 void CMesh::Clear()
 {
 	m_Nodes.clear();
+	m_NodeIndex.Clear();
 	int i;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
 		m_Indices[i].clear();
 	}
-/*	map<ELEMENT_TYPE, list<int> >::iterator itType;
+/*	map<ELEMENT_TYPE, vector<int> >::iterator itType;
 	for (itType = m_Indices.begin(); itType != m_Indices.end(); ++itType)
 	{
 		itType->second.clear();
@@ -1462,17 +1697,18 @@ void CMesh::Clear()
 
 int CMesh::OutputNodes(ostream &Output, int iStartIndex, string Seperator, bool bSCIRun) const
 {
+	CTextWriter Writer(Output);
 	int iNodeIndex;
 	vector<XYZ>::const_iterator itNode;
 
 	if ( bSCIRun )
-		Output << m_Nodes.size() << endl;
+		Writer << m_Nodes.size() << "\n";
 
 	for (itNode = m_Nodes.begin(), iNodeIndex=0; itNode != m_Nodes.end(); ++itNode, ++iNodeIndex)
 	{
 		if (iStartIndex >= 0 && !bSCIRun)
-			Output << iNodeIndex+iStartIndex << Seperator;
-		Output << *itNode << endl;
+			Writer << iNodeIndex+iStartIndex << Seperator;
+		Writer << *itNode << "\n";
 	}
 	return iNodeIndex+iStartIndex;
 }
@@ -1480,23 +1716,24 @@ int CMesh::OutputNodes(ostream &Output, int iStartIndex, string Seperator, bool
 int CMesh::OutputElements(ostream &Output, CMesh::ELEMENT_TYPE ElementType, int iStartIndex, int iIndexOffset, string Seperator, bool bSCIRun) const
 {
 	assert(ElementType >= 0 && ElementType < NUM_ELEMENT_TYPES);
+	CTextWriter Writer(Output);
 	int i;
 	int iElementNumber = 0;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 
 	if ( bSCIRun )
-		Output << m_Indices[ElementType].size()/GetNumNodes(ElementType) << endl;
+		Writer << m_Indices[ElementType].size()/GetNumNodes(ElementType) << "\n";
 	for (itIndex = m_Indices[ElementType].begin(); itIndex != m_Indices[ElementType].end(); ++iElementNumber)
 	{
 		if (iStartIndex >= 0 && !bSCIRun)
-			Output << iElementNumber+iStartIndex << Seperator;
+			Writer << iElementNumber+iStartIndex << Seperator;
 		for (i=0; i<GetNumNodes(ElementType); ++i, ++itIndex)
 		{
 			if (i>0)
-				Output << Seperator;
-			Output << (*itIndex)+iIndexOffset;
+				Writer << Seperator;
+			Writer << (*itIndex)+iIndexOffset;
 		}
-		Output << endl;
+		Writer << "\n";
 	}
 	return iElementNumber+iStartIndex;
 }
@@ -1506,7 +1743,7 @@ void CMesh::GetNodeElementReferences(vector<vector<int*> > &References)
 	References.clear();
 	References.resize(m_Nodes.size());
 	int i;
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
 		for (itIndex = m_Indices[i].begin(); itIndex != m_Indices[i].end(); ++itIndex)
@@ -1531,9 +1768,9 @@ double CMesh::CalculateVolume() const
 
 	double dVolume = 0;
 	// Code from http://www.gamedev.net/reference/articles/article2247.asp
-	const list<int> &TriangleIndices = m_Indices[TRI];
+	const vector<int> &TriangleIndices = m_Indices[TRI];
 	XYZ P1, P2, P3;
-	list<int>::const_iterator itIter;
+	vector<int>::const_iterator itIter;
 	for (itIter = TriangleIndices.begin(); itIter != TriangleIndices.end(); )
 	{
 		P1 = m_Nodes[*(itIter++)];
@@ -1551,7 +1788,7 @@ vector<XYZ> CMesh::GetElementCenters() const
 	TGLOG("Get Element Centres");
 	vector<XYZ> ElementCenters;
 	int i, j, iNumNodes;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
 		iNumNodes = GetNumNodes((ELEMENT_TYPE)i);
@@ -1577,7 +1814,7 @@ vector<XYZ> CMesh::GetElementCenters( ELEMENT_TYPE type )
 {
 	vector<XYZ> ElementCentres;
 	int iNumNodes = GetNumNodes(type);
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	for ( itIndex = m_Indices[type].begin(); itIndex != m_Indices[type].end(); )
 	{
 		XYZ Centre;
@@ -1609,11 +1846,11 @@ int CMesh::CountInvertedElements(ELEMENT_TYPE ElementType) const
 	{
 		return 0;
 	}
-	list<int>::const_iterator itIter;
+	vector<int>::const_iterator itIter;
 	int i, iNumInvertedElements = 0;
 	CMesh CopiedMesh;
 	CopiedMesh.m_Nodes = m_Nodes;
-	const list<int> &Indices = m_Indices[ElementType];
+	const vector<int> &Indices = m_Indices[ElementType];
 	int iNumNodes = GetNumNodes(ElementType);
 	for (itIter = Indices.begin(); itIter != Indices.end(); )
 	{
@@ -1630,7 +1867,7 @@ int CMesh::CountInvertedElements(ELEMENT_TYPE ElementType) const
 	return iNumInvertedElements;
 }
 
-int CMesh::IntersectLine(const XYZ &P1, const XYZ &P2, vector<pair<double, XYZ> > &IntersectionPoints, pair<bool, bool> TrimResults, bool bForceFind/*, const CElementsOctree *pOctree*/) const
+int CMesh::IntersectLine(const XYZ &P1, const XYZ &P2, vector<pair<double, XYZ> > &IntersectionPoints, pair<bool, bool> TrimResults, bool bForceFind, const CTriangleBVH *pBVH) const
 {
 	int i;
 	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
@@ -1644,91 +1881,74 @@ int CMesh::IntersectLine(const XYZ &P1, const XYZ &P2, vector<pair<double, XYZ>
 
 	IntersectionPoints.clear();
 
+	const vector<int> &TriangleIndices = m_Indices[TRI];
+	int iNumTriangles = (int)TriangleIndices.size()/3;
+	if (pBVH && pBVH->GetNumTriangles() != iNumTriangles)
+	{
+		TGERROR("Warning: IntersectLine bounding volume hierarchy doesn't match the mesh, it will be ignored");
+		pBVH = NULL;
+	}
+
+	// Only the triangles near the line need to be checked, they are checked in the same order as
+	// the brute force search so that the results are identical
+	vector<int> Triangles;
+	if (pBVH)
+	{
+		pBVH->GetTrianglesNearLine(P1, P2, TrimResults, Triangles);
+		sort(Triangles.begin(), Triangles.end());
+		iNumTriangles = (int)Triangles.size();
+	}
+
 	XYZ T1, T2, T3;
 	XYZ Normal, Intersection;
 	double dU;
 	const double dTolerance = 1e-9;
-/*	if (pOctree && pOctree->GetOctree())
-	{
-		list<vector<int> > Elements;
-		list<vector<int> >::iterator itIter;
-
-		COctreeVisitorElementNearLine Visitor(P1, P2, Elements, TrimResults);
+	bool bFirst = true;
+	double dMin;
+	double dAccuracy;
+	double dBestU;
+	XYZ BestNormal;
+	int iTriangle;
 
-		pOctree->GetOctree()->visit(Visitor);
+	for (i = 0; i < iNumTriangles; ++i)
+	{
+		iTriangle = pBVH ? Triangles[i] : i;
+		T1 = m_Nodes[TriangleIndices[3*iTriangle]];
+		T2 = m_Nodes[TriangleIndices[3*iTriangle+1]];
+		T3 = m_Nodes[TriangleIndices[3*iTriangle+2]];
 
-		for (itIter = Elements.begin(); itIter != Elements.end(); ++itIter)
+		Normal = CrossProduct(T2-T1, T3-T1);
+		if (Normal)
 		{
-			T1 = m_Nodes[(*itIter)[0]];
-			T2 = m_Nodes[(*itIter)[1]];
-			T3 = m_Nodes[(*itIter)[2]];
-
-			Normal = CrossProduct(T2-T1, T3-T1);
 			Normalise(Normal);
 
 			if (GetIntersectionLinePlane(P1, P2, T1, Normal, Intersection, &dU))
 			{
 				if (TrimResults.first && dU < 0)
-					; // Do nothing
-				else if(TrimResults.second && dU > 1)
-					; // Do nothing
-				else if (PointInsideTriangle(T1, T2, T3, Intersection, Normal))
+					continue; // Do nothing
+				if(TrimResults.second && dU > 1)
+					continue; // Do nothing
+				dMin = PointInsideTriangleAccuracy(T1, T2, T3, Intersection, Normal);
+				if (dMin >= -dTolerance)
 				{
 					IntersectionPoints.push_back(pair<double, XYZ>(dU, Normal));
 				}
-			}
-		}
-	}
-	else
-	{*/
-		bool bFirst = true;
-		double dMin;
-		double dAccuracy;
-		double dBestU;
-		XYZ BestNormal;
-
-		const list<int> &TriangleIndices = m_Indices[TRI];
-		list<int>::const_iterator itIter;
-		for (itIter = TriangleIndices.begin(); itIter != TriangleIndices.end(); )
-		{
-			T1 = m_Nodes[*(itIter++)];
-			T2 = m_Nodes[*(itIter++)];
-			T3 = m_Nodes[*(itIter++)];
-
-			Normal = CrossProduct(T2-T1, T3-T1);
-			if (Normal)
-			{
-				Normalise(Normal);
-
-				if (GetIntersectionLinePlane(P1, P2, T1, Normal, Intersection, &dU))
+				if (bFirst || dMin > dAccuracy)
 				{
-					if (TrimResults.first && dU < 0)
-						continue; // Do nothing
-					if(TrimResults.second && dU > 1)
-						continue; // Do nothing
-					dMin = PointInsideTriangleAccuracy(T1, T2, T3, Intersection, Normal);
-					if (dMin >= -dTolerance)
-					{
-						IntersectionPoints.push_back(pair<double, XYZ>(dU, Normal));
-					}
-					if (bFirst || dMin > dAccuracy)
-					{
-						dAccuracy = dMin;
-						bFirst = false;
-						dBestU = dU;
-						BestNormal = Normal;
-					}
-/*					if (PointInsideTriangle(T1, T2, T3, Intersection, Normal))
-					{
-						IntersectionPoints.push_back(pair<double, XYZ>(dU, Normal));
-					}*/
+					dAccuracy = dMin;
+					bFirst = false;
+					dBestU = dU;
+					BestNormal = Normal;
 				}
 			}
 		}
-//	}
+	}
 
 	if (bForceFind && IntersectionPoints.empty())
 	{
+		// The closest miss may be any triangle so check them all
+		if (pBVH)
+			return IntersectLine(P1, P2, IntersectionPoints, TrimResults, bForceFind);
 		IntersectionPoints.push_back(pair<double, XYZ>(dBestU, BestNormal));
 	}
 
@@ -1737,6 +1957,19 @@ int CMesh::IntersectLine(const XYZ &P1, const XYZ &P2, vector<pair<double, XYZ>
 	return IntersectionPoints.size();
 }
 
+int CMesh::IntersectLines(const vector<pair<XYZ, XYZ> > &Lines, vector<vector<pair<double, XYZ> > > &IntersectionPoints, pair<bool, bool> TrimResults, bool bForceFind) const
+{
+	CTriangleBVH BVH;
+	BVH.Build(*this);
+	IntersectionPoints.resize(Lines.size());
+	int i, iNumIntersections = 0;
+	for (i = 0; i < (int)Lines.size(); ++i)
+	{
+		iNumIntersections += IntersectLine(Lines[i].first, Lines[i].second, IntersectionPoints[i], TrimResults, bForceFind, &BVH);
+	}
+	return iNumIntersections;
+}
+
 void CMesh::AddOrCancel(list<pair<int, int> > &EdgeStack, pair<int, int> Edge)
 {
 	list<pair<int, int> >::iterator FindResult;
@@ -1779,9 +2012,9 @@ void CMesh::MeshConvexHull()
 	if (m_Nodes.size() < 3)
 		return;
 
-	list<int> &TriangleIndices = m_Indices[TRI];
+	vector<int> &TriangleIndices = m_Indices[TRI];
 	// Generate a list of triangle normals
-	list<PLANE> TrianglePlanes;
+	vector<PLANE> TrianglePlanes;
 	PLANE Plane;
 	XYZ P1, P2, P3, P;
 
@@ -1818,9 +2051,8 @@ void CMesh::MeshConvexHull()
 	Plane.d = -Plane.d;
 	TrianglePlanes.push_back(Plane);
 
-	list<int>::iterator itIter, itTriStart;
-	list<PLANE>::iterator itPlane;
 	int i1, i2, i3;
+	int j, iNumKept;
 	bool bFacesAdded;
 	// This loop will be iterated until no more faces are added, this is necessary when
 	// we have more than 3 nodes that are coplanar. If not some nodes will be missed.
@@ -1830,29 +2062,34 @@ void CMesh::MeshConvexHull()
 		for (i=0; i<(int)m_Nodes.size(); ++i)
 		{
 			P = m_Nodes[i];
-			// Delete faces that this vertex can see
-			for (itIter = TriangleIndices.begin(), itPlane = TrianglePlanes.begin(); itIter != TriangleIndices.end(); )
+			// Delete faces that this vertex can see, the remaining triangles and their planes
+			// are compacted towards the front of the arrays
+			for (j = 0, iNumKept = 0; j < (int)TrianglePlanes.size(); ++j)
 			{
-				itTriStart = itIter;
-				i1 = *(itIter++);
-				i2 = *(itIter++);
-				i3 = *(itIter++);
+				i1 = TriangleIndices[j*3+0];
+				i2 = TriangleIndices[j*3+1];
+				i3 = TriangleIndices[j*3+2];
 				// If the vertex can see the plane (with a tolerance) we don't want to remove
 				// triangles that are in the same place as the vertex or the algorithm will fail.
-				if (DotProduct(itPlane->Normal, P) > itPlane->d+TOL)
+				if (DotProduct(TrianglePlanes[j].Normal, P) > TrianglePlanes[j].d+TOL)
 				{
 					// If the edge already exist in the edge stack then it should cancel with it
 					// (remove the edge rather than adding it) otherwise add the edge.
 					AddOrCancel(EdgeStack, pair<int, int>(i1, i2));
 					AddOrCancel(EdgeStack, pair<int, int>(i2, i3));
 					AddOrCancel(EdgeStack, pair<int, int>(i3, i1));
-					// Delete the triangle
-					itIter = TriangleIndices.erase(itTriStart, itIter);
-					itPlane = TrianglePlanes.erase(itPlane);
 				}
 				else
-					++itPlane;
+				{
+					TriangleIndices[iNumKept*3+0] = i1;
+					TriangleIndices[iNumKept*3+1] = i2;
+					TriangleIndices[iNumKept*3+2] = i3;
+					TrianglePlanes[iNumKept] = TrianglePlanes[j];
+					++iNumKept;
+				}
 			}
+			TriangleIndices.resize(iNumKept*3);
+			TrianglePlanes.resize(iNumKept);
 			// Create new triangles and calculate the planes of the new triangle.
 			// Not only is it an optimisation to calculate the triangle planes only once
 			// it is also for consitency.
@@ -1953,7 +2190,7 @@ bool CMesh::SaveToSTL(string Filename, bool bBinary) const
 	if (!Output)
 		return false;
 
-	const list<int> &TriangleIndices = m_Indices[TRI];
+	const vector<int> &TriangleIndices = m_Indices[TRI];
 
 	if (bBinary)
 	{
@@ -1967,7 +2204,7 @@ bool CMesh::SaveToSTL(string Filename, bool bBinary) const
 		Output << "solid " << Filename << endl;
 
 	XYZ T1, T2, T3, Normal;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	short int Padding = 0;
 	for (itIndex = TriangleIndices.begin(); itIndex != TriangleIndices.end(); )
 	{
@@ -2030,7 +2267,7 @@ bool CMesh::SaveToSMESH(string Filename) const
 	Output << "# facet count, no boundary marker" << endl;
 	Output << iNumTriangles+iNumQuads << " 0" << endl;
 	Output << "# facets" << endl;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	int iNumNodesPerElement;
 	int i, j;
 	ELEMENT_TYPE ElemType;
@@ -2128,7 +2365,7 @@ bool CMesh::SaveToABAQUS(string Filename, const vector<POINT_INFO> *pElementInfo
 //		iStartIndex = OutputElements(Output, WEDGE, iStartIndex, 1);
 		int i1, i2, i3, i4, i5, i6;
 		int iElementNumber = 0;
-		list<int>::const_iterator itIndex;
+		vector<int>::const_iterator itIndex;
 		for (itIndex = m_Indices[WEDGE].begin(); itIndex != m_Indices[WEDGE].end(); ++iElementNumber)
 		{
 			i1 = *(itIndex++)+1;
@@ -2345,59 +2582,44 @@ bool CMesh::SaveToABAQUS(string Filename, const vector<POINT_INFO> *pElementInfo
 	return true;
 }
 
-bool CMesh::SaveToVTK(string Filename, const vector<CMeshDataBase*> *pMeshData) const
+bool CMesh::SaveToVTK(string Filename, const vector<CMeshDataBase*> *pMeshData, VTK_FORMAT Format) const
 {
 	AddExtensionIfMissing(Filename, ".vtu");
 
-	TiXmlDocument doc;
-	TiXmlDeclaration decl("1.0", "", "");
-	doc.InsertEndChild(decl);
-	TiXmlElement VTKFile("VTKFile");
+	CVTKWriter Writer(Format);
+	if (!Writer.Open(Filename, "UnstructuredGrid"))
+		return false;
+
+	int i, iNumCells = 0;
+	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
 	{
-		VTKFile.SetAttribute("type", "UnstructuredGrid");
-		VTKFile.SetAttribute("version", "0.1");
-		VTKFile.SetAttribute("byte_order", "LittleEndian");
-		TiXmlElement UnstructuredGrid("UnstructuredGrid");
+		if (GetVTKElementType((ELEMENT_TYPE)i))
+			iNumCells += (int)m_Indices[i].size()/GetNumNodes((ELEMENT_TYPE)i);
+	}
+	Writer.StartElement("Piece", "NumberOfPoints=\"" + stringify(m_Nodes.size()) + "\" NumberOfCells=\"" + stringify(iNumCells) + "\"");
+	WriteVTKPoints(Writer);
+	WriteVTKCells(Writer);
+	if (pMeshData)
+	{
+		vector<CMeshDataBase*>::const_iterator itData;
+		Writer.StartElement("PointData");
+		for (itData = pMeshData->begin(); itData != pMeshData->end(); ++itData)
 		{
-			TiXmlElement Piece("Piece");
-			{
-				TiXmlElement Points("Points");
-				int iNumPoints = FillVTKPointData(Points);
-				Piece.InsertEndChild(Points);
-
-				TiXmlElement Cells("Cells");
-				int iNumCells = FillVTKCellData(Cells);
-				Piece.InsertEndChild(Cells);
-
-				if (pMeshData)
-				{
-					TiXmlElement PointData("PointData");
-					TiXmlElement CellData("CellData");
-					vector<CMeshDataBase*>::const_iterator itData;
-					for (itData = pMeshData->begin(); itData != pMeshData->end(); ++itData)
-					{
-						if ((*itData)->m_DataType == CMeshDataBase::NODE)
-							(*itData)->InsertVTKData(PointData);
-						else
-							(*itData)->InsertVTKData(CellData);
-					}
-					TGLOG("Finished iterator");
-					Piece.InsertEndChild(PointData);
-					Piece.InsertEndChild(CellData);
-					TGLOG("End InsertVTKData");
-				}
-
-				Piece.SetAttribute("NumberOfPoints", stringify(iNumPoints));
-				Piece.SetAttribute("NumberOfCells", stringify(iNumCells));
-			}
-			UnstructuredGrid.InsertEndChild(Piece);
+			if ((*itData)->m_DataType == CMeshDataBase::NODE)
+				(*itData)->WriteVTKData(Writer);
 		}
-		VTKFile.InsertEndChild(UnstructuredGrid);
+		Writer.EndElement();
+		Writer.StartElement("CellData");
+		for (itData = pMeshData->begin(); itData != pMeshData->end(); ++itData)
+		{
+			if ((*itData)->m_DataType != CMeshDataBase::NODE)
+				(*itData)->WriteVTKData(Writer);
+		}
+		Writer.EndElement();
 	}
+	Writer.EndElement();
 
-	doc.InsertEndChild(VTKFile);
-	TGLOG("Return call SaveFile");
-	return doc.SaveFile(Filename);
+	return Writer.Close();
 }
 /*
 bool CMesh::SaveToVTK(string Filename, const vector<TiXmlElement> *pAdditionalData) const
@@ -2444,122 +2666,123 @@ bool CMesh::SaveToVTK(string Filename, const vector<TiXmlElement> *pAdditionalDa
 	return doc.SaveFile(Filename);
 }
 */
-int CMesh::FillVTKPointData(TiXmlElement &Points) const
-{
-	TGLOG("FillVTKPointData");
-	ostringstream PointsData;
-	vector<XYZ>::const_iterator itNode;
-	for (itNode = m_Nodes.begin(); itNode != m_Nodes.end(); ++itNode)
-	{
-		PointsData << itNode->x << " " << itNode->y << " " << itNode->z << " ";
-	}
-
-	TiXmlElement DataArray("DataArray");
-	{
-		DataArray.SetAttribute("type", "Float32");
-		DataArray.SetAttribute("NumberOfComponents", "3");
-		DataArray.SetAttribute("format", "ascii");
-		DataArray.InsertEndChild(TiXmlText(PointsData.str()));
-	}
-	Points.InsertEndChild(DataArray);
-	TGLOG("return");
-	return m_Nodes.size();
+void CMesh::WriteVTKPoints(CVTKWriter &Writer) const
+{
+	Writer.StartElement("Points");
+	// Ascii files have always been labelled Float32, the binary values are the doubles of the nodes
+	string Type = Writer.GetFormat() == VTK_ASCII ? "Float32" : "Float64";
+	Writer.AddDataArray("type=\"" + Type + "\" NumberOfComponents=\"3\" " + Writer.GetFormatAttributes(), m_Nodes.size()*3*sizeof(double), [this, &Writer]()
+	{
+		// Copied in blocks so that only the coordinates are written
+		const size_t BLOCK_SIZE = 1024;
+		double Values[3*BLOCK_SIZE];
+		size_t i, j;
+		for (i=0; i<m_Nodes.size(); i+=BLOCK_SIZE)
+		{
+			size_t iNumNodes = min(BLOCK_SIZE, m_Nodes.size()-i);
+			for (j=0; j<iNumNodes; ++j)
+			{
+				Values[3*j] = m_Nodes[i+j].x;
+				Values[3*j+1] = m_Nodes[i+j].y;
+				Values[3*j+2] = m_Nodes[i+j].z;
+			}
+			Writer.WriteValues(Values, 3*iNumNodes);
+		}
+	});
+	Writer.EndElement();
 }
 
-int CMesh::FillVTKCellData(TiXmlElement &Cells) const
+void CMesh::WriteVTKCells(CVTKWriter &Writer) const
 {
-	TGLOG("FillVTKCellData");
-	ostringstream ConnectivityData;
-	ostringstream OffsetsData;
-	ostringstream TypesData;
+	size_t iNumIndices = 0, iNumCells = 0;
+	int i;
+	for (i = 0; i < NUM_ELEMENT_TYPES; ++i)
+	{
+		if (GetVTKElementType((ELEMENT_TYPE)i))
+		{
+			iNumIndices += m_Indices[i].size();
+			iNumCells += m_Indices[i].size()/GetNumNodes((ELEMENT_TYPE)i);
+		}
+	}
 
-	int i, iOffset = 0;
-	int iTotalNumCells = 0;
-	list<int>::const_iterator itIndex;
-	int j;
-	for (j = 0; j < NUM_ELEMENT_TYPES; ++j)
+	Writer.StartElement("Cells");
+	Writer.AddDataArray("type=\"Int32\" Name=\"connectivity\" " + Writer.GetFormatAttributes(), iNumIndices*sizeof(int), [this, &Writer]()
 	{
-		int iVTKType = 0;
-		switch (j)
+		for (int j = 0; j < NUM_ELEMENT_TYPES; ++j)
 		{
-		case TRI:
-			iVTKType = 5;
-			break;
-		case QUAD:
-			iVTKType = 9;
-			break;
-		case TET:
-			iVTKType = 10;
-			break;
-		case WEDGE:
-			iVTKType = 13;
-			break;
-		case PYRAMID:
-			iVTKType = 14;
-			break;
-		case HEX:
-			iVTKType = 12;
-			break;
-		case LINE:
-			iVTKType = 3;
-			break;
-		case POLYLINE:
-			iVTKType = 4;
-			break;
-		case QUADRATIC_TET:
-			iVTKType = 24;
-			break;
+			if (GetVTKElementType((ELEMENT_TYPE)j) && !m_Indices[j].empty())
+				Writer.WriteValues(&m_Indices[j][0], m_Indices[j].size());
 		}
-		if (iVTKType != 0)
+	});
+	// The offsets and types are generated in blocks as they are written
+	Writer.AddDataArray("type=\"Int32\" Name=\"offsets\" " + Writer.GetFormatAttributes(), iNumCells*sizeof(int), [this, &Writer]()
+	{
+		const int BLOCK_SIZE = 4096;
+		int Offsets[BLOCK_SIZE];
+		int j, k, iOffset = 0, iNumInBlock = 0;
+		for (j = 0; j < NUM_ELEMENT_TYPES; ++j)
 		{
+			if (!GetVTKElementType((ELEMENT_TYPE)j))
+				continue;
 			int iNumNodesPerElement = GetNumNodes((ELEMENT_TYPE)j);
-			int iNumElements = m_Indices[j].size()/iNumNodesPerElement;
-			for (itIndex = m_Indices[j].begin(), i=0; itIndex != m_Indices[j].end(); ++itIndex, ++i)
-			{
-				ConnectivityData << *itIndex << " ";
-			}
-			for (i=0; i<iNumElements; ++i)
-			{
-				TypesData << iVTKType << " ";
-			}
-			for (i=0; i<iNumElements; ++i)
+			int iNumElements = (int)m_Indices[j].size()/iNumNodesPerElement;
+			for (k = 0; k < iNumElements; ++k)
 			{
 				iOffset += iNumNodesPerElement;
-				OffsetsData << iOffset << " ";
+				Offsets[iNumInBlock++] = iOffset;
+				if (iNumInBlock == BLOCK_SIZE)
+				{
+					Writer.WriteValues(Offsets, iNumInBlock);
+					iNumInBlock = 0;
+				}
 			}
-			iTotalNumCells += iNumElements;
 		}
+		Writer.WriteValues(Offsets, iNumInBlock);
+	});
+	Writer.AddDataArray("type=\"Int32\" Name=\"types\" " + Writer.GetFormatAttributes(), iNumCells*sizeof(int), [this, &Writer]()
+	{
+		const int BLOCK_SIZE = 4096;
+		int Types[BLOCK_SIZE];
+		int j, k;
+		for (j = 0; j < NUM_ELEMENT_TYPES; ++j)
+		{
+			int iVTKType = GetVTKElementType((ELEMENT_TYPE)j);
+			if (!iVTKType)
+				continue;
+			int iNumElements = (int)m_Indices[j].size()/GetNumNodes((ELEMENT_TYPE)j);
+			fill(Types, Types+BLOCK_SIZE, iVTKType);
+			for (k = 0; k < iNumElements; k += BLOCK_SIZE)
+				Writer.WriteValues(Types, min(BLOCK_SIZE, iNumElements-k));
+		}
+	});
+	Writer.EndElement();
+}
+
+int CMesh::GetVTKElementType(ELEMENT_TYPE Type)
+{
+	switch (Type)
+	{
+	case TRI:
+		return 5;
+	case QUAD:
+		return 9;
+	case TET:
+		return 10;
+	case WEDGE:
+		return 13;
+	case PYRAMID:
+		return 14;
+	case HEX:
+		return 12;
+	case LINE:
+		return 3;
+	case POLYLINE:
+		return 4;
+	case QUADRATIC_TET:
+		return 24;
+	default:
+		return 0;
 	}
-
-
-	TiXmlElement Connectivity("DataArray");
-	{
-		Connectivity.SetAttribute("type", "Int32");
-		Connectivity.SetAttribute("Name", "connectivity");
-		Connectivity.SetAttribute("format", "ascii");
-		Connectivity.InsertEndChild(TiXmlText(ConnectivityData.str()));
-	}
-	Cells.InsertEndChild(Connectivity);
-
-	TiXmlElement Offsets("DataArray");
-	{
-		Offsets.SetAttribute("type", "Int32");
-		Offsets.SetAttribute("Name", "offsets");
-		Offsets.SetAttribute("format", "ascii");
-		Offsets.InsertEndChild(TiXmlText(OffsetsData.str()));
-	}
-	Cells.InsertEndChild(Offsets);
-
-	TiXmlElement Types("DataArray");
-	{
-		Types.SetAttribute("type", "Int32");
-		Types.SetAttribute("Name", "types");
-		Types.SetAttribute("format", "ascii");
-		Types.InsertEndChild(TiXmlText(TypesData.str()));
-	}
-	Cells.InsertEndChild(Types);
-	TGLOG("return");
-	return iTotalNumCells;
 }
 
 bool CMesh::AddElement(ELEMENT_TYPE Type, const vector<int> &Indices)
@@ -2613,11 +2836,13 @@ vector<XYZ>::const_iterator CMesh::NodesEnd() const
 
 vector<XYZ>::iterator CMesh::NodesBegin()
 {
+	m_NodeIndex.Clear();
 	return m_Nodes.begin();
 }
 
 vector<XYZ>::iterator CMesh::NodesEnd()
 {
+	m_NodeIndex.Clear();
 	return m_Nodes.end();
 }
 
@@ -2631,6 +2856,7 @@ void CMesh::SetNode(int iIndex, XYZ Node)
 {
 	assert(iIndex >= 0 && iIndex<(int)m_Nodes.size());
 	m_Nodes[iIndex] = Node; 
+	m_NodeIndex.Clear();
 } 	 
 
 const XYZ& CMesh::GetNode(int iIndex) const
@@ -2640,6 +2866,7 @@ const XYZ& CMesh::GetNode(int iIndex) const
 
 vector<XYZ>::iterator CMesh::DeleteNode(vector<XYZ>::iterator it)
 {
+	m_NodeIndex.Clear();
 	return m_Nodes.erase(it);
 }
 
@@ -2660,21 +2887,23 @@ const vector<XYZ>& CMesh::GetNodes() const
 
 vector<XYZ>& CMesh::GetNodes()
 {
+	m_NodeIndex.Clear();
 	return m_Nodes;
 }
 
 void CMesh::SetNumNodes(int NumNodes)
 {
 	m_Nodes.resize(NumNodes);
+	m_NodeIndex.Clear();
 }
 
-const list<int>& CMesh::GetIndices(ELEMENT_TYPE ElemType) const
+const vector<int>& CMesh::GetIndices(ELEMENT_TYPE ElemType) const
 {
 	assert(ElemType >= 0 && ElemType < NUM_ELEMENT_TYPES);
 	return m_Indices[ElemType];
 }
 
-list<int>& CMesh::GetIndices(ELEMENT_TYPE ElemType)
+vector<int>& CMesh::GetIndices(ELEMENT_TYPE ElemType)
 {
 	assert(ElemType >= 0 && ElemType < NUM_ELEMENT_TYPES);
 	return m_Indices[ElemType];
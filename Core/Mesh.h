@@ -20,6 +20,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #pragma once
 //#include "../tinyxml/tinyxml.h"
 #include "MeshData.h"
+#include "NodeKDTree.h"
+#include "TriangleBVH.h"
 
 //class TiXmlElement;
 namespace TexGen
@@ -32,7 +34,8 @@ namespace TexGen
 	perform basic tasks and output to various file formats. As such, direct access to the
 	data is provided.
 	m_Nodes is a vector of nodes contained within the mesh.
-	m_Indices is a list of indices into the nodes.
+	m_Indices holds the indices into the nodes, one contiguous array per element type
+	with GetNumNodes(ElementType) indices stored for each element.
 	The element types supported are listed in the ELEMENT_TYPE enum, this can be easily
 	be extended. If this is done the GetNumNodes function must be updated to specify
 	the number of nodes the element type uses.
@@ -114,7 +117,10 @@ namespace TexGen
 		//////////////////////////////////////////////
 
 		/// Convert a specific quad element to two triangles
-		list<int>::iterator ConvertQuadtoTriangles(list<int>::iterator itQuad);
+		vector<int>::iterator ConvertQuadtoTriangles(vector<int>::iterator itQuad);
+
+		/// Add two triangles covering a specific quad element, the quad element itself is left in place
+		void AddQuadTriangles(vector<int>::const_iterator itQuad);
 
 		/// Convert triangle elements to segments
 		void ConvertTrianglestoSegments();
@@ -218,10 +224,22 @@ namespace TexGen
 		*/
 		void ChangeNodeIndices(int iChangeTo, int iChangeFrom, vector<vector<int*> > &References);
 
+		/// Remove pairs of elements that have the same indices but opposite normals
+		/**
+		Each element cancels out the earliest element before it with the opposite orientation.
+		Elements are matched by hashing their indices so the cost is linear in the number of elements.
+		\param ElementType Type of elements to be removed, must be TRI or QUAD
+		*/
+		void RemoveOpposingElements(ELEMENT_TYPE ElementType);
+
 		/// Remove triangles that have the same indices but opposite normals
 		void RemoveOpposingTriangles();
 
 		/// Remove quads that have the same indices but opposite normals
+		/**
+		Unlike RemoveOpposingElements the first quad of a set sharing the same indices is removed
+		along with all the quads opposing it.
+		*/
 		void RemoveOpposingQuads();
 
 		/// Remove triangles which have two equal corner indices
@@ -233,6 +251,14 @@ namespace TexGen
 		/// Remove segments which have the same indices
 		void RemoveDuplicateSegments();
 
+		/// Remove the elements of a given type flagged in Removed, keeping the order of the rest
+		/**
+		Removed holds one flag per element, elements beyond the end of Removed are kept.
+		This compacts the connectivity array in a single pass and should be preferred over
+		erasing elements one at a time.
+		*/
+		void RemoveElements(ELEMENT_TYPE ElementType, const vector<bool> &Removed);
+
 		/// Remove duplicate elements which have the same indices (leaves one copy of element)
 		/**
 		\param ElementType Type of elements to be removed
@@ -355,9 +381,20 @@ namespace TexGen
 		\param IntersectionPoints Information about where the intersections occured
 		\param TrimResults If true then only intersections found where \f$ 0 \le \mu_i \le 1 \f$ are returned
 		\param bForceFind Force the algorithm to find the closest intersection if no exact intersections can be found
+		\param pBVH Bounding volume hierarchy built from this mesh, if given only the triangles near the line are checked
 		\return Number of intersections found
 		*/
-		int IntersectLine(const XYZ &P1, const XYZ &P2, vector< pair<double, XYZ> > &IntersectionPoints, pair<bool, bool> TrimResults = make_pair(false, false), bool bForceFind = false/*, const CElementsOctree *pOctree = NULL*/) const;
+		int IntersectLine(const XYZ &P1, const XYZ &P2, vector< pair<double, XYZ> > &IntersectionPoints, pair<bool, bool> TrimResults = make_pair(false, false), bool bForceFind = false, const CTriangleBVH *pBVH = NULL) const;
+
+		/// Find the points where each of a set of lines intersects the mesh
+		/**
+		Equivalent to calling IntersectLine for each line but a bounding volume hierarchy is built once
+		and used for all the lines.
+		\param Lines The start and end points of each line
+		\param IntersectionPoints Set to the intersections found for each line
+		\return Total number of intersections found
+		*/
+		int IntersectLines(const vector<pair<XYZ, XYZ> > &Lines, vector<vector<pair<double, XYZ> > > &IntersectionPoints, pair<bool, bool> TrimResults = make_pair(false, false), bool bForceFind = false) const;
 
 		/// Build grid of points
 		/**
@@ -383,7 +420,9 @@ namespace TexGen
 		/**
 		This is usefull for applying boundary conditions. For example given a block
 		width w and height h, all node pairs given by vector XYZ(w, 0, 0) should be 
-		tied together and all node pairs given by vector XYZ(0, h, 0) should be tied
+		tied together and all node pairs given by vector XYZ(0, h, 0) should be tied.
+		Nodes are matched through a uniform grid over the faces joined by Vector so the
+		cost is linear in the number of nodes.
 		*/
 		vector<pair<int, int> > GetNodePairs(XYZ Vector, const double Tolerance = 1e-6) const;
 		void GetNodePairs(XYZ Vector, vector<pair<int, int> > &NodePairs, const double Tolerance = 1e-6) const;
@@ -403,6 +442,41 @@ namespace TexGen
 		*/
 		int GetClosestNodeDistance(XYZ Position, double dTol ) const;
 
+		/// Build a k-d tree over the nodes to speed up closest node queries
+		/**
+		Once built, GetClosestNode and GetClosestNodeDistance use the index automatically. Nodes
+		appended with AddNode after the index is built are checked separately until there are
+		enough of them to make rebuilding worthwhile. Modifying or deleting nodes discards the
+		index. Queries may rebuild the index so they should not be made from several threads
+		at once.
+		*/
+		void BuildNodeIndex() const;
+
+		/// Discard the closest node index
+		void ClearNodeIndex() const;
+
+		/// Check whether the closest node index has been built
+		bool HasNodeIndex() const { return m_NodeIndex.IsBuilt(); }
+
+		/// Get the index of the closest node to each of the given positions
+		/**
+		The node index is built if it doesn't already exist.
+		\return Indices of the closest nodes, the same length as Positions with -1 if there are no nodes
+		*/
+		vector<int> GetClosestNodes(const vector<XYZ> &Positions) const;
+
+		/// Get the index of the closest node to each of the given positions within a tolerance
+		/**
+		As for GetClosestNodeDistance but for many positions at once. The node index is built if it doesn't already exist.
+		*/
+		vector<int> GetClosestNodesDistance(const vector<XYZ> &Positions, double dTol) const;
+
+		/// Get the indices of all the nodes within a given radius of a position, sorted in ascending order
+		/**
+		The node index is built if it doesn't already exist.
+		*/
+		vector<int> GetNodesInRadius(XYZ Position, double dRadius) const;
+
 		/// Convert element index list to vector so can access by index
 		/**
 		\param ElementType The element type of the list to be converted
@@ -424,10 +498,13 @@ namespace TexGen
 
 		/// Save the mesh to VTK unstructured grid file format (.vtu)
 		/**
+		The file is written straight from the mesh storage. The binary formats are much smaller and faster to
+		write and read than ascii, appended raw data being written without any encoding.
 		\param Filename Name of the .vtu filename (extension will be automatically appended if ommited)
 		\param pMeshData Contains a vector of additional data attached to nodes or elements that should be saved
+		\param Format Encoding of the data arrays
 		*/
-		bool SaveToVTK(string Filename, const vector<CMeshDataBase*> *pMeshData = NULL) const;
+		bool SaveToVTK(string Filename, const vector<CMeshDataBase*> *pMeshData = NULL, VTK_FORMAT Format = VTK_ASCII) const;
 
 		/// Save the mesh to ABAQUS input file format with information such as yarn tangents
 		/**
@@ -493,11 +570,38 @@ namespace TexGen
 		void SetNumNodes(int NumNodes);
 
 		/// Get the element indices of a given element type
-		const list<int>& GetIndices(ELEMENT_TYPE ElemType) const;
-		list<int>& GetIndices(ELEMENT_TYPE ElemType);
+		/**
+		Each element takes GetNumNodes(ElemType) consecutive entries. These used to be returned as a list<int>,
+		code holding the result in a list<int> reference or iterator must now use vector<int> instead.
+		*/
+		const vector<int>& GetIndices(ELEMENT_TYPE ElemType) const;
+		vector<int>& GetIndices(ELEMENT_TYPE ElemType);
 
 
 	protected:
+		/// Ways of building a key from the indices of an element
+		enum KEY_TYPE
+		{
+			KEY_ORDERED,			///< Indices in the order they are stored
+			KEY_SORTED,				///< Indices sorted in ascending order
+			KEY_CYCLE,				///< Indices rotated to give the smallest sequence, identifies a surface element and its orientation
+			KEY_REVERSED_CYCLE,		///< As KEY_CYCLE for the element with its orientation reversed
+		};
+
+		/// Get a key for each element of a given type, the keys are stored contiguously with GetNumNodes(ElementType) indices each
+		void GetElementKeys(ELEMENT_TYPE ElementType, KEY_TYPE KeyType, vector<int> &Keys) const;
+
+		/// Give each distinct key an id, numbered in order of first appearance
+		/**
+		\param Keys Keys of iKeySize indices stored contiguously
+		\param Ids Set to the id of each key
+		\return The number of distinct keys
+		*/
+		static int GetKeyIds(const vector<int> &Keys, int iKeySize, vector<int> &Ids);
+
+		/// Get the key id of each surface element and of the same element with its orientation reversed
+		int GetOpposingKeyIds(ELEMENT_TYPE ElementType, vector<int> &Ids, vector<int> &OpposingIds) const;
+
 		/// Add an edge to the stack of edges if it doesn't already exist otherwise if it exists delete it
 		/**
 		This function is used in conjunction with MeshConvexHull.
@@ -506,13 +610,32 @@ namespace TexGen
 
 		static void WriteBinaryXYZ(ostream &Output, XYZ Vector);
 
-		int FillVTKPointData(TiXmlElement &Points) const;
-		int FillVTKCellData(TiXmlElement &Cells) const;
+		/// Find node pairs (A, B) where A == B + Vector, used by GetNodePairs
+		/**
+		If more than one node matches, the one with the lowest index is paired. If bPreferLaterNodes
+		is true nodes with an index greater or equal to A are preferred before those with a lower index.
+		*/
+		void FindNodePairs(XYZ Vector, vector<pair<int, int> > &NodePairs, double TOL, bool bPreferLaterNodes) const;
+
+		/// Check the closest node index is usable, rebuilding it if many nodes have been appended since it was built
+		bool UpdateNodeIndex() const;
+
+		/// Find the closest node using the node index, the index must be up to date
+		int FindIndexedClosestNode(const XYZ &Position, double &dDistSqrd) const;
+
+		/// Add the points of the mesh to the VTK file
+		void WriteVTKPoints(CVTKWriter &Writer) const;
+		/// Add the connectivity, offsets and types of the elements to the VTK file
+		void WriteVTKCells(CVTKWriter &Writer) const;
+		/// Get the VTK cell type of an element type, 0 if it can't be saved to VTK
+		static int GetVTKElementType(ELEMENT_TYPE Type);
 
 		/// List of nodes
 		vector<XYZ> m_Nodes;
 		/// Map of indices into the nodes
-		list<int> m_Indices[NUM_ELEMENT_TYPES];
+		vector<int> m_Indices[NUM_ELEMENT_TYPES];
+		/// Optional index of the nodes for closest node queries
+		mutable CNodeKDTree m_NodeIndex;
 
 	};
 
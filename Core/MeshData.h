@@ -18,6 +18,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 =============================================================================*/
 
 #pragma once
+#include "VTKWriter.h"
 
 namespace TexGen
 {
@@ -34,7 +35,8 @@ namespace TexGen
 		CMeshDataBase(string Name, DATA_TYPE Type) : m_Name(Name), m_DataType(Type) {}
 		virtual ~CMeshDataBase() {}
 
-		virtual void InsertVTKData(TiXmlElement &Parent) const = 0;
+		/// Add the data to the element of the VTK file being written
+		virtual void WriteVTKData(CVTKWriter &Writer) const = 0;
 
 		string m_Name;
 		DATA_TYPE m_DataType;
@@ -46,79 +48,30 @@ namespace TexGen
 	public:
 		CMeshData(string Name, DATA_TYPE Type) : CMeshDataBase(Name, Type) {}
 
-		void InsertVTKData(TiXmlElement &Parent) const
+		void WriteVTKData(CVTKWriter &Writer) const
 		{
-			ostringstream DataStream;
-			typename vector<T>::const_iterator itData;
-			for (itData = m_Data.begin(); itData != m_Data.end(); ++itData)
-			{
-				WriteVTKDataElement(DataStream, *itData) << " ";
-			}
-/*			for(unsigned int i=0; i<m_Data.size(); ++i)
-			{
-				WriteVTKDataElement(DataStream, m_Data[i]) << " ";
-			}*/
-			TiXmlElement Element("DataArray");
-			{
-				Element.SetAttribute("type", GetVTKDataType());
-				Element.SetAttribute("NumberOfComponents", GetNumberOfComponents());
-				Element.SetAttribute("format", "ascii");
-				Element.SetAttribute("Name", m_Name.c_str());
-				Element.InsertEndChild(TiXmlText(DataStream.str()));
-			}
-			Parent.InsertEndChild(Element);
+			string Attributes = "type=\"" + GetVTKDataType() + "\" NumberOfComponents=\"" + stringify(GetNumberOfComponents()) + "\" ";
+			Attributes += Writer.GetFormatAttributes() + " Name=\"" + CVTKWriter::EncodeAttribute(m_Name) + "\"";
+			// The values are written straight from m_Data
+			Writer.AddDataArray(Attributes, m_Data.size()*sizeof(T), [this, &Writer]() { WriteVTKValues(Writer); });
 		}
 		static string GetVTKDataType()
 		{
-			// Data type unknown?
-			assert(false);
-			return "";
+			return CVTKWriter::GetDataType<T>();
 		}
 		static int GetNumberOfComponents()
 		{
 			return 1;
 		}
-		ostream &WriteVTKDataElement(ostream &output, T Element) const
+		void WriteVTKValues(CVTKWriter &Writer) const
 		{
-			output << Element;
-			return output;
+			if (!m_Data.empty())
+				Writer.WriteValues(&m_Data[0], m_Data.size());
 		}
 
 		vector<T> m_Data;
 	};
 
-	// Need some specialisations on the char to make sure it gets output as an integer rather than a character
-	template <>
-	inline ostream &CMeshData<char>::WriteVTKDataElement(ostream &output, char Element) const
-	{
-		output << (int)Element;
-		return output;
-	}
-	template <>
-	inline ostream &CMeshData<unsigned char>::WriteVTKDataElement(ostream &output, unsigned char Element) const
-	{
-		output << (int)Element;
-		return output;
-	}
-
-	#define DEFINE_INT_DATA_TYPE(TYPE) template <> inline string CMeshData<TYPE>::GetVTKDataType() {return "Int" + stringify(sizeof(TYPE)*8);}
-	#define DEFINE_UINT_DATA_TYPE(TYPE) template <> inline string CMeshData<TYPE>::GetVTKDataType() {return "UInt" + stringify(sizeof(TYPE)*8);}
-
-	DEFINE_INT_DATA_TYPE(char)
-	DEFINE_INT_DATA_TYPE(short)
-	DEFINE_INT_DATA_TYPE(int)
-	DEFINE_INT_DATA_TYPE(long)
-	DEFINE_UINT_DATA_TYPE(unsigned char)
-	DEFINE_UINT_DATA_TYPE(unsigned short)
-	DEFINE_UINT_DATA_TYPE(unsigned int)
-	DEFINE_UINT_DATA_TYPE(unsigned long)
-
-	#undef DEFINE_INT_DATA_TYPE
-	#undef DEFINE_UINT_DATA_TYPE
-
-	template <> string inline CMeshData<float>::GetVTKDataType() {return "Float" + stringify(sizeof(float)*8);}
-	template <> string inline CMeshData<double>::GetVTKDataType() {return "Float" + stringify(sizeof(double)*8);}
-
 	////////////////////////////////////////
 	// DEFINE THE USER-DEFINED DATA TYPES //
 	////////////////////////////////////////
@@ -135,10 +88,23 @@ namespace TexGen
 		return 3;
 	}
 	template <>
-	inline ostream &CMeshData<XYZ>::WriteVTKDataElement(ostream &output, XYZ Element) const
+	inline void CMeshData<XYZ>::WriteVTKValues(CVTKWriter &Writer) const
 	{
-		output << Element.x << " " << Element.y << " " << Element.z;
-		return output;
+		// Copied in blocks so that only the components are written
+		const size_t BLOCK_SIZE = 1024;
+		double Values[3*BLOCK_SIZE];
+		size_t i, j;
+		for (i=0; i<m_Data.size(); i+=BLOCK_SIZE)
+		{
+			size_t iNumValues = min(BLOCK_SIZE, m_Data.size()-i);
+			for (j=0; j<iNumValues; ++j)
+			{
+				Values[3*j] = m_Data[i+j].x;
+				Values[3*j+1] = m_Data[i+j].y;
+				Values[3*j+2] = m_Data[i+j].z;
+			}
+			Writer.WriteValues(Values, 3*iNumValues);
+		}
 	}
 
 	/// XY
@@ -153,10 +119,21 @@ namespace TexGen
 		return 2;
 	}
 	template <>
-	inline ostream &CMeshData<XY>::WriteVTKDataElement(ostream &output, XY Element) const
+	inline void CMeshData<XY>::WriteVTKValues(CVTKWriter &Writer) const
 	{
-		output << Element.x << " " << Element.y;
-		return output;
+		const size_t BLOCK_SIZE = 1024;
+		double Values[2*BLOCK_SIZE];
+		size_t i, j;
+		for (i=0; i<m_Data.size(); i+=BLOCK_SIZE)
+		{
+			size_t iNumValues = min(BLOCK_SIZE, m_Data.size()-i);
+			for (j=0; j<iNumValues; ++j)
+			{
+				Values[2*j] = m_Data[i+j].x;
+				Values[2*j+1] = m_Data[i+j].y;
+			}
+			Writer.WriteValues(Values, 2*iNumValues);
+		}
 	}
 
 };	// namespace TexGen
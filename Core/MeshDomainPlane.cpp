@@ -54,10 +54,10 @@ void CMeshDomainPlane::MeshDomainPlanes( bool bPeriodic )
 
 	for (itDomainMeshes = m_DomainMeshes.begin(), i = 0; itDomainMeshes != m_DomainMeshes.end(); itDomainMeshes++, ++i)
 	{
-		const list<int> &QuadIndices = itDomainMeshes->GetIndices(CMesh::QUAD);
-		const list<int> &PolygonIndices = itDomainMeshes->GetIndices(CMesh::POLYGON);
-		list<int>::const_iterator itQuadIndices;
-		list<int>::const_iterator itPolyIndices;
+		const vector<int> &QuadIndices = itDomainMeshes->GetIndices(CMesh::QUAD);
+		const vector<int> &PolygonIndices = itDomainMeshes->GetIndices(CMesh::POLYGON);
+		vector<int>::const_iterator itQuadIndices;
+		vector<int>::const_iterator itPolyIndices;
 		vector<int> NumVertices;
 		vector<XY> HolePoints;
 		bool bIsQuad = QuadIndices.size() > 0;
@@ -169,9 +169,9 @@ void CMeshDomainPlane::MeshDomainPlanes( bool bPeriodic )
 
 
 
-bool CMeshDomainPlane::ConvertDomainPointsTo2D(const list<int> &Indices, CMesh& DomainMesh, int numNodes, vector<XY>& Points2D, PLANEPARAMS& ConvertRef)
+bool CMeshDomainPlane::ConvertDomainPointsTo2D(const vector<int> &Indices, CMesh& DomainMesh, int numNodes, vector<XY>& Points2D, PLANEPARAMS& ConvertRef)
 {
-	list<int>::const_iterator itIndices;
+	vector<int>::const_iterator itIndices;
 	itIndices = Indices.begin();
 	//for (itIndices = Indices.begin(); itIndices != Indices.end(); )
 	//{
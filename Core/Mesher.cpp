@@ -285,8 +285,8 @@ void CMesher::CreateVolumeMesh(CTextile &Textile)
 		CreateNodeSets( EdgeNodePairSets, CornerIndex, Repeats );
 	}
 
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
 	int iRegion;
 	for (i = 0; i < CMesh::NUM_ELEMENT_TYPES; ++i)
 	{
@@ -310,8 +310,8 @@ void CMesher::RaiseNodes(int iIndex)
 	insert_iterator<set<int> > iiYarnIndices(YarnIndices, YarnIndices.end());
 	set<int>::iterator itYarnIndex;
 
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
 	int i, j, iNode, iRegion;
 
 	// Find projected triangles which have node (iIndex) as a corner
@@ -472,8 +472,8 @@ void CMesher::SubdivideNodes(int iIndex)
 
 double CMesher::GetBestSeed(int iIndex)
 {
-	list<int>::iterator itIndex;
-	list<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
+	vector<int>::iterator itIndex;
+	vector<int> &Indices = m_ProjectedMesh.GetIndices(CMesh::TRI);
 	int iCorner[3];
 	int i;
 	double dEdgeLength = 0;
@@ -651,8 +651,8 @@ void CMesher::ConvertMeshToQuadratic()
 {
 	CMesh QuadraticMesh;
 	QuadraticMesh.GetNodes() = m_VolumeMesh.GetNodes();
-	const list<int> &Indices = m_VolumeMesh.GetIndices(CMesh::TET);
-	list<int>::const_iterator itIndex;
+	const vector<int> &Indices = m_VolumeMesh.GetIndices(CMesh::TET);
+	vector<int>::const_iterator itIndex;
 	int i1, i2, i3, i4;
 	for (itIndex = Indices.begin(); itIndex != Indices.end(); )
 	{
@@ -1091,7 +1091,7 @@ int CMesher::MixedMeshColumn(vector<RAISED_NODE> Columns[3], set<pair<int, int>
 		case 3:
 			{
 				// Mesh with wedge elements
-//				list<int> &Indices = m_VolumeMesh.GetIndices(CMesh::WEDGE);
+//				vector<int> &Indices = m_VolumeMesh.GetIndices(CMesh::WEDGE);
 				vector<int> Indices;
 				for (i=0; i<3; ++i)
 				{
@@ -1107,7 +1107,7 @@ int CMesher::MixedMeshColumn(vector<RAISED_NODE> Columns[3], set<pair<int, int>
 		case 2:
 			{
 				// Mesh with pyramid elements
-//				list<int> &Indices = m_VolumeMesh.GetIndices(CMesh::PYRAMID);
+//				vector<int> &Indices = m_VolumeMesh.GetIndices(CMesh::PYRAMID);
 				vector<int> Indices;
 				int iNoUp = 0;
 				for (i=0; i<3; ++i)
@@ -1130,7 +1130,7 @@ int CMesher::MixedMeshColumn(vector<RAISED_NODE> Columns[3], set<pair<int, int>
 		case 1:
 			{
 				// Mesh with wedge elements
-//				list<int> &Indices = m_VolumeMesh.GetIndices(CMesh::TET);
+//				vector<int> &Indices = m_VolumeMesh.GetIndices(CMesh::TET);
 				vector<int> Indices;
 				for (i=0; i<3; ++i)
 				{
@@ -1289,7 +1289,7 @@ void CMesher::FillYarnTangentsData()
 	//double dTolerance = 1e-1;
 	double dTolerance = 1e-5;
 	list<MESHER_ELEMENT_DATA>::iterator itElementData;
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	int i, iNumNodes;
 	int iNumYarns = m_pTextile->GetNumYarns();
 	bool bInside;
@@ -1302,10 +1302,11 @@ void CMesher::FillYarnTangentsData()
 			YarnTranslations[i] = pDomain->GetTranslations(*m_pTextile->GetYarn(i));
 		}
 	}
+	CYarnQueryContext Context;
 	int j;
 	for (j = 0; j < CMesh::NUM_ELEMENT_TYPES; ++j)
 	{
-		list<int> &Indices = m_VolumeMesh.GetIndices((CMesh::ELEMENT_TYPE)j);
+		vector<int> &Indices = m_VolumeMesh.GetIndices((CMesh::ELEMENT_TYPE)j);
 		list<MESHER_ELEMENT_DATA> &ElementData = m_ElementData[(CMesh::ELEMENT_TYPE)j];
 		iNumNodes = CMesh::GetNumNodes((CMesh::ELEMENT_TYPE)j);
 		for (itIndex = Indices.begin(), itElementData = ElementData.begin(); itIndex != Indices.end() && itElementData != ElementData.end(); ++itElementData)
@@ -1320,7 +1321,7 @@ void CMesher::FillYarnTangentsData()
 			if (itElementData->iYarnIndex >= 0 && itElementData->iYarnIndex < iNumYarns)
 			{
 				CYarn* pYarn = m_pTextile->GetYarn(itElementData->iYarnIndex);
-				bInside = pYarn->PointInsideYarn(AvgPos, YarnTranslations[itElementData->iYarnIndex], &itElementData->YarnTangent, &itElementData->Location, &itElementData->dVolumeFraction, &itElementData->dSurfaceDistance, dTolerance, &itElementData->Orientation, &itElementData->Up);
+				bInside = pYarn->PointInsideYarn(AvgPos, YarnTranslations[itElementData->iYarnIndex], &itElementData->YarnTangent, &itElementData->Location, &itElementData->dVolumeFraction, &itElementData->dSurfaceDistance, dTolerance, &itElementData->Orientation, &itElementData->Up, false, &Context);
 				//assert(bInside);
 				if ( !bInside )
 					TGLOG("PointInsideYarn false");
@@ -1610,9 +1611,9 @@ void CMesher::AddQuadraticNodesToSets()
 		}
 	}
 
-	const list<int> &Indices = m_VolumeMesh.GetIndices(CMesh::QUADRATIC_TET);
+	const vector<int> &Indices = m_VolumeMesh.GetIndices(CMesh::QUADRATIC_TET);
 	NumNodes = CMesh::GetNumNodes(CMesh::QUADRATIC_TET);
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	map<int,vector<int> >::iterator itEndIndices = FaceSetIndices.end();
 	
 	vector<int> iIndex;
@@ -1621,7 +1622,7 @@ void CMesher::AddQuadraticNodesToSets()
 		list<int> Faces;
 
 		iIndex.clear();
-		list<int>::const_iterator itEndIndex = itIndex;
+		vector<int>::const_iterator itEndIndex = itIndex;
 		advance( itEndIndex, NumNodes);
 		iIndex.insert( iIndex.begin(), itIndex, itEndIndex );
 		for ( int i = 0; i < 4; ++i )
@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "PrecompiledHeaders.h"
 #include "Misc.h"
 #include "../units/units.h"
+#include <mutex>
 
 namespace TexGen
 {
@@ -59,9 +60,13 @@ namespace TexGen
 		}
 	}
 
+	// The units library keeps its state in global variables so calls into it must be serialised
+	static std::mutex g_UnitsMutex;
+
 	// Warning possible memory leaks contained within the units library!!!
 	double ConvertUnits(double dValue, std::string SourceUnits, std::string TargetUnits)
 	{
+		std::lock_guard<std::mutex> Lock(g_UnitsMutex);
 		units_clear_exception();
 		double dResult = dValue*units_convert(const_cast<char*>(SourceUnits.c_str()), const_cast<char*>(TargetUnits.c_str()));
 		char* szError = units_check_exception();
@@ -72,6 +77,7 @@ namespace TexGen
 
 	bool CompatibleUnits(std::string SourceUnits, std::string TargetUnits, std::string *pErrorMessage)
 	{
+		std::lock_guard<std::mutex> Lock(g_UnitsMutex);
 		units_clear_exception();
 		units_convert(const_cast<char*>(SourceUnits.c_str()), const_cast<char*>(TargetUnits.c_str()));
 		char* szError = units_check_exception();
@@ -87,6 +93,7 @@ namespace TexGen
 
 	std::string ReduceUnits(std::string Units)
 	{
+		std::lock_guard<std::mutex> Lock(g_UnitsMutex);
 		units_clear_exception();
 		std::string Result = units_reduce(const_cast<char*>(Units.c_str()));
 		char* szError = units_check_exception();
@@ -97,6 +104,7 @@ namespace TexGen
 
 	void AddNewUnits(std::string NewUnit, std::string BaseUnits)
 	{
+		std::lock_guard<std::mutex> Lock(g_UnitsMutex);
 		units_clear_exception();
 		units_new(const_cast<char*>(NewUnit.c_str()), const_cast<char*>(BaseUnits.c_str()));
 		char* szError = units_check_exception();
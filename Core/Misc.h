@@ -113,6 +113,7 @@ namespace TexGen
 		INP_EXPORT,
 		VTU_EXPORT,
 		SCIRUN_EXPORT,
+		VTI_EXPORT,
 	};
 
 	enum DOMAIN_TYPE
@@ -259,6 +260,17 @@ namespace TexGen
 		}
 	}
 
+	inline void GetMinMaxXYZ(const std::vector<XYZ> &Points, XYZ &Min, XYZ &Max )
+	{
+		Min = Points[0];
+		Max = Points[0];
+		for ( int i = 1; i < (int)Points.size(); ++i )
+		{
+			Min = TexGen::Min( Min, Points[i] );
+			Max = TexGen::Max( Max, Points[i] );
+		}
+	}
+
 	enum PERIODIC_BOUNDARY_CONDITIONS
 	{
 		MATERIAL_CONTINUUM,
@@ -270,8 +282,9 @@ namespace TexGen
 		BENDING_BC,
 	};
 
-	template <typename T>
-	void WriteValues(std::ostream &Output, T &Values, int iMaxPerLine)
+	/// Write the values with iMaxPerLine values per line, to a stream or a CTextWriter
+	template <typename OUTPUT, typename T>
+	void WriteValues(OUTPUT &Output, T &Values, int iMaxPerLine)
 	{
 		int iLinePos = 0;
 		typename T::const_iterator itValue;
@@ -0,0 +1,145 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+
+#include "PrecompiledHeaders.h"
+#include "NodeKDTree.h"
+
+using namespace TexGen;
+
+/// Used to sort node indices by one coordinate of the nodes
+struct LessNodeAxis
+{
+	LessNodeAxis(const vector<XYZ> &Nodes, int iAxis) : m_Nodes(Nodes), m_iAxis(iAxis) {}
+	bool operator()(int i1, int i2) const { return m_Nodes[i1][m_iAxis] < m_Nodes[i2][m_iAxis]; }
+	const vector<XYZ> &m_Nodes;
+	int m_iAxis;
+};
+
+CNodeKDTree::CNodeKDTree()
+: m_bBuilt(false)
+{
+}
+
+void CNodeKDTree::Clear()
+{
+	m_bBuilt = false;
+	m_Order.clear();
+	m_Axis.clear();
+}
+
+void CNodeKDTree::Build(const vector<XYZ> &Nodes)
+{
+	m_Order.resize(Nodes.size());
+	m_Axis.assign(Nodes.size(), 0);
+	for (int i = 0; i < (int)Nodes.size(); ++i)
+		m_Order[i] = i;
+	BuildRange(Nodes, 0, (int)Nodes.size());
+	m_bBuilt = true;
+}
+
+void CNodeKDTree::BuildRange(const vector<XYZ> &Nodes, int iBegin, int iEnd)
+{
+	if (iEnd - iBegin <= 1)
+		return;
+
+	// Split along the axis with the largest extent
+	XYZ Min = Nodes[m_Order[iBegin]], Max = Min;
+	int i, iAxis;
+	for (i = iBegin+1; i < iEnd; ++i)
+	{
+		const XYZ &P = Nodes[m_Order[i]];
+		for (iAxis = 0; iAxis < 3; ++iAxis)
+		{
+			Min[iAxis] = min(Min[iAxis], P[iAxis]);
+			Max[iAxis] = max(Max[iAxis], P[iAxis]);
+		}
+	}
+	XYZ Size = Max - Min;
+	int iSplitAxis = 0;
+	if (Size.y > Size[iSplitAxis])
+		iSplitAxis = 1;
+	if (Size.z > Size[iSplitAxis])
+		iSplitAxis = 2;
+
+	int iMid = (iBegin + iEnd)/2;
+	nth_element(m_Order.begin()+iBegin, m_Order.begin()+iMid, m_Order.begin()+iEnd, LessNodeAxis(Nodes, iSplitAxis));
+	m_Axis[iMid] = (unsigned char)iSplitAxis;
+	BuildRange(Nodes, iBegin, iMid);
+	BuildRange(Nodes, iMid+1, iEnd);
+}
+
+int CNodeKDTree::GetClosestNode(const vector<XYZ> &Nodes, const XYZ &Position, double &dDistSqrd) const
+{
+	int iClosest = -1;
+	dDistSqrd = -1;
+	SearchClosest(Nodes, Position, 0, (int)m_Order.size(), iClosest, dDistSqrd);
+	return iClosest;
+}
+
+void CNodeKDTree::SearchClosest(const vector<XYZ> &Nodes, const XYZ &Position, int iBegin, int iEnd, int &iClosest, double &dClosestDistSqrd) const
+{
+	if (iBegin >= iEnd)
+		return;
+	int iMid = (iBegin + iEnd)/2;
+	int iNode = m_Order[iMid];
+	const XYZ &Node = Nodes[iNode];
+	double dDistSqrd = GetLengthSquared(Position, Node);
+	if (iClosest == -1 || dDistSqrd < dClosestDistSqrd || (dDistSqrd == dClosestDistSqrd && iNode < iClosest))
+	{
+		iClosest = iNode;
+		dClosestDistSqrd = dDistSqrd;
+	}
+	double dDiff = Position[m_Axis[iMid]] - Node[m_Axis[iMid]];
+	// Search the side containing the position first, then the other side if it could hold
+	// a node at least as close (equal distances are needed to find the lowest index)
+	if (dDiff < 0)
+	{
+		SearchClosest(Nodes, Position, iBegin, iMid, iClosest, dClosestDistSqrd);
+		if (dDiff*dDiff <= dClosestDistSqrd)
+			SearchClosest(Nodes, Position, iMid+1, iEnd, iClosest, dClosestDistSqrd);
+	}
+	else
+	{
+		SearchClosest(Nodes, Position, iMid+1, iEnd, iClosest, dClosestDistSqrd);
+		if (dDiff*dDiff <= dClosestDistSqrd)
+			SearchClosest(Nodes, Position, iBegin, iMid, iClosest, dClosestDistSqrd);
+	}
+}
+
+void CNodeKDTree::GetNodesInRadius(const vector<XYZ> &Nodes, const XYZ &Position, double dRadius, vector<int> &Indices) const
+{
+	SearchRadius(Nodes, Position, 0, (int)m_Order.size(), dRadius*dRadius, Indices);
+}
+
+void CNodeKDTree::SearchRadius(const vector<XYZ> &Nodes, const XYZ &Position, int iBegin, int iEnd, double dRadiusSqrd, vector<int> &Indices) const
+{
+	if (iBegin >= iEnd)
+		return;
+	int iMid = (iBegin + iEnd)/2;
+	int iNode = m_Order[iMid];
+	const XYZ &Node = Nodes[iNode];
+	if (GetLengthSquared(Position, Node) <= dRadiusSqrd)
+		Indices.push_back(iNode);
+	double dDiff = Position[m_Axis[iMid]] - Node[m_Axis[iMid]];
+	if (dDiff <= 0 || dDiff*dDiff <= dRadiusSqrd)
+		SearchRadius(Nodes, Position, iBegin, iMid, dRadiusSqrd, Indices);
+	if (dDiff >= 0 || dDiff*dDiff <= dRadiusSqrd)
+		SearchRadius(Nodes, Position, iMid+1, iEnd, dRadiusSqrd, Indices);
+}
@@ -0,0 +1,74 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+
+#pragma once
+
+namespace TexGen
+{
+	using namespace std;
+
+	/// Balanced k-d tree over a set of nodes for closest node and radius queries
+	/**
+	The tree only stores the order of the node indices, the node positions themselves are
+	passed in with each query and must be the same as those the tree was built with. Nodes
+	appended after the tree was built are not part of it and must be checked separately.
+	Ties between nodes at the same distance are resolved in favour of the lowest index so
+	results match a linear search over the nodes.
+	*/
+	class CLASS_DECLSPEC CNodeKDTree
+	{
+	public:
+		CNodeKDTree();
+
+		/// Build the tree over the given nodes
+		void Build(const vector<XYZ> &Nodes);
+
+		/// Remove all nodes from the tree
+		void Clear();
+
+		/// Get the number of nodes the tree was built with
+		int GetNumNodes() const { return (int)m_Order.size(); }
+
+		/// Check whether the tree has been built
+		bool IsBuilt() const { return m_bBuilt; }
+
+		/// Get the node closest to a position
+		/**
+		\param Nodes The nodes the tree was built with
+		\param Position The position to find the closest node to
+		\param dDistSqrd Set to the squared distance to the closest node
+		\return The index of the closest node or -1 if the tree is empty
+		*/
+		int GetClosestNode(const vector<XYZ> &Nodes, const XYZ &Position, double &dDistSqrd) const;
+
+		/// Add the indices of the nodes within a radius of a position to a list, in no particular order
+		void GetNodesInRadius(const vector<XYZ> &Nodes, const XYZ &Position, double dRadius, vector<int> &Indices) const;
+
+	protected:
+		void BuildRange(const vector<XYZ> &Nodes, int iBegin, int iEnd);
+		void SearchClosest(const vector<XYZ> &Nodes, const XYZ &Position, int iBegin, int iEnd, int &iClosest, double &dClosestDistSqrd) const;
+		void SearchRadius(const vector<XYZ> &Nodes, const XYZ &Position, int iBegin, int iEnd, double dRadiusSqrd, vector<int> &Indices) const;
+
+		bool m_bBuilt;
+		vector<int> m_Order;	///< Node indices, the node splitting each range is stored at its middle
+		vector<unsigned char> m_Axis;	///< Axis the node at each position splits its range along
+	};
+
+};	// namespace TexGen
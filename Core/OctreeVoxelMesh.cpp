@@ -27,9 +27,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 using namespace TexGen;
 
-//CTextile gTextile;
-//pair<XYZ, XYZ>	g_DomainAABB;
-
 static const int    corner_num_hanging[P4EST_CHILDREN] =
 #ifndef P4_TO_P8
 { 1, 2, 2, 1 }
@@ -40,7 +37,6 @@ static const int    corner_num_hanging[P4EST_CHILDREN] =
 
 static const int    zero = 0;           /**< Constant zero. */
 static const int    ones = P4EST_CHILDREN - 1;  /**< One bit per dimension. */
-static const int   *corner_to_hanging[P4EST_CHILDREN];
 
 /** For each node i of the reference quadrant, corner_num_hanging[i] many. */
 // This stuff is defined in P4EST but by some reason it is "unresolved" when compiled
@@ -65,23 +61,17 @@ const int           p8est_edge_corners[12][2] =
  { 2, 6 },
  { 3, 7 }};
 
-int COctreeVoxelMesh::max_level;
-
-vector<XYZ> COctreeVoxelMesh::cornerPoints;
-vector<XYZ> COctreeVoxelMesh::CentrePoints;
-
-vector<vector<int>> COctreeVoxelMesh::FaceX_min;
-vector<vector<int>> COctreeVoxelMesh::FaceX_max;
-vector<vector<int>> COctreeVoxelMesh::FaceY_min;
-vector<vector<int>> COctreeVoxelMesh::FaceY_max;
-vector<vector<int>> COctreeVoxelMesh::FaceZ_min;
-vector<vector<int>> COctreeVoxelMesh::FaceZ_max;
+// Assign independent nodes for hanging nodes (this piece is copied from one of the examples provided with p4est)
+static const int   *const corner_to_hanging[P4EST_CHILDREN] =
+{ &zero,
+  p8est_edge_corners[0],
+  p8est_edge_corners[4],
+  p8est_face_corners[4],
+  p8est_edge_corners[8],
+  p8est_face_corners[2],
+  p8est_face_corners[0],
+  &ones };
 
-CTextile COctreeVoxelMesh::gTextile;
-pair<XYZ, XYZ>	COctreeVoxelMesh::g_DomainAABB;
-vector<char> COctreeVoxelMesh::materialInfo; 
-
-int g_XVoxels, g_YVoxels, g_ZVoxels;
 
 // Tolerance is quarter of the max refinement
 int my_comparison(double x, double y) 
@@ -160,86 +150,77 @@ pair<int, int> most_common(vector<int> v) {
 
 // P4EST should be initialised with initial coordinates of the unit cell vertices
 // TODO: Try to initialise P4EST with several elements to have better refinement in a certain direction
-int COctreeVoxelMesh::writeTempFile(string filename, pair<XYZ, XYZ> myDomain) 
+p4est_connectivity_t *COctreeVoxelMesh::CreateConnectivity() const
 {
-	ofstream TempFile(filename);
-	if (!TempFile) {
-		TGERROR("Cannot create an initialisation *.inp file " << filename);
-		return -1;
-	}
-	TempFile << "*HEADING" << "\n";
-	TempFile << "This is a temp input for the octree refinement" << "\n";
-	TempFile << "*NODE" << "\n";
-
-	if ( false )
-	{
-		// Starting from a single element mesh
-		TempFile << "1, " << myDomain.first.x<< ", " << myDomain.first.y << ", " << myDomain.first.z << "\n";
-		TempFile << "2, " << myDomain.second.x << ", " << myDomain.first.y << ", " << myDomain.first.z << "\n";
-		TempFile << "3, " << myDomain.first.x << ", " << myDomain.second.y << ", " << myDomain.first.z << "\n";
-		TempFile << "4, " << myDomain.second.x << ", " << myDomain.second.y << ", " << myDomain.first.z << "\n";
-
-		TempFile << "5, " << myDomain.first.x <<", " << myDomain.first.y << ", " << myDomain.second.z << "\n";
-		TempFile << "6, " << myDomain.second.x << ", " << myDomain.first.y << ", " << myDomain.second.z << "\n";
-		TempFile << "7, " << myDomain.first.x << ", " << myDomain.second.y << ", " << myDomain.second.z << "\n";
-		TempFile << "8, " << myDomain.second.x << ", " << myDomain.second.y << ", " << myDomain.second.z << "\n";
-		TempFile << "*ELEMENT,TYPE=C3D8R" << "\n";
-		TempFile << "1, 5, 7, 3, 1, 6, 8, 4, 2" << "\n";
-	}
-	else
+	// One tree for each voxel, the vertices are the corners of the voxels
+	int numx = m_XVoxels + 1;
+	int numy = m_YVoxels + 1;
+	int numz = m_ZVoxels + 1;
+	p4est_topidx_t num_vertices = (p4est_topidx_t)numx * numy * numz;
+	p4est_topidx_t num_trees = (p4est_topidx_t)m_XVoxels * m_YVoxels * m_ZVoxels;
+
+	p4est_connectivity_t *connectivity = p4est_connectivity_new(num_vertices, num_trees, 0, 0, 0, 0);
+	if (connectivity == NULL)
+		return NULL;
+
+	XYZ DomSize = m_DomainAABB.second - m_DomainAABB.first;
+	double VoxSize[3];
+	VoxSize[0] = DomSize.x / m_XVoxels;
+	VoxSize[1] = DomSize.y / m_YVoxels;
+	VoxSize[2] = DomSize.z / m_ZVoxels;
+
+	int x, y, z, i;
+	double *pVertex = connectivity->vertices;
+	for ( z = 0; z < numz; ++z )
 	{
-
-		XYZ DomSize;
-		DomSize = myDomain.second - myDomain.first;	
-	
-		double m_VoxSize[3];
-		m_VoxSize[0] = DomSize.x / m_XVoxels;
-		m_VoxSize[1] = DomSize.y / m_YVoxels;
-		m_VoxSize[2] = DomSize.z / m_ZVoxels;
-
-		int iNodeIndex = 1;
-		int x,y,z;
-
-		for ( z = 0; z <= m_ZVoxels; ++z )
+		for ( y = 0; y < numy; ++y )
 		{
-			for ( y = 0; y <= m_YVoxels; ++y )
+			for ( x = 0; x < numx; ++x )
 			{
-				for ( x = 0; x <=m_XVoxels; ++x )
-				{
-					XYZ Point;
-					Point.x = myDomain.first.x + m_VoxSize[0] * x;
-					Point.y = myDomain.first.y + m_VoxSize[1] * y;
-					Point.z = myDomain.first.z + m_VoxSize[2] * z;
-					TempFile << iNodeIndex << ", " << Point << "\n";
-					++iNodeIndex;
-				}
+				*(pVertex++) = m_DomainAABB.first.x + VoxSize[0] * x;
+				*(pVertex++) = m_DomainAABB.first.y + VoxSize[1] * y;
+				*(pVertex++) = m_DomainAABB.first.z + VoxSize[2] * z;
 			}
 		}
+	}
 
-		TempFile << "*ELEMENT,TYPE=C3D8R" << "\n";
-		int iElementNumber = 1;
-		int numx = m_XVoxels + 1;
-		int numy = m_YVoxels + 1;
-
-		for ( z = 0; z < m_ZVoxels; ++z )
+	// Voxel corners in the order of the tree corners. This is the orientation the trees had when the
+	// connectivity was read from an ABAQUS input file and the refinement depends on it
+	const int Corners[P4EST_CHILDREN][3] = 
+	{{ 0, 0, 1 },
+	 { 0, 1, 1 },
+	 { 0, 0, 0 },
+	 { 0, 1, 0 },
+	 { 1, 0, 1 },
+	 { 1, 1, 1 },
+	 { 1, 0, 0 },
+	 { 1, 1, 0 }};
+
+	p4est_topidx_t iTree = 0;
+	for ( z = 0; z < m_ZVoxels; ++z )
+	{
+		for ( y = 0; y < m_YVoxels; ++y )
 		{
-			for ( y = 0; y < m_YVoxels; ++y )
+			for ( x = 0; x < m_XVoxels; ++x )
 			{
-				for ( x = 0; x < m_XVoxels; ++x )
+				for ( i = 0; i < P4EST_CHILDREN; ++i )
+				{
+					connectivity->tree_to_vertex[P4EST_CHILDREN * iTree + i] = 
+						(x + Corners[i][0]) + (y + Corners[i][1]) * numx + (z + Corners[i][2]) * numx * numy;
+				}
+				// Each tree is its own neighbour until the connectivity is completed
+				for ( i = 0; i < P4EST_FACES; ++i )
 				{
-					TempFile << iElementNumber << ", ";
-					TempFile << x +y*numx + (z+1)*numx*numy + 1 << ", " << x +(y+1)*numx + (z+1)*numx*numy + 1 << ", ";
-					TempFile << x + (y+1)*numx + z*numx*numy + 1 << ", " << x + y*numx + z*numx*numy + 1  << ", ";
-					TempFile << (x+1) +y*numx + (z+1)*numx*numy + 1 << ", " << (x+1) +(y+1)*numx + (z+1)*numx*numy + 1 << ", ";
-					TempFile << (x+1) + (y+1)*numx + z*numx*numy + 1 << ", " << (x+1) +y*numx + z*numx*numy + 1 << "\n";
-					++iElementNumber;
+					connectivity->tree_to_tree[P4EST_FACES * iTree + i] = iTree;
+					connectivity->tree_to_face[P4EST_FACES * iTree + i] = i;
 				}
+				++iTree;
 			}
 		}
 	}
 
-	TempFile.close();
-	return 0;
+	p4est_connectivity_complete(connectivity);
+	return connectivity;
 }
 
 vector<int> GetFaceIndices(CMesh::ELEMENT_TYPE ElemType, const set<int> &NodeIndices)
@@ -328,18 +309,34 @@ COctreeVoxelMesh::COctreeVoxelMesh(string Type)
 :CVoxelMesh(Type)
 {
 	m_bTet = false;
+	max_level = 0;
+	numClassified = 0;
+	onDemandInfo = true;
+	p4est = NULL;
+	conn = NULL;
 }
 
 COctreeVoxelMesh::~COctreeVoxelMesh(void)
 {
-	p4est_destroy (p4est);
-	TGLOG("P4est object destroyed");
-	p4est_connectivity_destroy (conn);
-	TGLOG("Connectivity destoyed");
+	DestroyP4EST();
 	m_ElementsInfo.clear();
 	//Centre
 }
 
+void COctreeVoxelMesh::DestroyP4EST()
+{
+	if (p4est) {
+		p4est_destroy (p4est);
+		p4est = NULL;
+		TGLOG("P4est object destroyed");
+	}
+	if (conn) {
+		p4est_connectivity_destroy (conn);
+		conn = NULL;
+		TGLOG("Connectivity destoyed");
+	}
+}
+
 // Boundaries are in format:
 int COctreeVoxelMesh::isBoundary(double point[3]) 
 {
@@ -540,6 +537,7 @@ void COctreeVoxelMesh::OutputPeriodicBoundaries(ostream &Output, CTextile& Texti
 
 int COctreeVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, bool bOutputYarn, int Filetype ) 
 {
+	CTextWriter Writer(Output);
 	CTimer timer;
 	timer.start("Writing elements");
 	vector<vector<int>>::iterator itElements;
@@ -550,14 +548,14 @@ int COctreeVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, boo
 	{
 		TGLOG("START WRITING ELEMENTS " << m_TetElements.size());
 		for (auto itElem = m_TetElements.begin(); itElem != m_TetElements.end(); ++itElem) {
-			Output << elem_count ++ << ", ";
+			Writer << elem_count ++ << ", ";
 			for (itNodes = itElem->begin(), i = 1; itNodes != itElem->end(); itNodes++, i++) {
-				Output << *itNodes;
+				Writer << *itNodes;
 				if (i < 4) {
-					Output << ", ";
+					Writer << ", ";
 				}
 			}
-		Output << "\n";
+		Writer << "\n";
 		}
 //		return 0;
 	} 
@@ -567,14 +565,14 @@ int COctreeVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, boo
 		TGLOG("START WRITING ELEMENTS " << m_AllElements.size());
 	
 		for (itElements = m_AllElements.begin(); itElements != m_AllElements.end(); itElements++) {
-			Output << elem_count ++ << ", ";
+			Writer << elem_count ++ << ", ";
 			for (itNodes = itElements->begin(), i = 1; itNodes != itElements->end(); itNodes++, i++) {
-				Output << *itNodes;
+				Writer << *itNodes;
 				if (i < 8) {
-					Output << ", ";
+					Writer << ", ";
 				}
 			}
-			Output << "\n";
+			Writer << "\n";
 		}
 	}
 
@@ -588,23 +586,23 @@ int COctreeVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, boo
 		map<int, vector<int>>::iterator itSurfaceNodes;
 		for (itSurfaceNodes = m_SurfaceNodes.begin(); itSurfaceNodes != m_SurfaceNodes.end(); ++itSurfaceNodes) {
 			if ( itSurfaceNodes->first == -1) {
-				Output << "*NSET, NSET=SURFACE-NODES-MATRIX" << "\n";
+				Writer << "*NSET, NSET=SURFACE-NODES-MATRIX" << "\n";
 			} else {
-				Output << "*NSET, NSET=SURFACE-NODES-YARN" << itSurfaceNodes->first << "\n";
+				Writer << "*NSET, NSET=SURFACE-NODES-YARN" << itSurfaceNodes->first << "\n";
 			}
-			WriteValues(Output, itSurfaceNodes->second, 16);
+			WriteValues(Writer, itSurfaceNodes->second, 16);
 		}
 
 		map<int, vector< pair<int,int> > >::iterator itSurfaceFaces;
 		for (itSurfaceFaces = m_SurfaceElementFaces.begin(); itSurfaceFaces != m_SurfaceElementFaces.end(); ++itSurfaceFaces) {
 			if (itSurfaceFaces->first == -1) {
-				Output << "*SURFACE, NAME=SURFACE-MATRIX" << "\n";
+				Writer << "*SURFACE, NAME=SURFACE-MATRIX" << "\n";
 			} else {
-				Output << "*SURFACE, NAME=SURFACE-YARN" << itSurfaceFaces->first << "\n";
+				Writer << "*SURFACE, NAME=SURFACE-YARN" << itSurfaceFaces->first << "\n";
 			}
 			vector< pair<int, int> >::iterator itFaces;
 			for (itFaces = itSurfaceFaces->second.begin(); itFaces != itSurfaceFaces->second.end(); ++itFaces) {
-				Output << itFaces->first << ", S" << itFaces->second << "\n";
+				Writer << itFaces->first << ", S" << itFaces->second << "\n";
 			}
 		}
 
@@ -621,14 +619,14 @@ int COctreeVoxelMesh::refine_fn_uni(p4est_t * p4est, p4est_topidx_t which_tree,
 	return 1;
 }
 
-void COctreeVoxelMesh::FindLocMinMax( int& XMin, int& XMax, int& YMin, int& YMax, XYZ& Min, XYZ& Max )
+void COctreeVoxelMesh::FindLocMinMax( int& XMin, int& XMax, int& YMin, int& YMax, XYZ& Min, XYZ& Max ) const
 {
-	double x_dist = (g_DomainAABB.second.x - g_DomainAABB.first.x)/pow(2, max_level);
-	double y_dist = (g_DomainAABB.second.y - g_DomainAABB.first.y)/pow(2, max_level);
-	XMin = (int)floor((Min.x - g_DomainAABB.first.x)/ x_dist);
-	XMax = (int)ceil((Max.x - g_DomainAABB.first.x) / x_dist);
-	YMin = (int)floor((Min.y - g_DomainAABB.first.y) / y_dist);
-	YMax = (int)ceil((Max.y - g_DomainAABB.first.y) / y_dist);
+	double x_dist = (m_DomainAABB.second.x - m_DomainAABB.first.x)/pow(2, max_level);
+	double y_dist = (m_DomainAABB.second.y - m_DomainAABB.first.y)/pow(2, max_level);
+	XMin = (int)floor((Min.x - m_DomainAABB.first.x)/ x_dist);
+	XMax = (int)ceil((Max.x - m_DomainAABB.first.x) / x_dist);
+	YMin = (int)floor((Min.y - m_DomainAABB.first.y) / y_dist);
+	YMax = (int)ceil((Max.y - m_DomainAABB.first.y) / y_dist);
 }
 
 // Refine all boundary elememnts to the maximum
@@ -641,9 +639,11 @@ int COctreeVoxelMesh::refine_fn_periodic(p4est_t * p4est, p4est_topidx_t which_t
 	p4est_quadrant_t node_quadrant;
 	XYZ Min, Max;
 	double vxyz[3];
+	const COctreeVoxelMesh *pMesh = (const COctreeVoxelMesh*)p4est->user_pointer;
+	const pair<XYZ, XYZ> &DomainAABB = pMesh->m_DomainAABB;
 
 	// Don't refine more than needed
-	if (quadrant->level > max_level - 1) {
+	if (quadrant->level > pMesh->max_level - 1) {
 		return 0;
 	}
 
@@ -678,17 +678,17 @@ int COctreeVoxelMesh::refine_fn_periodic(p4est_t * p4est, p4est_topidx_t which_t
 	}
 
 	// X boundaries
-	if (my_comparison(Min.x, g_DomainAABB.first.x) || my_comparison(Max.x, g_DomainAABB.second.x) ) {
+	if (my_comparison(Min.x, DomainAABB.first.x) || my_comparison(Max.x, DomainAABB.second.x) ) {
 		return 1;
 	}
 	
 	// Y boundaries
-	if ( my_comparison(Min.y, g_DomainAABB.first.y) || my_comparison(Max.y, g_DomainAABB.second.y) ) {
+	if ( my_comparison(Min.y, DomainAABB.first.y) || my_comparison(Max.y, DomainAABB.second.y) ) {
 		return 1;
 	}
 
 	// Z boundaries
-	if ( my_comparison(Min.z, g_DomainAABB.first.z) || my_comparison(Max.z, g_DomainAABB.second.z) ) {
+	if ( my_comparison(Min.z, DomainAABB.first.z) || my_comparison(Max.z, DomainAABB.second.z) ) {
 		return 1;
 	}
 
@@ -698,16 +698,8 @@ int COctreeVoxelMesh::refine_fn_periodic(p4est_t * p4est, p4est_topidx_t which_t
 // Refinement only if at least two dissimilar materials are within an element
 int COctreeVoxelMesh::refine_fn(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant)
 {
-	vector<XYZ> CornerPoints;
-	vector<POINT_INFO> CornerInfo;
-	XYZ Point;
-	int refine = 0;
-	p4est_quadrant_t node_quadrant;
-	double x_min, x_max, y_min, y_max, z_min, z_max;
-	double vxyz[3];
-	double cx, cy, cz;
-	cx = cy = cz = 0;
-	int trig = 0;
+	COctreeVoxelMesh *pMesh = (COctreeVoxelMesh*)p4est->user_pointer;
+	int max_level = pMesh->max_level;
 
 	// We do not want to refine deeper than a given maximum level. 
 	if (quadrant->level > max_level - 1) {
@@ -717,7 +709,26 @@ int COctreeVoxelMesh::refine_fn(p4est_t * p4est, p4est_topidx_t which_tree, p4es
 	if (quadrant->level <2) {
 		return 1;
 	}
-	
+
+	vector<XYZ> CornerPoints;
+	vector<XYZ> ExtraPoints;
+	getRefinePoints(p4est, which_tree, quadrant, CornerPoints, ExtraPoints);
+
+	if (pMesh->getPointsInfo(CornerPoints, max_level ) == 1 || pMesh->getPointsInfo(ExtraPoints, max_level) == 1 )
+		return 1;
+
+	return 0;
+}
+
+// Corners and centre of the element, and the same points moved slightly outwards from the centre
+void COctreeVoxelMesh::getRefinePoints(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant, vector<XYZ> &CornerPoints, vector<XYZ> &ExtraPoints)
+{
+	XYZ Point;
+	p4est_quadrant_t node_quadrant;
+	double vxyz[3];
+	double cx, cy, cz;
+	cx = cy = cz = 0;
+
 	for (int node_i=0; node_i < 8; node_i++) {
 		p4est_quadrant_corner_node(quadrant, node_i, &node_quadrant);
 		p4est_qcoord_to_vertex (p4est->connectivity, which_tree, node_quadrant.x, node_quadrant.y, node_quadrant.z, vxyz);
@@ -729,29 +740,9 @@ int COctreeVoxelMesh::refine_fn(p4est_t * p4est, p4est_topidx_t which_tree, p4es
 		cz += 1.0/8.0 *vxyz[2];
 
 		CornerPoints.push_back(Point);
-
-		if (node_i == 0) {
-			x_min = Point.x; x_max = Point.x;
-			y_min = Point.y; y_max = Point.y;
-			z_min = Point.z; z_max = Point.z;
-		} else {
-			if (Point.x < x_min)
-				x_min = Point.x;
-			if (Point.x > x_max)
-				x_max = Point.x;	
-			if (Point.y < y_min)
-				y_min = Point.y;
-			if (Point.y > y_max)
-				y_max = Point.y;
-			if (Point.z < z_min)
-				z_min = Point.z;
-			if (Point.z > z_max)
-				z_max = Point.z;
-		}
 	}
 
 	double coef = 1.01;
-	vector<XYZ> ExtraPoints;
 	for (int i = 0; i < 8; i++) {
 		XYZ NewPoint;
 		NewPoint.x = (CornerPoints[i].x - cx)*coef + cx;
@@ -761,19 +752,32 @@ int COctreeVoxelMesh::refine_fn(p4est_t * p4est, p4est_topidx_t which_tree, p4es
 	}
 	ExtraPoints.push_back(XYZ(cx, cy, cz));
 	CornerPoints.push_back(XYZ(cx, cy, cz));
+}
 
-	if (getPointsInfo(CornerPoints, max_level ) == 1 || getPointsInfo(ExtraPoints, max_level) == 1 )
-		return 1;
+// After main refinement is done we want to ensure that there are no hanging nodes at the surface
+int COctreeVoxelMesh::refine_fn_post(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant)
+{
+	COctreeVoxelMesh *pMesh = (COctreeVoxelMesh*)p4est->user_pointer;
+	int max_level = pMesh->max_level;
+
+	// We do not want to refine deeper than a given maximum level. 
+	if (quadrant->level > max_level -1) {
+		return 0;
+	}
+
+	vector<XYZ> ExtraPoints;
+	getPostRefinePoints(p4est, which_tree, quadrant, ExtraPoints);
 
+	if (pMesh->getPointsInfo(ExtraPoints, max_level) == 1)
+		return 1;
+	
 	return 0;
 }
 
-// After main refinement is done we want to ensure that there are no hanging nodes at the surface
-int COctreeVoxelMesh::refine_fn_post(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant)
+// Centre of the element and points around it reaching into the neighbouring elements
+void COctreeVoxelMesh::getPostRefinePoints(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant, vector<XYZ> &ExtraPoints)
 {
 	vector<XYZ> CornerPoints;
-	vector<XYZ> ExtraPoints;
-	vector<POINT_INFO> ExtraInfo;
 	XYZ Point;
 	p4est_quadrant_t node_quadrant;
 	double vxyz[3];
@@ -782,13 +786,6 @@ int COctreeVoxelMesh::refine_fn_post(p4est_t * p4est, p4est_topidx_t which_tree,
 	CentrePoint.y = 0;
 	CentrePoint.z = 0;
 
-	// We do not want to refine deeper than a given maximum level. 
-	if (quadrant->level > max_level -1) {
-		return 0;
-	}
-
-	
-	//int trig = 0;
 	for (int i = 0; i < 8; i++) {
 		p4est_quadrant_corner_node(quadrant, i, &node_quadrant);
 		p4est_qcoord_to_vertex (p4est->connectivity, which_tree, node_quadrant.x, node_quadrant.y, node_quadrant.z, vxyz);
@@ -852,27 +849,22 @@ int COctreeVoxelMesh::refine_fn_post(p4est_t * p4est, p4est_topidx_t which_tree,
 		NewPoint.z = (CornerPoints[i].z - CentrePoint.z)*coef + CentrePoint.z;
 		ExtraPoints.push_back(NewPoint);
 	}
-	
-	if (getPointsInfo(ExtraPoints, max_level) == 1)
-		return 1;
-	
-	return 0;
 }
 
-// Return 1 is at least one of the points is not the same material as others
-// Return 0 is all the points are from the same materials
-int COctreeVoxelMesh::getPointsInfo(vector<XYZ> myPoints, int refineLevel)
+// Index of the point of the finest lattice closest to the given point, after moving the point inside the domain
+// Index is set to the lattice coordinates and if pLatticePoint is not NULL it is set to the position of the lattice point
+long long COctreeVoxelMesh::getLatticeIndex(const XYZ &Point, int refineLevel, int Index[3], XYZ *pLatticePoint) const
 {
-	double x0 = g_DomainAABB.first.x;
-	double y0 = g_DomainAABB.first.y;
-	double z0 = g_DomainAABB.first.z;
-	double x_length = g_DomainAABB.second.x - x0;
-	double y_length = g_DomainAABB.second.y - y0;
-	double z_length = g_DomainAABB.second.z - z0;
+	double x0 = m_DomainAABB.first.x;
+	double y0 = m_DomainAABB.first.y;
+	double z0 = m_DomainAABB.first.z;
+	double x_length = m_DomainAABB.second.x - x0;
+	double y_length = m_DomainAABB.second.y - y0;
+	double z_length = m_DomainAABB.second.z - z0;
 	
-	double dx = x_length / pow(2, refineLevel) / g_XVoxels;
-	double dy = y_length / pow(2, refineLevel) / g_YVoxels;
-	double dz = z_length / pow(2, refineLevel) / g_ZVoxels;
+	double dx = x_length / pow(2, refineLevel) / m_XVoxels;
+	double dy = y_length / pow(2, refineLevel) / m_YVoxels;
+	double dz = z_length / pow(2, refineLevel) / m_ZVoxels;
 
 	int num = pow(2, refineLevel) + 1;
 
@@ -880,56 +872,156 @@ int COctreeVoxelMesh::getPointsInfo(vector<XYZ> myPoints, int refineLevel)
 	int row_len = num;
 	int layer_len = num * num;
 	*/
-	int row_len = num * g_XVoxels;
-	int layer_len = row_len * num * g_YVoxels;
+	long long row_len = (long long)num * m_XVoxels;
+	long long layer_len = row_len * num * m_YVoxels;
+
+	double x = Point.x; 
+	double y = Point.y;
+	double z = Point.z;
+
+	if ( x > x0 + x_length )
+		x -= x_length;
+
+	if ( x < x0 )
+		x += x_length;
+
+	if ( y > y0 + y_length )
+		y -= y_length;
+
+	if ( y < y0 )
+		y += y_length;
+
+	if ( z > z0 + z_length )
+		z -= z_length;
+
+	if ( z < z0 )
+		z += z_length;
+
+	int index_i = ( (x - x0)/ dx - floor((x - x0) / dx) >= 0.5 ) ? ceil((x - x0) / dx) : floor((x - x0) / dx);
+	int index_j = ( (y - y0)/ dy - floor((y - y0) / dy) >= 0.5 ) ? ceil((y - y0) / dy) : floor((y - y0) / dy);
+	int index_k = ( (z - z0)/ dz - floor((z - z0) / dz) >= 0.5 ) ? ceil((z - z0) / dz) : floor((z - z0) / dz);
+
+	//TGLOG("X: " << x << "(" << index_i << "), Y: " << y << "(" << index_j << "), Z: " << z << "(" << index_k << ")");
+
+	Index[0] = index_i;
+	Index[1] = index_j;
+	Index[2] = index_k;
+
+	// This is exactly where storePointInfo puts the point so the same material is found for it
+	if (pLatticePoint)
+		*pLatticePoint = XYZ(x0 + dx*index_i, y0 + dy*index_j, z0 + dz*index_k);
+
+	return index_i + row_len * index_j + layer_len * index_k;
+}
+
+// Material stored for a lattice point when classifying on demand, the block containing the point is created if needed
+char &COctreeVoxelMesh::getCachedMaterial(const int Index[3])
+{
+	int iBlock = (Index[0] >> 3) + numBlocks[0] * ((Index[1] >> 3) + numBlocks[1] * (Index[2] >> 3));
+	vector<char> &Block = materialBlocks[iBlock];
+	if (Block.empty())
+		Block.resize(512, UNCLASSIFIED);
+	return Block[(Index[0] & 7) + 8 * ((Index[1] & 7) + 8 * (Index[2] & 7))];
+}
+
+// Find the materials of the lattice points closest to the given points which haven't been classified yet
+void COctreeVoxelMesh::classifyPoints(const vector<XYZ> &myPoints, int refineLevel)
+{
+	if (!onDemandInfo)
+		return;
 
 	vector<XYZ>::const_iterator itPoint;
-	int previousMaterial;
-	int i = 0;
+	vector<char*> NewMaterials;
+	vector<XYZ> NewPoints;
+	XYZ LatticePoint;
+	int Index[3];
 
 	for (itPoint = myPoints.begin(); itPoint != myPoints.end(); ++itPoint)
 	{
-		double x = itPoint->x; 
-		double y = itPoint->y;
-		double z = itPoint->z;
-
-		if ( x > x0 + x_length )
-			x -= x_length;
+		getLatticeIndex(*itPoint, refineLevel, Index, &LatticePoint);
+		char &Material = getCachedMaterial(Index);
+		// Mark the point so that it is only classified once. The blocks are never resized
+		// once created so the material can be filled in through a pointer afterwards
+		if (Material == UNCLASSIFIED)
+		{
+			Material = PENDING;
+			NewMaterials.push_back(&Material);
+			NewPoints.push_back(LatticePoint);
+		}
+	}
 
-		if ( x < x0 )
-			x += x_length;
+	if (NewPoints.empty())
+		return;
 
-		if ( y > y0 + y_length )
-			y -= y_length;
+	vector<POINT_INFO> NewInfo;
+	m_Textile.GetPointInformation(NewPoints, NewInfo);
+	for (int i = 0; i < (int)NewInfo.size(); ++i)
+		*NewMaterials[i] = NewInfo[i].iYarnIndex;
+	numClassified += (int)NewInfo.size();
+}
 
-		if ( y < y0 )
-			y += y_length;
+// Classify the points needed by the next refinement pass of all the elements together rather than one element at a time
+void COctreeVoxelMesh::classifyLeaves(bool bPost)
+{
+	if (!onDemandInfo)
+		return;
 
-		if ( z > z0 + z_length )
-			z -= z_length;
+	vector<XYZ> AllPoints;
+	vector<XYZ> CornerPoints;
+	vector<XYZ> ExtraPoints;
 
-		if ( z < z0 )
-			z += z_length;
+	for (p4est_topidx_t which_tree = p4est->first_local_tree; which_tree <= p4est->last_local_tree; ++which_tree)
+	{
+		p4est_tree_t *tree = p4est_tree_array_index(p4est->trees, which_tree);
+		for (size_t i = 0; i < tree->quadrants.elem_count; ++i)
+		{
+			p4est_quadrant_t *quadrant = p4est_quadrant_array_index(&tree->quadrants, i);
+			// Only the elements for which the refinement functions look at the points
+			if (quadrant->level > max_level - 1 || (!bPost && quadrant->level < 2))
+				continue;
+			CornerPoints.clear();
+			ExtraPoints.clear();
+			if (bPost)
+				getPostRefinePoints(p4est, which_tree, quadrant, ExtraPoints);
+			else
+				getRefinePoints(p4est, which_tree, quadrant, CornerPoints, ExtraPoints);
+			AllPoints.insert(AllPoints.end(), CornerPoints.begin(), CornerPoints.end());
+			AllPoints.insert(AllPoints.end(), ExtraPoints.begin(), ExtraPoints.end());
+		}
+	}
+	classifyPoints(AllPoints, max_level);
+}
 
-		int index_i = ( (x - x0)/ dx - floor((x - x0) / dx) >= 0.5 ) ? ceil((x - x0) / dx) : floor((x - x0) / dx);
-		int index_j = ( (y - y0)/ dy - floor((y - y0) / dy) >= 0.5 ) ? ceil((y - y0) / dy) : floor((y - y0) / dy);
-		int index_k = ( (z - z0)/ dz - floor((z - z0) / dz) >= 0.5 ) ? ceil((z - z0) / dz) : floor((z - z0) / dz);
+// Return 1 is at least one of the points is not the same material as others
+// Return 0 is all the points are from the same materials
+int COctreeVoxelMesh::getPointsInfo(vector<XYZ> myPoints, int refineLevel)
+{
+	vector<XYZ>::const_iterator itPoint;
+	int previousMaterial;
+	int i = 0;
+	int Index[3];
 
-		/* Maybe this is still needed for 1x1x1
-		if ( index_i + row_len * index_j + layer_len * index_k > num * num * num || index_i + row_len * index_j + layer_len * index_k < 0)
+	for (itPoint = myPoints.begin(); itPoint != myPoints.end(); ++itPoint)
+	{
+		long long index = getLatticeIndex(*itPoint, refineLevel, Index, NULL);
+		int material;
+		if (onDemandInfo)
 		{
-			TGERROR("Something is not right - index is outside of stored info");
-			TGERROR("X, Y, Z: " << x << ", " << y << ", " << z);
-			return 0;
+			material = getCachedMaterial(Index);
+			if (material == UNCLASSIFIED)
+			{
+				// Mostly points of elements created by recursive refinement, which classifyLeaves didn't see
+				classifyPoints(myPoints, refineLevel);
+				material = getCachedMaterial(Index);
+			}
 		}
-		*/
-
-		//TGLOG("X: " << x << "(" << index_i << "), Y: " << y << "(" << index_j << "), Z: " << z << "(" << index_k << ")");
+		else
+			material = materialInfo[index];
 
 		if (i == 0)
-			previousMaterial = materialInfo[index_i + row_len * index_j + layer_len * index_k];
+			previousMaterial = material;
 
-		if (i > 0 && previousMaterial != materialInfo[index_i + row_len * index_j + layer_len * index_k] )
+		if (i > 0 && previousMaterial != material )
 			return 1;
 
 		i++;
@@ -942,12 +1034,12 @@ void COctreeVoxelMesh::storePointInfo(int refineLevel)
 {
 	vector<XYZ> myPoints;
 	vector<POINT_INFO> temp;
-	double x0 = g_DomainAABB.first.x;
-	double y0 = g_DomainAABB.first.y;
-	double z0 = g_DomainAABB.first.z;
-	double x_length = g_DomainAABB.second.x - x0;
-	double y_length = g_DomainAABB.second.y - y0;
-	double z_length = g_DomainAABB.second.z - z0;
+	double x0 = m_DomainAABB.first.x;
+	double y0 = m_DomainAABB.first.y;
+	double z0 = m_DomainAABB.first.z;
+	double x_length = m_DomainAABB.second.x - x0;
+	double y_length = m_DomainAABB.second.y - y0;
+	double z_length = m_DomainAABB.second.z - z0;
 	
 	double dx = x_length / pow(2, refineLevel) / m_XVoxels;
 	double dy = y_length / pow(2, refineLevel) / m_YVoxels;
@@ -968,7 +1060,7 @@ void COctreeVoxelMesh::storePointInfo(int refineLevel)
 
 	//TGLOG("Number of points : "<< k*j*i);
 	temp.clear();
-	gTextile.GetPointInformation(myPoints,temp);
+	m_Textile.GetPointInformation(myPoints,temp);
 
 	vector<POINT_INFO>::const_iterator itInfo;
 
@@ -993,7 +1085,7 @@ void COctreeVoxelMesh::fillMaterialInfo() {
 		}
 	}
 	vector<POINT_INFO> myInfo;
-	gTextile.GetPointInformation(myPoints, myInfo);
+	m_Textile.GetPointInformation(myPoints, myInfo);
 
 	POINT_INFO info;
 	for (int i = 0; i < CentrePoints.size(); i++) {
@@ -1020,7 +1112,16 @@ int COctreeVoxelMesh::CreateP4ESTRefinement(int min_level, int refine_level)
 	//conn = p8est_connectivity_new_unitcube ();
 	//p4est = p4est_new (mpicomm, conn, 0, NULL, NULL);
 
+	// Forest left from a previous mesh saved with this object
+	DestroyP4EST();
+
 	int len = pow(2, max_level);
+	FaceX_min.clear();
+	FaceX_max.clear();
+	FaceY_min.clear();
+	FaceY_max.clear();
+	FaceZ_min.clear();
+	FaceZ_max.clear();
 	for (int i = 0; i < len + 1; i++) {
 		vector<int> temp(len, 0);
 		FaceX_min.push_back(temp);
@@ -1031,23 +1132,31 @@ int COctreeVoxelMesh::CreateP4ESTRefinement(int min_level, int refine_level)
 		FaceZ_max.push_back(temp);
 	}
 
-	if (writeTempFile("temp_octree.inp", m_DomainAABB) == -1) {
-		return -1;
+	// Blocks of 8x8x8 lattice points are created when the refinement first needs one of their points
+	int num = pow(2, max_level) + 1;
+	numBlocks[0] = (num * m_XVoxels + 7) / 8;
+	numBlocks[1] = (num * m_YVoxels + 7) / 8;
+	numBlocks[2] = (num * m_ZVoxels + 7) / 8;
+	numClassified = 0;
+	materialBlocks.clear();
+	if (onDemandInfo)
+		materialBlocks.resize((size_t)numBlocks[0] * numBlocks[1] * numBlocks[2]);
+	else
+	{
+		storePointInfo(max_level);
+		TGLOG("Stored");
 	}
 
-	storePointInfo(max_level);
-	
-	TGLOG("Stored");
-
-	// Create a forest from the inp file
-	conn = p4est_connectivity_read_inp ("temp_octree.inp");
+	// Create a forest with a tree for each voxel
+	conn = CreateConnectivity();
 
-	if (conn == NULL) {
-		TGERROR("Failed to read a valid connectivity from temp_octree.inp");
+	if (conn == NULL || !p4est_connectivity_is_valid(conn)) {
+		TGERROR("Failed to create a valid connectivity for the octree refinement");
 		return -1;
 	}
 	// Create a forest that is not refined; it consists of the root octant. 
-	p4est = p4est_new (mpicomm, conn, 0, NULL, NULL);
+	// The mesh is passed to the refinement functions through the user pointer
+	p4est = p4est_new (mpicomm, conn, 0, NULL, this);
 
 	/* Comment from P4EST: Refine the forest iteratively, load balancing at each iteration.
 	* This is important when starting with an unrefined forest */
@@ -1059,6 +1168,7 @@ int COctreeVoxelMesh::CreateP4ESTRefinement(int min_level, int refine_level)
 
 	// Refine elements which have multiple materials within them
 	for (int level = min_level; level < refine_level; ++level) {
+		classifyLeaves(false);
 		p4est_refine (p4est,1, refine_fn, NULL);
 		p4est_partition (p4est, 0, NULL);
 		
@@ -1074,6 +1184,7 @@ int COctreeVoxelMesh::CreateP4ESTRefinement(int min_level, int refine_level)
 	// Post refinement is needed to have the boundaries of the inclusions to be represented by the smallest refinement only
 	
 	for (int i = 0; i < 3; i++) {
+		classifyLeaves(true);
 		p4est_refine (p4est, 0, refine_fn_post, NULL);
 		//p4est_refine (p4est, 1, refine_fn_periodic, NULL);
 		p4est_partition (p4est, 0, NULL);
@@ -1081,7 +1192,9 @@ int COctreeVoxelMesh::CreateP4ESTRefinement(int min_level, int refine_level)
 		p4est_partition (p4est, 0, NULL);	
 	}
 
+	TGLOG("Classified " << (onDemandInfo ? numClassified : materialInfo.size()) << " lattice points");
 	materialInfo.clear();
+	materialBlocks.clear();
 
 	return 0;
 }
@@ -1092,11 +1205,6 @@ void COctreeVoxelMesh::SaveVoxelMesh(CTextile &Textile, string OutputFilename, i
 	m_YVoxels = YVoxNum;
 	m_ZVoxels = ZVoxNum;
 
-	g_XVoxels = XVoxNum;
-	g_YVoxels = YVoxNum;
-	g_ZVoxels = ZVoxNum;
-
-
 	CTimer timer;
 	max_level = refine_level;
 	m_bSmooth = smoothing;
@@ -1105,9 +1213,8 @@ void COctreeVoxelMesh::SaveVoxelMesh(CTextile &Textile, string OutputFilename, i
 	m_smoothCoef2 = s2;
 	m_bSurface = surfaceOutput;
 
-  	gTextile = Textile;
+  	m_Textile = Textile;
 	m_DomainAABB = Textile.GetDomain()->GetMesh().GetAABB();
-	g_DomainAABB = m_DomainAABB;
 	//m_bTet = bTet;
 	
 	if (min_level < 0 || refine_level < 0 || min_level > refine_level) {
@@ -1150,16 +1257,7 @@ void COctreeVoxelMesh::ConvertOctreeToNodes()
 	p4est_ghost_destroy (ghost);
 	ghost = NULL;
 	CentrePoints.clear();
-
-	// Assign independent nodes for hanging nodes (this piece is copied from one of the examples provided with p4est)
-	corner_to_hanging[0] = &zero;
-	corner_to_hanging[1] = p8est_edge_corners[0];
-	corner_to_hanging[2] = p8est_edge_corners[4];
-	corner_to_hanging[3] = p8est_face_corners[4];
-	corner_to_hanging[4] = p8est_edge_corners[8];
-	corner_to_hanging[ones - 2] = p4est_face_corners[2];
-	corner_to_hanging[ones - 1] = p4est_face_corners[0];
-	corner_to_hanging[ones] = &ones;
+	cornerPoints.clear();
 
 	int                 i, k, node_i, q, Q, used, anyhang, hanging_corner[P4EST_CHILDREN], node_elements[8], hang_nums[8];
 	int elem_order[8] = {0, 2, 3, 1, 4, 6, 7, 5}; // That is how elements should be ordered in abaqus
@@ -1898,7 +1996,7 @@ void COctreeVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filet
 	
 	//timer.start("Retrieving info on centre points");
 	TGLOG("Retrieving info on centre points");
-	gTextile.GetPointInformation(CentrePoints, m_ElementsInfo);
+	m_Textile.GetPointInformation(CentrePoints, m_ElementsInfo);
 	//fillMaterialInfo();
 	//timer.check("Info retrieved");
 	TGLOG("Info retrieved");
@@ -1915,12 +2013,12 @@ void COctreeVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filet
 	if (false)
 	{
 
-			double x0 = g_DomainAABB.first.x;
-			double y0 = g_DomainAABB.first.y;
-			double z0 = g_DomainAABB.first.z;
-			double x_length = g_DomainAABB.second.x - x0;
-			double y_length = g_DomainAABB.second.y - y0;
-			double z_length = g_DomainAABB.second.z - z0;
+			double x0 = m_DomainAABB.first.x;
+			double y0 = m_DomainAABB.first.y;
+			double z0 = m_DomainAABB.first.z;
+			double x_length = m_DomainAABB.second.x - x0;
+			double y_length = m_DomainAABB.second.y - y0;
+			double z_length = m_DomainAABB.second.z - z0;
 	
 			double dx = x_length / pow(2, max_level);
 			double dy = y_length / pow(2, max_level);
@@ -2071,8 +2169,10 @@ void COctreeVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filet
 	TGLOG("Write the nodes");
 	map<int,XYZ>::iterator itNodes, itNodes2;
 
+	Output << setprecision(12);
+	CTextWriter Writer(Output);
 	for (itNodes = AllNodes.begin(); itNodes != AllNodes.end(); ++itNodes) {
-		Output << setprecision(12) << itNodes->first << ", " << itNodes->second.x << ", " << itNodes->second.y << ", " << itNodes->second.z << "\n";
+		Writer << itNodes->first << ", " << itNodes->second.x << ", " << itNodes->second.y << ", " << itNodes->second.z << "\n";
 	}
 	//timer.check("Nodes written");
 	TGLOG("Nodes written");
@@ -49,13 +49,12 @@ extern "C" {
 }
 
 #include "VoxelMesh.h"
+#include "Textile.h"
 
 namespace TexGen
 { 
 	using namespace std;
 
-	class CTextile;	
-
 	/// Class used to generate octree-refine voxel mesh for output to ABAQUS
 	class CLASS_DECLSPEC COctreeVoxelMesh : public CVoxelMesh
 	{
@@ -66,22 +65,6 @@ namespace TexGen
 		COctreeVoxelMesh(string Type= "CPeriodicBoundaries");
 		virtual ~COctreeVoxelMesh(void);
 
-		static int max_level;
-
-		static vector<XYZ> cornerPoints;
-		static vector<XYZ> CentrePoints;
-
-		static vector< vector<int> > FaceX_min;
-		static vector< vector<int> > FaceX_max;
-		static vector< vector<int> > FaceY_min;
-		static vector< vector<int> > FaceY_max;
-		static vector< vector<int> > FaceZ_min;
-		static vector< vector<int> > FaceZ_max;
-
-		static CTextile gTextile;
-		static pair<XYZ, XYZ> g_DomainAABB;
-		static vector<char> materialInfo; 
-
 		/** Save Octree-refined mesh with an option of surface smoothing
 		\param int min_level
 		\param int refine_level - maximum refinement level
@@ -92,8 +75,19 @@ namespace TexGen
 		*/
 		void SaveVoxelMesh(CTextile &Textile, string OutputFilename, int XVoxNum, int YVoxNum, int ZVoxNum, int min_level, int refine_level, bool smoothing, int smoothIter, double smooth1, double smooth2, bool surfaceOuput);
 
+		/// Set whether the material at points of the finest refinement lattice is found only when the refinement needs it
+		/**
+		By default points are classified on demand and remembered, so the cost depends on the area of the yarn
+		surfaces rather than on the volume of the finest grid. Otherwise every point of the finest grid is
+		classified before refining.
+		*/
+		void SetOnDemandClassification(bool bOnDemand) { onDemandInfo = bOnDemand; }
+
 
 	protected:
+		/// Values of materialBlocks for lattice points which haven't been classified or are being classified
+		enum { UNCLASSIFIED = -128, PENDING = -127 };
+
 		// The operator for comparison can be incorporated into XYZ structure and the all the "Point" can be replaced with "XYZ"
 		struct Point {
 			int nodeNum;
@@ -141,7 +135,13 @@ namespace TexGen
 		pair<int, vector<int> > GetFaceIndices2(CMesh::ELEMENT_TYPE ElemType, const set<int> &NodeIndices, int currentElement);
 
 		void storePointInfo(int refineLevel);
-		static int getPointsInfo(vector<XYZ> myPoints, int refineLevel);
+		int getPointsInfo(vector<XYZ> myPoints, int refineLevel);
+		long long getLatticeIndex(const XYZ &Point, int refineLevel, int Index[3], XYZ *pLatticePoint) const;
+		char &getCachedMaterial(const int Index[3]);
+		void classifyPoints(const vector<XYZ> &myPoints, int refineLevel);
+		void classifyLeaves(bool bPost);
+		static void getRefinePoints(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant, vector<XYZ> &CornerPoints, vector<XYZ> &ExtraPoints);
+		static void getPostRefinePoints(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant, vector<XYZ> &ExtraPoints);
 
 		//int refine_fn_uni(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant);
 		static int refine_fn_uni(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant);
@@ -149,15 +149,45 @@ namespace TexGen
 		static int refine_fn_post(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant);
 		static int refine_fn(p4est_t * p4est, p4est_topidx_t which_tree, p4est_quadrant_t * quadrant);
 
-		static void FindLocMinMax( int& XMin, int& XMax, int& YMin, int& YMax, XYZ& Min, XYZ& Max );
+		void FindLocMinMax( int& XMin, int& XMax, int& YMin, int& YMax, XYZ& Min, XYZ& Max ) const;
 
 		void extractSurfaceNodeSets(std::map< int, vector<int> > &NodeSurf, std::vector<int> &AllSurf);
 		void OutputSurfaces(const std::map<int, vector<int> > &NodeSurf, const std::vector<int> &AllSurf);
-		int writeTempFile(string filename, pair<XYZ, XYZ> myDomain) ;
+		/// Create the P4EST connectivity with a tree for each voxel of the domain
+		p4est_connectivity_t *CreateConnectivity() const;
+		/// Destroy the forest and connectivity if they have been created
+		void DestroyP4EST();
 		
+		/// The forest, the user pointer of which is this object so that the refinement functions can get to the state below
 		p4est_t *p4est;
 		p4est_connectivity_t *conn;
 
+		int max_level;
+
+		vector<XYZ> cornerPoints;
+		vector<XYZ> CentrePoints;
+
+		vector< vector<int> > FaceX_min;
+		vector< vector<int> > FaceX_max;
+		vector< vector<int> > FaceY_min;
+		vector< vector<int> > FaceY_max;
+		vector< vector<int> > FaceZ_min;
+		vector< vector<int> > FaceZ_max;
+
+		/// Copy of the textile being meshed
+		CTextile m_Textile;
+		vector<char> materialInfo; 
+		/// Materials of the finest lattice points classified so far when classifying on demand
+		/**
+		The lattice is split into blocks of 8x8x8 points and the storage for a block is only created when
+		one of its points is needed, so memory depends on the area of the yarn surfaces rather than the volume
+		*/
+		vector< vector<char> > materialBlocks;
+		int numBlocks[3];
+		int numClassified;
+		/// Classify the finest lattice points only when the refinement needs them rather than all of them beforehand
+		bool onDemandInfo;
+
 		map<int,XYZ> AllNodes;
 		vector< std::vector<int> > m_OddHexes;  
 		map< int, vector<int> > m_ElementMarkup;
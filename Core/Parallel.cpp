@@ -0,0 +1,114 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#include "PrecompiledHeaders.h"
+#include "Parallel.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+
+namespace TexGen
+{
+	// May be changed while a parallel operation on another thread is reading it
+	static std::atomic<int> g_iNumThreads(0);
+
+	void SetNumThreads(int iNumThreads)
+	{
+		g_iNumThreads = iNumThreads < 0 ? 0 : iNumThreads;
+	}
+
+	int GetNumThreads()
+	{
+		int iNumThreads = g_iNumThreads;
+		if (iNumThreads > 0)
+			return iNumThreads;
+		int iHardwareThreads = (int)std::thread::hardware_concurrency();
+		return iHardwareThreads > 0 ? iHardwareThreads : 1;
+	}
+
+	void ParallelFor(int iNumTasks, const std::function<void(int)> &Func, int iNumThreads)
+	{
+		if (iNumTasks <= 0)
+			return;
+		if (iNumThreads <= 0)
+			iNumThreads = GetNumThreads();
+		if (iNumThreads > iNumTasks)
+			iNumThreads = iNumTasks;
+
+		if (iNumThreads <= 1)
+		{
+			for (int i=0; i<iNumTasks; ++i)
+				Func(i);
+			return;
+		}
+
+		std::atomic<int> NextTask(0);
+		std::exception_ptr pException;
+		std::mutex ExceptionMutex;
+		auto Worker = [&]()
+		{
+			try
+			{
+				int i;
+				while ((i = NextTask++) < iNumTasks)
+					Func(i);
+			}
+			catch (...)
+			{
+				// Keep the first exception and stop handing out the remaining tasks
+				std::lock_guard<std::mutex> Lock(ExceptionMutex);
+				if (!pException)
+					pException = std::current_exception();
+				NextTask = iNumTasks;
+			}
+		};
+
+		// The calling thread acts as one of the workers. The loggers need not be thread safe (the GUI
+		// logger writes to a window) so messages from the other threads are held back until they finish
+		std::vector<std::thread> Threads;
+		std::vector<CLoggerBuffer> LogBuffers(iNumThreads-1);
+		Threads.reserve(iNumThreads-1);
+		try
+		{
+			for (int i=1; i<iNumThreads; ++i)
+			{
+				CLoggerBuffer *pLogBuffer = &LogBuffers[i-1];
+				Threads.push_back(std::thread([&Worker, pLogBuffer]()
+				{
+					SetThreadLogger(pLogBuffer);
+					Worker();
+					SetThreadLogger(NULL);
+				}));
+			}
+		}
+		catch (...)
+		{
+			// Unable to start another thread, the threads already started and this one share the work
+		}
+		Worker();
+		for (size_t i=0; i<Threads.size(); ++i)
+			Threads[i].join();
+		for (size_t i=0; i<Threads.size(); ++i)
+			LogBuffers[i].Flush();
+		// Exceptions are passed on once all the threads have finished
+		if (pException)
+			std::rethrow_exception(pException);
+	}
+};	// namespace TexGen
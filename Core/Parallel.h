@@ -0,0 +1,65 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#pragma once
+#include <functional>
+#include <atomic>
+
+namespace TexGen
+{
+	/** \file Parallel.h
+	Helper functions used to spread independent pieces of work over several threads
+	*/
+
+	/// Set the number of threads used by parallel operations
+	/**
+	\param iNumThreads Number of threads to use, 0 uses all hardware threads and 1 runs everything serially
+	*/
+	CLASS_DECLSPEC void SetNumThreads(int iNumThreads);
+	/// Get the number of threads that parallel operations will actually use (always at least 1)
+	CLASS_DECLSPEC int GetNumThreads();
+
+	/// Call Func(i) for each i in [0, iNumTasks), distributing the calls over the worker threads
+	/**
+	Tasks are handed out dynamically so that expensive tasks do not hold up the other threads.
+	The order in which tasks execute is not defined, Func must therefore only write to data
+	owned by task i for the result to be independent of the number of threads.
+	If iNumThreads is 0 the value returned by GetNumThreads() is used.
+	If Func throws, the tasks not yet started are skipped and the first exception is
+	rethrown on the calling thread once all the threads have finished.
+	Messages logged by the other threads are passed on to the logger from the calling
+	thread once all the threads have finished, so the logger is only ever used by one thread.
+	*/
+	CLASS_DECLSPEC void ParallelFor(int iNumTasks, const std::function<void(int)> &Func, int iNumThreads = 0);
+
+	/// Atomic value which can be copied and assigned, for members of classes that rely on the implicit copy
+	/**
+	Copying loads the value from the other instance and stores it in this one, the copy as a whole is
+	therefore not atomic.
+	*/
+	template <typename T>
+	class CCopyableAtomic : public std::atomic<T>
+	{
+	public:
+		CCopyableAtomic(T Value = T()) : std::atomic<T>(Value) {}
+		CCopyableAtomic(const CCopyableAtomic &CopyMe) : std::atomic<T>(CopyMe.load()) {}
+		CCopyableAtomic &operator=(const CCopyableAtomic &CopyMe) { this->store(CopyMe.load()); return *this; }
+		CCopyableAtomic &operator=(T Value) { this->store(Value); return *this; }
+	};
+};	// namespace TexGen
@@ -91,9 +91,10 @@ void CPeriodicBoundaries::CreatePeriodicBoundaries( ostream& Output, int iDummyN
 
 void CPeriodicBoundaries::OutputSets( ostream& Output, vector<int>& Set, string SetName)
 {
-	Output << "*NSet, NSet=" + SetName;
-	Output << ", Unsorted" << endl;
-	WriteValues( Output, Set, 16 ); 
+	CTextWriter Writer(Output);
+	Writer << "*NSet, NSet=" + SetName;
+	Writer << ", Unsorted" << "\n";
+	WriteValues( Writer, Set, 16 ); 
 }
 
 void CPeriodicBoundaries::OutputDummyNodeSets( ostream& Output, int iDummyNodeNum )
@@ -154,257 +155,258 @@ void CPeriodicBoundaries::OutputVertexSets( ostream& Output )
 
 void CPeriodicBoundaries::OutputEquations( ostream& Output, int iBoundaryConditions )
 {
-	Output << "***************************" << endl;
-	Output << "*** BOUNDARY CONDITIONS ***" << endl;
-	Output << "***************************" << endl;
+	CTextWriter Writer(Output);
+	Writer << "***************************" << "\n";
+	Writer << "*** BOUNDARY CONDITIONS ***" << "\n";
+	Writer << "***************************" << "\n";
 
-	Output << "*** Name: Translation stop Vertex 1 Type: Displacement/Rotation" << endl;
-	Output << "*Boundary" << endl;
-	Output << "MasterNode1, 1, 1" << endl;
-	Output << "MasterNode1, 2, 2" << endl;
-	Output << "MasterNode1, 3, 3" << endl;
-	Output << endl;
+	Writer << "*** Name: Translation stop Vertex 1 Type: Displacement/Rotation" << "\n";
+	Writer << "*Boundary" << "\n";
+	Writer << "MasterNode1, 1, 1" << "\n";
+	Writer << "MasterNode1, 2, 2" << "\n";
+	Writer << "MasterNode1, 3, 3" << "\n";
+	Writer << "\n";
 
-	Output << "*****************" << endl;
-	Output << "*** EQUATIONS ***" << endl;
-	Output << "*****************" << endl;
-	Output << "*Equation\n3\n";
-	Output << "FaceA, 1, 1.0, FaceB, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+	Writer << "*****************" << "\n";
+	Writer << "*** EQUATIONS ***" << "\n";
+	Writer << "*****************" << "\n";
+	Writer << "*Equation\n3\n";
+	Writer << "FaceA, 1, 1.0, FaceB, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "FaceA, 2, 1.0, FaceB, 2, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "FaceA, 2, 1.0, FaceB, 2, -1.0" << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "FaceA, 3, 1.0, FaceB, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "FaceA, 3, 1.0, FaceB, 3, -1.0" << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "FaceC, 1, 1.0, FaceD, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "FaceC, 1, 1.0, FaceD, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "FaceC, 2, 1.0, FaceD, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "FaceC, 2, 1.0, FaceD, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "FaceC, 3, 1.0, FaceD, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "FaceC, 3, 1.0, FaceD, 3, -1.0" << "\n";
 
 	if ( iBoundaryConditions == MATERIAL_CONTINUUM )
 	{
-		Output << "*Equation\n3\n";
-		Output << "FaceE, 1, 1.0, FaceF, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "FaceE, 1, 1.0, FaceF, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "FaceE, 2, 1.0, FaceF, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "FaceE, 2, 1.0, FaceF, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "FaceE, 3, 1.0, FaceF, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "FaceE, 3, 1.0, FaceF, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 	}
 
-	Output << "*Equation\n3\n";
-	Output << "Edge2, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge2, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge2, 2, 1.0, Edge1, 2, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge2, 2, 1.0, Edge1, 2, -1.0" << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge2, 3, 1.0, Edge1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge2, 3, 1.0, Edge1, 3, -1.0" << "\n";
 
-	Output << "*Equation\n4\n";
-	Output << "Edge3, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n4\n";
+	Writer << "Edge3, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "Edge3, 2, 1.0, Edge1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge3, 2, 1.0, Edge1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge3, 3, 1.0, Edge1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge3, 3, 1.0, Edge1, 3, -1.0" << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "Edge4, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge4, 1, 1.0, Edge1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "Edge4, 2, 1.0, Edge1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge4, 2, 1.0, Edge1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge4, 3, 1.0, Edge1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge4, 3, 1.0, Edge1, 3, -1.0" << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "Edge6, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge6, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge6, 2, 1.0, Edge5, 2, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge6, 2, 1.0, Edge5, 2, -1.0" << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge6, 3, 1.0, Edge5, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge6, 3, 1.0, Edge5, 3, -1.0" << "\n";
 
 	if ( iBoundaryConditions == SINGLE_LAYER_RVE )
 	{
-		Output << "*Equation\n3\n";
-		Output << "Edge7, 1, 1.0, Edge8, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge7, 1, 1.0, Edge8, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-		Output << "*Equation\n2\n";
-		Output << "Edge7, 2, 1.0, Edge8, 2, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "Edge7, 2, 1.0, Edge8, 2, -1.0" << "\n";
 
-		Output << "*Equation\n2\n";
-		Output << "Edge7, 3, 1.0, Edge8, 3, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "Edge7, 3, 1.0, Edge8, 3, -1.0" << "\n";
 
 	}
 	else
 	{
-		Output << "*Equation\n4\n";
-		Output << "Edge7, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << ", ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "Edge7, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << ", ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge7, 2, 1.0, Edge5, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge7, 2, 1.0, Edge5, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge7, 3, 1.0, Edge5, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge7, 3, 1.0, Edge5, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge8, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge8, 1, 1.0, Edge5, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge8, 2, 1.0, Edge5, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge8, 2, 1.0, Edge5, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge8, 3, 1.0, Edge5, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge8, 3, 1.0, Edge5, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 	}
 
-	Output << "*Equation\n3\n";
-	Output << "Edge10, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge10, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "Edge10, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "Edge10, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "Edge10, 3, 1.0, Edge9, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "Edge10, 3, 1.0, Edge9, 3, -1.0" << "\n";
 
 	if ( iBoundaryConditions == SINGLE_LAYER_RVE )
 	{
-		Output << "*Equation\n3\n";
-		Output << "Edge11, 1, 1.0, Edge12, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge11, 1, 1.0, Edge12, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge11, 2, 1.0, Edge12, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge11, 2, 1.0, Edge12, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-		Output << "*Equation\n2\n";
-		Output << "Edge11, 3, 1.0, Edge12, 3, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "Edge11, 3, 1.0, Edge12, 3, -1.0" << "\n";
 
 	}
 	else
 	{
-		Output << "*Equation\n4\n";
-		Output << "Edge11, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << ", ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "Edge11, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << ", ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "Edge11, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "Edge11, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge11, 3, 1.0, Edge9, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge11, 3, 1.0, Edge9, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge12, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge12, 1, 1.0, Edge9, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge12, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge12, 2, 1.0, Edge9, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "Edge12, 3, 1.0, Edge9, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "Edge12, 3, 1.0, Edge9, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 	}
 
-	Output << "*Equation\n3\n";
-	Output << "MasterNode2, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "MasterNode2, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "MasterNode2, 2, 1.0, MasterNode1, 2, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "MasterNode2, 2, 1.0, MasterNode1, 2, -1.0" << "\n";
 	
-	Output << "*Equation\n2\n";
-	Output << "MasterNode2, 3, 1.0, MasterNode1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "MasterNode2, 3, 1.0, MasterNode1, 3, -1.0" << "\n";
 
-	Output << "*Equation\n4\n";
-	Output << "MasterNode3, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n4\n";
+	Writer << "MasterNode3, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "MasterNode3, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "MasterNode3, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "MasterNode3, 3, 1.0, MasterNode1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "MasterNode3, 3, 1.0, MasterNode1, 3, -1.0" << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "MasterNode4, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "MasterNode4, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n3\n";
-	Output << "MasterNode4, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl;
+	Writer << "*Equation\n3\n";
+	Writer << "MasterNode4, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n";
 
-	Output << "*Equation\n2\n";
-	Output << "MasterNode4, 3, 1.0, MasterNode1, 3, -1.0" << endl;
+	Writer << "*Equation\n2\n";
+	Writer << "MasterNode4, 3, 1.0, MasterNode1, 3, -1.0" << "\n";
 
 	if ( iBoundaryConditions == SINGLE_LAYER_RVE )
 	{
-		Output << "*Equation\n3\n";
-		Output << "MasterNode6, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode6, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-		Output << "*Equation\n2\n";
-		Output << "MasterNode6, 2, 1.0, MasterNode5, 2, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "MasterNode6, 2, 1.0, MasterNode5, 2, -1.0" << "\n";
 
-		Output << "*Equation\n2\n";
-		Output << "MasterNode6, 3, 1.0, MasterNode5, 3, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "MasterNode6, 3, 1.0, MasterNode5, 3, -1.0" << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "MasterNode7, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "," << endl;
-		Output << "ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "MasterNode7, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << "," << "\n";
+		Writer << "ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode7, 2, 1.0, MasterNode5, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl; 
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode7, 2, 1.0, MasterNode5, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n"; 
 
-		Output << "*Equation\n2\n";
-		Output << "MasterNode7, 3, 1.0, MasterNode5, 3, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "MasterNode7, 3, 1.0, MasterNode5, 3, -1.0" << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode8, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << endl; 
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode8, 1, 1.0, MasterNode5, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << "\n"; 
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode8, 2, 1.0, MasterNode5, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << endl; 
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode8, 2, 1.0, MasterNode5, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << "\n"; 
 
-		Output << "*Equation\n2\n";
-		Output << "MasterNode8, 3, 1.0, MasterNode5, 3, -1.0" << endl;
+		Writer << "*Equation\n2\n";
+		Writer << "MasterNode8, 3, 1.0, MasterNode5, 3, -1.0" << "\n";
 
 	}
 	else
 	{
-		Output << "*Equation\n3\n";
-		Output << "MasterNode5, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode5, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode5, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode5, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode5, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode5, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "MasterNode6, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << ", ConstraintsDriver0, 1, -" << m_DomSize.x << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "MasterNode6, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver4, 1, -" << m_DomSize.z << ", ConstraintsDriver0, 1, -" << m_DomSize.x << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode6, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode6, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode6, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode6, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n5\n";
-		Output << "MasterNode7, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver4, 1, -" << m_DomSize.z << "," << endl;
-		Output << "ConstraintsDriver3, 1, -" << m_DomSize.y << endl;
+		Writer << "*Equation\n5\n";
+		Writer << "MasterNode7, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver0, 1, -" << m_DomSize.x << ", ConstraintsDriver4, 1, -" << m_DomSize.z << "," << "\n";
+		Writer << "ConstraintsDriver3, 1, -" << m_DomSize.y << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "MasterNode7, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "MasterNode7, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode7, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode7, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "MasterNode8, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << ", ConstraintsDriver4, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "MasterNode8, 1, 1.0, MasterNode1, 1, -1.0, ConstraintsDriver3, 1, -" << m_DomSize.y << ", ConstraintsDriver4, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n4\n";
-		Output << "MasterNode8, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n4\n";
+		Writer << "MasterNode8, 2, 1.0, MasterNode1, 2, -1.0, ConstraintsDriver1, 1, -" << m_DomSize.y << ", ConstraintsDriver5, 1, -" << m_DomSize.z << "\n";
 
-		Output << "*Equation\n3\n";
-		Output << "MasterNode8, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << endl;
+		Writer << "*Equation\n3\n";
+		Writer << "MasterNode8, 3, 1.0, MasterNode1, 3, -1.0, ConstraintsDriver2, 1, -" << m_DomSize.z << "\n";
 	}
 	
 }
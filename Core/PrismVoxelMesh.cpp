@@ -60,6 +60,7 @@ bool CPrismVoxelMesh::CalculateVoxelSizes(CTextile &Textile)
 
 void CPrismVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filetype)
 {
+	CTextWriter Writer(Output);
 	int x, y, z;
 	int iNodeIndex = 1;
 	vector<XYZ> CentrePoints;
@@ -82,8 +83,8 @@ void CPrismVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filety
 
 				if (Filetype == INP_EXPORT)
 				{
-					Output << iNodeIndex << ", ";
-					Output << Point << "\n";
+					Writer << iNodeIndex << ", ";
+					Writer << Point << "\n";
 				}
 				else if (Filetype == VTU_EXPORT)
 					m_Mesh.AddNode(Point);
@@ -148,6 +149,7 @@ void CPrismVoxelMesh::GetElementMap(CTextile &Textile)
 
 int CPrismVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, bool bOutputYarn, int Filetype)
 {
+	CTextWriter Writer(Output);
 	int numx = m_XVoxels + 1;
 	int numy = m_YVoxels + 1;
 	int x, y, z;
@@ -157,7 +159,7 @@ int CPrismVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, bool
 	vector<POINT_INFO> NewElementInfo;
 
 	if (Filetype == SCIRUN_EXPORT)
-		Output << m_NumElements * m_YVoxels;
+		Writer << m_NumElements * m_YVoxels;
 
 	for (z = 0; z < m_ZVoxels; ++z)
 	{
@@ -172,18 +174,18 @@ int CPrismVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, bool
 					{
 						if (Filetype == INP_EXPORT)
 						{
-							Output << iElementNumber << ", ";
-							Output << (x + 1) + y*numx + z*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + z*numx*numy + 1 << ", ";
-							Output << x + (y + 1)*numx + z*numx*numy + 1 << ", " << x + y*numx + z*numx*numy + 1 << ", ";
-							Output << (x + 1) + y*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", ";
-							Output << x + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", " << x + y*numx + (z + 1)*numx*numy + 1 << "\n";
+							Writer << iElementNumber << ", ";
+							Writer << (x + 1) + y*numx + z*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + z*numx*numy + 1 << ", ";
+							Writer << x + (y + 1)*numx + z*numx*numy + 1 << ", " << x + y*numx + z*numx*numy + 1 << ", ";
+							Writer << (x + 1) + y*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", ";
+							Writer << x + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", " << x + y*numx + (z + 1)*numx*numy + 1 << "\n";
 						}
 						else if (Filetype == SCIRUN_EXPORT)
 						{
-							Output << x + y*numx + z*numx*numy + 1 << ", " << (x + 1) + y*numx + z*numx*numy + 1 << ", ";
-							Output << x + y*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + y*numx + (z + 1)*numx*numy + 1 << ", ";
-							Output << x + (y + 1)*numx + z*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + z*numx*numy + 1 << ", ";
-							Output << x + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + (z + 1)*numx*numy + 1 << "\n";
+							Writer << x + y*numx + z*numx*numy + 1 << ", " << (x + 1) + y*numx + z*numx*numy + 1 << ", ";
+							Writer << x + y*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + y*numx + (z + 1)*numx*numy + 1 << ", ";
+							Writer << x + (y + 1)*numx + z*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + z*numx*numy + 1 << ", ";
+							Writer << x + (y + 1)*numx + (z + 1)*numx*numy + 1 << ", " << (x + 1) + (y + 1)*numx + (z + 1)*numx*numy + 1 << "\n";
 						}
 						else  // VTU export
 						{
@@ -52,13 +52,12 @@ bool CRectangularVoxelMesh::CalculateVoxelSizes(CTextile &Textile)
 
 void CRectangularVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filetype )
 {
+	CTextWriter Writer(Output);
 	int x,y,z;
 	int iNodeIndex = 1;
-	vector<XYZ> CentrePoints;
-	vector<POINT_INFO> RowInfo;
 
 	if ( Filetype == SCIRUN_EXPORT )  // if outputting in SCIRun format need to output number of voxels
-		Output << (m_XVoxels+1)*(m_YVoxels+1)*(m_ZVoxels+1) << "\n";
+		Writer << (m_XVoxels+1)*(m_YVoxels+1)*(m_ZVoxels+1) << "\n";
 	
 	for ( z = 0; z <= m_ZVoxels; ++z )
 	{
@@ -71,28 +70,88 @@ void CRectangularVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int
 				Point.y = m_DomainAABB.first.y + m_VoxSize[1] * y;
 				Point.z = m_DomainAABB.first.z + m_VoxSize[2] * z;
 				if ( Filetype == INP_EXPORT )
-					Output << iNodeIndex << ", ";
+					Writer << iNodeIndex << ", ";
 
 				if (Filetype == VTU_EXPORT)
 					m_Mesh.AddNode(Point);
 				else
-					Output << Point << "\n";
-
-				if ( x < m_XVoxels && y < m_YVoxels && z < m_ZVoxels )
-				{
-					Point.x += 0.5*m_VoxSize[0];
-					Point.y += 0.5*m_VoxSize[1];
-					Point.z += 0.5*m_VoxSize[2];
-					CentrePoints.push_back(Point);
-				}
+					Writer << Point << "\n";
+
 				++iNodeIndex;
 			}
 			
 		}
-		RowInfo.clear();   // Changed to do layer at a time instead of row to optimise
-			Textile.GetPointInformation( CentrePoints, RowInfo );
-			m_ElementsInfo.insert(m_ElementsInfo.end(), RowInfo.begin(), RowInfo.end() );
-			CentrePoints.clear();
 	}
-	//Textile.GetPointInformation( CentrePoints, m_ElementsInfo );
-}
\ No newline at end of file
+}
+
+bool CRectangularVoxelMesh::GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints)
+{
+	int x,y;
+
+	CentrePoints.clear();
+	for ( y = 0; y < m_YVoxels; ++y )
+	{
+		for ( x = 0; x < m_XVoxels; ++x )
+		{
+			XYZ Point;
+			Point.x = m_DomainAABB.first.x + m_VoxSize[0] * x;
+			Point.y = m_DomainAABB.first.y + m_VoxSize[1] * y;
+			Point.z = m_DomainAABB.first.z + m_VoxSize[2] * z;
+			Point.x += 0.5*m_VoxSize[0];
+			Point.y += 0.5*m_VoxSize[1];
+			Point.z += 0.5*m_VoxSize[2];
+			CentrePoints.push_back(Point);
+		}
+	}
+	return true;
+}
+
+bool CRectangularVoxelMesh::SaveVoxelMeshToVTI(string Filename, CTextile &Textile)
+{
+	AddExtensionIfMissing(Filename, ".vti");
+
+	// Only one value per voxel is stored for each field, the voxels are classified a layer at a time
+	size_t iNumVoxels = (size_t)m_XVoxels*m_YVoxels*m_ZVoxels;
+	CMeshData<int> YarnIndex("YarnIndex", CMeshDataBase::ELEMENT);
+	CMeshData<XYZ> Orientation("Orientation", CMeshDataBase::ELEMENT);
+	CMeshData<double> VolumeFraction("VolumeFraction", CMeshDataBase::ELEMENT);
+	CMeshData<double> SurfaceDistance("SurfaceDistance", CMeshDataBase::ELEMENT);
+	YarnIndex.m_Data.reserve(iNumVoxels);
+	Orientation.m_Data.reserve(iNumVoxels);
+	VolumeFraction.m_Data.reserve(iNumVoxels);
+	SurfaceDistance.m_Data.reserve(iNumVoxels);
+
+	vector<POINT_INFO> LayerInfo;
+	vector<POINT_INFO>::const_iterator itInfo;
+	int z;
+	for (z = 0; z < m_ZVoxels; ++z)
+	{
+		if (!GetLayerInfo(Textile, z, LayerInfo))
+			return false;
+		for (itInfo = LayerInfo.begin(); itInfo != LayerInfo.end(); ++itInfo)
+		{
+			YarnIndex.m_Data.push_back(itInfo->iYarnIndex);
+			Orientation.m_Data.push_back(itInfo->Orientation);
+			VolumeFraction.m_Data.push_back(itInfo->dVolumeFraction);
+			SurfaceDistance.m_Data.push_back(itInfo->dSurfaceDistance);
+		}
+	}
+
+	// Image data cells are ordered with x varying fastest then y, the same as the layers
+	string Extent = "0 " + stringify(m_XVoxels) + " 0 " + stringify(m_YVoxels) + " 0 " + stringify(m_ZVoxels);
+	string Origin = stringify(m_DomainAABB.first.x) + " " + stringify(m_DomainAABB.first.y) + " " + stringify(m_DomainAABB.first.z);
+	string Spacing = stringify(m_VoxSize[0]) + " " + stringify(m_VoxSize[1]) + " " + stringify(m_VoxSize[2]);
+
+	CVTKWriter Writer(VTK_APPENDED_RAW);
+	if (!Writer.Open(Filename, "ImageData", "WholeExtent=\"" + Extent + "\" Origin=\"" + Origin + "\" Spacing=\"" + Spacing + "\""))
+		return false;
+	Writer.StartElement("Piece", "Extent=\"" + Extent + "\"");
+	Writer.StartElement("CellData", "Scalars=\"YarnIndex\" Vectors=\"Orientation\"");
+	YarnIndex.WriteVTKData(Writer);
+	Orientation.WriteVTKData(Writer);
+	VolumeFraction.WriteVTKData(Writer);
+	SurfaceDistance.WriteVTKData(Writer);
+	Writer.EndElement();
+	Writer.EndElement();
+	return Writer.Close();
+}
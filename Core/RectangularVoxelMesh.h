@@ -45,8 +45,16 @@ namespace TexGen
 		/// bOutputMatrix and bOutput yarn specify which of these are saved to the Abaqus file
 		void SaveToAbaqus( string Filename, CTextile &Textile, bool bOutputMatrix, bool bOutputYarn, int iBoundaryConditions, int iElementType );
 		
-		/// Outputs nodes to .inp file and gets element information
+		/// Outputs nodes to .inp file
 		void OutputNodes(ostream &Output, CTextile &Textile, int Filetype = INP_EXPORT );
+		/// Get the centre points of the voxels in one layer of the grid
+		bool GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints);
+		/// Save the voxels as VTK image data
+		/**
+		The grid is defined by its origin, spacing and dimensions so only the yarn index, orientation, volume
+		fraction and surface distance of each voxel are written, as appended binary cell data.
+		*/
+		bool SaveVoxelMeshToVTI(string Filename, CTextile &Textile);
 
 		
 		/// Voxel size for each axis
@@ -63,10 +63,9 @@ bool CRotatedVoxelMesh::CalculateVoxelSizes( CTextile &Textile )
 
 void CRotatedVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filetype )
 {
+	CTextWriter Writer(Output);
 	int x,y,z;
 	int iNodeIndex = 1;
-	vector<XYZ> CentrePoints;
-	vector<POINT_INFO> RowInfo;
 	XYZ StartPoint = m_StartPoint;
 	
 	for ( z = 0; z <= m_ZVoxels; ++z )
@@ -85,32 +84,45 @@ void CRotatedVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int File
 				
 				if (Filetype == INP_EXPORT)
 				{
-					Output << iNodeIndex << ", ";
-					Output << Point << "\n";
+					Writer << iNodeIndex << ", ";
+					Writer << Point << "\n";
 				}
 				else if (Filetype == VTU_EXPORT)
 					m_Mesh.AddNode(Point);
 
-				if ( x < m_XVoxels && y < m_YVoxels && z < m_ZVoxels )
-				{
-					Point.x += 0.5*m_RotatedVoxSize[0].x;
-					Point.x += 0.5*m_RotatedVoxSize[1].x;
-					Point.x += 0.5*m_RotatedVoxSize[2].x;
-					Point.y += 0.5*m_RotatedVoxSize[0].y;
-					Point.y += 0.5*m_RotatedVoxSize[1].y;
-					Point.y += 0.5*m_RotatedVoxSize[2].y;
-					Point.z += 0.5*m_RotatedVoxSize[0].z;
-					Point.z += 0.5*m_RotatedVoxSize[1].z;
-					Point.z += 0.5*m_RotatedVoxSize[2].z;
-					CentrePoints.push_back(Point);
-				}
 				++iNodeIndex;
 			}
 			
 		}
-		RowInfo.clear();   // Changed to do layer at a time instead of row to optimise
-			Textile.GetPointInformation( CentrePoints, RowInfo );
-			m_ElementsInfo.insert(m_ElementsInfo.end(), RowInfo.begin(), RowInfo.end() );
-			CentrePoints.clear();
 	}
+}
+
+bool CRotatedVoxelMesh::GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints)
+{
+	int x,y;
+	XYZ StartPoint = m_StartPoint + m_RotatedVoxSize[2] * z;
+
+	CentrePoints.clear();
+	for ( y = 0; y < m_YVoxels; ++y )
+	{
+		XYZ YStartPoint;
+		YStartPoint = StartPoint + m_RotatedVoxSize[1] * y;
+
+		for ( x = 0; x < m_XVoxels; ++x )
+		{
+			XYZ Point;
+			Point = YStartPoint + m_RotatedVoxSize[0] * x;
+			Point.x += 0.5*m_RotatedVoxSize[0].x;
+			Point.x += 0.5*m_RotatedVoxSize[1].x;
+			Point.x += 0.5*m_RotatedVoxSize[2].x;
+			Point.y += 0.5*m_RotatedVoxSize[0].y;
+			Point.y += 0.5*m_RotatedVoxSize[1].y;
+			Point.y += 0.5*m_RotatedVoxSize[2].y;
+			Point.z += 0.5*m_RotatedVoxSize[0].z;
+			Point.z += 0.5*m_RotatedVoxSize[1].z;
+			Point.z += 0.5*m_RotatedVoxSize[2].z;
+			CentrePoints.push_back(Point);
+		}
+	}
+	return true;
 }
\ No newline at end of file
@@ -37,8 +37,10 @@ namespace TexGen
 		/// Calculate voxel size based on number of voxels on each axis and domain size
 		bool CalculateVoxelSizes(CTextile &Textile);
 		
-		/// Outputs nodes to .inp file and gets element information
+		/// Outputs nodes to .inp file
 		void OutputNodes(ostream &Output, CTextile &Textile, int Filetype = INP_EXPORT);
+		/// Get the centre points of the voxels in one layer of the grid
+		bool GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints);
 
 		/// x, y, z lengths of rotated voxels
 		XYZ				m_RotatedVoxSize[3];
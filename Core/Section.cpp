@@ -21,8 +21,21 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "Section.h"
 #include "TexGen.h"
 #include <limits>
+#include <mutex>
 
 using namespace TexGen;
+
+// Sections are often shared by many yarns and sampled from several threads at once so the sampled
+// points are looked up while holding a lock. Sections are spread over a fixed set of locks rather
+// than each owning one so that they can still be copied.
+static const int NUM_SECTION_MUTEXES = 64;
+static std::mutex g_SectionMutexes[NUM_SECTION_MUTEXES];
+
+static std::mutex &GetSectionMutex(const CSection *pSection)
+{
+	return g_SectionMutexes[((size_t)pSection/sizeof(CSection)) % NUM_SECTION_MUTEXES];
+}
+
 CSection::CSection()
 : m_bEquiSpaced(false)
 {
@@ -33,13 +46,53 @@ CSection::~CSection(void)
 {
 }
 
+CSection::CSection(const CSection &CopyMe)
+: m_pSectionMesh(CopyMe.m_pSectionMesh)
+{
+	std::lock_guard<std::mutex> Lock(GetSectionMutex(&CopyMe));
+	m_SampledPoints = CopyMe.m_SampledPoints;
+	m_pEdgePoints = CopyMe.m_pEdgePoints;
+	m_bEquiSpaced = CopyMe.m_bEquiSpaced;
+}
+
+CSection &CSection::operator=(const CSection &CopyMe)
+{
+	if (this == &CopyMe)
+		return *this;
+	map<pair<int, bool>, SAMPLED_POINTS> SampledPoints;
+	shared_ptr<const vector<XY> > pEdgePoints;
+	bool bEquiSpaced;
+	{
+		std::lock_guard<std::mutex> Lock(GetSectionMutex(&CopyMe));
+		SampledPoints = CopyMe.m_SampledPoints;
+		pEdgePoints = CopyMe.m_pEdgePoints;
+		bEquiSpaced = CopyMe.m_bEquiSpaced;
+	}
+	// Copied separately so that the two locks are never held at once
+	std::lock_guard<std::mutex> Lock(GetSectionMutex(this));
+	m_SampledPoints.swap(SampledPoints);
+	m_pEdgePoints = pEdgePoints;
+	m_bEquiSpaced = bEquiSpaced;
+	m_pSectionMesh = CopyMe.m_pSectionMesh;
+	return *this;
+}
+
 CSection::CSection(TiXmlElement &Element)
 {
 	AssignDefaults();
 	m_bEquiSpaced = valueify<bool>(Element.Attribute("EquiSpaced"));
+	vector<XY> EdgePoints;
 	FOR_EACH_TIXMLELEMENT(pEdgePoint, Element, "EdgePoint")
 	{
-		m_EdgePoints.push_back(valueify<XY>(pEdgePoint->Attribute("value")));
+		EdgePoints.push_back(valueify<XY>(pEdgePoint->Attribute("value")));
+	}
+	// The saved points are returned when the same points are requested again rather than resampling them
+	if (!EdgePoints.empty())
+	{
+		m_pEdgePoints.reset(new vector<XY>(EdgePoints));
+		SAMPLED_POINTS &Sampled = m_SampledPoints[make_pair((int)EdgePoints.size(), m_bEquiSpaced)];
+		Sampled.pPoints = m_pEdgePoints;
+		Sampled.bEquiSpaced = m_bEquiSpaced;
 	}
 	TiXmlElement *pSectionMesh = Element.FirstChildElement("SectionMesh");
 	if (pSectionMesh)
@@ -59,9 +112,18 @@ void CSection::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputTyp
 	}
 	if (OutputType == OUTPUT_FULL)
 	{
-		Element.SetAttribute("EquiSpaced", stringify(m_bEquiSpaced));
+		shared_ptr<const vector<XY> > pEdgePoints;
+		bool bEquiSpaced;
+		{
+			std::lock_guard<std::mutex> Lock(GetSectionMutex(this));
+			pEdgePoints = m_pEdgePoints;
+			bEquiSpaced = m_bEquiSpaced;
+		}
+		Element.SetAttribute("EquiSpaced", stringify(bEquiSpaced));
+		if (!pEdgePoints)
+			return;
 		vector<XY>::const_iterator itPoint;
-		for (itPoint = m_EdgePoints.begin(); itPoint != m_EdgePoints.end(); ++itPoint)
+		for (itPoint = pEdgePoints->begin(); itPoint != pEdgePoints->end(); ++itPoint)
 		{
 			TiXmlElement EdgePoint("EdgePoint");
 			EdgePoint.SetAttribute("value", stringify(*itPoint));
@@ -118,31 +180,70 @@ const CMesh &CSection::GetMesh(int iNumPoints, bool bEquiSpaced) const
 
 const vector<XY> &CSection::GetPoints(int iNumPoints, bool bEquiSpaced) const
 {
-	if (iNumPoints != (int)m_EdgePoints.size() || bEquiSpaced != m_bEquiSpaced)
+	// The points are owned by m_SampledPoints until the section is modified so the reference stays valid
+	return *GetSharedPoints(iNumPoints, bEquiSpaced);
+}
+
+shared_ptr<const vector<XY> > CSection::GetSharedPoints(int iNumPoints, bool bEquiSpaced) const
+{
+	pair<int, bool> Key(iNumPoints, bEquiSpaced);
+	{
+		std::lock_guard<std::mutex> Lock(GetSectionMutex(this));
+		map<pair<int, bool>, SAMPLED_POINTS>::const_iterator itPoints = m_SampledPoints.find(Key);
+		if (itPoints != m_SampledPoints.end())
+		{
+			m_pEdgePoints = itPoints->second.pPoints;
+			m_bEquiSpaced = itPoints->second.bEquiSpaced;
+			return itPoints->second.pPoints;
+		}
+	}
+	// Sample outside the lock so that other sections sharing the lock aren't held up, if another
+	// thread samples the same points at the same time the first one stored is kept
+	shared_ptr<vector<XY> > pPoints(new vector<XY>);
+	bool bSampledEquiSpaced = SamplePoints(iNumPoints, bEquiSpaced, *pPoints);
+	std::lock_guard<std::mutex> Lock(GetSectionMutex(this));
+	SAMPLED_POINTS &Stored = m_SampledPoints[Key];
+	if (!Stored.pPoints)
 	{
-		if (!bEquiSpaced || !CreateEquiSpacedSection(iNumPoints))
-			CreateSection(iNumPoints);
+		Stored.pPoints = pPoints;
+		Stored.bEquiSpaced = bSampledEquiSpaced;
 	}
-	return m_EdgePoints;
+	m_pEdgePoints = Stored.pPoints;
+	m_bEquiSpaced = Stored.bEquiSpaced;
+	return Stored.pPoints;
 }
 
-void CSection::CreateSection(int iNumPoints) const
+bool CSection::SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const
 {
+	if (bEquiSpaced && CreateEquiSpacedSection(iNumPoints, Points))
+		return true;
+	CreateSection(iNumPoints, Points);
+	return false;
+}
+
+void CSection::ClearSampledPoints()
+{
+	std::lock_guard<std::mutex> Lock(GetSectionMutex(this));
+	m_SampledPoints.clear();
+	m_pEdgePoints.reset();
 	m_bEquiSpaced = false;
-	m_EdgePoints.clear();
+}
+
+void CSection::CreateSection(int iNumPoints, vector<XY> &Points) const
+{
+	Points.clear();
 	XY Point;
 	int i;
 	double t;
 	for (i=0; i<iNumPoints; ++i)
 	{
 		t = (double)i/(double)iNumPoints;
-		m_EdgePoints.push_back(GetPoint(t));
+		Points.push_back(GetPoint(t));
 	}
 }
 
-bool CSection::CreateEquiSpacedSection(int iNumPoints) const
+bool CSection::CreateEquiSpacedSection(int iNumPoints, vector<XY> &Points) const
 {
-	m_bEquiSpaced = true;
 	int i, j;
 	int iMaxIterations = 1000;
 	double dStdDevTolerance = 1E-12;
@@ -156,7 +257,7 @@ bool CSection::CreateEquiSpacedSection(int iNumPoints) const
 	vector<double> dLengths;
 	dLengths.resize(iNumPoints);
 
-	m_EdgePoints.resize(iNumPoints);
+	Points.resize(iNumPoints);
 	// The spacing vector stores the increment in t between nodes.
 	// Initially the increment in t values between all nodes should be equal.
 	// Note that the sum of t increments in the Spacing vector must equal 1.
@@ -169,13 +270,13 @@ bool CSection::CreateEquiSpacedSection(int iNumPoints) const
 		// Get the section using the spacing vector
 		for (i=0, t=0; i<iNumPoints; t+=Spacing[i], ++i)
 		{
-			m_EdgePoints[i]=GetPoint(t);
+			Points[i]=GetPoint(t);
 		}
 		// Find the average distance between section points
 		dAvgLength = 0;
 		for (i=0; i<iNumPoints; ++i)
 		{
-			dLengths[i] = GetLength(m_EdgePoints[i], m_EdgePoints[(i+1)%iNumPoints]);
+			dLengths[i] = GetLength(Points[i], Points[(i+1)%iNumPoints]);
 			if ( dLengths[i] < MinDouble )
 			//if ( dLengths[i] < 10 * DBL_MIN )
 			{
@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "SectionMeshTriangulate.h"
 #include "SectionMeshRectangular.h"
 #include "SectionMeshRectangleSection.h"
+#include <memory>
 
 namespace TexGen
 { 
@@ -51,15 +52,17 @@ namespace TexGen
 
 		/// Get a section with given number of points on the perimeter
 		/**
-		The section is created and saved to m_EdgePoints which is then returned.
-		If this function is called multiple times with the same	parameter the section
-		need not be recreated. Note that the returned vector is only valid until
-		the next call to this function, a copy of the vector should be made if it
-		needs to be kept for any period of time.
+		The points are sampled the first time they are requested for a given number of points
+		and spacing, after that the same points are returned. This function is safe to call
+		from several threads at once. The returned vector remains valid until the section is
+		modified, assigned to or destroyed, use GetSharedPoints to keep the points for longer.
 		\param iNumPoints Number of points the section is made up of
 		\param bEquiSpaced If set to true, the code will attempt to space the nodes at equal distances apart
 		*/
-		virtual const vector<XY> &GetPoints(int iNumPoints, bool bEquiSpaced = false) const;
+		const vector<XY> &GetPoints(int iNumPoints, bool bEquiSpaced = false) const;
+
+		/// Same as GetPoints but shares ownership of the points so that they outlive changes to the section
+		shared_ptr<const vector<XY> > GetSharedPoints(int iNumPoints, bool bEquiSpaced = false) const;
 
 		/// Get a mesh with given number of points on the perimeter, a mesh must be assigned
 		/// to the section before this function is called.
@@ -100,25 +103,58 @@ namespace TexGen
 		*/
 		virtual XY GetPoint(double t) const = 0;
 	protected:
-		
+		/// Sampled points are shared between copies of a section as they are never modified
+		CSection(const CSection &CopyMe);
+		CSection &operator=(const CSection &CopyMe);
+
+		/// Sample the points returned by GetPoints
+		/**
+		Derived classes which don't sample the parametric equation evenly in t should override this.
+		\param iNumPoints Number of points the section is made up of
+		\param bEquiSpaced Whether the points should be spaced the same distance apart
+		\param Points Vector the points are stored in
+		\return true if the points were spaced the same distance apart, this may be false even when
+		requested if the equispaced points could not be found
+		*/
+		virtual bool SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const;
+
+		/// Discard the sampled points, must be called by derived classes when the shape of the section changes
+		void ClearSampledPoints();
 
 		/// Create a section with given number of points on the perimeter
 		/**
-		m_EdgePoints will be populated with given number of points
+		Points will be populated with given number of points
 		\param iNumPoints Number of points the section is made up of
+		\param Points Vector the points are stored in
 		*/
-		void CreateSection(int iNumPoints) const;
+		void CreateSection(int iNumPoints, vector<XY> &Points) const;
 		/// Same as CreateSection except all the points will be spaced the same distance apart
 		/**
 		This should work fine as long as the first derivative of the parametric equation with
 		respect to t is continuous and the number of points making up the section is not too small
 		*/
-		bool CreateEquiSpacedSection(int iNumPoints) const;
+		bool CreateEquiSpacedSection(int iNumPoints, vector<XY> &Points) const;
+
+		/// Points sampled for one request along with whether they actually are equispaced
+		struct SAMPLED_POINTS
+		{
+			shared_ptr<const vector<XY> > pPoints;
+			bool bEquiSpaced;
+			SAMPLED_POINTS() : bEquiSpaced(false) {}
+		};
+
+		/// Points sampled so far, indexed by the number of points and whether they were requested equispaced
+		/**
+		The points are kept until the section is modified as the references returned by GetPoints must stay
+		valid until then, entries are therefore never evicted. Callers only use a handful of point counts for
+		each section (generally the number of section points of the yarn) so this stays small.
+		*/
+		mutable map<pair<int, bool>, SAMPLED_POINTS> m_SampledPoints;
 
-		/// List of 2d points creating the outline of the cross-section
-		mutable vector<XY> m_EdgePoints;
+		/// The points sampled most recently, these are saved with the section
+		mutable shared_ptr<const vector<XY> > m_pEdgePoints;
 
-		/// Keep this variable to determine whether the section was created with equidistant points or not
+		/// Keep this variable to determine whether m_pEdgePoints are equidistant points or not
 		mutable bool m_bEquiSpaced;
 
 		/// Pointer to a derived class of SectionMesh, this class is in charge of creating the section mesh
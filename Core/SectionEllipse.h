@@ -45,7 +45,7 @@ namespace TexGen
 		// Accessor methods
 		double GetWidth() const { return m_dWidth; }
 		double GetHeight() const { return m_dHeight; }
-		void SetWidth( double dWidth ){ m_dWidth = dWidth; }
+		void SetWidth( double dWidth ){ m_dWidth = dWidth; ClearSampledPoints(); }
 
 	protected:
 		double m_dWidth, m_dHeight;
@@ -64,16 +64,22 @@ bool CSectionHybrid::operator == (const CSection &CompareMe) const
 CSectionHybrid::CSectionHybrid(TiXmlElement &Element)
 : CSection(Element)
 {
+	// The members are filled directly rather than with AddDivision and AssignSection so that
+	// the edge points read by CSection are kept
 	FOR_EACH_TIXMLELEMENT(pDivision, Element, "Division")
 	{
 		double dVal = 0;
 		pDivision->Attribute("Value", &dVal);
-		AddDivision(dVal);
+		m_Divisions.push_back(dVal);
 	}
+	sort(m_Divisions.begin(), m_Divisions.end());
+	m_Sections.resize(max((int)m_Divisions.size(), 1), CSectionEllipse(1, 1));
 	int i = 0;
 	FOR_EACH_TIXMLELEMENT(pSection, Element, "Section")
 	{
-		AssignSection(i++, *CreateSection(*pSection));
+		if (i < (int)m_Sections.size())
+			m_Sections[i] = CreateSection(*pSection);
+		++i;
 	}
 }
 
@@ -100,6 +106,7 @@ void CSectionHybrid::AddDivision(double dFraction)
 	m_Divisions.push_back(dFraction);
 	sort(m_Divisions.begin(), m_Divisions.end());
 	m_Sections.resize(max((int)m_Divisions.size(), 1), CSectionEllipse(1, 1));
+	ClearSampledPoints();
 }
 
 bool CSectionHybrid::AssignSection(int iIndex, const CSection &Section)
@@ -110,6 +117,7 @@ bool CSectionHybrid::AssignSection(int iIndex, const CSection &Section)
 		return false;
 	}
 	m_Sections[iIndex] = Section;
+	ClearSampledPoints();
 	return true;
 }
 
@@ -55,8 +55,6 @@ m_bRetainPoints(bRetainPoints)
 	}
 
 	CalcTValues();
-	if (bRetainPoints)
-		CreateSection();
 }
 
 CSectionPolygon::~CSectionPolygon(void)
@@ -79,8 +77,6 @@ CSectionPolygon::CSectionPolygon(TiXmlElement &Element)
 		m_PolygonPoints.push_back(valueify<XY>(pPoint->Attribute("value")));
 	}
 	CalcTValues();
-	if (m_bRetainPoints)
-		CreateSection();
 }
 
 void CSectionPolygon::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType) const
@@ -141,6 +137,7 @@ void CSectionPolygon::Scale(XY Scale)
 		itPoint->x *= Scale.x;
 		itPoint->y *= Scale.y;
 	}
+	ClearSampledPoints();
 }
 
 void CSectionPolygon::Scale(double dScale)
@@ -150,6 +147,7 @@ void CSectionPolygon::Scale(double dScale)
 	{
 		*itPoint *= dScale;
 	}
+	ClearSampledPoints();
 }
 
 void CSectionPolygon::CalcTValues()
@@ -178,12 +176,14 @@ void CSectionPolygon::CalcTValues()
 	}
 }
 
-void CSectionPolygon::CreateSection() const
+bool CSectionPolygon::SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const
 {
-	m_bEquiSpaced = false;
-	m_EdgePoints.clear();
-
-	m_EdgePoints = m_PolygonPoints;
+	if (m_bRetainPoints && !bEquiSpaced && iNumPoints == (int)m_PolygonPoints.size())
+	{
+		Points = m_PolygonPoints;
+		return false;
+	}
+	return CSection::SamplePoints(iNumPoints, bEquiSpaced, Points);
 }
 
 
@@ -59,8 +59,8 @@ namespace TexGen
 		/// Assign t value as proportion of distance around perimeter for each point
 		void CalcTValues();
 
-		/// Create section with edge points same as polygon points
-		void CreateSection() const;
+		/// Use the polygon points as the section edge points if they are retained and the same number of points is requested
+		bool SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const;
 
 		vector<XY> m_PolygonPoints;
 		/// The proportion of the distance around the total perimeter range from 0 to 1 for each point
@@ -55,9 +55,9 @@ namespace TexGen
 		double GetHeight() const { return m_dHeight; }
 		double GetPower() const { return m_dPower; }
 		double GetXOffset() const { return m_dXOffset; }
-		void SetWidth( double dWidth ){ m_dWidth = dWidth; }
-		void SetHeight( double dHeight ){ m_dHeight = dHeight; }
-		void SetPower( double dPower ){ m_dPower = dPower; }
+		void SetWidth( double dWidth ){ m_dWidth = dWidth; ClearSampledPoints(); }
+		void SetHeight( double dHeight ){ m_dHeight = dHeight; ClearSampledPoints(); }
+		void SetPower( double dPower ){ m_dPower = dPower; ClearSampledPoints(); }
 
 	protected:
 		double m_dWidth, m_dHeight, m_dPower, m_dXOffset;
@@ -86,69 +86,67 @@ string CSectionRectangle::GetDefaultName() const
 	return "Rectangle(W:" + stringify(m_dWidth) + ",H:" + stringify(m_dHeight) + ")";
 }
 
-const vector<XY> &CSectionRectangle::GetPoints(int iNumPoints, bool bEquiSpaced) const
+bool CSectionRectangle::SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const
 {
-	if (iNumPoints != (int)m_EdgePoints.size() ) // Doesn't do anything with equispaced at the moment || bEquiSpaced != m_bEquiSpaced)
+	// Doesn't do anything with equispaced at the moment
+	Points.resize(iNumPoints);
+	if ( iNumPoints == 2 )  // If only 2 points requested want to force them to be on centre plane
 	{
-		m_EdgePoints.resize(iNumPoints);
-		if ( iNumPoints == 2 )  // If only 2 points requested want to force them to be on centre plane
-		{
-			m_EdgePoints[0].x = m_dWidth/2.0;
-			m_EdgePoints[0].y = 0.0;
-
-			m_EdgePoints[1].x = -m_dWidth/2.0;
-			m_EdgePoints[1].y = 0.0;
-			return m_EdgePoints;
-		}
-
-		double dTotalLength = 2 * m_dWidth + 2 * m_dHeight;
-		double dAveSpacing = dTotalLength / (iNumPoints-1);
-
-		int iNumYSpaces = (int)(m_dHeight / dAveSpacing);
-		if ( ( iNumYSpaces % 2 ) || iNumYSpaces == 0 )
-		{
-			iNumYSpaces++;
-		}
-		double dYSpacing = m_dHeight/iNumYSpaces;
-
-		int iNumXSpaces = iNumPoints/2 - iNumYSpaces;
-		double dXSpacing = m_dWidth/iNumXSpaces;
-
-		int j = 0;
-		XY SectionPoint( m_dWidth/2.0, 0.0 );
-		m_EdgePoints[j] = SectionPoint;
-		++j;
+		Points[0].x = m_dWidth/2.0;
+		Points[0].y = 0.0;
+
+		Points[1].x = -m_dWidth/2.0;
+		Points[1].y = 0.0;
+		return false;
+	}
 
-		for ( int i=0; i < iNumYSpaces/2; ++i )
-		{
-			SectionPoint.y += dYSpacing;
-			m_EdgePoints[j] = SectionPoint;
-			++j;
-		}
-		for ( int i = 0; i < iNumXSpaces; ++i )
-		{
-			SectionPoint.x -= dXSpacing;
-			m_EdgePoints[j] = SectionPoint;
-			++j;
-		}
-		for ( int i = 0; i < iNumYSpaces; ++i )
-		{
-			SectionPoint.y -= dYSpacing;
-			m_EdgePoints[j] = SectionPoint;
-			++j;
-		}
-		for ( int i = 0; i < iNumXSpaces; ++i )
-		{
-			SectionPoint.x += dXSpacing;
-			m_EdgePoints[j] = SectionPoint;
-			++j;
-		}
-		for ( int i = 0; i < (iNumYSpaces/2)-1; ++i )
-		{
-			SectionPoint.y += dYSpacing;
-			m_EdgePoints[j] = SectionPoint;
-			++j;
-		}
+	double dTotalLength = 2 * m_dWidth + 2 * m_dHeight;
+	double dAveSpacing = dTotalLength / (iNumPoints-1);
+
+	int iNumYSpaces = (int)(m_dHeight / dAveSpacing);
+	if ( ( iNumYSpaces % 2 ) || iNumYSpaces == 0 )
+	{
+		iNumYSpaces++;
+	}
+	double dYSpacing = m_dHeight/iNumYSpaces;
+
+	int iNumXSpaces = iNumPoints/2 - iNumYSpaces;
+	double dXSpacing = m_dWidth/iNumXSpaces;
+
+	int j = 0;
+	XY SectionPoint( m_dWidth/2.0, 0.0 );
+	Points[j] = SectionPoint;
+	++j;
+
+	for ( int i=0; i < iNumYSpaces/2; ++i )
+	{
+		SectionPoint.y += dYSpacing;
+		Points[j] = SectionPoint;
+		++j;
+	}
+	for ( int i = 0; i < iNumXSpaces; ++i )
+	{
+		SectionPoint.x -= dXSpacing;
+		Points[j] = SectionPoint;
+		++j;
+	}
+	for ( int i = 0; i < iNumYSpaces; ++i )
+	{
+		SectionPoint.y -= dYSpacing;
+		Points[j] = SectionPoint;
+		++j;
+	}
+	for ( int i = 0; i < iNumXSpaces; ++i )
+	{
+		SectionPoint.x += dXSpacing;
+		Points[j] = SectionPoint;
+		++j;
+	}
+	for ( int i = 0; i < (iNumYSpaces/2)-1; ++i )
+	{
+		SectionPoint.y += dYSpacing;
+		Points[j] = SectionPoint;
+		++j;
 	}
-	return m_EdgePoints;
+	return false;
 }
\ No newline at end of file
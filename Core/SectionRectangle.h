@@ -42,9 +42,6 @@ namespace TexGen
 
 		void PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType) const;
 
-		/// Get a section with given number of points on the perimeter
-		virtual const vector<XY> &GetPoints(int iNumPoints, bool bEquiSpaced = false) const;
-
 		string GetType() const { return "CSectionRectangle"; }
 		string GetDefaultName() const;
 
@@ -53,10 +50,13 @@ namespace TexGen
 		// Accessor methods
 		double GetWidth() const { return m_dWidth; }
 		double GetHeight() const { return m_dHeight; }
-		void SetWidth( double dWidth ){ m_dWidth = dWidth; }
-		void SetHeight( double dHeight ){ m_dHeight = dHeight; }
+		void SetWidth( double dWidth ){ m_dWidth = dWidth; ClearSampledPoints(); }
+		void SetHeight( double dHeight ){ m_dHeight = dHeight; ClearSampledPoints(); }
 
 	protected:
+		/// Points are spaced evenly along each side with the corners included
+		bool SamplePoints(int iNumPoints, bool bEquiSpaced, vector<XY> &Points) const;
+
 		double m_dWidth, m_dHeight;
 		double m_XSpacing, m_YSpacing;
 	};
@@ -63,10 +63,9 @@ bool CShearedVoxelMesh::CalculateVoxelSizes( CTextile &Textile )
 
 void CShearedVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int Filetype )
 {
+	CTextWriter Writer(Output);
 	int x,y,z;
 	int iNodeIndex = 1;
-	vector<XYZ> CentrePoints;
-	vector<POINT_INFO> RowInfo;
 	XYZ StartPoint = m_StartPoint;
 	
 	for ( z = 0; z <= m_ZVoxels; ++z )
@@ -87,28 +86,43 @@ void CShearedVoxelMesh::OutputNodes(ostream &Output, CTextile &Textile, int File
 
 				if (Filetype == INP_EXPORT)
 				{
-					Output << iNodeIndex << ", ";
-					Output << Point << "\n";
+					Writer << iNodeIndex << ", ";
+					Writer << Point << "\n";
 				}
 				else if (Filetype == VTU_EXPORT)
 					m_Mesh.AddNode(Point);
 
-				if ( x < m_XVoxels && y < m_YVoxels && z < m_ZVoxels )
-				{
-					Point.x += 0.5*m_ShearedVoxSize[0].x;
-					Point.x += 0.5*m_ShearedVoxSize[1].x;
-					Point.y += 0.5*m_ShearedVoxSize[0].y;
-					Point.y += 0.5*m_ShearedVoxSize[1].y;
-					Point.z += 0.5*m_ShearedVoxSize[2].x;
-					CentrePoints.push_back(Point);
-				}
 				++iNodeIndex;
 			}
 			
 		}
-		RowInfo.clear();   // Changed to do layer at a time instead of row to optimise
-			Textile.GetPointInformation( CentrePoints, RowInfo );
-			m_ElementsInfo.insert(m_ElementsInfo.end(), RowInfo.begin(), RowInfo.end() );
-			CentrePoints.clear();
 	}
+}
+
+bool CShearedVoxelMesh::GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints)
+{
+	int x,y;
+	XYZ StartPoint = m_StartPoint;
+
+	CentrePoints.clear();
+	StartPoint.z = m_StartPoint.z + m_ShearedVoxSize[2].x * z;
+	for ( y = 0; y < m_YVoxels; ++y )
+	{
+		StartPoint.x = m_StartPoint.x + m_ShearedVoxSize[1].x * y;
+		StartPoint.y = m_StartPoint.y + m_ShearedVoxSize[1].y * y;
+		for ( x = 0; x < m_XVoxels; ++x )
+		{
+			XYZ Point;
+			Point.x = StartPoint.x + m_ShearedVoxSize[0].x * x;
+			Point.y = StartPoint.y + m_ShearedVoxSize[0].y * x;
+			Point.z = StartPoint.z;
+			Point.x += 0.5*m_ShearedVoxSize[0].x;
+			Point.x += 0.5*m_ShearedVoxSize[1].x;
+			Point.y += 0.5*m_ShearedVoxSize[0].y;
+			Point.y += 0.5*m_ShearedVoxSize[1].y;
+			Point.z += 0.5*m_ShearedVoxSize[2].x;
+			CentrePoints.push_back(Point);
+		}
+	}
+	return true;
 }
\ No newline at end of file
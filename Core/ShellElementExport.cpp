@@ -152,13 +152,13 @@ void CShellElementExport::GetYarnSurfaces(int iYarn, const vector<XYZ> &Repeats,
 
 	// Get the yarn surface
 	int i, ElementNum;
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	
 	pair<int,int> Element;
 	Element.first = iYarn;
 
 	
-	list<int> &Indices = SurfaceMesh.GetIndices(CMesh::QUAD);
+	vector<int> &Indices = SurfaceMesh.GetIndices(CMesh::QUAD);
 	for (itIndex = Indices.begin(), ElementNum = 0; itIndex != Indices.end(); ++ElementNum)
 	{
 		vector<int> ElemIndices;
@@ -200,7 +200,7 @@ void CShellElementExport::GetYarnSurface(int iYarn, vector<pair<int,int>> &Eleme
 	Element.first = iYarn;
 
 	
-	list<int> &Indices = m_YarnMeshes[iYarn].GetIndices(CMesh::QUAD);
+	vector<int> &Indices = m_YarnMeshes[iYarn].GetIndices(CMesh::QUAD);
 	int numElements = m_YarnMeshes[iYarn].GetNumElements(CMesh::QUAD);
 	for ( ElementNum = 0; ElementNum < numElements ; ++ElementNum )
 	{
@@ -261,7 +261,7 @@ void CSimulationAbaqus::GetYarnSurfaces(int iYarn, const vector<XYZ> &Repeats, v
 
 	// Get the yarn surface
 	int i, iType, iBoundaryNodes;
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	
 	ELEMENT_FACE Face;
 	for (iType = 0; iType < CMesh::NUM_ELEMENT_TYPES; ++iType)
@@ -269,7 +269,7 @@ void CSimulationAbaqus::GetYarnSurfaces(int iYarn, const vector<XYZ> &Repeats, v
 		CMesh::ELEMENT_TYPE Type = (CMesh::ELEMENT_TYPE)iType;
 		if ( Type != CMesh::POLYGON )
 		{
-			list<int> &Indices = SurfaceMesh.GetIndices(Type);
+			vector<int> &Indices = SurfaceMesh.GetIndices(Type);
 			for (itIndex = Indices.begin(); itIndex != Indices.end(); )
 			{
 				vector<int> ElemIndices;
@@ -333,7 +333,7 @@ void CSimulationAbaqus::GetYarnSurface(int iYarn, const vector<XYZ> &Repeats, ve
 
 	// Get the yarn surface
 	int i, iType, iBoundaryNodes;
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	
 	ELEMENT_FACE Face;
 	for (iType = 0; iType < CMesh::NUM_ELEMENT_TYPES; ++iType)
@@ -341,7 +341,7 @@ void CSimulationAbaqus::GetYarnSurface(int iYarn, const vector<XYZ> &Repeats, ve
 		CMesh::ELEMENT_TYPE Type = (CMesh::ELEMENT_TYPE)iType;
 		if ( Type != CMesh::POLYGON )
 		{
-			list<int> &Indices = SurfaceMesh.GetIndices(Type);
+			vector<int> &Indices = SurfaceMesh.GetIndices(Type);
 			for (itIndex = Indices.begin(); itIndex != Indices.end(); )
 			{
 				vector<int> ElemIndices;
@@ -370,14 +370,14 @@ CSimulationAbaqus::ELEMENT_FACE CSimulationAbaqus::FindFaceIndex(int iYarn, cons
 	VolumeMesh.RemoveElementType(CMesh::POLYGON);
 	VolumeMesh.RemoveUnreferencedNodes();
 
-	list<int>::iterator itIndex;
+	vector<int>::iterator itIndex;
 	int i, iElementIndex, iType;
 	for (iType = 0; iType < CMesh::NUM_ELEMENT_TYPES; ++iType)
 	{
 		if ( iType == CMesh::POLYGON )
 			continue;
 		CMesh::ELEMENT_TYPE Type = (CMesh::ELEMENT_TYPE)iType;
-		list<int> &Indices = VolumeMesh.GetIndices(Type);
+		vector<int> &Indices = VolumeMesh.GetIndices(Type);
 		for (itIndex = Indices.begin(), iElementIndex=0; itIndex != Indices.end(); ++iElementIndex)
 		{
 			vector<int> VolIndices;
@@ -1045,7 +1045,7 @@ void CSimulationAbaqus::CreateMidPointVolumeFractions( vector<SECTION_VF_DATA> &
 
 void CSimulationAbaqus::GetElementVolumeFractions( vector<POINT_INFO> &ElementsInfo, vector<SECTION_VF_DATA> &MidVFData )
 {
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	vector<SECTION_VF_DATA>::iterator itData;
 	int i, ElementIndex = 0;
 	for (i = 0; i < CMesh::NUM_ELEMENT_TYPES; ++i)
@@ -1087,8 +1087,8 @@ void CSimulationAbaqus::GetElementVolumeFractions( vector<POINT_INFO> &ElementsI
 
 void CSimulationAbaqus::GetSectionVolumeFractions(CTextile &Textile, vector<SECTION_VF_DATA> &VolFractionData, int iYarn )
 {
-	list<int> &PolygonIndices = m_YarnMeshes[iYarn].GetIndices( CMesh::POLYGON );
-	list<int>::iterator itInt;
+	vector<int> &PolygonIndices = m_YarnMeshes[iYarn].GetIndices( CMesh::POLYGON );
+	vector<int>::iterator itInt;
 	for ( itInt = PolygonIndices.begin(); itInt != PolygonIndices.end(); )
 	{
 		SECTION_VF_DATA VolFData;
@@ -59,12 +59,12 @@ void CTetgenMesh::SaveTetgenMesh( CTextile &Textile, string OutputFilename, stri
 	m_in.facetlist = new tetgenio::facet[m_in.numberoffacets];
 
 	// Add facets for yarn elements
-	list<int>::const_iterator itIter;
+	vector<int>::const_iterator itIter;
 	
 	int i = 0;
 	for ( int j = 0; j < CMesh::NUM_ELEMENT_TYPES; ++j)
 	{
-		const list<int> &Indices = m_Mesh.GetIndices((CMesh::ELEMENT_TYPE)j);
+		const vector<int> &Indices = m_Mesh.GetIndices((CMesh::ELEMENT_TYPE)j);
 		int iNumNodes = CMesh::GetNumNodes((CMesh::ELEMENT_TYPE)j);
 		for (itIter = Indices.begin(); itIter != Indices.end(); )
 		{
@@ -91,14 +91,17 @@ void CTetgenMesh::SaveTetgenMesh( CTextile &Textile, string OutputFilename, stri
 		}
 	}
 
+	// Index the surface nodes so that domain plane points can be matched to them quickly
+	m_Mesh.BuildNodeIndex();
+
 	// Add facets for domain planes
 	if ( bPeriodic )
 	{
 		vector<CMesh>::iterator itTriangulatedMeshes;
 		for ( itTriangulatedMeshes = m_TriangulatedMeshes.begin(); itTriangulatedMeshes != m_TriangulatedMeshes.end(); ++itTriangulatedMeshes )
 		{
-			const list<int> &TriIndices = itTriangulatedMeshes->GetIndices(CMesh::TRI);
-			list<int>::const_iterator itTriIndices;
+			const vector<int> &TriIndices = itTriangulatedMeshes->GetIndices(CMesh::TRI);
+			vector<int>::const_iterator itTriIndices;
 
 			int iNodeOffset = m_Mesh.GetNumNodes();  // Adding domain plane points to m_Mesh so need to continue from current max index
 			int iNumNodes = 3;
@@ -140,10 +143,10 @@ void CTetgenMesh::SaveTetgenMesh( CTextile &Textile, string OutputFilename, stri
 		vector<CMesh>::iterator itDomainMeshes;
 		for ( itDomainMeshes = m_DomainMeshes.begin(); itDomainMeshes != m_DomainMeshes.end(); ++itDomainMeshes )
 		{
-			const list<int> &QuadIndices = itDomainMeshes->GetIndices(CMesh::QUAD);
-			const list<int> &PolygonIndices = itDomainMeshes->GetIndices(CMesh::POLYGON);
-			list<int>::const_iterator itQuadIndices;
-			list<int>::const_iterator itPolygonIndices;
+			const vector<int> &QuadIndices = itDomainMeshes->GetIndices(CMesh::QUAD);
+			const vector<int> &PolygonIndices = itDomainMeshes->GetIndices(CMesh::POLYGON);
+			vector<int>::const_iterator itQuadIndices;
+			vector<int>::const_iterator itPolygonIndices;
 
 
 			int iNodeOffset = m_Mesh.GetNumNodes();
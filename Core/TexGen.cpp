@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "PrecompiledHeaders.h"
 #include "TexGen.h"
+#include "Parallel.h"
 
 using namespace TexGen;
 
@@ -287,6 +288,16 @@ string CTexGen::GetVersion() const
 	return stringify(m_iMajorVersion) + "." + stringify(m_iMinorVersion) + "." + stringify(m_iRevision);
 }
 
+void CTexGen::SetNumThreads( int iNumThreads )
+{
+	TexGen::SetNumThreads( iNumThreads );
+}
+
+int CTexGen::GetNumThreads() const
+{
+	return TexGen::GetNumThreads();
+}
+
 void CTexGen::SetMessages( bool bMessagesOn, const CLogger &Logger )
 {
 	m_bMessagesOn = bMessagesOn;
@@ -150,6 +150,13 @@ namespace TexGen
 		void SetMessages( bool bMessagesOn );
 		/// Get messages on/off
 		bool GetMessagesOn( ) const { return m_bMessagesOn; }
+		/// Set the number of threads used by parallel operations such as voxel mesh classification
+		/**
+		\param iNumThreads Number of threads, 0 uses all available hardware threads and 1 runs serially
+		*/
+		void SetNumThreads( int iNumThreads );
+		/// Get the number of threads used by parallel operations
+		int GetNumThreads() const;
 		/// Get list of textile names
 		void GetTextileNames( vector<string> &Names );
 
@@ -0,0 +1,198 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#include "PrecompiledHeaders.h"
+#include "TextWriter.h"
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#include <locale>
+
+// Floating point to_chars gives the same text as printf (which the streams use) without the locale handling
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define TEXGEN_FLOAT_TO_CHARS
+#endif
+
+using namespace TexGen;
+
+namespace
+{
+	/// Two digit strings of the numbers 0 to 99 so that integers can be formatted two digits at a time
+	const char DIGIT_PAIRS[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	/// Format an unsigned integer backwards from pEnd, returning a pointer to the first digit
+	char *FormatDigits(unsigned long long iValue, char *pEnd)
+	{
+		while (iValue >= 100)
+		{
+			int i = (int)(iValue % 100)*2;
+			iValue /= 100;
+			*--pEnd = DIGIT_PAIRS[i+1];
+			*--pEnd = DIGIT_PAIRS[i];
+		}
+		if (iValue >= 10)
+		{
+			int i = (int)iValue*2;
+			*--pEnd = DIGIT_PAIRS[i+1];
+			*--pEnd = DIGIT_PAIRS[i];
+		}
+		else
+			*--pEnd = (char)('0' + iValue);
+		return pEnd;
+	}
+}
+
+CTextWriter::CTextWriter(ostream &Output)
+: m_Output(Output)
+, m_iLength(0)
+, m_iPrecision((int)Output.precision())
+, m_FloatField(Output.flags() & ios_base::floatfield)
+, m_bShortestRoundTrip(false)
+{
+	m_FallbackStream.imbue(locale::classic());
+}
+
+CTextWriter::~CTextWriter(void)
+{
+	Flush();
+}
+
+void CTextWriter::Flush()
+{
+	if (m_iLength)
+		m_Output.write(m_Buffer, m_iLength);
+	m_iLength = 0;
+}
+
+CTextWriter &CTextWriter::Write(const char *pText, size_t iLength)
+{
+	if (iLength > BUFFER_SIZE/2)
+	{
+		Flush();
+		m_Output.write(pText, iLength);
+		return *this;
+	}
+	Reserve(iLength);
+	memcpy(m_Buffer + m_iLength, pText, iLength);
+	m_iLength += iLength;
+	return *this;
+}
+
+CTextWriter &CTextWriter::operator << (char Character)
+{
+	Reserve(1);
+	m_Buffer[m_iLength++] = Character;
+	return *this;
+}
+
+CTextWriter &CTextWriter::WriteInteger(unsigned long long iValue)
+{
+	char Digits[MAX_NUMBER_LENGTH];
+	char *pEnd = Digits + MAX_NUMBER_LENGTH;
+	char *pStart = FormatDigits(iValue, pEnd);
+	return Write(pStart, pEnd - pStart);
+}
+
+CTextWriter &CTextWriter::WriteInteger(long long iValue)
+{
+	char Digits[MAX_NUMBER_LENGTH];
+	char *pEnd = Digits + MAX_NUMBER_LENGTH;
+	// Negated as unsigned so that the most negative value doesn't overflow
+	char *pStart = FormatDigits(iValue < 0 ? 0ULL - (unsigned long long)iValue : (unsigned long long)iValue, pEnd);
+	if (iValue < 0)
+		*--pStart = '-';
+	return Write(pStart, pEnd - pStart);
+}
+
+CTextWriter &CTextWriter::operator << (double dValue)
+{
+	Reserve(MAX_NUMBER_LENGTH + m_iPrecision);
+	// Only very large numbers in the fixed format might not fit, in which case there is a whole buffer to try with
+	if (!FormatDouble(dValue))
+	{
+		Flush();
+		FormatDouble(dValue);
+	}
+	return *this;
+}
+
+bool CTextWriter::FormatDouble(double dValue)
+{
+	char *pStart = m_Buffer + m_iLength;
+	char *pEnd = m_Buffer + BUFFER_SIZE;
+#ifdef TEXGEN_FLOAT_TO_CHARS
+	to_chars_result Result;
+	if (m_bShortestRoundTrip)
+		Result = to_chars(pStart, pEnd, dValue);
+	else if (m_FloatField == ios_base::fixed)
+		Result = to_chars(pStart, pEnd, dValue, chars_format::fixed, m_iPrecision);
+	else if (m_FloatField == ios_base::scientific)
+		Result = to_chars(pStart, pEnd, dValue, chars_format::scientific, m_iPrecision);
+	else
+		Result = to_chars(pStart, pEnd, dValue, chars_format::general, m_iPrecision);
+	if (Result.ec != errc())
+		return false;
+	m_iLength = Result.ptr - m_Buffer;
+#else
+	// Use a stream in the classic locale so the decimal point doesn't depend on the C locale of the host.
+	// For the shortest round trip 17 significant digits are used, these always read back as the same
+	// value but unlike to_chars they are not necessarily the fewest digits that do
+	m_FallbackStream.str("");
+	m_FallbackStream.clear();
+	if (m_bShortestRoundTrip)
+	{
+		m_FallbackStream.precision(17);
+		m_FallbackStream.unsetf(ios_base::floatfield);
+	}
+	else
+	{
+		m_FallbackStream.precision(m_iPrecision);
+		m_FallbackStream.setf(m_FloatField, ios_base::floatfield);
+	}
+	m_FallbackStream << dValue;
+	string Text = m_FallbackStream.str();
+	if (Text.size() > (size_t)(pEnd - pStart))
+		return false;
+	memcpy(pStart, Text.c_str(), Text.size());
+	m_iLength += Text.size();
+#endif
+	return true;
+}
+
+CTextWriter &CTextWriter::operator << (const XYZ &Vector)
+{
+	return *this << Vector.x << ", " << Vector.y << ", " << Vector.z;
+}
+
+CTextWriter &CTextWriter::operator << (const XY &Vector)
+{
+	return *this << Vector.x << ", " << Vector.y;
+}
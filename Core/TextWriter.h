@@ -0,0 +1,93 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#pragma once
+
+namespace TexGen
+{
+	using namespace std;
+
+	/// Formats numbers as text for large output files such as ABAQUS input files
+	/**
+	Values are formatted into a buffer which is passed on to the stream in large blocks, avoiding the
+	per value overhead of the stream operators. By default doubles are formatted as the stream would format
+	them, using its precision and floating point format at the time the writer is created, so the text is
+	identical to writing with the stream directly. Nothing should be written to the stream directly while
+	the writer exists as it is only flushed when the buffer is full or the writer is destroyed.
+	*/
+	class CLASS_DECLSPEC CTextWriter
+	{
+	public:
+		CTextWriter(ostream &Output);
+		~CTextWriter(void);
+
+		CTextWriter &operator << (int iValue) { return WriteInteger((long long)iValue); }
+		CTextWriter &operator << (unsigned int iValue) { return WriteInteger((unsigned long long)iValue); }
+		CTextWriter &operator << (long iValue) { return WriteInteger((long long)iValue); }
+		CTextWriter &operator << (unsigned long iValue) { return WriteInteger((unsigned long long)iValue); }
+		CTextWriter &operator << (long long iValue) { return WriteInteger(iValue); }
+		CTextWriter &operator << (unsigned long long iValue) { return WriteInteger(iValue); }
+		CTextWriter &operator << (double dValue);
+		CTextWriter &operator << (const XYZ &Vector);
+		CTextWriter &operator << (const XY &Vector);
+		CTextWriter &operator << (char Character);
+		CTextWriter &operator << (const char *szText) { return Write(szText, strlen(szText)); }
+		CTextWriter &operator << (const string &Text) { return Write(Text.c_str(), Text.size()); }
+
+		/// Write characters to the buffer
+		CTextWriter &Write(const char *pText, size_t iLength);
+
+		/// Pass the buffered text on to the stream
+		void Flush();
+
+		/// Write doubles with the fewest digits which read back as the same value rather than with the stream's format
+		/**
+		This relies on floating point support in std::to_chars. Where the standard library doesn't provide it
+		doubles are written with 17 significant digits instead, these still read back as the same value but
+		are not the shortest round trip.
+		*/
+		void SetShortestRoundTrip(bool bShortest) { m_bShortestRoundTrip = bShortest; }
+
+	protected:
+		enum { BUFFER_SIZE = 65536 };
+		/// Enough space for any integer or any double in the general or scientific formats
+		enum { MAX_NUMBER_LENGTH = 32 };
+
+		CTextWriter &WriteInteger(long long iValue);
+		CTextWriter &WriteInteger(unsigned long long iValue);
+		/// Try to format a double into the space left in the buffer, returning false if it didn't fit
+		bool FormatDouble(double dValue);
+		/// Make sure there are iLength characters free in the buffer
+		void Reserve(size_t iLength)
+		{
+			if (m_iLength + iLength > BUFFER_SIZE)
+				Flush();
+		}
+
+		ostream &m_Output;
+		char m_Buffer[BUFFER_SIZE];
+		size_t m_iLength;
+		int m_iPrecision;
+		ios_base::fmtflags m_FloatField;
+		bool m_bShortestRoundTrip;
+		/// Classic locale stream used to format doubles where std::to_chars doesn't support them, reused between values
+		ostringstream m_FallbackStream;
+	};
+
+};	// namespace TexGen
@@ -28,6 +28,7 @@ using namespace TexGen;
 
 CTextile::CTextile(void)
 : m_bNeedsBuilding(true)
+, m_bBuilding(false)
 {
 }
 
@@ -63,7 +64,7 @@ CTextile &CTextile::operator=(const CTextile& CopyMe)
 }
 
 CTextile::CTextile(TiXmlElement &Element)
-:CPropertiesTextile(Element),m_bNeedsBuilding(true)
+:CPropertiesTextile(Element),m_bNeedsBuilding(true),m_bBuilding(false)
 {
 	TiXmlElement* pDomain = Element.FirstChildElement("Domain");
 	if (pDomain)
@@ -220,13 +221,13 @@ bool CTextile::AddSurfaceToMesh(CMesh &Mesh, vector<CMesh> &DomainMeshes, bool b
 		m_pDomain->GetPrismDomain()->GetMeshWithPolygonEnd( DomainMesh );
 	}
 
-	list<int>::const_iterator itIter;
+	vector<int>::const_iterator itIter;
 	int iNumNodes;
 
 	// Save each domain face as separate mesh & add to DomainMeshes vector
 	for ( int i = 0; i < CMesh::NUM_ELEMENT_TYPES; ++i)
 	{
-		const list<int> &Indices = DomainMesh.GetIndices((CMesh::ELEMENT_TYPE)i);
+		const vector<int> &Indices = DomainMesh.GetIndices((CMesh::ELEMENT_TYPE)i);
 		iNumNodes = CMesh::GetNumNodes((CMesh::ELEMENT_TYPE)i);
 		if (i != CMesh::POLYGON)
 		{
@@ -408,6 +409,12 @@ bool CTextile::OutputAbaqus(string FileName, double dInitialStrains)
 }
 */
 void CTextile::GetPointInformation(const vector<XYZ> &Points, vector<POINT_INFO> &PointsInfo, double dTolerance)
+{
+	// Unstructured points are treated as rows of a single point so no starting guesses are shared
+	GetGridPointInformation(Points, PointsInfo, 1, dTolerance);
+}
+
+void CTextile::GetGridPointInformation(const vector<XYZ> &Points, vector<POINT_INFO> &PointsInfo, int iRowLength, double dTolerance)
 {
 	//TGLOGINDENT("Getting information for " << (int)Points.size() << " points");
 	if (Points.empty())
@@ -417,49 +424,76 @@ void CTextile::GetPointInformation(const vector<XYZ> &Points, vector<POINT_INFO>
 
 	PointsInfo.clear();
 	PointsInfo.resize(Points.size());
-	vector<XYZ>::const_iterator itPoint;
-	std::vector<XY>::iterator itLoc; 	
-	vector<POINT_INFO>::iterator itInfo;
-	POINT_INFO Info;
 
-	XYZ Min,Max;
-	for (itPoint = Points.begin(); itPoint != Points.end(); ++itPoint)
-	{
-		if (itPoint == Points.begin())
-		{
-			Min = Max = *itPoint;
-		}
-		else
-		{
-			Min = ::Min(Min, *itPoint);
-			Max = ::Max(Max, *itPoint);
-		}
-	}
-	XYZ Tangent;
-	XY Loc;
-	CDomainPlanes DomainPlanes(Min, Max);
-	vector<CYarn>::iterator itYarn;
-	int iIndex;
-	for (itYarn = m_Yarns.begin(), iIndex=0; itYarn != m_Yarns.end(); ++itYarn, ++iIndex)
+	XYZ Min, Max;
+	GetMinMaxXYZ(Points, Min, Max);
+	if (!PrepareSpatialIndex(Min, Max, dTolerance))
+		return;
+
+	// Each tile of whole rows is classified independently and the starting guesses are reset at the
+	// beginning of each row, so the result does not depend on the number of threads used
+	if (iRowLength < 1)
+		iRowLength = 1;
+	int iNumPoints = (int)Points.size();
+	int iNumRows = (iNumPoints + iRowLength - 1) / iRowLength;
+	int iRowsPerTile = max(1, POINT_TILE_SIZE / iRowLength);
+	int iNumTiles = (iNumRows + iRowsPerTile - 1) / iRowsPerTile;
+	ParallelFor(iNumTiles, [&](int iTile)
 	{
-		vector<XYZ> Translations = DomainPlanes.GetTranslations(*itYarn);
-		for (itPoint = Points.begin(), itInfo = PointsInfo.begin(); itPoint != Points.end(); ++itPoint, ++itInfo)
+		// Plane positions found for the previous point in the row, stored by entry index in ascending order
+		vector<pair<int, double> > PrevPlanes, Planes;
+		CYarnQueryContext Context;
+		int iEndRow = min(iNumRows, (iTile+1)*iRowsPerTile);
+		for (int iRow = iTile*iRowsPerTile; iRow < iEndRow; ++iRow)
 		{
-			if (itYarn->PointInsideYarn(*itPoint, Translations, &Info.YarnTangent, 
-				&Info.Location, &Info.dVolumeFraction, &Info.dSurfaceDistance, dTolerance, &Info.Orientation, &Info.Up))
+			PrevPlanes.clear();
+			int iEnd = min(iNumPoints, (iRow+1)*iRowLength);
+			for (int iPoint = iRow*iRowLength; iPoint < iEnd; ++iPoint)
 			{
-				// If the point is inside several yarns, either because the yarns overlap or because
-				// the tolerance is set too high, the point is assigned the yarn which it lies deepest
-				// within. I.e. the one with the lowest surface distance (note that negative surface
-				// distance represents a point lying below the yarn surface).
-				if (itInfo->iYarnIndex == -1 || Info.dSurfaceDistance < itInfo->dSurfaceDistance)
+				POINT_INFO &PointInfo = PointsInfo[iPoint];
+				const int *pCandidate, *pEnd;
+				m_SpatialIndex.GetCandidates(Points[iPoint], pCandidate, pEnd);
+				vector<pair<int, double> >::const_iterator itPrevPlane = PrevPlanes.begin();
+				Planes.clear();
+				int iInsideYarn = -1;
+				for (; pCandidate != pEnd; ++pCandidate)
 				{
-					*itInfo = Info;
-					itInfo->iYarnIndex = iIndex;
+					const CYarnSpatialIndex::ENTRY &Entry = m_SpatialIndex.GetEntry(*pCandidate);
+					// Once the point is found inside a yarn the remaining repeats and segments of that yarn are skipped
+					if (Entry.iYarn == iInsideYarn)
+						continue;
+					const CYarn &Yarn = m_Yarns[Entry.iYarn];
+					XYZ Point = Points[iPoint] - m_SpatialIndex.GetTranslations(Entry.iYarn)[Entry.iTranslation];
+					if (!PointInsideBox(Point, Yarn.m_AABB.first, Yarn.m_AABB.second, dTolerance))
+						continue;
+					while (itPrevPlane != PrevPlanes.end() && itPrevPlane->first < *pCandidate)
+						++itPrevPlane;
+					double dPlaneU = -1;
+					if (itPrevPlane != PrevPlanes.end() && itPrevPlane->first == *pCandidate)
+						dPlaneU = itPrevPlane->second;
+					POINT_INFO Info;
+					bool bInside = Yarn.PointInsideYarnSegment(Point, Entry.iSegment, &Info.YarnTangent, 
+						&Info.Location, &Info.dVolumeFraction, &Info.dSurfaceDistance, dTolerance, &Info.Orientation, &Info.Up, false, &dPlaneU, &Context);
+					if (dPlaneU >= 0)
+						Planes.push_back(make_pair(*pCandidate, dPlaneU));
+					if (bInside)
+					{
+						iInsideYarn = Entry.iYarn;
+						// If the point is inside several yarns, either because the yarns overlap or because
+						// the tolerance is set too high, the point is assigned the yarn which it lies deepest
+						// within. I.e. the one with the lowest surface distance (note that negative surface
+						// distance represents a point lying below the yarn surface).
+						if (PointInfo.iYarnIndex == -1 || Info.dSurfaceDistance < PointInfo.dSurfaceDistance)
+						{
+							PointInfo = Info;
+							PointInfo.iYarnIndex = Entry.iYarn;
+						}
+					}
 				}
+				PrevPlanes.swap(Planes);
 			}
 		}
-	}
+	});
 }
 
 void CTextile::GetPointInformation(const vector<XYZ> &Points, vector<POINT_INFO> &PointsInfo, int iYarn, double dTolerance, bool bSurface)
@@ -472,50 +506,77 @@ void CTextile::GetPointInformation(const vector<XYZ> &Points, vector<POINT_INFO>
 
 	PointsInfo.clear();
 	PointsInfo.resize(Points.size());
-	vector<XYZ>::const_iterator itPoint;
-	std::vector<XY>::iterator itLoc; 	
-	vector<POINT_INFO>::iterator itInfo;
-	POINT_INFO Info;
 
-	XYZ Min,Max;
-	for (itPoint = Points.begin(); itPoint != Points.end(); ++itPoint)
+	XYZ Min, Max;
+	GetMinMaxXYZ(Points, Min, Max);
+	CDomainPlanes DomainPlanes(Min, Max);
+	vector<XYZ> Translations;
+	if (!PrepareYarnForPointQueries(iYarn, DomainPlanes, Translations))
+		return;
+
+	int iNumPoints = (int)Points.size();
+	int iNumTiles = (iNumPoints + POINT_TILE_SIZE - 1) / POINT_TILE_SIZE;
+	ParallelFor(iNumTiles, [&](int iTile)
 	{
-		if (itPoint == Points.begin())
+		int iEnd = min(iNumPoints, (iTile+1)*POINT_TILE_SIZE);
+		CYarnQueryContext Context;
+		for (int iPoint = iTile*POINT_TILE_SIZE; iPoint < iEnd; ++iPoint)
 		{
-			Min = Max = *itPoint;
+			POINT_INFO Info;
+			if (m_Yarns[iYarn].PointInsideYarn(Points[iPoint], Translations, &Info.YarnTangent, 
+				&Info.Location, &Info.dVolumeFraction, &Info.dSurfaceDistance, dTolerance, &Info.Orientation, &Info.Up, bSurface, &Context))
+			{
+				PointsInfo[iPoint] = Info;
+				PointsInfo[iPoint].iYarnIndex = iYarn;
+			}
 		}
-		else
+	});
+}
+
+bool CTextile::PrepareYarnForPointQueries(int iYarn, const CDomain &Domain, vector<XYZ> &Translations) const
+{
+	const CYarn &Yarn = m_Yarns[iYarn];
+	Translations = Domain.GetTranslations(Yarn);
+	if (Translations.empty())
+		return true;
+	// Build everything PointInsideYarn may need now so that the queries themselves don't modify the yarn
+	int iBuildType = CYarn::SURFACE;
+	if (Yarn.GetYarnSection() && Yarn.GetYarnSection()->GetType() != "CYarnSectionConstant")
+		iBuildType |= CYarn::VOLUME;
+	return Yarn.BuildYarnIfNeeded(iBuildType);
+}
+
+bool CTextile::PrepareSpatialIndex(const XYZ &Min, const XYZ &Max, double dTolerance) const
+{
+	int i;
+	if (!BuildYarns(CYarn::SURFACE))
+		return false;
+	if (!m_SpatialIndex.IsValid(m_Yarns, Min, Max, dTolerance))
+	{
+		// Cover the whole domain so that queries over successive parts of it (e.g. layers of voxels)
+		// can share the same index
+		XYZ IndexMin = Min, IndexMax = Max;
+		if (m_pDomain)
 		{
-			Min = ::Min(Min, *itPoint);
-			Max = ::Max(Max, *itPoint);
+			pair<XYZ, XYZ> DomainAABB = m_pDomain->GetMesh().GetAABB();
+			IndexMin = ::Min(IndexMin, DomainAABB.first);
+			IndexMax = ::Max(IndexMax, DomainAABB.second);
 		}
+		m_SpatialIndex.Build(m_Yarns, IndexMin, IndexMax, dTolerance);
 	}
-	XYZ Tangent;
-	XY Loc;
-	CDomainPlanes DomainPlanes(Min, Max);
-	vector<CYarn>::iterator itYarn;
-	
-	vector<XYZ> Translations = DomainPlanes.GetTranslations(m_Yarns[iYarn]);
-	for (itPoint = Points.begin(), itInfo = PointsInfo.begin(); itPoint != Points.end(); ++itPoint, ++itInfo)
+	// Build everything else PointInsideYarn may need now so that the queries themselves don't modify the yarns
+	for (i=0; i<(int)m_Yarns.size(); ++i)
 	{
-		if (m_Yarns[iYarn].PointInsideYarn(*itPoint, Translations, &Info.YarnTangent, 
-			&Info.Location, &Info.dVolumeFraction, &Info.dSurfaceDistance, dTolerance, &Info.Orientation, &Info.Up, bSurface))
-		{
-			// If the point is inside several yarns, either because the yarns overlap or because
-			// the tolerance is set too high, the point is assigned the yarn which it lies deepest
-			// within. I.e. the one with the lowest surface distance (note that negative surface
-			// distance represents a point lying below the yarn surface).
-			if (itInfo->iYarnIndex == -1 )//|| Info.dSurfaceDistance < itInfo->dSurfaceDistance)
-			{
-				*itInfo = Info;
-				itInfo->iYarnIndex = iYarn;
-			}
-		}
-		else
+		const CYarn &Yarn = m_Yarns[i];
+		if (m_SpatialIndex.GetTranslations(i).empty())
+			continue;
+		if (Yarn.GetYarnSection() && Yarn.GetYarnSection()->GetType() != "CYarnSectionConstant")
 		{
+			if (!Yarn.BuildYarnIfNeeded(CYarn::VOLUME))
+				return false;
 		}
 	}
-	
+	return true;
 }
 
 void CTextile::SavePointInformationToVTK(string Filename, const CMesh &Mesh, double dTolerance)
@@ -574,6 +635,45 @@ double CTextile::GetApproximateSize()
 	return GetLength(Min, Max);
 }
 
+// Find the pairs of boxes which intersect using sweep and prune along the x axis, boxes which are
+// not valid are ignored. Both orderings of each pair are returned, sorted.
+static void GetIntersectingBoxes(const vector<pair<XYZ, XYZ> > &AABBs, const vector<bool> &Valid, double dTolerance, vector<pair<int, int> > &Pairs)
+{
+	vector<int> Order;
+	int i;
+	for (i=0; i<(int)AABBs.size(); ++i)
+	{
+		if (Valid[i])
+			Order.push_back(i);
+	}
+	sort(Order.begin(), Order.end(), [&AABBs](int i1, int i2) { return AABBs[i1].first.x < AABBs[i2].first.x; });
+
+	// Boxes whose x range may still overlap the boxes which come after them in the sorted order
+	vector<int> Active;
+	vector<int>::iterator itActive;
+	for (i=0; i<(int)Order.size(); ++i)
+	{
+		const pair<XYZ, XYZ> &AABB = AABBs[Order[i]];
+		for (itActive = Active.begin(); itActive != Active.end(); )
+		{
+			const pair<XYZ, XYZ> &ActiveAABB = AABBs[*itActive];
+			if (ActiveAABB.second.x < AABB.first.x - dTolerance)
+			{
+				itActive = Active.erase(itActive);
+				continue;
+			}
+			if (BoundingBoxIntersect(AABB.first, AABB.second, ActiveAABB.first, ActiveAABB.second, dTolerance))
+			{
+				Pairs.push_back(make_pair(Order[i], *itActive));
+				Pairs.push_back(make_pair(*itActive, Order[i]));
+			}
+			++itActive;
+		}
+		Active.push_back(Order[i]);
+	}
+	sort(Pairs.begin(), Pairs.end());
+}
+
 int CTextile::DetectInterference(vector<float> &DistanceToSurface, vector<int> &YarnIndices, bool bTrimToDomain, CMesh *pInterferingPoints )
 {
 	if (!BuildTextileIfNeeded())
@@ -589,79 +689,125 @@ int CTextile::DetectInterference(vector<float> &DistanceToSurface, vector<int> &
 		pInterferingPoints->Clear();
 
 	TGLOGINDENT("Detecting interference between yarns in textile \"" << GetName() << "\"");
-	int iIntersections = 0;
-	vector<CYarn>::iterator itYarn;
-	vector<CYarn>::iterator itYarnCompare;
-	vector<CSlaveNode>::const_iterator itSlaveNode;
-	vector<XYZ>::const_iterator itPoint;
-	pair<XYZ, XYZ> AABB1, AABB2;
-	// Parameters to send to PointInsideYarn. Only need because default parameters before pDistanceToSurface
-	XYZ pTangent;
-	XY pLoc;
-	double pVolumeFraction, pDistanceToSurface;
-	int iIndex;
+	if (!BuildYarns(CYarn::SURFACE))
+		return -1;
 
-	for (itYarn = m_Yarns.begin(), iIndex = 0; itYarn != m_Yarns.end(); ++itYarn, ++iIndex)
+	// Broad phase: find the yarns whose bounding boxes intersect. The bounding boxes, trimmed to the domain
+	// if needed, and the translations are only found once for each yarn
+	int i, iNumYarns = (int)m_Yarns.size();
+	vector<pair<XYZ, XYZ> > AABBs(iNumYarns);
+	vector<bool> Valid(iNumYarns, true);
+	vector<vector<XYZ> > Translations(iNumYarns);
+	for (i=0; i<iNumYarns; ++i)
 	{
-		for (itYarnCompare = m_Yarns.begin(); itYarnCompare != m_Yarns.end(); ++itYarnCompare)
+		if ( bTrimToDomain )
 		{
-			if (itYarn == itYarnCompare)
-				continue;
-			if ( bTrimToDomain )
-			{
-				CMesh YarnMesh, CompareMesh;
-				
-				itYarn->AddSurfaceToMesh(YarnMesh, m_pDomain);
-				AABB1 = YarnMesh.GetAABB();
-				itYarnCompare->AddSurfaceToMesh( CompareMesh, m_pDomain );
-				AABB2 = CompareMesh.GetAABB();
-			}
-			else
-			{
-				AABB1 = itYarn->GetAABB();
-				AABB2 = itYarnCompare->GetAABB();
-			}
-			if (!BoundingBoxIntersect(AABB1.first, AABB1.second, AABB2.first, AABB2.second, 1e-9))
-				continue;
+			CMesh YarnMesh;
+			m_Yarns[i].AddSurfaceToMesh(YarnMesh, m_pDomain);
+			AABBs[i] = YarnMesh.GetAABB();
+			// Yarns entirely outside the domain can't interfere
+			Valid[i] = YarnMesh.GetNumNodes() > 0;
+			Translations[i] = m_pDomain->GetTranslations(m_Yarns[i]);
+		}
+		else
+		{
+			AABBs[i] = m_Yarns[i].GetAABB();
+			Translations[i].push_back(XYZ(0,0,0));
+		}
+	}
+	vector<pair<int, int> > Pairs;
+	GetIntersectingBoxes(AABBs, Valid, 1e-9, Pairs);
 
-			vector<XYZ> YarnTranslations;
-			vector<XYZ> CompareTranslations;
-			if( bTrimToDomain )
-			{
-				YarnTranslations = m_pDomain->GetTranslations(*itYarn);
-				CompareTranslations = m_pDomain->GetTranslations(*itYarnCompare);
-			}
-			else
+	// Bounding box of the section points of each slave node, used to skip whole sections
+	// which can't be inside the other yarn
+	vector<vector<pair<XYZ, XYZ> > > SectionAABBs(iNumYarns);
+	for (i=0; i<iNumYarns; ++i)
+	{
+		if (!Valid[i])
+			continue;
+		const vector<CSlaveNode> &SlaveNodes = m_Yarns[i].GetSlaveNodes(CYarn::SURFACE);
+		SectionAABBs[i].resize(SlaveNodes.size());
+		for (size_t j=0; j<SlaveNodes.size(); ++j)
+		{
+			if (!SlaveNodes[j].GetSectionPoints().empty())
+				GetMinMaxXYZ(SlaveNodes[j].GetSectionPoints(), SectionAABBs[i][j].first, SectionAABBs[i][j].second);
+		}
+	}
+
+	// Narrow phase: check the section points of one yarn against the other yarn for each pair. The results
+	// of each pair are kept separately and joined in order so that they don't depend on the number of threads
+	struct INTERFERENCE
+	{
+		vector<XYZ> Points;
+		vector<float> Distances;
+	};
+	vector<INTERFERENCE> Interferences(Pairs.size());
+	ParallelFor((int)Pairs.size(), [&](int iPair)
+	{
+		const CYarn &Yarn = m_Yarns[Pairs[iPair].first];
+		const CYarn &CompareYarn = m_Yarns[Pairs[iPair].second];
+		const vector<XYZ> &YarnTranslations = Translations[Pairs[iPair].first];
+		const vector<XYZ> &CompareTranslations = Translations[Pairs[iPair].second];
+		const vector<pair<XYZ, XYZ> > &YarnSectionAABBs = SectionAABBs[Pairs[iPair].first];
+		pair<XYZ, XYZ> CompareAABB = CompareYarn.GetAABB();
+		INTERFERENCE &Interference = Interferences[iPair];
+		// Parameters to send to PointInsideYarn. Only need because default parameters before pDistanceToSurface
+		XYZ pTangent;
+		XY pLoc;
+		double pVolumeFraction, pDistanceToSurface;
+		vector<bool> CheckTranslations(YarnTranslations.size());
+		CYarnQueryContext Context;
+		vector<XYZ>::const_iterator itPoint, itXYZ, itCompareXYZ;
+		const vector<CSlaveNode> &SlaveNodes = Yarn.GetSlaveNodes(CYarn::SURFACE);
+		for (size_t j=0; j<SlaveNodes.size(); ++j)
+		{
+			// PointInsideYarn only finds points inside the bounding box of one of the translated copies of the yarn
+			bool bCheckSection = false;
+			for (size_t k=0; k<YarnTranslations.size(); ++k)
 			{
-				XYZ Translation(0,0,0);
-				YarnTranslations.push_back(Translation);
-				CompareTranslations.push_back(Translation);
+				CheckTranslations[k] = false;
+				for (itCompareXYZ = CompareTranslations.begin(); itCompareXYZ != CompareTranslations.end() && !CheckTranslations[k]; ++itCompareXYZ)
+				{
+					XYZ Offset = YarnTranslations[k] - *itCompareXYZ;
+					CheckTranslations[k] = BoundingBoxIntersect(YarnSectionAABBs[j].first + Offset, YarnSectionAABBs[j].second + Offset,
+						CompareAABB.first, CompareAABB.second, 1e-9);
+				}
+				bCheckSection |= CheckTranslations[k];
 			}
-
-			const vector<CSlaveNode> &SlaveNodes = itYarn->GetSlaveNodes(CYarn::SURFACE);
-			for (itSlaveNode = SlaveNodes.begin(); itSlaveNode != SlaveNodes.end(); ++itSlaveNode)
+			if (!bCheckSection)
+				continue;
+			for (itPoint = SlaveNodes[j].GetSectionPoints().begin(); itPoint != SlaveNodes[j].GetSectionPoints().end(); ++itPoint)
 			{
-				for (itPoint = itSlaveNode->GetSectionPoints().begin(); itPoint != itSlaveNode->GetSectionPoints().end(); ++itPoint)
+				for (itXYZ = YarnTranslations.begin(); itXYZ != YarnTranslations.end(); ++itXYZ)
 				{
-					vector<XYZ>::const_iterator itXYZ;
-					for( itXYZ = YarnTranslations.begin(); itXYZ != YarnTranslations.end(); ++itXYZ )
+					if (!CheckTranslations[itXYZ - YarnTranslations.begin()])
+						continue;
+					if ( !bTrimToDomain || m_pDomain->PointInDomain( *itPoint + *itXYZ ) ) // Don't need to check for intersection if point outside domain
 					{
-						if ( !bTrimToDomain || m_pDomain->PointInDomain( *itPoint + *itXYZ ) ) // Don't need to check for intersection if point outside domain
+						if (CompareYarn.PointInsideYarn(*itPoint + *itXYZ, CompareTranslations, &pTangent, &pLoc, &pVolumeFraction, &pDistanceToSurface, 1e-9, NULL, NULL, false, &Context))
 						{
-							if (itYarnCompare->PointInsideYarn(*itPoint + *itXYZ, CompareTranslations, &pTangent, &pLoc, &pVolumeFraction, &pDistanceToSurface))
-							{
-								if (pInterferingPoints)
-									pInterferingPoints->AddNode(*itPoint + *itXYZ);
-								DistanceToSurface.push_back( (float)pDistanceToSurface );
-								YarnIndices.push_back( iIndex );
-								
-								++iIntersections;
-							}
+							Interference.Points.push_back(*itPoint + *itXYZ);
+							Interference.Distances.push_back( (float)pDistanceToSurface );
 						}
 					}
 				}
 			}
 		}
+	});
+
+	int iIntersections = 0;
+	for (size_t j=0; j<Pairs.size(); ++j)
+	{
+		const INTERFERENCE &Interference = Interferences[j];
+		if (pInterferingPoints)
+		{
+			vector<XYZ>::const_iterator itPoint;
+			for (itPoint = Interference.Points.begin(); itPoint != Interference.Points.end(); ++itPoint)
+				pInterferingPoints->AddNode(*itPoint);
+		}
+		DistanceToSurface.insert(DistanceToSurface.end(), Interference.Distances.begin(), Interference.Distances.end());
+		YarnIndices.insert(YarnIndices.end(), Interference.Distances.size(), Pairs[j].first);
+		iIntersections += (int)Interference.Distances.size();
 	}
 	TGLOG("Found " << iIntersections << " intersections between yarns in textile \"" << GetName() << "\"");
 	return iIntersections;
@@ -707,8 +853,29 @@ int CTextile::GetNumYarns() const
 	return (int)m_Yarns.size();
 }
 
+bool CTextile::BuildYarns(int iBuildType, int iNumThreads) const
+{
+	if (!BuildTextileIfNeeded())
+		return false;
+	// Each yarn is built from its own nodes and sections so the result doesn't depend on the number of
+	// threads. The builds do share the logger, ParallelFor holds back the messages logged on the worker
+	// threads and passes them on from this thread once all the yarns are built
+	vector<char> Built(m_Yarns.size(), false);
+	ParallelFor((int)m_Yarns.size(), [&](int i)
+	{
+		Built[i] = m_Yarns[i].BuildYarnIfNeeded(iBuildType);
+	}, iNumThreads);
+	return find(Built.begin(), Built.end(), false) == Built.end();
+}
+
 bool CTextile::BuildTextileIfNeeded() const
 {
+	// Textiles are built on demand, possibly from several threads at once. Once built the flags
+	// are only read so the lock is only taken while a build is needed or in progress.
+	// BuildTextile clears m_bNeedsBuilding before the yarns are ready so m_bBuilding is checked too.
+	if (!m_bNeedsBuilding && !m_bBuilding)
+		return true;
+	lock_guard<recursive_mutex> Lock(m_BuildMutex);
 	if (!m_bNeedsBuilding)
 		return true;
 	else
@@ -716,8 +883,11 @@ bool CTextile::BuildTextileIfNeeded() const
 		// Even if the build fails, we set this flag to false because if nothing happens
 		// which changes the textile between this call and the next call. The next call
 		// will also fail, thus there is no point to call it again.
+		m_bBuilding = true;
 		m_bNeedsBuilding = false;
-		return BuildTextile();
+		bool bBuilt = BuildTextile();
+		m_bBuilding = false;
+		return bBuilt;
 	}
 }
 
@@ -1170,8 +1340,8 @@ double CTextile::GetDomainVolumeFraction()
 
 		vector<XYZ> Translations = m_pDomain->GetTranslations(*itYarn);
 		Centres = Mesh.GetElementCenters();
-		list<int> &TetIndices = Mesh.GetIndices(CMesh::TET);
-		list<int>::iterator itTetInd;
+		vector<int> &TetIndices = Mesh.GetIndices(CMesh::TET);
+		vector<int>::iterator itTetInd;
 
 		YarnFibreVf = itYarn->GetFibreYarnVolumeFraction();
 		if ( YarnFibreVf < TOL )
@@ -20,6 +20,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #pragma once
 #include "Yarn.h"
 #include "PropertiesTextile.h"
+#include "YarnSpatialIndex.h"
+#include "Parallel.h"
+#include <mutex>
 namespace TexGen
 { 
 	class CDomain;
@@ -129,6 +132,16 @@ namespace TexGen
 		*/
 		void GetPointInformation(const vector<XYZ> &Points, vector<POINT_INFO> &PointsInfo, double dTolerance = 1e-9);
 
+		/// Get useful information of a list of points lying on a structured grid
+		/**
+		Same as GetPointInformation except that the points are known to be ordered row by row, with
+		consecutive points in a row being neighbours (e.g. voxel centres with x varying fastest). The
+		position found along the yarn for one point is used as the starting guess for the next point
+		in the row which reduces the number of iterations needed to locate each point.
+		\param iRowLength Number of points in each row
+		*/
+		void GetGridPointInformation(const vector<XYZ> &Points, vector<POINT_INFO> &PointsInfo, int iRowLength, double dTolerance = 1e-9);
+
 		/// Get information when know which yarn point is in.  Saves iterating through entire textile
 		/**
 		\param bSurface default is False. Set to True if getting point information for surface mesh export. Assumes Points are on yarn surface and doesn't do PointInside check
@@ -300,6 +313,18 @@ namespace TexGen
 		const CDomain* GetDomain() const {return m_pDomain;}
 		CDomain* GetDomain() {return m_pDomain;}
 
+		/// Build all the yarns of the textile at once, each yarn being built in a separate task
+		/**
+		Yarns are otherwise built one at a time when they are first used. Building them beforehand spreads
+		the slave node interpolation, section generation and section meshing of the yarns over several threads,
+		giving the same yarns as building them one after the other. Messages logged while building the yarns
+		are passed on to the logger from the calling thread once all the yarns have been built.
+		\param iBuildType Can be a value from the CYarn::BUILD_TYPE enum, LINE, SURFACE or VOLUME
+		\param iNumThreads Number of threads to use, 0 uses the value returned by GetNumThreads()
+		\return false if building any of the yarns failed
+		*/
+		bool BuildYarns(int iBuildType = CYarn::SURFACE, int iNumThreads = 0) const;
+
 	protected:
 		/// Build the textile only if needed
 		/**
@@ -325,6 +350,21 @@ namespace TexGen
 
 		int AddYarn(const CYarn &Yarn) const;
 
+		/// Build the yarn ready for concurrent calls to PointInsideYarn and get the repeats which intersect the domain
+		/**
+		\return false if the yarn could not be built
+		*/
+		bool PrepareYarnForPointQueries(int iYarn, const CDomain &Domain, vector<XYZ> &Translations) const;
+
+		/// Build the yarns and make sure the spatial index is up to date for points lying between Min and Max
+		/**
+		\return false if one of the yarns could not be built
+		*/
+		bool PrepareSpatialIndex(const XYZ &Min, const XYZ &Max, double dTolerance) const;
+
+		/// Number of points classified together by each parallel task in GetPointInformation
+		static const int POINT_TILE_SIZE = 256;
+
 		/// Vector of yarns contained within this cell
 		/**
 		Note that this variable has been made mutable to enable building of the
@@ -340,8 +380,17 @@ namespace TexGen
 		Note: This is only relavant for classes which derive from CTextile and handle the
 		construction of yarns automatically
 		*/
-		mutable bool m_bNeedsBuilding;
+		mutable CCopyableAtomic<bool> m_bNeedsBuilding;
+
+		/// Set while BuildTextile is running so that other threads wait for it to finish
+		mutable CCopyableAtomic<bool> m_bBuilding;
+
+		/// Lock held while the textile is built, building may call functions which check whether it needs building again
+		mutable recursive_mutex m_BuildMutex;
 
 		CObjectContainer<CDomain> m_pDomain;
+
+		/// Index of the yarn segments used to speed up GetPointInformation, rebuilt when the yarns change
+		mutable CYarnSpatialIndex m_SpatialIndex;
 	};
 };	// namespace TexGen
@@ -60,8 +60,8 @@ double CTextileDeformerVolumeMesh::GetDisplacement(XYZ Pos, int iYarn, XYZ &Disp
 		return false;
 	const CMesh &Mesh = m_YarnMeshes[iYarn].Mesh;
 	const vector<XYZ> &NodeDisplacements = m_YarnMeshes[iYarn].NodeDisplacements;
-	list<int>::const_iterator itIndex;
-	const list<int> &Indices = Mesh.GetIndices(CMesh::TET);
+	vector<int>::const_iterator itIndex;
+	const vector<int> &Indices = Mesh.GetIndices(CMesh::TET);
 	int i1, i2, i3, i4;
 	XYZ N1, N2, N3, N4;
 	double a, b, c, d, dMin;
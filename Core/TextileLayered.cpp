@@ -253,6 +253,10 @@ void CTextileLayered::NestLayers()
 	// Create mesh for each layer
 	iNumX = GetLayerMeshes( LayerMeshes );
 	iNumY = iNumX;
+	// Index the triangles of each layer, every layer is intersected with the same grid of lines
+	vector<CTriangleBVH> LayerBVHs( LayerMeshes.size() );
+	for ( int iLayer = 0; iLayer < (int)LayerMeshes.size(); ++iLayer )
+		LayerBVHs[iLayer].Build( LayerMeshes[iLayer] );
 
 #ifdef _DEBUG
 	int i = 0;
@@ -278,13 +282,12 @@ void CTextileLayered::NestLayers()
 	{
 		for ( int i = 0; i <= iNumX; ++i )
 		{
-			vector<CMesh>::iterator itMeshes;
 			XYZ P1(Pos.x,Pos.y,AABB.first.z);
 			XYZ P2(Pos.x,Pos.y,AABB.second.z);
-			for ( itMeshes = LayerMeshes.begin(); itMeshes != LayerMeshes.end(); ++itMeshes )
+			for ( int iLayer = 0; iLayer < (int)LayerMeshes.size(); ++iLayer )
 			{
 				vector<pair<double,XYZ> > IntersectionPoints;
-				int iNum = itMeshes->IntersectLine(P1, P2, IntersectionPoints, make_pair(true,true));
+				int iNum = LayerMeshes[iLayer].IntersectLine(P1, P2, IntersectionPoints, make_pair(true,true), false, &LayerBVHs[iLayer]);
 				if ( iNum >= 2 )
 				{
 					pair<double,double> Intersects;
@@ -356,6 +359,9 @@ void CTextileLayered::MaxNestLayers()
 	int iNumX, iNumY;
 	// Initial grid resolution is based on number of slave nodes
 	int iGridRes = GetLayerMeshes( LayerMeshes );
+	vector<CTriangleBVH> LayerBVHs( LayerMeshes.size() );
+	for ( int iLayer = 0; iLayer < (int)LayerMeshes.size(); ++iLayer )
+		LayerBVHs[iLayer].Build( LayerMeshes[iLayer] );
 
 #ifdef _DEBUG
 	int i = 0;
@@ -417,7 +423,7 @@ void CTextileLayered::MaxNestLayers()
 				for ( int k = 0; k < 2; ++k )
 				{
 					vector<pair<double,XYZ> > IntersectionPoints;
-					int iNum = LayerMeshes[iLayer+k].IntersectLine(P1, P2, IntersectionPoints, make_pair(true,true));
+					int iNum = LayerMeshes[iLayer+k].IntersectLine(P1, P2, IntersectionPoints, make_pair(true,true), false, &LayerBVHs[iLayer+k]);
 					if ( iNum >= 2 )
 					{
 						pair<double,double> Intersects;
@@ -0,0 +1,194 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+
+#include "PrecompiledHeaders.h"
+#include "Mesh.h"
+#include <limits>
+
+using namespace TexGen;
+
+/// Used to sort triangle indices by one coordinate of the triangle centres
+struct LessCentreAxis
+{
+	LessCentreAxis(const vector<XYZ> &Centres, int iAxis) : m_Centres(Centres), m_iAxis(iAxis) {}
+	bool operator()(int i1, int i2) const { return m_Centres[i1][m_iAxis] < m_Centres[i2][m_iAxis]; }
+	const vector<XYZ> &m_Centres;
+	int m_iAxis;
+};
+
+CTriangleBVH::CTriangleBVH()
+{
+}
+
+void CTriangleBVH::Clear()
+{
+	m_Nodes.clear();
+	m_Triangles.clear();
+}
+
+void CTriangleBVH::Build(const CMesh &Mesh)
+{
+	// Same tolerance as CMesh::IntersectLine
+	const double dTolerance = 1e-9;
+
+	Clear();
+	const vector<int> &Indices = Mesh.GetIndices(CMesh::TRI);
+	int iNumTriangles = (int)Indices.size()/3;
+	vector<XYZ> Centres(iNumTriangles);
+	vector<pair<XYZ, XYZ> > Boxes(iNumTriangles);
+	m_Triangles.resize(iNumTriangles);
+	int i, j;
+	for (i = 0; i < iNumTriangles; ++i)
+	{
+		XYZ T[3];
+		for (j = 0; j < 3; ++j)
+			T[j] = Mesh.GetNode(Indices[3*i+j]);
+
+		// Points up to dTolerance/(edge length) outside each edge are accepted as intersections.
+		// The region this covers lies within the triangle scaled about its incentre so that the
+		// inscribed circle grows by the largest of these distances.
+		double dEdges[3];
+		for (j = 0; j < 3; ++j)
+			dEdges[j] = GetLength(T[(j+1)%3], T[(j+2)%3]);
+		double dPerimeter = dEdges[0] + dEdges[1] + dEdges[2];
+		double dMinEdge = min(dEdges[0], min(dEdges[1], dEdges[2]));
+		double dInRadius = GetLength(CrossProduct(T[1]-T[0], T[2]-T[0]))/dPerimeter;
+		double dScale = 1;
+		XYZ InCentre = T[0];
+		if (dInRadius > 0)
+		{
+			dScale = (dInRadius + dTolerance/dMinEdge)/dInRadius;
+			InCentre = (dEdges[0]*T[0] + dEdges[1]*T[1] + dEdges[2]*T[2])/dPerimeter;
+		}
+		XYZ Min, Max;
+		for (j = 0; j < 3; ++j)
+		{
+			XYZ P = InCentre + (T[j]-InCentre)*dScale;
+			Min = j ? TexGen::Min(Min, P) : P;
+			Max = j ? TexGen::Max(Max, P) : P;
+		}
+		// Allow for rounding errors in the intersection point
+		XYZ Margin = Max - Min;
+		double dMargin = 1e-6*max(Margin.x, max(Margin.y, Margin.z)) + 1e-9*max(GetLength(Min), GetLength(Max));
+		Boxes[i] = make_pair(Min - XYZ(dMargin, dMargin, dMargin), Max + XYZ(dMargin, dMargin, dMargin));
+		Centres[i] = 0.5*(Min + Max);
+		m_Triangles[i] = i;
+	}
+	if (iNumTriangles)
+	{
+		m_Nodes.reserve(2*iNumTriangles);
+		BuildNode(Centres, Boxes, 0, iNumTriangles);
+	}
+}
+
+int CTriangleBVH::BuildNode(const vector<XYZ> &Centres, const vector<pair<XYZ, XYZ> > &Boxes, int iBegin, int iEnd)
+{
+	const int iMaxLeafSize = 4;
+
+	int iNode = (int)m_Nodes.size();
+	m_Nodes.push_back(NODE());
+	XYZ Min = Boxes[m_Triangles[iBegin]].first, Max = Boxes[m_Triangles[iBegin]].second;
+	XYZ CentreMin = Centres[m_Triangles[iBegin]], CentreMax = CentreMin;
+	int i;
+	for (i = iBegin+1; i < iEnd; ++i)
+	{
+		int iTriangle = m_Triangles[i];
+		Min = TexGen::Min(Min, Boxes[iTriangle].first);
+		Max = TexGen::Max(Max, Boxes[iTriangle].second);
+		CentreMin = TexGen::Min(CentreMin, Centres[iTriangle]);
+		CentreMax = TexGen::Max(CentreMax, Centres[iTriangle]);
+	}
+	m_Nodes[iNode].Min = Min;
+	m_Nodes[iNode].Max = Max;
+	if (iEnd - iBegin <= iMaxLeafSize)
+	{
+		m_Nodes[iNode].iFirst = iBegin;
+		m_Nodes[iNode].iCount = iEnd - iBegin;
+		return iNode;
+	}
+
+	// Split at the median of the triangle centres along the axis with the largest extent
+	XYZ Size = CentreMax - CentreMin;
+	int iAxis = 0;
+	if (Size.y > Size[iAxis])
+		iAxis = 1;
+	if (Size.z > Size[iAxis])
+		iAxis = 2;
+	int iMid = (iBegin + iEnd)/2;
+	nth_element(m_Triangles.begin()+iBegin, m_Triangles.begin()+iMid, m_Triangles.begin()+iEnd, LessCentreAxis(Centres, iAxis));
+
+	BuildNode(Centres, Boxes, iBegin, iMid);
+	int iSecond = BuildNode(Centres, Boxes, iMid, iEnd);
+	m_Nodes[iNode].iFirst = iSecond;
+	m_Nodes[iNode].iCount = 0;
+	return iNode;
+}
+
+bool CTriangleBVH::LineIntersectsBox(const XYZ &P1, const XYZ &Dir, double dMinU, double dMaxU, const XYZ &Min, const XYZ &Max)
+{
+	int i;
+	for (i = 0; i < 3; ++i)
+	{
+		if (Dir[i] == 0)
+		{
+			if (P1[i] < Min[i] || P1[i] > Max[i])
+				return false;
+			continue;
+		}
+		double dU1 = (Min[i] - P1[i])/Dir[i];
+		double dU2 = (Max[i] - P1[i])/Dir[i];
+		if (dU1 > dU2)
+			swap(dU1, dU2);
+		dMinU = max(dMinU, dU1);
+		dMaxU = min(dMaxU, dU2);
+		if (dMinU > dMaxU)
+			return false;
+	}
+	return true;
+}
+
+void CTriangleBVH::GetTrianglesNearLine(const XYZ &P1, const XYZ &P2, pair<bool, bool> TrimResults, vector<int> &Triangles) const
+{
+	if (m_Nodes.empty())
+		return;
+	XYZ Dir = P2 - P1;
+	double dMinU = TrimResults.first ? 0 : -numeric_limits<double>::infinity();
+	double dMaxU = TrimResults.second ? 1 : numeric_limits<double>::infinity();
+
+	vector<int> Stack;
+	Stack.push_back(0);
+	while (!Stack.empty())
+	{
+		int iNode = Stack.back();
+		Stack.pop_back();
+		const NODE &Node = m_Nodes[iNode];
+		if (!LineIntersectsBox(P1, Dir, dMinU, dMaxU, Node.Min, Node.Max))
+			continue;
+		if (Node.iCount)
+		{
+			Triangles.insert(Triangles.end(), m_Triangles.begin()+Node.iFirst, m_Triangles.begin()+Node.iFirst+Node.iCount);
+		}
+		else
+		{
+			Stack.push_back(Node.iFirst);
+			Stack.push_back(iNode+1);
+		}
+	}
+}
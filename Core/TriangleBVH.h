@@ -0,0 +1,74 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+
+#pragma once
+
+namespace TexGen
+{
+	using namespace std;
+
+	class CMesh;
+
+	/// Bounding volume hierarchy over the triangles of a mesh to speed up line intersection queries
+	/**
+	Build it once from a triangle mesh and pass it to CMesh::IntersectLine for each line to be
+	tested. The hierarchy does not keep a reference to the mesh so it must be rebuilt if the
+	mesh is modified. The bounding boxes are enlarged by the tolerance used in CMesh::IntersectLine
+	so no triangle the brute force search would find is culled.
+	*/
+	class CLASS_DECLSPEC CTriangleBVH
+	{
+	public:
+		CTriangleBVH();
+
+		/// Build the hierarchy over the triangles of the mesh
+		void Build(const CMesh &Mesh);
+
+		/// Remove all triangles from the hierarchy
+		void Clear();
+
+		/// Get the number of triangles the hierarchy was built with
+		int GetNumTriangles() const { return (int)m_Triangles.size(); }
+
+		/// Get the indices of the triangles which may be intersected by a line
+		/**
+		\param P1 Origin of the line
+		\param P2 End of the line
+		\param TrimResults If true the line is limited to the segment beyond P1 and/or before P2
+		\param Triangles Triangle indices (position in the TRI element list) are added to this, in no particular order
+		*/
+		void GetTrianglesNearLine(const XYZ &P1, const XYZ &P2, pair<bool, bool> TrimResults, vector<int> &Triangles) const;
+
+	protected:
+		struct NODE
+		{
+			XYZ Min, Max;
+			int iFirst;	///< First triangle for leaf nodes or index of the second child for interior nodes (the first child follows its parent)
+			int iCount;	///< Number of triangles for leaf nodes, 0 for interior nodes
+		};
+
+		int BuildNode(const vector<XYZ> &Centres, const vector<pair<XYZ, XYZ> > &Boxes, int iBegin, int iEnd);
+		static bool LineIntersectsBox(const XYZ &P1, const XYZ &Dir, double dMinU, double dMaxU, const XYZ &Min, const XYZ &Max);
+
+		vector<NODE> m_Nodes;
+		vector<int> m_Triangles;	///< Triangle indices ordered so that each leaf refers to a contiguous range
+	};
+
+};	// namespace TexGen
@@ -0,0 +1,265 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#include "PrecompiledHeaders.h"
+#include "VTKWriter.h"
+
+using namespace TexGen;
+
+namespace
+{
+	const char BASE64_CHARACTERS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	/// Number of encoded characters collected before they are written
+	const size_t BASE64_BUFFER_SIZE = 65536;
+}
+
+CVTKWriter::CVTKWriter(VTK_FORMAT Format)
+: m_Format(Format)
+, m_bStartTagOpen(false)
+, m_iAppendedOffset(0)
+, m_iBytesWritten(0)
+, m_bError(false)
+, m_iNumBase64Bytes(0)
+{
+}
+
+CVTKWriter::~CVTKWriter(void)
+{
+	if (m_Output.is_open())
+		Close();
+}
+
+bool CVTKWriter::Open(string Filename, string DataSetType, string Attributes)
+{
+	m_Output.open(Filename.c_str(), ios::out | ios::binary);
+	if (!m_Output)
+	{
+		TGERROR("Unable to open file for writing: " << Filename);
+		return false;
+	}
+	m_Elements.clear();
+	m_AppendedArrays.clear();
+	m_iAppendedOffset = 0;
+	m_bError = false;
+
+	int iTest = 1;
+	string ByteOrder = *(char*)&iTest ? "LittleEndian" : "BigEndian";
+	m_Output << "<?xml version=\"1.0\" ?>\n";
+	// Binary data needs version 1.0 for the 64 bit headers
+	if (m_Format == VTK_ASCII)
+		StartElement("VTKFile", "type=\"" + DataSetType + "\" version=\"0.1\" byte_order=\"" + ByteOrder + "\"");
+	else
+		StartElement("VTKFile", "type=\"" + DataSetType + "\" version=\"1.0\" byte_order=\"" + ByteOrder + "\" header_type=\"UInt64\"");
+	StartElement(DataSetType, Attributes);
+	return true;
+}
+
+bool CVTKWriter::Close()
+{
+	if (!m_Output.is_open())
+		return false;
+	// End everything inside the VTKFile element
+	while (m_Elements.size() > 1)
+		EndElement();
+	if (m_Format == VTK_APPENDED_RAW && !m_AppendedArrays.empty())
+	{
+		CloseStartTag();
+		m_Output << GetIndent() << "<AppendedData encoding=\"raw\">\n_";
+		vector<APPENDED_ARRAY>::const_iterator itArray;
+		for (itArray = m_AppendedArrays.begin(); itArray != m_AppendedArrays.end(); ++itArray)
+			WriteArray(itArray->iNumBytes, itArray->WriteData);
+		m_Output << "\n" << GetIndent() << "</AppendedData>\n";
+		m_AppendedArrays.clear();
+	}
+	while (!m_Elements.empty())
+		EndElement();
+	m_Output.close();
+	bool bSuccess = !m_bError && !m_Output.fail();
+	if (!bSuccess)
+		TGERROR("Unable to write VTK file");
+	return bSuccess;
+}
+
+void CVTKWriter::StartElement(string Name, string Attributes)
+{
+	CloseStartTag();
+	m_Output << GetIndent() << "<" << Name;
+	if (!Attributes.empty())
+		m_Output << " " << Attributes;
+	m_Elements.push_back(Name);
+	m_bStartTagOpen = true;
+}
+
+void CVTKWriter::EndElement()
+{
+	if (m_Elements.empty())
+		return;
+	string Name = m_Elements.back();
+	m_Elements.pop_back();
+	if (m_bStartTagOpen)
+	{
+		// Element without children
+		m_Output << " />\n";
+		m_bStartTagOpen = false;
+	}
+	else
+		m_Output << GetIndent() << "</" << Name << ">\n";
+}
+
+string CVTKWriter::GetFormatAttributes() const
+{
+	switch (m_Format)
+	{
+	case VTK_BASE64:
+		return "format=\"binary\"";
+	case VTK_APPENDED_RAW:
+		return "format=\"appended\" offset=\"" + stringify(m_iAppendedOffset) + "\"";
+	default:
+		return "format=\"ascii\"";
+	}
+}
+
+void CVTKWriter::AddDataArray(string Attributes, size_t iNumBytes, const function<void()> &WriteData)
+{
+	CloseStartTag();
+	m_Output << GetIndent() << "<DataArray " << Attributes;
+	if (m_Format == VTK_APPENDED_RAW)
+	{
+		m_Output << " />\n";
+		APPENDED_ARRAY Array;
+		Array.iNumBytes = iNumBytes;
+		Array.WriteData = WriteData;
+		m_AppendedArrays.push_back(Array);
+		m_iAppendedOffset += sizeof(unsigned long long) + iNumBytes;
+		return;
+	}
+	m_Output << ">";
+	WriteArray(iNumBytes, WriteData);
+	m_Output << "</DataArray>\n";
+}
+
+string CVTKWriter::EncodeAttribute(const string &Value)
+{
+	string Encoded;
+	string::const_iterator itChar;
+	for (itChar = Value.begin(); itChar != Value.end(); ++itChar)
+	{
+		switch (*itChar)
+		{
+		case '&':
+			Encoded += "&amp;";
+			break;
+		case '<':
+			Encoded += "&lt;";
+			break;
+		case '>':
+			Encoded += "&gt;";
+			break;
+		case '\"':
+			Encoded += "&quot;";
+			break;
+		case '\'':
+			Encoded += "&apos;";
+			break;
+		default:
+			Encoded += *itChar;
+		}
+	}
+	return Encoded;
+}
+
+void CVTKWriter::CloseStartTag()
+{
+	if (m_bStartTagOpen)
+	{
+		m_Output << ">\n";
+		m_bStartTagOpen = false;
+	}
+}
+
+string CVTKWriter::GetIndent() const
+{
+	return string(4*m_Elements.size(), ' ');
+}
+
+void CVTKWriter::WriteArray(size_t iNumBytes, const function<void()> &WriteData)
+{
+	if (m_Format != VTK_ASCII)
+	{
+		unsigned long long iHeader = iNumBytes;
+		WriteBytes((const char*)&iHeader, sizeof(iHeader));
+	}
+	m_iBytesWritten = 0;
+	WriteData();
+	if (m_Format == VTK_BASE64)
+		FlushBase64();
+	if (m_Format != VTK_ASCII && m_iBytesWritten != iNumBytes)
+	{
+		TGERROR("Size of VTK data array doesn't match the data written");
+		m_bError = true;
+	}
+}
+
+void CVTKWriter::WriteBytes(const char *pData, size_t iNumBytes)
+{
+	m_iBytesWritten += iNumBytes;
+	if (m_Format == VTK_APPENDED_RAW)
+	{
+		m_Output.write(pData, iNumBytes);
+		return;
+	}
+	const unsigned char *pBytes = (const unsigned char*)pData;
+	size_t i;
+	for (i=0; i<iNumBytes; ++i)
+	{
+		m_Base64Bytes[m_iNumBase64Bytes++] = pBytes[i];
+		if (m_iNumBase64Bytes == 3)
+		{
+			m_Base64Buffer += BASE64_CHARACTERS[m_Base64Bytes[0] >> 2];
+			m_Base64Buffer += BASE64_CHARACTERS[((m_Base64Bytes[0] & 0x03) << 4) | (m_Base64Bytes[1] >> 4)];
+			m_Base64Buffer += BASE64_CHARACTERS[((m_Base64Bytes[1] & 0x0f) << 2) | (m_Base64Bytes[2] >> 6)];
+			m_Base64Buffer += BASE64_CHARACTERS[m_Base64Bytes[2] & 0x3f];
+			m_iNumBase64Bytes = 0;
+			if (m_Base64Buffer.size() >= BASE64_BUFFER_SIZE)
+			{
+				m_Output.write(m_Base64Buffer.data(), m_Base64Buffer.size());
+				m_Base64Buffer.clear();
+			}
+		}
+	}
+}
+
+void CVTKWriter::FlushBase64()
+{
+	if (m_iNumBase64Bytes > 0)
+	{
+		int i;
+		for (i=m_iNumBase64Bytes; i<3; ++i)
+			m_Base64Bytes[i] = 0;
+		char Encoded[4];
+		Encoded[0] = BASE64_CHARACTERS[m_Base64Bytes[0] >> 2];
+		Encoded[1] = BASE64_CHARACTERS[((m_Base64Bytes[0] & 0x03) << 4) | (m_Base64Bytes[1] >> 4)];
+		Encoded[2] = m_iNumBase64Bytes > 1 ? BASE64_CHARACTERS[((m_Base64Bytes[1] & 0x0f) << 2) | (m_Base64Bytes[2] >> 6)] : '=';
+		Encoded[3] = '=';
+		m_Base64Buffer.append(Encoded, 4);
+		m_iNumBase64Bytes = 0;
+	}
+	m_Output.write(m_Base64Buffer.data(), m_Base64Buffer.size());
+	m_Base64Buffer.clear();
+}
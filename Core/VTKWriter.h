@@ -0,0 +1,143 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#pragma once
+#include <functional>
+#include <limits>
+
+namespace TexGen
+{
+	using namespace std;
+
+	/// Encoding of the data arrays of VTK XML files
+	enum VTK_FORMAT
+	{
+		VTK_ASCII,			///< Values written as text inside the data arrays
+		VTK_BASE64,			///< Binary values base64 encoded inside the data arrays
+		VTK_APPENDED_RAW,	///< Binary values appended unencoded after the data set
+	};
+
+	/// Writes VTK XML files straight to disk
+	/**
+	The elements are written as they are started so the file never has to be held in memory. The values of
+	each data array are written by a function passed to AddDataArray, which is called straight away or for
+	appended data when the file is closed, so the values can be written from wherever they are already stored.
+	Binary data arrays are preceded by their size in bytes as a 64 bit integer.
+	*/
+	class CLASS_DECLSPEC CVTKWriter
+	{
+	public:
+		CVTKWriter(VTK_FORMAT Format = VTK_ASCII);
+		~CVTKWriter(void);
+
+		/// Open the file and start the data set element
+		/**
+		\param Filename Name of the file including its extension
+		\param DataSetType Type of VTK data set, e.g. "UnstructuredGrid" or "ImageData"
+		\param Attributes Attributes of the data set element such as the extent of image data
+		*/
+		bool Open(string Filename, string DataSetType, string Attributes = "");
+
+		/// End any open elements, write the appended data and close the file
+		/**
+		\return false if any of the file couldn't be written
+		*/
+		bool Close();
+
+		/// Start an element such as Piece, Points, Cells, PointData or CellData inside the current element
+		void StartElement(string Name, string Attributes = "");
+
+		/// End the element started last
+		void EndElement();
+
+		/// Get the attributes giving the format of the next data array added
+		/**
+		The attributes are returned separately so that they can be placed among the other attributes of the array.
+		*/
+		string GetFormatAttributes() const;
+
+		/// Add a data array to the current element
+		/**
+		\param Attributes All of the attributes of the DataArray element including those from GetFormatAttributes
+		\param iNumBytes Size in bytes of the binary values, WriteData must write exactly this many bytes
+		\param WriteData Function writing the values with WriteValues, anything it refers to must exist until the file is closed
+		*/
+		void AddDataArray(string Attributes, size_t iNumBytes, const function<void()> &WriteData);
+
+		/// Write values of the data array being written
+		template <typename T>
+		void WriteValues(const T *pValues, size_t iNumValues)
+		{
+			if (m_Format == VTK_ASCII)
+			{
+				// Promoted so that chars are written as numbers
+				for (size_t i=0; i<iNumValues; ++i)
+					m_Output << +pValues[i] << " ";
+			}
+			else
+				WriteBytes((const char*)pValues, iNumValues*sizeof(T));
+		}
+
+		/// Get the name of the VTK type of T
+		template <typename T>
+		static string GetDataType()
+		{
+			if (numeric_limits<T>::is_integer)
+				return (numeric_limits<T>::is_signed ? "Int" : "UInt") + stringify(sizeof(T)*8);
+			return "Float" + stringify(sizeof(T)*8);
+		}
+
+		/// Replace the characters which can't appear in the value of an XML attribute with entities
+		static string EncodeAttribute(const string &Value);
+
+		VTK_FORMAT GetFormat() const { return m_Format; }
+
+	protected:
+		/// Data array to be written after the data set
+		struct APPENDED_ARRAY
+		{
+			size_t iNumBytes;
+			function<void()> WriteData;
+		};
+
+		/// Write the start tag of an element if it is still open for attributes
+		void CloseStartTag();
+		/// Indentation for the current depth of elements
+		string GetIndent() const;
+		/// Write the values of a data array preceded by their size
+		void WriteArray(size_t iNumBytes, const function<void()> &WriteData);
+		/// Write binary values encoding them as needed
+		void WriteBytes(const char *pData, size_t iNumBytes);
+		/// Encode the base64 bytes left over, padding the end of the encoded data
+		void FlushBase64();
+
+		ofstream m_Output;
+		VTK_FORMAT m_Format;
+		vector<string> m_Elements;		///< Names of the elements which have been started and not ended
+		bool m_bStartTagOpen;			///< The start tag of the last element started hasn't been closed with >
+		vector<APPENDED_ARRAY> m_AppendedArrays;
+		size_t m_iAppendedOffset;		///< Offset of the next appended array from the start of the appended data
+		size_t m_iBytesWritten;			///< Number of bytes written for the data array being written
+		bool m_bError;
+		unsigned char m_Base64Bytes[3];	///< Bytes waiting to be encoded as a group of 3
+		int m_iNumBase64Bytes;
+		string m_Base64Buffer;			///< Encoded characters waiting to be written
+	};
+
+};	// namespace TexGen
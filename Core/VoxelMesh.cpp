@@ -24,11 +24,95 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "ShearedPeriodicBoundaries.h"
 #include "StaggeredPeriodicBoundaries.h"
 #include "BendingPeriodicBoundaries.h"
+#include "Parallel.h"
 #include <iterator>
 //#define SHINY_PROFILER TRUE
 
 using namespace TexGen;
 
+/// Add an element to a set stored as ranges of consecutive element numbers
+/**
+Elements must be added in ascending order. Storing ranges keeps the sets small since
+neighbouring voxels usually belong to the same yarn.
+*/
+static void AddToElementSet( vector<pair<int, int> > &Ranges, int iElement )
+{
+	if ( !Ranges.empty() && Ranges.back().second == iElement-1 )
+		Ranges.back().second = iElement;
+	else
+		Ranges.push_back( make_pair( iElement, iElement ) );
+}
+
+/// Output the element numbers of a set stored as ranges with iMaxPerLine per line, in the same format as WriteValues
+static void WriteElementRanges( CTextWriter &Output, const vector<pair<int, int> > &Ranges, int iMaxPerLine )
+{
+	int iLinePos = 0;
+	vector<pair<int, int> >::const_iterator itRange;
+	for (itRange = Ranges.begin(); itRange != Ranges.end(); ++itRange)
+	{
+		for (int i = itRange->first; i <= itRange->second; ++i)
+		{
+			if (iLinePos == 0)
+			{
+				// Do nothing...
+			}
+			else if (iLinePos < iMaxPerLine)
+			{
+				Output << ", ";
+			}
+			else
+			{
+				Output << "\n";
+				iLinePos = 0;
+			}
+			Output << i;
+			++iLinePos;
+		}
+	}
+	Output << "\n";
+}
+
+/// Number of elements in each block of text formatted by one thread
+static const int ELEMENT_BLOCK_SIZE = 4096;
+
+/// Format numbered blocks of text on the worker threads and write them to the stream in order
+/**
+The blocks are formatted a batch at a time into separate buffers which are then written in order, so
+the output is identical to formatting the blocks one after another and only one batch is held in memory.
+*/
+static void WriteBlocksInOrder( ostream &Output, int iNumBlocks, const function<void(int, CTextWriter&)> &FormatBlock )
+{
+	int iNumThreads = GetNumThreads();
+	if ( iNumThreads == 1 || iNumBlocks <= 1 )
+	{
+		CTextWriter Writer(Output);
+		for ( int i = 0; i < iNumBlocks; ++i )
+			FormatBlock( i, Writer );
+		return;
+	}
+
+	int iBatchSize = 4*iNumThreads;
+	vector<string> Blocks( iBatchSize );
+	for ( int iFirstBlock = 0; iFirstBlock < iNumBlocks; iFirstBlock += iBatchSize )
+	{
+		int iNumInBatch = min( iBatchSize, iNumBlocks-iFirstBlock );
+		ParallelFor( iNumInBatch, [&]( int i )
+		{
+			// Numbers must be formatted as the stream would format them
+			ostringstream Block;
+			Block.flags( Output.flags() );
+			Block.precision( Output.precision() );
+			{
+				CTextWriter Writer(Block);
+				FormatBlock( iFirstBlock+i, Writer );
+			}
+			Blocks[i] = Block.str();
+		}, iNumThreads );
+		for ( int i = 0; i < iNumInBatch; ++i )
+			Output.write( Blocks[i].data(), Blocks[i].size() );
+	}
+}
+
 CVoxelMesh::CVoxelMesh(string Type)
 {
 	if ( Type == "CShearedPeriodicBoundaries" )
@@ -81,6 +165,8 @@ void CVoxelMesh::SaveVoxelMesh(CTextile &Textile, string OutputFilename, int XVo
 		timer.check("End of SaveToAbaqus");
 		timer.stop();
 	}
+	else if (FileType == VTI_EXPORT)
+		SaveVoxelMeshToVTI(OutputFilename, Textile);
 	else
 		SaveVoxelMeshToVTK(OutputFilename, Textile);
 
@@ -129,8 +215,8 @@ void CVoxelMesh::SaveVoxelMesh(CTextile &Textile, string OutputFilename, int XVo
 	vector<POINT_INFO> ElementsInfo;
 	vector<POINT_INFO>::iterator itElementInfo;
 	
-	list<int>::iterator itIndex;
-	list<int>::iterator itStartIndex;
+	vector<int>::iterator itIndex;
+	vector<int>::iterator itStartIndex;
 	int i;
 	int iNumNodes = m_Mesh.GetNumNodes(CMesh::HEX);
 	int iNumElements;
@@ -146,7 +232,7 @@ void CVoxelMesh::SaveVoxelMesh(CTextile &Textile, string OutputFilename, int XVo
 	TGLOG("Adding elements");
 	AddElements();
 	Textile.GetPointInformation(m_Mesh.GetElementCenters(), ElementsInfo);
-	list<int> &Indices = m_Mesh.GetIndices(CMesh::HEX);
+	vector<int> &Indices = m_Mesh.GetIndices(CMesh::HEX);
 	TGLOG("Deleting fibre elements");
 	iNumElements = ElementsInfo.size();
 	if ( !bOutputYarns )
@@ -249,6 +335,7 @@ void CVoxelMesh::SaveVoxelMeshToVTK(string Filename, CTextile &Textile )
 	ofstream Output(Filename.c_str());
 
 	OutputNodes(Output, Textile, VTU_EXPORT);
+	CalculateElementsInfo(Textile);
 
 	OutputHexElements(Output, true, true, VTU_EXPORT);
 
@@ -284,6 +371,12 @@ void CVoxelMesh::SaveVoxelMeshToVTK(string Filename, CTextile &Textile )
 	m_Mesh.SaveToVTK(Filename, &MeshData);
 }
 
+bool CVoxelMesh::SaveVoxelMeshToVTI(string Filename, CTextile &Textile)
+{
+	TGERROR("Unable to save voxel mesh as VTK image data, the voxels don't form a regular grid");
+	return false;
+}
+
 void CVoxelMesh::SaveToAbaqus( string Filename, CTextile &Textile, bool bOutputMatrix, bool bOutputYarn, int iBoundaryConditions, int iElementType )
 {
 	//PROFILE_FUNC();
@@ -320,23 +413,28 @@ void CVoxelMesh::SaveToAbaqus( string Filename, CTextile &Textile, bool bOutputM
 	{
 		Output << "*Element, Type=C3D8" << "\n";
 	}
-	//PROFILE_BEGIN(OutputHexElements);
-	iNumHexElements = OutputHexElements( Output, bOutputMatrix, bOutputYarn );
-	//PROFILE_END();
 	bool bMatrixOnly = false;
 	if ( bOutputMatrix && !bOutputYarn )
 		bMatrixOnly = true;
 
-	if ( bOutputYarn )
+	// Classify and output one layer at a time if the mesh supports it, otherwise use the element information calculated in OutputNodes
+	if ( !OutputLayers( Output, Filename, Textile, bOutputMatrix, bOutputYarn, iNumHexElements ) )
 	{
-		TGLOG("Outputting orientations & element sets");
-		//PROFILE_BEGIN(OutputOrientations);
-		OutputOrientationsAndElementSets( Filename, Output );
+		//PROFILE_BEGIN(OutputHexElements);
+		iNumHexElements = OutputHexElements( Output, bOutputMatrix, bOutputYarn );
 		//PROFILE_END();
-	}
-	else if ( bMatrixOnly )
-	{
-		OutputMatrixElementSet( Filename, Output, iNumHexElements, bMatrixOnly );
+
+		if ( bOutputYarn )
+		{
+			TGLOG("Outputting orientations & element sets");
+			//PROFILE_BEGIN(OutputOrientations);
+			OutputOrientationsAndElementSets( Filename, Output );
+			//PROFILE_END();
+		}
+		else if ( bMatrixOnly )
+		{
+			OutputMatrixElementSet( Filename, Output, iNumHexElements, bMatrixOnly );
+		}
 	}
 	//PROFILE_BEGIN(OutputNodeSets);
 	OutputAllNodesSet( Filename, Output );
@@ -371,6 +469,7 @@ void CVoxelMesh::SaveToSCIRun( string Filename, CTextile &Textile )
 	TGLOG("Saving voxel mesh data points to " << Filename);
 	
 	OutputNodes(NodesFile, Textile, SCIRUN_EXPORT );
+	CalculateElementsInfo(Textile);
 	
 	Filename = RemoveExtension( Filename, ".pts" );
 	Filename += ".hex";
@@ -398,73 +497,182 @@ void CVoxelMesh::SaveToSCIRun( string Filename, CTextile &Textile )
 
 int CVoxelMesh::OutputHexElements(ostream &Output, bool bOutputMatrix, bool bOutputYarn, int Filetype )
 {
-	int numx = m_XVoxels + 1;
-	int numy = m_YVoxels + 1;
-	int x,y,z;
-	vector<POINT_INFO>::iterator itElementInfo = m_ElementsInfo.begin();
+	int z;
+	vector<POINT_INFO>::const_iterator itElementInfo = m_ElementsInfo.begin();
 	int iElementNumber = 1;
 
 	vector<POINT_INFO> NewElementInfo;
+	// Just saving yarn so need to make element array with just yarn info
+	vector<POINT_INFO> *pNewElementInfo = ( bOutputYarn && !bOutputMatrix ) ? &NewElementInfo : NULL;
 
 	if ( Filetype == SCIRUN_EXPORT )
 		Output << m_XVoxels*m_YVoxels*m_ZVoxels << "\n";
 	
 	for ( z = 0; z < m_ZVoxels; ++z )
 	{
-		for ( y = 0; y < m_YVoxels; ++y )
+		iElementNumber = OutputLayerHexElements( Output, z, itElementInfo, bOutputMatrix, bOutputYarn, iElementNumber, Filetype, pNewElementInfo );
+	}
+
+
+	if ( bOutputYarn && !bOutputMatrix )
+	{
+		m_ElementsInfo.clear();
+		m_ElementsInfo = NewElementInfo;
+	}
+	return ( iElementNumber-1 );
+}
+
+int CVoxelMesh::OutputLayerHexElements(ostream &Output, int z, vector<POINT_INFO>::const_iterator &itElementInfo, bool bOutputMatrix, bool bOutputYarn, int iElementNumber, int Filetype, vector<POINT_INFO> *pOutputInfo )
+{
+	int numx = m_XVoxels + 1;
+	int numy = m_YVoxels + 1;
+	int x,y;
+
+	// Number the elements of each row first so that the rows can then be formatted in parallel
+	vector<POINT_INFO>::const_iterator itLayerInfo = itElementInfo;
+	vector<int> RowElementNumbers( m_YVoxels );
+	for ( y = 0; y < m_YVoxels; ++y )
+	{
+		RowElementNumbers[y] = iElementNumber;
+		for ( x = 0; x < m_XVoxels; ++x )
 		{
-			for ( x = 0; x < m_XVoxels; ++x )
+			if ( (itElementInfo->iYarnIndex == -1 && bOutputMatrix) 
+				 || (itElementInfo->iYarnIndex >=0 && bOutputYarn) )
 			{
-				if ( (itElementInfo->iYarnIndex == -1 && bOutputMatrix) 
-					 || (itElementInfo->iYarnIndex >=0 && bOutputYarn) )
+				if ( Filetype != INP_EXPORT && Filetype != SCIRUN_EXPORT )
 				{
-					if ( Filetype == INP_EXPORT )
-					{
-						Output << iElementNumber << ", ";
-						Output << (x+1) +y*numx + z*numx*numy + 1 << ", " << (x+1) + (y+1)*numx + z*numx*numy + 1 << ", ";
-						Output << x + (y+1)*numx + z*numx*numy + 1 << ", " << x + y*numx + z*numx*numy + 1 << ", ";
-						Output << (x+1) +y*numx + (z+1)*numx*numy + 1 << ", " << (x+1) +(y+1)*numx + (z+1)*numx*numy + 1 << ", ";
-						Output << x +(y+1)*numx + (z+1)*numx*numy + 1 << ", " << x +y*numx + (z+1)*numx*numy + 1 << "\n";
-					}
-					else if ( Filetype == SCIRUN_EXPORT)
-					{
-						Output << x +y*numx + z*numx*numy + 1 << ", " << (x+1) + y*numx + z*numx*numy + 1 << ", ";
-						Output << x + y*numx + (z+1)*numx*numy + 1 << ", " << (x+1) + y*numx + (z+1)*numx*numy + 1 << ", ";
-						Output << x + (y+1)*numx + z*numx*numy + 1 << ", " << (x+1) +(y+1)*numx + z*numx*numy + 1 << ", ";
-						Output << x +(y+1)*numx + (z+1)*numx*numy + 1 << ", " << (x+1) + (y+1)*numx + (z+1)*numx*numy + 1 << "\n";
-					}
-					else  // VTU export
-					{
-						vector<int> Indices;
-						Indices.push_back(x + y*numx + z*numx*numy);
-						Indices.push_back((x + 1) + y*numx + z*numx*numy);
-						Indices.push_back((x + 1) + y*numx + (z + 1)*numx*numy);
-						Indices.push_back(x + y*numx + (z + 1)*numx*numy);
-						Indices.push_back(x + (y + 1)*numx + z*numx*numy);
-						Indices.push_back((x + 1) + (y + 1)*numx + z*numx*numy);
-						Indices.push_back((x + 1) + (y + 1)*numx + (z + 1)*numx*numy);
-						Indices.push_back(x + (y + 1)*numx + (z + 1)*numx*numy);
-						m_Mesh.AddElement(CMesh::HEX, Indices);
-					}
-					++iElementNumber;
-					if ( bOutputYarn && !bOutputMatrix ) // Just saving yarn so need to make element array with just yarn info
-					{
-						NewElementInfo.push_back( *itElementInfo );
-					}					
-					
+					vector<int> Indices;
+					Indices.push_back(x + y*numx + z*numx*numy);
+					Indices.push_back((x + 1) + y*numx + z*numx*numy);
+					Indices.push_back((x + 1) + y*numx + (z + 1)*numx*numy);
+					Indices.push_back(x + y*numx + (z + 1)*numx*numy);
+					Indices.push_back(x + (y + 1)*numx + z*numx*numy);
+					Indices.push_back((x + 1) + (y + 1)*numx + z*numx*numy);
+					Indices.push_back((x + 1) + (y + 1)*numx + (z + 1)*numx*numy);
+					Indices.push_back(x + (y + 1)*numx + (z + 1)*numx*numy);
+					m_Mesh.AddElement(CMesh::HEX, Indices);
 				}
-				++itElementInfo;
+				++iElementNumber;
+				if ( pOutputInfo )
+				{
+					pOutputInfo->push_back( *itElementInfo );
+				}					
+				
 			}
+			++itElementInfo;
 		}
 	}
+	if ( Filetype != INP_EXPORT && Filetype != SCIRUN_EXPORT )
+		return iElementNumber;
 
+	// Enough rows in each block that formatting it is worth handing to a thread
+	int iRowsPerBlock = max( 1, ELEMENT_BLOCK_SIZE/max( m_XVoxels, 1 ) );
+	int iNumBlocks = ( m_YVoxels + iRowsPerBlock - 1 )/iRowsPerBlock;
+	WriteBlocksInOrder( Output, iNumBlocks, [&]( int iBlock, CTextWriter &Writer )
+	{
+		int yEnd = min( (iBlock+1)*iRowsPerBlock, m_YVoxels );
+		for ( int y = iBlock*iRowsPerBlock; y < yEnd; ++y )
+		{
+			vector<POINT_INFO>::const_iterator itInfo = itLayerInfo + y*m_XVoxels;
+			int iElement = RowElementNumbers[y];
+			for ( int x = 0; x < m_XVoxels; ++x, ++itInfo )
+			{
+				if ( !( (itInfo->iYarnIndex == -1 && bOutputMatrix) || (itInfo->iYarnIndex >=0 && bOutputYarn) ) )
+					continue;
+				if ( Filetype == INP_EXPORT )
+				{
+					Writer << iElement << ", ";
+					Writer << (x+1) +y*numx + z*numx*numy + 1 << ", " << (x+1) + (y+1)*numx + z*numx*numy + 1 << ", ";
+					Writer << x + (y+1)*numx + z*numx*numy + 1 << ", " << x + y*numx + z*numx*numy + 1 << ", ";
+					Writer << (x+1) +y*numx + (z+1)*numx*numy + 1 << ", " << (x+1) +(y+1)*numx + (z+1)*numx*numy + 1 << ", ";
+					Writer << x +(y+1)*numx + (z+1)*numx*numy + 1 << ", " << x +y*numx + (z+1)*numx*numy + 1 << "\n";
+				}
+				else
+				{
+					Writer << x +y*numx + z*numx*numy + 1 << ", " << (x+1) + y*numx + z*numx*numy + 1 << ", ";
+					Writer << x + y*numx + (z+1)*numx*numy + 1 << ", " << (x+1) + y*numx + (z+1)*numx*numy + 1 << ", ";
+					Writer << x + (y+1)*numx + z*numx*numy + 1 << ", " << (x+1) +(y+1)*numx + z*numx*numy + 1 << ", ";
+					Writer << x +(y+1)*numx + (z+1)*numx*numy + 1 << ", " << (x+1) + (y+1)*numx + (z+1)*numx*numy + 1 << "\n";
+				}
+				++iElement;
+			}
+		}
+	});
+	return iElementNumber;
+}
 
-	if ( bOutputYarn && !bOutputMatrix )
+bool CVoxelMesh::GetLayerInfo(CTextile &Textile, int z, vector<POINT_INFO> &LayerInfo)
+{
+	vector<XYZ> CentrePoints;
+	if ( !GetLayerCentrePoints( z, CentrePoints ) )
+		return false;
+	LayerInfo.clear();
+	Textile.GetGridPointInformation( CentrePoints, LayerInfo, m_XVoxels );
+	return true;
+}
+
+void CVoxelMesh::CalculateElementsInfo(CTextile &Textile)
+{
+	vector<POINT_INFO> LayerInfo;
+	for ( int z = 0; z < m_ZVoxels; ++z )
 	{
-		m_ElementsInfo.clear();
-		m_ElementsInfo = NewElementInfo;
+		if ( !GetLayerInfo( Textile, z, LayerInfo ) )
+			return;
+		m_ElementsInfo.insert( m_ElementsInfo.end(), LayerInfo.begin(), LayerInfo.end() );
 	}
-	return ( iElementNumber-1 );
+}
+
+bool CVoxelMesh::OutputLayers(ostream &Output, string Filename, CTextile &Textile, bool bOutputMatrix, bool bOutputYarn, int &iNumElements)
+{
+	vector<POINT_INFO> LayerInfo;
+	if ( !GetLayerInfo( Textile, 0, LayerInfo ) )
+		return false;
+
+	ofstream OriOutput;
+	ofstream DataOutput;
+	bool bElementData = false;
+	if ( bOutputYarn )
+	{
+		TGLOG("Outputting orientations & element sets");
+		bElementData = OpenElementDataFiles( Filename, OriOutput, DataOutput );
+	}
+
+	map<int, vector<pair<int, int> > > ElementSets;
+	vector<POINT_INFO> OutputInfo;
+	vector<POINT_INFO>::const_iterator itElementInfo;
+	int iElementNumber = 1;
+	int i, z;
+	for ( z = 0; z < m_ZVoxels; ++z )
+	{
+		if ( z > 0 )
+			GetLayerInfo( Textile, z, LayerInfo );
+
+		OutputInfo.clear();
+		itElementInfo = LayerInfo.begin();
+		int iFirstElement = iElementNumber;
+		iElementNumber = OutputLayerHexElements( Output, z, itElementInfo, bOutputMatrix, bOutputYarn, iElementNumber, INP_EXPORT, &OutputInfo );
+
+		if ( !bElementData )
+			continue;
+		OutputElementData( OriOutput, DataOutput, OutputInfo, iFirstElement );
+		for ( itElementInfo = OutputInfo.begin(), i = iFirstElement; itElementInfo != OutputInfo.end(); ++itElementInfo, ++i )
+		{
+			AddToElementSet( ElementSets[itElementInfo->iYarnIndex], i );
+		}
+	}
+	iNumElements = iElementNumber-1;
+
+	// As in OutputOrientationsAndElementSets nothing is written for the yarns if the element data files couldn't be opened
+	if ( bElementData )
+	{
+		OutputOrientationsHeader( Filename, Output );
+		OutputElementSets( Output, ElementSets, iNumElements );
+	}
+	else if ( !bOutputYarn && bOutputMatrix )
+	{
+		OutputMatrixElementSet( Filename, Output, iNumElements, true );
+	}
+	return true;
 }
 
 void CVoxelMesh::OutputOrientationsAndElementSets( string Filename )
@@ -476,28 +684,63 @@ void CVoxelMesh::OutputOrientationsAndElementSets( string Filename )
 }
 
 void CVoxelMesh::OutputOrientationsAndElementSets( string Filename, ostream &Output )
+{
+	ofstream OriOutput;
+	ofstream DataOutput;
+	if ( !OpenElementDataFiles( Filename, OriOutput, DataOutput ) )
+		return;
+
+	OutputOrientationsHeader( Filename, Output );
+
+	int i;
+	OutputElementData( OriOutput, DataOutput, m_ElementsInfo, 1 );
+	
+	map<int, vector<pair<int, int> > > ElementSets;
+	vector<POINT_INFO>::iterator itData;
+	for (itData = m_ElementsInfo.begin(), i=1; itData != m_ElementsInfo.end(); ++itData, ++i)
+	{
+		AddToElementSet( ElementSets[itData->iYarnIndex], i );
+	}
+
+	OutputElementSets( Output, ElementSets, (int)m_ElementsInfo.size() );
+}
+
+bool CVoxelMesh::OpenElementDataFiles( string Filename, ofstream &OriOutput, ofstream &DataOutput )
 {
 	string OrientationsFilename = Filename;
 	OrientationsFilename.replace(OrientationsFilename.end()-4, OrientationsFilename.end(), ".ori");
-	ofstream OriOutput(OrientationsFilename.c_str());
+	OriOutput.open(OrientationsFilename.c_str());
 	string ElementDataFilename = Filename;
 	ElementDataFilename.replace(ElementDataFilename.end()-4, ElementDataFilename.end(), ".eld");
-	ofstream DataOutput(ElementDataFilename.c_str());
+	DataOutput.open(ElementDataFilename.c_str());
 
 	if (!OriOutput)
 	{
 		TGERROR("Unable to output orientations, could not open file: " << OrientationsFilename);
-		return;
+		return false;
 	}
 	if (!DataOutput)
 	{
 		TGERROR("Unable to output additional element data, could not open file: " << ElementDataFilename);
-		return;
+		return false;
 	}
 
 	TGLOG("Saving element orientations data to " << OrientationsFilename);
 	TGLOG("Saving additional element data to " << ElementDataFilename);
 
+	// Default orientation
+	WriteOrientationsHeader( OriOutput );
+	OriOutput <<  ", 1.0, 0.0, 0.0,   0.0, 1.0, 0.0" << "\n";
+
+	WriteElementsHeader( DataOutput );
+	return true;
+}
+
+void CVoxelMesh::OutputOrientationsHeader( string Filename, ostream &Output )
+{
+	string OrientationsFilename = Filename;
+	OrientationsFilename.replace(OrientationsFilename.end()-4, OrientationsFilename.end(), ".ori");
+
 	WriteOrientationsHeader( Output );
 	Output << "*Distribution Table, Name=TexGenOrientationVectors" << "\n";
 	Output << "COORD3D,COORD3D" << "\n";
@@ -505,62 +748,77 @@ void CVoxelMesh::OutputOrientationsAndElementSets( string Filename, ostream &Out
 	Output << "*Orientation, Name=TexGenOrientations, Definition=coordinates" << "\n";
 	Output << "TexGenOrientationVectors" << "\n";
 	Output << "1, 0" << "\n";
+}
 
-	// Default orientation
-	WriteOrientationsHeader( OriOutput );
-	OriOutput <<  ", 1.0, 0.0, 0.0,   0.0, 1.0, 0.0" << "\n";
-
-	WriteElementsHeader( DataOutput );
+void CVoxelMesh::OutputElementData( ostream &OriOutput, ostream &DataOutput, const vector<POINT_INFO> &ElementsInfo, int iFirstElement )
+{
+	int iNumElements = (int)ElementsInfo.size();
+	int iNumBlocks = ( iNumElements + ELEMENT_BLOCK_SIZE - 1 )/ELEMENT_BLOCK_SIZE;
+	WriteBlocksInOrder( OriOutput, iNumBlocks, [&]( int iBlock, CTextWriter &Writer )
+	{
+		int iEnd = min( (iBlock+1)*ELEMENT_BLOCK_SIZE, iNumElements );
+		for ( int i = iBlock*ELEMENT_BLOCK_SIZE; i < iEnd; ++i )
+			OutputElementOrientation( Writer, iFirstElement+i, ElementsInfo[i] );
+	});
+	WriteBlocksInOrder( DataOutput, iNumBlocks, [&]( int iBlock, CTextWriter &Writer )
+	{
+		int iEnd = min( (iBlock+1)*ELEMENT_BLOCK_SIZE, iNumElements );
+		for ( int i = iBlock*ELEMENT_BLOCK_SIZE; i < iEnd; ++i )
+			OutputElementData( Writer, iFirstElement+i, ElementsInfo[i] );
+	});
+}
 
-	int i;
-	
-	map<int, vector<int> > ElementSets;
-	vector<POINT_INFO>::iterator itData;
-	for (itData = m_ElementsInfo.begin(), i=1; itData != m_ElementsInfo.end(); ++itData, ++i)
+void CVoxelMesh::OutputElementOrientation( CTextWriter &OriOutput, int iElement, const POINT_INFO &Info )
+{
+	if (Info.iYarnIndex != -1)
 	{
-		if (itData->iYarnIndex != -1)
-		{
-			XYZ Up = itData->Up;
-			XYZ Dir = itData->Orientation;
-			
-			XYZ Perp = CrossProduct(Dir, Up);
-			Normalise(Perp);
-			OriOutput << i << ", " << Dir << ",   " << Perp << "\n";
-		}
-		else
-		{
-			// Default orientation
-			OriOutput << i << ", 1.0, 0.0, 0.0,   0.0, 1.0, 0.0" << "\n";
-		}
-		DataOutput << i;
-		DataOutput << ", " << itData->iYarnIndex;
-		DataOutput << ", " << itData->Location;		// This counts as 2 DepVars
-		DataOutput << ", " << itData->dVolumeFraction;
-		DataOutput << ", " << itData->dSurfaceDistance;
-		DataOutput << "\n";
-		ElementSets[itData->iYarnIndex].push_back(i);
+		XYZ Up = Info.Up;
+		XYZ Dir = Info.Orientation;
+		
+		XYZ Perp = CrossProduct(Dir, Up);
+		Normalise(Perp);
+		OriOutput << iElement << ", " << Dir << ",   " << Perp << "\n";
 	}
+	else
+	{
+		// Default orientation
+		OriOutput << iElement << ", 1.0, 0.0, 0.0,   0.0, 1.0, 0.0" << "\n";
+	}
+}
+
+void CVoxelMesh::OutputElementData( CTextWriter &DataOutput, int iElement, const POINT_INFO &Info )
+{
+	DataOutput << iElement;
+	DataOutput << ", " << Info.iYarnIndex;
+	DataOutput << ", " << Info.Location;		// This counts as 2 DepVars
+	DataOutput << ", " << Info.dVolumeFraction;
+	DataOutput << ", " << Info.dSurfaceDistance;
+	DataOutput << "\n";
+}
+
+void CVoxelMesh::OutputElementSets( ostream &Output, const map<int, vector<pair<int, int> > > &ElementSets, int iNumElements )
+{
+	CTextWriter Writer(Output);
 
 	// Output element sets
-	Output << "********************" << "\n";
-	Output << "*** ELEMENT SETS ***" << "\n";
-	Output << "********************" << "\n";
-	Output << "** TexGen generates a number of element sets:" << "\n";
-	Output << "** All - Contains all elements" << "\n";
-	Output << "** Matrix - Contains all elements belonging to the matrix" << "\n";
-	Output << "** YarnX - Where X represents the yarn index" << "\n";
-	Output << "*ElSet, ElSet=AllElements, Generate" << "\n";
-	Output << "1, " << m_ElementsInfo.size() << ", 1" << "\n";
-	vector<int>::iterator itIndices;
-	map<int, vector<int> >::iterator itElementSet;
+	Writer << "********************" << "\n";
+	Writer << "*** ELEMENT SETS ***" << "\n";
+	Writer << "********************" << "\n";
+	Writer << "** TexGen generates a number of element sets:" << "\n";
+	Writer << "** All - Contains all elements" << "\n";
+	Writer << "** Matrix - Contains all elements belonging to the matrix" << "\n";
+	Writer << "** YarnX - Where X represents the yarn index" << "\n";
+	Writer << "*ElSet, ElSet=AllElements, Generate" << "\n";
+	Writer << "1, " << iNumElements << ", 1" << "\n";
+	map<int, vector<pair<int, int> > >::const_iterator itElementSet;
 	for (itElementSet = ElementSets.begin(); itElementSet != ElementSets.end(); ++itElementSet)
 	{
 		if (itElementSet->first == -1)
-			Output << "*ElSet, ElSet=Matrix" << "\n";
+			Writer << "*ElSet, ElSet=Matrix" << "\n";
 		else
-			Output << "*ElSet, ElSet=Yarn" << itElementSet->first << "\n";
+			Writer << "*ElSet, ElSet=Yarn" << itElementSet->first << "\n";
 
-		WriteValues(Output, itElementSet->second, 16);
+		WriteElementRanges(Writer, itElementSet->second, 16);
 	}	
 }
 
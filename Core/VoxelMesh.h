@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "Mesh.h"
 #include "Materials.h"
+#include "TextWriter.h"
 
 namespace TexGen
 { 
@@ -74,6 +75,11 @@ namespace TexGen
 		//void AddElements();
 		/// Save voxel mesh in VTK format without boundary conditions
 		void SaveVoxelMeshToVTK(string Filename, CTextile &Textile);
+		/// Save the voxels as VTK image data (.vti), only possible for meshes which are regular grids
+		/**
+		\return False if the mesh isn't a regular grid or the file couldn't be written
+		*/
+		virtual bool SaveVoxelMeshToVTI(string Filename, CTextile &Textile);
 		/// Save voxel mesh in Abaqus .inp format with periodic boundary conditions
 		/// bOutputMatrix and bOutput yarn specify which of these are saved to the Abaqus file
 		void SaveToAbaqus( string Filename, CTextile &Textile, bool bOutputMatrix, bool bOutputYarn, int iBoundaryConditions, int iElementType );
@@ -87,10 +93,55 @@ namespace TexGen
 		\ return Maximum element index
 		*/
 		virtual int OutputHexElements(ostream &Output, bool bOutputMatrix, bool bOutputYarn, int Filetype = INP_EXPORT );
+		/// Output the hex elements for one layer of voxels
+		/**
+		Blocks of rows are formatted in parallel and written in order so the file doesn't depend on the number of threads
+		\param itElementInfo Element information for the first voxel of the layer, advanced to the next layer on return
+		\param pOutputInfo If not NULL the information for each element output is appended to it
+		\return Number of the next element to be output
+		*/
+		int OutputLayerHexElements(ostream &Output, int z, vector<POINT_INFO>::const_iterator &itElementInfo, bool bOutputMatrix, bool bOutputYarn, int iElementNumber, int Filetype, vector<POINT_INFO> *pOutputInfo = NULL );
+
+		/// Get the centre points of the voxels in one layer of the grid, with x varying fastest then y
+		/**
+		\return False if the mesh cannot be classified one layer at a time
+		*/
+		virtual bool GetLayerCentrePoints(int z, vector<XYZ> &CentrePoints) { return false; }
+		/// Calculate the element information for one layer of voxels
+		bool GetLayerInfo(CTextile &Textile, int z, vector<POINT_INFO> &LayerInfo);
+		/// Calculate the element information for the whole grid and store it in m_ElementsInfo
+		/**
+		Meshes which don't support layer classification calculate m_ElementsInfo in OutputNodes instead
+		*/
+		void CalculateElementsInfo(CTextile &Textile);
+		/// Classify the voxels and output elements, orientations and element sets one layer at a time
+		/**
+		Only the element information for the current layer is stored so memory use does not grow with
+		the number of layers. The nodes must already have been output.
+		\param iNumElements Set to the number of elements output
+		\return False if the mesh doesn't support layer classification, in which case nothing is output
+		*/
+		bool OutputLayers(ostream &Output, string Filename, CTextile &Textile, bool bOutputMatrix, bool bOutputYarn, int &iNumElements);
 
 
 		/// Outputs yarn orientations and element sets to .ori and .eld files
 		void OutputOrientationsAndElementSets( string Filename, ostream &Output );
+		/// Open the .ori and .eld files and write their headers
+		bool OpenElementDataFiles( string Filename, ofstream &OriOutput, ofstream &DataOutput );
+		/// Output the orientation definition referring to the .ori file to the .inp file
+		void OutputOrientationsHeader( string Filename, ostream &Output );
+		/// Output the orientations and additional data for consecutive elements to the .ori and .eld files
+		/**
+		Blocks of elements are formatted in parallel and written in order so the files don't depend on the number of threads
+		\param iFirstElement Number of the element of the first entry of ElementsInfo
+		*/
+		void OutputElementData( ostream &OriOutput, ostream &DataOutput, const vector<POINT_INFO> &ElementsInfo, int iFirstElement );
+		/// Output the orientation of one element to the .ori file
+		void OutputElementOrientation( CTextWriter &OriOutput, int iElement, const POINT_INFO &Info );
+		/// Output the additional data for one element to the .eld file
+		void OutputElementData( CTextWriter &DataOutput, int iElement, const POINT_INFO &Info );
+		/// Output the yarn and matrix element sets, each stored as ranges of consecutive element numbers
+		void OutputElementSets( ostream &Output, const map<int, vector<pair<int, int> > > &ElementSets, int iNumElements );
 		/// Outputs all elements when only outputting matrix
 		void OutputMatrixElementSet( string Filename, ostream &Output, int iNumHexElements, bool bMatrixOnly );
 		/// Output node set containing all nodes
@@ -120,6 +171,9 @@ namespace TexGen
 		/// Domain limits
 		pair<XYZ, XYZ>	m_DomainAABB;
 		/// Element information as calculated by GetPointInformation
+		/**
+		Not used by Abaqus export of meshes which support layer classification
+		*/
 		vector<POINT_INFO>	m_ElementsInfo;
 
 		//CObjectContainer<CPeriodicBoundaries> m_PeriodicBoundaries;
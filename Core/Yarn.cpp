@@ -24,14 +24,41 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "Domain.h"
 #include "SectionEllipse.h"
 #include "Textile.h"
+#include <mutex>
+#include <atomic>
 
 using namespace TexGen;
 
+// Yarn section meshes are cached by the sections so concurrent point queries
+// must not mesh them at the same time
+static std::mutex g_SectionMutex;
+
+// Source of the values returned by GetBuildStamp
+static std::atomic<int> g_iLastBuildStamp(0);
+
+// Yarns built on demand may be queried from several threads at once so building is done while holding
+// a lock. Yarns are spread over a fixed set of locks rather than each owning one so that they can still
+// be copied, yarns stored next to each other in a vector get different locks.
+static const int NUM_BUILD_MUTEXES = 64;
+static std::mutex g_BuildMutexes[NUM_BUILD_MUTEXES];
+
+static std::mutex &GetBuildMutex(const CYarn *pYarn)
+{
+	return g_BuildMutexes[((size_t)pYarn/sizeof(CYarn)) % NUM_BUILD_MUTEXES];
+}
+
 CYarn::CYarn(void)
 : m_iNumSlaveNodes(0)
 , m_iNumSectionPoints(0)
 , m_iNeedsBuilding(ALL)
+, m_bIncrementalBuild(false)
 , m_bEquiSpacedSectionMesh(true)
+, m_iBuildStamp(0)
+, m_iSectionCacheSamples(0)
+, m_iMaxSectionCacheKB(65536)
+, m_iCachedSamples(0)
+, m_dOrientationCacheTolerance(0)
+, m_iMaxOrientationSamples(256)
 //, m_pParent(NULL)
 {
 	AssignDefaults();
@@ -46,7 +73,14 @@ CYarn::CYarn(TiXmlElement &Element)
 , m_iNumSlaveNodes(0)
 , m_iNumSectionPoints(0)
 , m_iNeedsBuilding(ALL)
+, m_bIncrementalBuild(false)
 , m_bEquiSpacedSectionMesh(true)
+, m_iBuildStamp(0)
+, m_iSectionCacheSamples(0)
+, m_iMaxSectionCacheKB(65536)
+, m_iCachedSamples(0)
+, m_dOrientationCacheTolerance(0)
+, m_iMaxOrientationSamples(256)
 //, m_pParent(NULL)
 {
 	AssignDefaults();
@@ -100,7 +134,18 @@ CYarn::CYarn(TiXmlElement &Element)
 		m_SectionLengths.push_back(valueify<double>(pSectionLength->Attribute("value")));
 	}
 
-	Element.Attribute("NeedsBuilding", &m_iNeedsBuilding);
+	int iNeedsBuilding = m_iNeedsBuilding;
+	Element.Attribute("NeedsBuilding", &iNeedsBuilding);
+	m_iNeedsBuilding = iNeedsBuilding;
+	// The slave nodes were loaded directly so the interpolation data must be created here,
+	// PointInsideYarn relies on it being ready whenever the line has been built
+	if (m_pInterpolation && !(m_iNeedsBuilding & LINE))
+		m_pInterpolationData = m_pInterpolation->CreateData(m_MasterNodes);
+	if (!(m_iNeedsBuilding & SURFACE))
+	{
+		m_iBuildStamp = ++g_iLastBuildStamp;
+		CreateSectionCache();
+	}
 }
 
 void CYarn::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType)
@@ -168,7 +213,8 @@ void CYarn::PopulateTiXmlElement(TiXmlElement &Element, OUTPUT_TYPE OutputType)
 			SectionLength.SetAttribute("value", stringify(m_SectionLengths[i]));
 			Element.InsertEndChild(SectionLength);
 		}
-		Element.SetAttribute("NeedsBuilding", m_iNeedsBuilding | VOLUME);
+		// Slave nodes of modified segments are out of date so the whole yarn must be rebuilt when loaded
+		Element.SetAttribute("NeedsBuilding", (m_iNeedsBuilding & SEGMENTS) ? ALL : (m_iNeedsBuilding | VOLUME));
 	}
 	else
 	{
@@ -274,8 +320,9 @@ bool CYarn::ReplaceNode(int iIndex, CNode NewNode)
 		}
 	}
 	m_MasterNodes[iIndex] = NewNode;
-	// When a node is replaced the yarn needs to be rebuilt
-	m_iNeedsBuilding = ALL;
+	// When a node is replaced the yarn needs to be rebuilt, only near the node if possible
+	if (!MarkSegmentsDirty(iIndex))
+		m_iNeedsBuilding = ALL;
 	return true;
 }
 
@@ -320,6 +367,48 @@ void CYarn::SetEquiSpacedSectionMesh(bool bEquiSpacedSectionMesh)
 	m_iNeedsBuilding = ALL;
 }
 
+void CYarn::SetSectionCache(int iSamplesPerSegment, int iMaxMemoryKB)
+{
+	m_iSectionCacheSamples = iSamplesPerSegment;
+	m_iMaxSectionCacheKB = iMaxMemoryKB;
+
+	// The cache is created when the sections are built
+	m_iNeedsBuilding |= SURFACE;
+}
+
+size_t CYarn::GetSectionCacheMemory() const
+{
+	size_t Size = m_SectionCache.capacity()*sizeof(vector<XY>) + m_SectionCacheBounds.capacity()*sizeof(pair<XY, XY>);
+	vector<vector<XY> >::const_iterator itSection;
+	for (itSection = m_SectionCache.begin(); itSection != m_SectionCache.end(); ++itSection)
+		Size += itSection->capacity()*sizeof(XY);
+	return Size;
+}
+
+void CYarn::SetOrientationCache(double dTolerance, int iMaxSamplesPerSegment)
+{
+	m_dOrientationCacheTolerance = dTolerance;
+	m_iMaxOrientationSamples = iMaxSamplesPerSegment;
+
+	// The cache is created when the section meshes are built
+	m_iNeedsBuilding |= VOLUME;
+}
+
+size_t CYarn::GetOrientationCacheMemory() const
+{
+	size_t Size = m_OrientationCache.capacity()*sizeof(ORIENTATION_SEGMENT);
+	vector<ORIENTATION_SEGMENT>::const_iterator itSegment;
+	vector<ORIENTATION_SAMPLE>::const_iterator itSample;
+	for (itSegment = m_OrientationCache.begin(); itSegment != m_OrientationCache.end(); ++itSegment)
+	{
+		Size += (itSegment->TriIndices.capacity() + itSegment->QuadIndices.capacity())*sizeof(int);
+		Size += itSegment->Samples.capacity()*sizeof(ORIENTATION_SAMPLE);
+		for (itSample = itSegment->Samples.begin(); itSample != itSegment->Samples.end(); ++itSample)
+			Size += itSample->Nodes.capacity()*sizeof(XY) + itSample->Orientations.capacity()*sizeof(XYZ);
+	}
+	return Size;
+}
+
 bool CYarn::SetResolution(int iNumSectionPoints)
 {
 	TGLOGINDENT("Calculating slave node resolution given " << iNumSectionPoints << " section points");
@@ -382,6 +471,16 @@ bool CYarn::BuildYarnIfNeeded(int iBuildType) const
 	if (iBuildType & SURFACE)
 		iBuildType |= LINE;
 
+	// Point queries call this for every point so the lock is only taken when something needs building
+	if (!(m_iNeedsBuilding & (iBuildType | SEGMENTS)))
+		return true;
+	std::lock_guard<std::mutex> Lock(GetBuildMutex(this));
+	// Only some of the segments need rebuilding after master nodes were moved
+	if (m_iNeedsBuilding & SEGMENTS)
+	{
+		if (!BuildDirtySegments())
+			return false;
+	}
 	// If the build type is LINE and it needs building, then build the slave nodes
 	if (iBuildType & m_iNeedsBuilding & LINE)
 	{
@@ -423,32 +522,139 @@ bool CYarn::BuildSlaveNodes() const
 	// Set a default resolution of 20 if no resolution is specified
 /*	if (m_iNumSlaveNodes == 0)
 		SetResolution(20);*/
-	m_SlaveNodes = m_pInterpolation->GetSlaveNodes(m_MasterNodes, m_iNumSlaveNodes);
+	m_pInterpolationData = m_pInterpolation->CreateData(m_MasterNodes);
+	m_SlaveNodes = m_pInterpolation->GetSlaveNodes(m_MasterNodes, *m_pInterpolationData, m_iNumSlaveNodes);
 
 	// Populate m_SectionLengths
-	int i, j;
+	CalculateSectionLengths();
+
+	// Center-line is built, but everything else needs rebuilding
+	m_iNeedsBuilding = ALL^LINE;
+
+	return true;
+}
+
+void CYarn::CalculateSectionLengths(const vector<bool> *pSegments) const
+{
+	int i, j = 0;
 	XYZ PrevPos;
+	int iNumSlaveNodes = (int)m_SlaveNodes.size();
 	m_SectionLengths.resize(m_MasterNodes.size()-1);
 
 	// Calculate the section length by summing the distances between the two master nodes
-	// on each end and all the slave nodes in between. 
+	// on each end and all the slave nodes in between. The slave nodes are ordered by section.
 	for (i=0; i<int(m_MasterNodes.size()-1); ++i)
 	{
+		while (j < iNumSlaveNodes && m_SlaveNodes[j].GetIndex() < i)
+			++j;
+		if (pSegments && !(*pSegments)[i])
+			continue;
 		m_SectionLengths[i] = 0;
 		PrevPos = m_MasterNodes[i].GetPosition();
-		for (j=0; j<int(m_SlaveNodes.size()); ++j)
+		for (; j<iNumSlaveNodes && m_SlaveNodes[j].GetIndex() == i; ++j)
 		{
-			if (m_SlaveNodes[j].GetIndex() == i)
-			{
-				m_SectionLengths[i] += GetLength(PrevPos, m_SlaveNodes[j].GetPosition());
-				PrevPos = m_SlaveNodes[j].GetPosition();
-			}
+			m_SectionLengths[i] += GetLength(PrevPos, m_SlaveNodes[j].GetPosition());
+			PrevPos = m_SlaveNodes[j].GetPosition();
 		}
 		m_SectionLengths[i] += GetLength(PrevPos, m_MasterNodes[i+1].GetPosition());
 	}
+}
 
-	// Center-line is built, but everything else needs rebuilding
-	m_iNeedsBuilding = ALL^LINE;
+bool CYarn::MarkSegmentsDirty(int iNode)
+{
+	// Only possible if the yarn has been built before, otherwise there is nothing to keep
+	if (!m_bIncrementalBuild || (m_iNeedsBuilding & LINE) || m_SlaveNodes.empty() || !m_pInterpolation || !m_pYarnSection)
+		return false;
+	int iNumSegments = (int)m_MasterNodes.size()-1;
+	if ((int)m_SectionLengths.size() != iNumSegments)
+		return false;
+
+	vector<bool> Segments;
+	if (iNode == -1)
+	{
+		Segments.assign(iNumSegments, true);
+	}
+	else
+	{
+		// The sections are reused so they mustn't depend on the lengths of the other segments
+		if (m_pYarnSection->GetUsesYarnLength())
+			return false;
+		if (!m_pInterpolation->GetAffectedSegments(iNumSegments+1, iNode, Segments))
+			return false;
+	}
+
+	if (!(m_iNeedsBuilding & SEGMENTS))
+		m_DirtySegments.assign(iNumSegments, false);
+	for (int i=0; i<iNumSegments; ++i)
+	{
+		if (Segments[i])
+			m_DirtySegments[i] = true;
+	}
+	m_iNeedsBuilding |= SEGMENTS;
+	return true;
+}
+
+bool CYarn::BuildDirtySegments() const
+{
+	TGLOG("Rebuilding modified yarn segments");
+	m_pInterpolationData = m_pInterpolation->CreateData(m_MasterNodes);
+
+	// Section points and meshes are only updated if they had been built, otherwise
+	// they are built for the whole yarn as usual
+	bool bSurface = !(m_iNeedsBuilding & SURFACE);
+	bool bVolume = !(m_iNeedsBuilding & VOLUME);
+
+	// The slave nodes stay at the same positions along their segment and the 2D sections
+	// stored in them are transformed to the new position of the slave node
+	vector<CSlaveNode>::iterator itSlaveNode;
+	for (itSlaveNode = m_SlaveNodes.begin(); itSlaveNode != m_SlaveNodes.end(); ++itSlaveNode)
+	{
+		if (!m_DirtySegments[itSlaveNode->GetIndex()])
+			continue;
+		CSlaveNode Node = GetInterpolatedNode(itSlaveNode->GetIndex(), itSlaveNode->GetT());
+		itSlaveNode->SetPosition(Node.GetPosition());
+		itSlaveNode->SetTangent(Node.GetTangent());
+		itSlaveNode->SetUp(Node.GetUp());
+		itSlaveNode->SetAngle(Node.GetAngle());
+		if (bSurface)
+			itSlaveNode->UpdateSectionPoints();
+		if (bVolume)
+			itSlaveNode->UpdateSectionMesh();
+	}
+	CalculateSectionLengths(&m_DirtySegments);
+
+	if (bSurface)
+	{
+		// The bounding box of a section includes the last slave node of the previous section
+		// and the first of the next one
+		int i, iNumSegments = (int)m_DirtySegments.size();
+		vector<bool> AABBSegments(iNumSegments, false);
+		for (i=0; i<iNumSegments; ++i)
+		{
+			if (m_DirtySegments[i])
+			{
+				AABBSegments[i] = true;
+				if (i > 0)
+					AABBSegments[i-1] = true;
+				if (i < iNumSegments-1)
+					AABBSegments[i+1] = true;
+			}
+		}
+		CreateSectionAABBs(&AABBSegments);
+
+		// The section bounding boxes together contain all of the section points
+		m_AABB = m_SectionAABBs[0];
+		for (i=1; i<iNumSegments; ++i)
+		{
+			m_AABB.first = Min(m_AABB.first, m_SectionAABBs[i].first);
+			m_AABB.second = Max(m_AABB.second, m_SectionAABBs[i].second);
+		}
+		m_iBuildStamp = ++g_iLastBuildStamp;
+	}
+	if (bVolume)
+		CreateOrientationCache(&m_DirtySegments);
+	m_DirtySegments.clear();
+	m_iNeedsBuilding &= ~SEGMENTS;
 
 	return true;
 }
@@ -525,6 +731,8 @@ bool CYarn::BuildSections() const
 	}
 
 	CreateSectionAABBs();
+	CreateSectionCache();
+	m_iBuildStamp = ++g_iLastBuildStamp;
 /*	const double TOL = 1e-9;
 	m_AABB.first.x -= TOL;
 	m_AABB.first.y -= TOL;
@@ -550,30 +758,354 @@ bool CYarn::BuildSections() const
 	return true;
 }
 
-void CYarn::CreateSectionAABBs() const
+void CYarn::CreateSectionCache() const
+{
+	m_SectionCache.clear();
+	m_SectionCacheBounds.clear();
+	m_iCachedSamples = 0;
+	if (!m_pYarnSection || m_MasterNodes.size() < 2)
+		return;
+
+	YARN_POSITION_INFORMATION YarnPositionInfo;
+	YarnPositionInfo.SectionLengths = m_SectionLengths;
+	YarnPositionInfo.iSection = 0;
+	YarnPositionInfo.dSectionPosition = 0;
+	vector<XY> Section;
+	if (m_pYarnSection->GetType() == "CYarnSectionConstant")
+	{
+		// The section is the same everywhere so it is stored once
+		Section = m_pYarnSection->GetSection(YarnPositionInfo, m_iNumSectionPoints);
+		m_SectionCache.push_back(vector<XY>(Section.begin(), Section.end()));
+	}
+	else if (m_iSectionCacheSamples > 0)
+	{
+		int iNumSegments = (int)m_MasterNodes.size()-1;
+		int iNumSamples = m_iSectionCacheSamples;
+		size_t SampleSize = m_iNumSectionPoints*sizeof(XY) + sizeof(vector<XY>) + sizeof(pair<XY, XY>);
+		int iMaxSamples = (int)(((size_t)m_iMaxSectionCacheKB*1024/SampleSize)/iNumSegments) - 1;
+		if (iNumSamples > iMaxSamples)
+		{
+			TGLOG("Section cache limited to " << iMaxSamples << " samples per segment by memory limit of " << m_iMaxSectionCacheKB << "KB");
+			iNumSamples = iMaxSamples;
+		}
+		if (iNumSamples < 1)
+			return;
+		m_SectionCache.reserve(iNumSegments*(iNumSamples+1));
+		int i, j;
+		for (i=0; i<iNumSegments; ++i)
+		{
+			YarnPositionInfo.iSection = i;
+			for (j=0; j<=iNumSamples; ++j)
+			{
+				YarnPositionInfo.dSectionPosition = double(j)/iNumSamples;
+				Section = m_pYarnSection->GetSection(YarnPositionInfo, m_iNumSectionPoints);
+				// Copied so that no spare capacity is kept
+				m_SectionCache.push_back(vector<XY>(Section.begin(), Section.end()));
+			}
+		}
+		m_iCachedSamples = iNumSamples;
+	}
+
+	m_SectionCacheBounds.reserve(m_SectionCache.size());
+	vector<vector<XY> >::const_iterator itSection;
+	for (itSection = m_SectionCache.begin(); itSection != m_SectionCache.end(); ++itSection)
+	{
+		XY Min, Max;
+		if (!itSection->empty())
+			GetMinMaxXY(*itSection, Min, Max);
+		m_SectionCacheBounds.push_back(make_pair(Min, Max));
+	}
+	if (m_iCachedSamples)
+		TGLOG("Section cache created using " << GetSectionCacheMemory()/1024 << "KB");
+}
+
+const vector<XY> &CYarn::GetSectionPoints(const YARN_POSITION_INFORMATION &PositionInfo, CYarnQueryContext &Context, XY &Min, XY &Max) const
+{
+	vector<XY> &Section = Context.m_Section;
+	if (!m_SectionCache.empty() && m_iCachedSamples == 0)
+	{
+		Min = m_SectionCacheBounds[0].first;
+		Max = m_SectionCacheBounds[0].second;
+		return m_SectionCache[0];
+	}
+	if (!m_SectionCache.empty())
+	{
+		// Interpolate linearly between the samples either side of the position
+		double dSample = PositionInfo.dSectionPosition*m_iCachedSamples;
+		int iSample = max(0, min(m_iCachedSamples-1, (int)floor(dSample)));
+		double w = dSample - iSample;
+		int iIndex = PositionInfo.iSection*(m_iCachedSamples+1) + iSample;
+		const vector<XY> &Section1 = m_SectionCache[iIndex];
+		const vector<XY> &Section2 = m_SectionCache[iIndex+1];
+		if (w <= 0 || Section1.size() != Section2.size())
+		{
+			Min = m_SectionCacheBounds[iIndex].first;
+			Max = m_SectionCacheBounds[iIndex].second;
+			return Section1;
+		}
+		if (w >= 1)
+		{
+			Min = m_SectionCacheBounds[iIndex+1].first;
+			Max = m_SectionCacheBounds[iIndex+1].second;
+			return Section2;
+		}
+		Context.Reserve(Section, Section1.size());
+		Section.resize(Section1.size());
+		for (int i=0; i<(int)Section1.size(); ++i)
+			Section[i] = Section1[i] + w*(Section2[i]-Section1[i]);
+	}
+	else
+	{
+		// Sections sample their points safely from several threads so no lock is needed here
+		Section = m_pYarnSection->GetSection(PositionInfo, m_iNumSectionPoints);
+		++Context.m_iNumAllocations;
+	}
+	GetMinMaxXY(Section, Min, Max);
+	return Section;
+}
+
+void CYarn::CreateOrientationCache(const vector<bool> *pSegments) const
+{
+	int iNumSegments = (int)m_MasterNodes.size()-1;
+	// Constant sections without rotation use the tangent so they gain nothing from the cache
+	if (m_dOrientationCacheTolerance <= 0 || !m_pYarnSection || iNumSegments < 1 || m_pYarnSection->GetType() == "CYarnSectionConstant")
+	{
+		// Swapped so that the memory is released
+		vector<ORIENTATION_SEGMENT>().swap(m_OrientationCache);
+		return;
+	}
+	if ((int)m_OrientationCache.size() != iNumSegments)
+	{
+		m_OrientationCache.clear();
+		m_OrientationCache.resize(iNumSegments);
+		pSegments = NULL;
+	}
+
+	// The section either side of the point used by PointInsideYarnSegment jumps to the end of the segment at
+	// u = 0.99 so each segment is sampled in two parts with a sample either side of the jump
+	const double dJump = 0.99;
+	double dMinInterval = 1.0/max(m_iMaxOrientationSamples, 1);
+	int i, j, iPart, iNumIntervals;
+	int iNumSamples = 0, iNumUncached = 0;
+	for (i=0; i<iNumSegments; ++i)
+	{
+		if (pSegments && !(*pSegments)[i])
+			continue;
+		ORIENTATION_SEGMENT &Segment = m_OrientationCache[i];
+		vector<ORIENTATION_SAMPLE> &Samples = Segment.Samples;
+		Segment.TriIndices.clear();
+		Segment.QuadIndices.clear();
+		Samples.clear();
+		bool bValid = true;
+		for (iPart=0; iPart<2 && bValid; ++iPart)
+		{
+			double dStart = iPart == 0 ? 0 : dJump;
+			double dEnd = iPart == 0 ? dJump : 1;
+			iNumIntervals = iPart == 0 ? 4 : 1;
+			Samples.push_back(ORIENTATION_SAMPLE());
+			// Samples still to be added, the next one is at the back
+			vector<ORIENTATION_SAMPLE> Pending(iNumIntervals);
+			for (j=0; j<=iNumIntervals && bValid; ++j)
+			{
+				double u = dStart + (dEnd-dStart)*j/iNumIntervals;
+				ORIENTATION_SAMPLE &Sample = j == 0 ? Samples.back() : Pending[iNumIntervals-j];
+				double u1 = u > 0.1 ? u-0.1 : 0;
+				double u2 = iPart == 0 ? u+0.1 : 1;
+				bValid = SampleOrientations(i, u, u1, u2, Segment, Sample);
+			}
+			while (!Pending.empty() && bValid)
+			{
+				const ORIENTATION_SAMPLE &Start = Samples.back();
+				const ORIENTATION_SAMPLE &End = Pending.back();
+				if (End.u - Start.u > dMinInterval)
+				{
+					// Compare the orientations half way between the samples with the interpolated ones
+					ORIENTATION_SAMPLE Middle;
+					double u = 0.5*(Start.u + End.u);
+					bValid = SampleOrientations(i, u, u > 0.1 ? u-0.1 : 0, iPart == 0 ? u+0.1 : 1, Segment, Middle);
+					double dMaxAngle = 0;
+					for (j=0; j<(int)Middle.Orientations.size() && bValid; ++j)
+					{
+						XYZ Ori = Start.Orientations[j] + End.Orientations[j];
+						Normalise(Ori);
+						dMaxAngle = max(dMaxAngle, acos(min(1.0, max(-1.0, DotProduct(Ori, Middle.Orientations[j])))));
+					}
+					if (dMaxAngle > m_dOrientationCacheTolerance)
+					{
+						Pending.push_back(ORIENTATION_SAMPLE());
+						Pending.back().u = u;
+						Pending.back().Nodes.swap(Middle.Nodes);
+						Pending.back().Orientations.swap(Middle.Orientations);
+						continue;
+					}
+				}
+				Samples.push_back(ORIENTATION_SAMPLE());
+				Samples.back().u = Pending.back().u;
+				Samples.back().Nodes.swap(Pending.back().Nodes);
+				Samples.back().Orientations.swap(Pending.back().Orientations);
+				Pending.pop_back();
+			}
+		}
+		if (!bValid)
+		{
+			// The section mesh changes along the segment so the exact orientation is used
+			Samples.clear();
+			++iNumUncached;
+		}
+		iNumSamples += (int)Samples.size();
+	}
+	TGLOG("Orientation cache created with " << iNumSamples << " samples using " << GetOrientationCacheMemory()/1024 << "KB");
+	if (iNumUncached)
+		TGLOG(iNumUncached << " segments not cached because the elements of their section meshes differ");
+}
+
+bool CYarn::SampleOrientations(int iSegment, double u, double u1, double u2, ORIENTATION_SEGMENT &Segment, ORIENTATION_SAMPLE &Sample) const
+{
+	YARN_POSITION_INFORMATION YarnPositionInfo;
+	YarnPositionInfo.SectionLengths = m_SectionLengths;
+	CSlaveNode N = GetInterpolatedNode(iSegment, u);
+	YarnPositionInfo.dSectionPosition = N.GetT();
+	YarnPositionInfo.iSection = N.GetIndex();
+	CMesh SectionMesh = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);
+	const vector<int> &TriIndices = SectionMesh.GetIndices(CMesh::TRI);
+	const vector<int> &QuadIndices = SectionMesh.GetIndices(CMesh::QUAD);
+	if (TriIndices.empty() && QuadIndices.empty())
+		return false;
+	if (Segment.TriIndices.empty() && Segment.QuadIndices.empty())
+	{
+		Segment.TriIndices = TriIndices;
+		Segment.QuadIndices = QuadIndices;
+	}
+	else if (TriIndices != Segment.TriIndices || QuadIndices != Segment.QuadIndices)
+		return false;
+
+	Sample.u = u;
+	Sample.Nodes.clear();
+	Sample.Nodes.reserve(SectionMesh.GetNumNodes());
+	vector<XYZ>::const_iterator itNode;
+	for (itNode = SectionMesh.NodesBegin(); itNode != SectionMesh.NodesEnd(); ++itNode)
+		Sample.Nodes.push_back(XY(itNode->x, itNode->y));
+
+	CSlaveNode EndNodes[2];
+	CMesh EndMeshes[2];
+	double EndU[2] = { u1, u2 };
+	int i, j;
+	for (j=0; j<2; ++j)
+	{
+		EndNodes[j] = GetInterpolatedNode(iSegment, EndU[j]);
+		YarnPositionInfo.dSectionPosition = EndNodes[j].GetT();
+		YarnPositionInfo.iSection = EndNodes[j].GetIndex();
+		EndMeshes[j] = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);
+	}
+
+	// Same calculation as PointInsideYarnSegment for each element
+	Sample.Orientations.clear();
+	Sample.Orientations.reserve(TriIndices.size()/3 + QuadIndices.size()/4);
+	CMesh::ELEMENT_TYPE ElementTypes[2] = { CMesh::TRI, CMesh::QUAD };
+	for (i=0; i<2; ++i)
+	{
+		const vector<int> &Indices1 = EndMeshes[0].GetIndices(ElementTypes[i]);
+		const vector<int> &Indices2 = EndMeshes[1].GetIndices(ElementTypes[i]);
+		int iNumNodes = CMesh::GetNumNodes(ElementTypes[i]);
+		int iNumIndices = (int)SectionMesh.GetIndices(ElementTypes[i]).size();
+		if ((int)Indices1.size() != iNumIndices || (int)Indices2.size() != iNumIndices)
+			return false;
+		int Index;
+		for (Index=0; Index<iNumIndices; Index+=iNumNodes)
+		{
+			XYZ Ori;
+			for (j=0; j<iNumNodes; ++j)
+			{
+				const XYZ &Node1 = EndMeshes[0].GetNode(Indices1[Index+j]);
+				const XYZ &Node2 = EndMeshes[1].GetNode(Indices2[Index+j]);
+				Ori += EndNodes[1].GetPointOnSection(XY(Node2.x, Node2.y)) - EndNodes[0].GetPointOnSection(XY(Node1.x, Node1.y));
+			}
+			Ori /= iNumNodes;
+			Normalise(Ori);
+			Sample.Orientations.push_back(Ori);
+		}
+	}
+	return true;
+}
+
+bool CYarn::GetCachedOrientation(int iSegment, double u, const XY &Loc, XYZ &Orientation, CYarnQueryContext &Context) const
+{
+	if (iSegment >= (int)m_OrientationCache.size())
+		return false;
+	const ORIENTATION_SEGMENT &Segment = m_OrientationCache[iSegment];
+	const vector<ORIENTATION_SAMPLE> &Samples = Segment.Samples;
+	if (Samples.size() < 2)
+		return false;
+
+	// Find the samples either side of u, where there are two samples at the same position the second one
+	// applies from that position on
+	int iLow = 0, iHigh = (int)Samples.size();
+	while (iHigh - iLow > 1)
+	{
+		int iMid = (iLow + iHigh)/2;
+		if (Samples[iMid].u <= u)
+			iLow = iMid;
+		else
+			iHigh = iMid;
+	}
+	iLow = min(iLow, (int)Samples.size()-2);
+	const ORIENTATION_SAMPLE &Sample1 = Samples[iLow];
+	const ORIENTATION_SAMPLE &Sample2 = Samples[iLow+1];
+	double w = 0;
+	if (Sample2.u > Sample1.u)
+		w = max(0.0, min(1.0, (u - Sample1.u)/(Sample2.u - Sample1.u)));
+
+	// Find the element of the interpolated section mesh containing the point
+	vector<XYZ> &Nodes = Context.m_ElementNodes;
+	Context.Reserve(Nodes, 4);
+	const vector<int> *pIndices[2] = { &Segment.TriIndices, &Segment.QuadIndices };
+	int i, j, iElement = 0;
+	for (i=0; i<2; ++i)
+	{
+		const vector<int> &Indices = *pIndices[i];
+		int iNumNodes = i == 0 ? 3 : 4;
+		vector<int>::const_iterator itIndex;
+		for (itIndex = Indices.begin(); itIndex != Indices.end(); ++iElement)
+		{
+			Nodes.clear();
+			for (j=0; j<iNumNodes; ++j, ++itIndex)
+			{
+				XY Node = Sample1.Nodes[*itIndex] + w*(Sample2.Nodes[*itIndex]-Sample1.Nodes[*itIndex]);
+				Nodes.push_back(XYZ(Node.x, Node.y, 0));
+			}
+			if (PointInside(Loc, Nodes))
+			{
+				Orientation = Sample1.Orientations[iElement] + w*(Sample2.Orientations[iElement]-Sample1.Orientations[iElement]);
+				Normalise(Orientation);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CYarn::CreateSectionAABBs(const vector<bool> *pSegments) const
 {
 	vector<XYZ>::const_iterator itPoint;
-	vector<CSlaveNode>::iterator itSlaveNode;
-	int iIndex;
 	int i, j;
 	int iSlaveNodeMin;
 	int iSlaveNodeMax;
+	int iNumSlaveNodes = (int)m_SlaveNodes.size();
+	// Index of the first slave node of the current section, the slave nodes are ordered by section
+	int iFirst = 0;
 	m_SectionAABBs.resize(m_MasterNodes.size()-1);
 	for (i=0; i<(int)m_SectionAABBs.size(); ++i)
 	{
-		iSlaveNodeMin = 0;
-		iSlaveNodeMax = (int)m_SlaveNodes.size()-1;
-		for (itSlaveNode = m_SlaveNodes.begin(), j=0; itSlaveNode != m_SlaveNodes.end(); ++itSlaveNode, ++j)
-		{
-			iIndex = itSlaveNode->GetIndex();
-			if (iIndex < i)
-				iSlaveNodeMin = j;
-			if (iIndex > i)
-			{
-				iSlaveNodeMax = j;
-				break;
-			}
-		}
+		// The box contains the slave nodes of the section along with the last slave node
+		// before it and the first slave node after it
+		while (iFirst < iNumSlaveNodes && m_SlaveNodes[iFirst].GetIndex() < i)
+			++iFirst;
+		if (pSegments && !(*pSegments)[i])
+			continue;
+		iSlaveNodeMin = max(iFirst-1, 0);
+		for (iSlaveNodeMax = iFirst; iSlaveNodeMax < iNumSlaveNodes && m_SlaveNodes[iSlaveNodeMax].GetIndex() <= i; ++iSlaveNodeMax);
+		if (iSlaveNodeMax == iNumSlaveNodes)
+			iSlaveNodeMax = iNumSlaveNodes-1;
 		bool bFirst = true;
 		for (j=iSlaveNodeMin; j<=iSlaveNodeMax; ++j)
 		{
@@ -632,6 +1164,7 @@ bool CYarn::BuildSectionMeshes() const
 
 		PrevPos = itSlaveNode->GetPosition();
 	}
+	CreateOrientationCache();
 
 	// Volume mesh points are built
 	m_iNeedsBuilding &= ALL^VOLUME;
@@ -641,6 +1174,7 @@ bool CYarn::BuildSectionMeshes() const
 void CYarn::AssignInterpolation(const CInterpolation &Interpolation)
 {
 	m_pInterpolation = Interpolation;
+	m_pInterpolationData.reset();
 
 	// When a new interpolation is assigned the yarn needs to be rebuilt
 	m_iNeedsBuilding = ALL;
@@ -695,8 +1229,10 @@ void CYarn::Translate(XYZ Vector)
 	}*/
 
 	// Will need to rebuild slave nodes, AABBs, etc... to be translated (could easily be translated as well
-	// but this method is more robust, if this becomes a performance issue recode)
-	m_iNeedsBuilding = ALL;
+	// but this method is more robust, if this becomes a performance issue recode). When building
+	// incrementally the sections are kept and just moved with the slave nodes.
+	if (!MarkSegmentsDirty(-1))
+		m_iNeedsBuilding = ALL;
 }
 
 bool CYarn::AddAABBToMesh(CMesh &Mesh) const
@@ -1049,7 +1585,7 @@ bool CYarn::AddVolumeToMesh(CMesh &Mesh) const
 	}
 
 	// Add nodes and elements to the mesh
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	int iPrevIndex = -1;
 	int iIndex;
 	int aiTriangles[3];
@@ -1058,7 +1594,7 @@ bool CYarn::AddVolumeToMesh(CMesh &Mesh) const
 	{
 		const CMesh &SectionMesh = itNode->GetSectionMesh();
 		iIndex = Mesh.InsertNodes(SectionMesh);
-		const list<int> &PolygonIndices = SectionMesh.GetIndices(CMesh::POLYGON);
+		const vector<int> &PolygonIndices = SectionMesh.GetIndices(CMesh::POLYGON);
 		for ( itIndex = PolygonIndices.begin(); itIndex != PolygonIndices.end(); ++itIndex )
 		{
 			Mesh.GetIndices(CMesh::POLYGON).push_back(*(itIndex) + iIndex);
@@ -1066,7 +1602,7 @@ bool CYarn::AddVolumeToMesh(CMesh &Mesh) const
 
 		if (iPrevIndex != -1)
 		{
-			const list<int> &TriIndices = SectionMesh.GetIndices(CMesh::TRI);
+			const vector<int> &TriIndices = SectionMesh.GetIndices(CMesh::TRI);
 			for (itIndex = TriIndices.begin(); itIndex != TriIndices.end(); )
 			{
 				aiTriangles[0] = *(itIndex++);
@@ -1082,7 +1618,7 @@ bool CYarn::AddVolumeToMesh(CMesh &Mesh) const
 				Mesh.GetIndices(CMesh::WEDGE).push_back(aiTriangles[1] + iIndex);
 				Mesh.GetIndices(CMesh::WEDGE).push_back(aiTriangles[2] + iIndex);
 			}
-			const list<int> &QuadIndices = SectionMesh.GetIndices(CMesh::QUAD);
+			const vector<int> &QuadIndices = SectionMesh.GetIndices(CMesh::QUAD);
 			for (itIndex = QuadIndices.begin(); itIndex != QuadIndices.end(); )
 			{
 				aiQuads[0] = *(itIndex++);
@@ -1199,7 +1735,7 @@ bool CYarn::AddCentrePlaneToMesh(CMesh &Mesh) const
 	int iOffset = Mesh.InsertNodes(YarnMesh);
 
 	// Add elements to the mesh
-	list<int>::const_iterator itIndex;
+	vector<int>::const_iterator itIndex;
 	
 	int iIndex = 0, iSlaveIndex = 0;
 
@@ -1333,7 +1869,7 @@ void CYarn::StraightenYarn(double dStraightness)
 	m_iNeedsBuilding = ALL;
 }
 
-bool CYarn::PointInsideYarn(const XYZ &Point, XYZ *pTangent, XY *pLoc, double* pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface) const
+bool CYarn::PointInsideYarn(const XYZ &Point, XYZ *pTangent, XY *pLoc, double* pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface, CYarnQueryContext *pContext) const
 {
 	//PROFILE_FUNC()
 	if (!BuildYarnIfNeeded(SURFACE))
@@ -1342,7 +1878,14 @@ bool CYarn::PointInsideYarn(const XYZ &Point, XYZ *pTangent, XY *pLoc, double* p
 	if (!PointInsideBox(Point, m_AABB.first, m_AABB.second, dTolerance))
 		return false;
 
-	bool bSectionConstant = m_pYarnSection->GetType() == "CYarnSectionConstant";
+	if (!pContext)
+	{
+		CYarnQueryContext Context;
+		return PointInsideYarn(Point, pTangent, pLoc, pVolumeFraction, pDistanceToSurface, dTolerance, pOrientation, pUp, bSurface, &Context);
+	}
+
+	// Checked without GetType so that no string is created for each query
+	bool bSectionConstant = dynamic_cast<const CYarnSectionConstant*>(GetYarnSection()) != NULL;
 	if ( pOrientation && !bSectionConstant )
 	{
 		if ( !BuildYarnIfNeeded(VOLUME) )  // Only need to build the volume mesh if pOrientation == true and varying sections
@@ -1350,203 +1893,217 @@ bool CYarn::PointInsideYarn(const XYZ &Point, XYZ *pTangent, XY *pLoc, double* p
 	}
 
 	int i;
+	int iNumSegments = (int)m_MasterNodes.size()-1;
+
+	for (i=0; i<iNumSegments; ++i)
+	{
+		if (PointInsideYarnSegment(Point, i, pTangent, pLoc, pVolumeFraction, pDistanceToSurface, dTolerance, pOrientation, pUp, bSurface, NULL, pContext))
+			return true;
+	}
+	return false;
+}
+
+CSlaveNode CYarn::GetInterpolatedNode(int iIndex, double t) const
+{
+	// The data is created whenever the line is built or loaded, it is only read here
+	// so that several threads may query the yarn at once
+	assert(m_pInterpolationData);
+	return m_pInterpolation->GetNode(m_MasterNodes, *m_pInterpolationData, iIndex, t);
+}
+
+bool CYarn::PointInsideYarnSegment(const XYZ &Point, int i, XYZ *pTangent, XY *pLoc, double* pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface, double *pPlaneU, CYarnQueryContext *pContext) const
+{
+	if (!PointInsideBox(Point, m_SectionAABBs[i].first, m_SectionAABBs[i].second, dTolerance))
+		return false;
+
+	if (!pContext)
+	{
+		CYarnQueryContext Context;
+		return PointInsideYarnSegment(Point, i, pTangent, pLoc, pVolumeFraction, pDistanceToSurface, dTolerance, pOrientation, pUp, bSurface, pPlaneU, &Context);
+	}
+	CYarnQueryContext &Context = *pContext;
+
+	// The interpolation is initialised when the yarn is built, it is not initialised again here
+	// so that several threads may query the same yarn at once
 	CSlaveNode N;
 	double u;
-	m_pInterpolation->Initialise(m_MasterNodes);
+	bool bFoundPlane = FindPlaneContainingPoint(Point, u, dTolerance, i, pPlaneU ? *pPlaneU : -1);
+	if (pPlaneU)
+		*pPlaneU = bFoundPlane ? u : -1;
+	if (!bFoundPlane)
+		return false;
 
-	YARN_POSITION_INFORMATION YarnPositionInfo;
-	YarnPositionInfo.SectionLengths = m_SectionLengths;
-	vector<XY> Section;
+	YARN_POSITION_INFORMATION &YarnPositionInfo = Context.m_PositionInfo;
+	Context.Reserve(YarnPositionInfo.SectionLengths, m_SectionLengths.size());
+	YarnPositionInfo.SectionLengths.assign(m_SectionLengths.begin(), m_SectionLengths.end());
 
 	bool bIsInside = false;
 
 	XY Loc;
 	XYZ Relative, Up, Side;
-	int iNumSegments = (int)m_MasterNodes.size()-1;
 
-	for (i=0; i<iNumSegments; ++i)
-	{
-		if (!PointInsideBox(Point, m_SectionAABBs[i].first, m_SectionAABBs[i].second, dTolerance))
-			continue;
-		if (FindPlaneContainingPoint(Point, u, dTolerance, i))
-		{
-			//TGLOG("Converged point inside yarn after " << iIterations << " iterations");
-	//		cout << "Num iterations: " << iIterations << endl;
+	//TGLOG("Converged point inside yarn after " << iIterations << " iterations");
+//		cout << "Num iterations: " << iIterations << endl;
 
-			N = m_pInterpolation->GetNode(m_MasterNodes, i, u);
+	N = GetInterpolatedNode(i, u);
 
-			YarnPositionInfo.dSectionPosition = N.GetT();
-			YarnPositionInfo.iSection = N.GetIndex();
-			Section = m_pYarnSection->GetSection(YarnPositionInfo, m_iNumSectionPoints);
-			N.UpdateSectionPoints(&Section);
+	YarnPositionInfo.dSectionPosition = N.GetT();
+	YarnPositionInfo.iSection = N.GetIndex();
+	XY Min, Max;
+	const vector<XY> &SectionPoints = GetSectionPoints(YarnPositionInfo, Context, Min, Max);
 
-			const vector<XY> &SectionPoints = N.Get2DSectionPoints();
-
-			// Calculate the location of the point projected on to the cross section plane
-			Relative = Point - N.GetPosition();
-			Up = N.GetUp();
-			Side = N.GetSide();
-			Loc.x = DotProduct(Side, Relative);
-			Loc.y = DotProduct(Up, Relative);
-
-			// Check if point is inside min/max box of section. 
-			XY Min, Max;
-			GetMinMaxXY( SectionPoints, Min, Max );
-			if ( Loc.x < Min.x || Loc.x > Max.x || Loc.y < Min.y || Loc.y > Max.y )
-				continue;
-			
-			{
-				//PROFILE_BLOCK( PointInside )
-				if (!bSurface )
-					bIsInside = PointInside( Loc, SectionPoints );
-				else
-					bIsInside = true;   // If surface assume that only exporting yarns and that been sent centre point
-										// of element which must be inside (or on surface)
-										// If this assumption changes will need to look at how PointInside function
-										// works for point on or very close to surface
-			}
+	// Calculate the location of the point projected on to the cross section plane
+	Relative = Point - N.GetPosition();
+	Up = N.GetUp();
+	Side = N.GetSide();
+	Loc.x = DotProduct(Side, Relative);
+	Loc.y = DotProduct(Up, Relative);
 
-			if ( bIsInside )
+	// Check if point is inside min/max box of section. 
+	if ( Loc.x < Min.x || Loc.x > Max.x || Loc.y < Min.y || Loc.y > Max.y )
+		return false;
+	
+	{
+		//PROFILE_BLOCK( PointInside )
+		if (!bSurface )
+			bIsInside = PointInside( Loc, SectionPoints );
+		else
+			bIsInside = true;   // If surface assume that only exporting yarns and that been sent centre point
+								// of element which must be inside (or on surface)
+								// If this assumption changes will need to look at how PointInside function
+								// works for point on or very close to surface
+	}
+
+	if ( bIsInside )
+	{
+		if (pTangent)
+		{
+			*pTangent = N.GetTangent();
+		}
+		if (pLoc)
+		{
+			*pLoc = Loc;
+		}
+		if (pVolumeFraction)
+		{
+			if (m_pFibreDistribution && m_pParent)
 			{
-				if (pTangent)
+				double dFibreArea = GetFibreArea(m_pParent->GetGeometryScale()+"^2");
+				if (dFibreArea == 0)
+					dFibreArea = m_pParent->GetFibreArea(m_pParent->GetGeometryScale()+"^2");
+				vector<XY> &FibreSectionPoints = Context.m_FibreSection;
+				Context.Reserve(FibreSectionPoints, SectionPoints.size());
+				FibreSectionPoints.assign(SectionPoints.begin(), SectionPoints.end());
+				if( N.GetAngle() != 0.0 )
 				{
-					*pTangent = N.GetTangent();
+					double CosAng = cos( N.GetAngle() );
+					vector<XY>::iterator itSectionPoints;
+					for ( itSectionPoints = FibreSectionPoints.begin(); itSectionPoints != FibreSectionPoints.end(); ++itSectionPoints )
+					{
+						XY Point = *itSectionPoints;
+						Point.x = Point.x * CosAng;
+						*itSectionPoints = Point;
+					}
 				}
-				if (pLoc)
+				*pVolumeFraction = m_pFibreDistribution->GetVolumeFraction(FibreSectionPoints, dFibreArea, Loc);
+				//*pVolumeFraction = m_pFibreDistribution->GetVolumeFraction(N.Get2DSectionPoints(), dFibreArea, Loc);
+			}
+			else
+			{
+				*pVolumeFraction = -1;
+			}
+		}
+		if (pDistanceToSurface)
+		{
+			//PROFILE_BLOCK( DistanceToSurface )
+			double dClosestEdgeDistance = FindClosestEdgeDistance( Loc, SectionPoints, dTolerance );
+			if ( dClosestEdgeDistance < dTolerance )
+				*pDistanceToSurface = dClosestEdgeDistance;
+		}
+
+		if ( pOrientation )
+		{
+			//PROFILE_BLOCK(Orientation)
+			if ( dynamic_cast<const CYarnSectionConstant*>(GetYarnSection()) && N.GetAngle() == 0.0 )
+			{
+				*pOrientation = N.GetTangent();  // Don't need to calculate orientation if constant section
+			}
+			else if ( !GetCachedOrientation( i, u, Loc, *pOrientation, Context ) )
+			{
+				// Find which element of section mesh point lies in. Get section mesh for section either side and calculate orientation from elements
+				CMesh &SectionMesh = Context.m_SectionMesh;
 				{
-					*pLoc = Loc;
+					std::lock_guard<std::mutex> Lock(g_SectionMutex);
+					SectionMesh = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);
 				}
-				if (pVolumeFraction)
+				++Context.m_iNumAllocations;
+				
+				int Index;
+				CMesh::ELEMENT_TYPE ElementType = GetMeshPoint( SectionMesh, Loc, Index, Context.m_ElementNodes );
+				if ( ElementType != CMesh::NUM_ELEMENT_TYPES )
 				{
-					if (m_pFibreDistribution && m_pParent)
+					XYZ Ori;
+					CSlaveNode EndNodes[2];
+					// Sections either side of the point, 1/10th of the length of the segment away
+					double EndU[2] = { u > 0.1 ? u-0.1 : 0, u < 0.99 ? u+0.1 : 1 };
+					int j;
+					for ( j = 0; j < 2; ++j )
 					{
-						double dFibreArea = GetFibreArea(m_pParent->GetGeometryScale()+"^2");
-						if (dFibreArea == 0)
-							dFibreArea = m_pParent->GetFibreArea(m_pParent->GetGeometryScale()+"^2");
-						vector<XY> SectionPoints = N.Get2DSectionPoints();
-						if( N.GetAngle() != 0.0 )
+						EndNodes[j] = GetInterpolatedNode(i, EndU[j]);
+						YarnPositionInfo.dSectionPosition = EndNodes[j].GetT();
+						YarnPositionInfo.iSection = EndNodes[j].GetIndex();
 						{
-							double CosAng = cos( N.GetAngle() );
-							vector<XY>::iterator itSectionPoints;
-							for ( itSectionPoints = SectionPoints.begin(); itSectionPoints != SectionPoints.end(); ++itSectionPoints )
-							{
-								XY Point = *itSectionPoints;
-								Point.x = Point.x * CosAng;
-								*itSectionPoints = Point;
-							}
+							std::lock_guard<std::mutex> Lock(g_SectionMutex);
+							Context.m_EndMeshes[j] = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);  // Gets 2D section
 						}
-						*pVolumeFraction = m_pFibreDistribution->GetVolumeFraction(SectionPoints, dFibreArea, Loc);
-						//*pVolumeFraction = m_pFibreDistribution->GetVolumeFraction(N.Get2DSectionPoints(), dFibreArea, Loc);
-					}
-					else
-					{
-						*pVolumeFraction = -1;
+						++Context.m_iNumAllocations;
 					}
-				}
-				if (pDistanceToSurface)
-				{
-					//PROFILE_BLOCK( DistanceToSurface )
-					double dClosestEdgeDistance = FindClosestEdgeDistance( Loc, SectionPoints, dTolerance );
-					if ( dClosestEdgeDistance < dTolerance )
-						*pDistanceToSurface = dClosestEdgeDistance;
-				}
 
-				if ( pOrientation )
-				{
-					//PROFILE_BLOCK(Orientation)
-					if ( bSectionConstant && N.GetAngle() == 0.0 )
-					{
-						*pOrientation = N.GetTangent();  // Don't need to calculate orientation if constant section
-					}
-					else
+					// Only the nodes of the element containing the point are converted to 3D
+					const vector<int> &Indices1 = Context.m_EndMeshes[0].GetIndices(ElementType);
+					const vector<int> &Indices2 = Context.m_EndMeshes[1].GetIndices(ElementType);
+					int iNumNodes = CMesh::GetNumNodes(ElementType);
+					for ( j = 0; j < iNumNodes; ++j )
 					{
-						// Find which element of section mesh point lies in. Get section mesh for section either side and calculate orientation from elements
-						CMesh SectionMesh = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);
-						
-						int Index;
-						CMesh::ELEMENT_TYPE ElementType = GetMeshPoint( SectionMesh, Loc, Index );
-						if ( ElementType != CMesh::NUM_ELEMENT_TYPES )
-						{
-							XYZ Ori;
-							double u1, u2;
-							CSlaveNode N1,N2;
-							
-							{
-								//PROFILE_BLOCK(Orientation1)
-							u1 = u > 0.1 ? u-0.1 : 0;
-							//if ( u > 0.01 )  // Is 1/100th length of section suitable offset?
-							//{
-								N1 = m_pInterpolation->GetNode(m_MasterNodes, i, u1 );
-								//N1 = m_pInterpolation->GetNode(m_MasterNodes, i, u - 0.01 );
-								YarnPositionInfo.dSectionPosition = N1.GetT();
-								YarnPositionInfo.iSection = N1.GetIndex();
-								SectionMesh = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);  // Gets 2D section
-								N1.UpdateSectionMesh( &SectionMesh );  // Converts back to 3D section
-							}
-							//}
-							// else use N1 at master node 
-							
-							{
-								//PROFILE_BLOCK(Orientation2)
-								u2 = u < 0.99 ? u+0.1 : 1;
-							//if ( u < 0.99 )
-							//{
-								N2 = m_pInterpolation->GetNode(m_MasterNodes, i, u2 );
-								//N2 = m_pInterpolation->GetNode(m_MasterNodes, i, u + 0.01 );
-								YarnPositionInfo.dSectionPosition = N2.GetT();
-								YarnPositionInfo.iSection = N2.GetIndex();
-								SectionMesh = m_pYarnSection->GetSectionMesh(YarnPositionInfo, m_iNumSectionPoints, false);
-								N2.UpdateSectionMesh( &SectionMesh );
-							//}
-							}
-							
-							{
-								//PROFILE_BLOCK(Orientation3)
-							CMesh End1Mesh = N1.GetSectionMesh();
-							CMesh End2Mesh = N2.GetSectionMesh();
-							int iNumNodes = CMesh::GetNumNodes(ElementType);
-							vector<int> ElementIndices1;
-							vector<int> ElementIndices2;
-							End1Mesh.ConvertElementListToVector( ElementType, ElementIndices1 );
-							End2Mesh.ConvertElementListToVector( ElementType, ElementIndices2 );
-							for ( int j = 0; j < iNumNodes; ++j )
-							{
-								Ori += End2Mesh.GetNode( ElementIndices2[Index] ) - End1Mesh.GetNode( ElementIndices1[Index] );
-								Index++;
-							}
-							Ori /= iNumNodes;
-							Normalise( Ori );
-							*pOrientation = Ori;
-							assert( fabs(Ori.x) > 1e-14 || fabs(Ori.y) > 1e-14 || fabs(Ori.z) > 1e-14 );
-							}
-						}
+						const XYZ &Node1 = Context.m_EndMeshes[0].GetNode( Indices1[Index] );
+						const XYZ &Node2 = Context.m_EndMeshes[1].GetNode( Indices2[Index] );
+						Ori += EndNodes[1].GetPointOnSection( XY(Node2.x, Node2.y) ) - EndNodes[0].GetPointOnSection( XY(Node1.x, Node1.y) );
+						Index++;
 					}
+					Ori /= iNumNodes;
+					Normalise( Ori );
+					*pOrientation = Ori;
+					assert( fabs(Ori.x) > 1e-14 || fabs(Ori.y) > 1e-14 || fabs(Ori.z) > 1e-14 );
 				}
-				if ( pUp )
+				else
 				{
-					*pUp = N.GetUp();
+					*pOrientation = N.GetTangent();  // Point not found in section mesh, fall back to the centreline tangent
 				}
-			
-				return true;
 			}
 		}
+		if ( pUp )
+		{
+			*pUp = N.GetUp();
+		}
+	
+		return true;
 	}
 	return false;
 }
 
-bool CYarn::PointInsideYarn(const XYZ &Point, const vector<XYZ> &Translations, XYZ *pTangent, XY* pLoc, double *pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface) const
+bool CYarn::PointInsideYarn(const XYZ &Point, const vector<XYZ> &Translations, XYZ *pTangent, XY* pLoc, double *pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface, CYarnQueryContext *pContext) const
 {
 	// TODO OPTIMISE THIS
 	vector<XYZ>::const_iterator itXYZ;
 	for (itXYZ = Translations.begin(); itXYZ != Translations.end(); ++itXYZ)
 	{
-		if (PointInsideYarn(Point - *itXYZ, pTangent, pLoc, pVolumeFraction, pDistanceToSurface, dTolerance, pOrientation, pUp, bSurface))
+		if (PointInsideYarn(Point - *itXYZ, pTangent, pLoc, pVolumeFraction, pDistanceToSurface, dTolerance, pOrientation, pUp, bSurface, pContext))
 			return true;
 	}
 	return false;
 }
 
-bool CYarn::FindPlaneContainingPoint(const XYZ &Point, double &u, double dTolerance, int iSeg) const
+bool CYarn::FindPlaneContainingPoint(const XYZ &Point, double &u, double dTolerance, int iSeg, double dStartU) const
 {
 	const double dConvergenceTolerance = 1e-6;
 	CSlaveNode N1, N2, N;
@@ -1554,8 +2111,8 @@ bool CYarn::FindPlaneContainingPoint(const XYZ &Point, double &u, double dTolera
 	PLANE Plane1, Plane2, SearchPlane;
 	double d1, d2, d, dprev;
 
-	N1 = m_pInterpolation->GetNode(m_MasterNodes, iSeg, 0);
-	N2 = m_pInterpolation->GetNode(m_MasterNodes, iSeg, 1);
+	N1 = GetInterpolatedNode(iSeg, 0);
+	N2 = GetInterpolatedNode(iSeg, 1);
 		
 	Plane1.Normal = N1.GetNormal();
 	Plane2.Normal = -N2.GetNormal();
@@ -1580,15 +2137,24 @@ bool CYarn::FindPlaneContainingPoint(const XYZ &Point, double &u, double dTolera
 		}
 		else
 		{
-			u = d1/(d1+d2);  
+			if ( dStartU > 0.0 && dStartU < 1.0 )
+			{
+				// Start from the given guess, the first secant step is taken between the start plane and the guess
+				u = dStartU;
+				dprev = d1;
+			}
+			else
+			{
+				u = d1/(d1+d2);  
+				dprev = d1 < d2 ? d1 : d2;
+				//dprev = d1;
+			}
 			du = u;
-			dprev = d1 < d2 ? d1 : d2;
-			//dprev = d1;
 			SearchPlane = Plane1;
 			int iIterations = 0;
 			while(abs(du) > dConvergenceTolerance)
 			{
-				N = m_pInterpolation->GetNode(m_MasterNodes, iSeg, u);
+				N = GetInterpolatedNode(iSeg, u);
 
 				SearchPlane.Normal = N.GetNormal();
 				SearchPlane.d = DotProduct(SearchPlane.Normal, N.GetPosition());
@@ -1624,7 +2190,6 @@ double CYarn::FindClosestSurfacePoint(const XYZ &Point, XYZ &SurfacePoint, int i
 	int i;
 	CSlaveNode N;
 	double u;
-	m_pInterpolation->Initialise(m_MasterNodes);
 
 	YARN_POSITION_INFORMATION YarnPositionInfo;
 	YarnPositionInfo.SectionLengths = m_SectionLengths;
@@ -1643,7 +2208,7 @@ double CYarn::FindClosestSurfacePoint(const XYZ &Point, XYZ &SurfacePoint, int i
 		if (FindPlaneContainingPoint(Point, u, dTolerance, i))
 		{
 
-			N = m_pInterpolation->GetNode(m_MasterNodes, i, u);
+			N = GetInterpolatedNode(i, u);
 
 			YarnPositionInfo.dSectionPosition = N.GetT();
 			YarnPositionInfo.iSection = N.GetIndex();
@@ -1886,14 +2451,20 @@ void CYarn::SetParent(const CTextile *pParent)
 
 
 CMesh::ELEMENT_TYPE CYarn::GetMeshPoint( CMesh &Mesh, const XY &Point, int& Index ) const
+{
+	vector<XYZ> Nodes;
+	return GetMeshPoint( Mesh, Point, Index, Nodes );
+}
+
+CMesh::ELEMENT_TYPE CYarn::GetMeshPoint( const CMesh &Mesh, const XY &Point, int& Index, vector<XYZ> &Nodes ) const
 {
 	//PROFILE_FUNC()
-	list<int>::iterator itIndex;
-	list<int> &TriIndices = Mesh.GetIndices( CMesh::TRI );
+	vector<int>::const_iterator itIndex;
+	const vector<int> &TriIndices = Mesh.GetIndices( CMesh::TRI );
 	
 	for ( itIndex = TriIndices.begin(), Index = 0; itIndex != TriIndices.end(); Index += 3 )
 	{
-		vector<XYZ> Nodes; 
+		Nodes.clear();
 		for ( int j = 0; j < 3; j++ )
 		{
 			Nodes.push_back( Mesh.GetNode( *itIndex++ ));
@@ -1904,11 +2475,11 @@ CMesh::ELEMENT_TYPE CYarn::GetMeshPoint( CMesh &Mesh, const XY &Point, int& Inde
 		}
 	}
 
-	list<int> &QuadIndices = Mesh.GetIndices( CMesh::QUAD );
+	const vector<int> &QuadIndices = Mesh.GetIndices( CMesh::QUAD );
 	
 	for ( itIndex = QuadIndices.begin(), Index = 0; itIndex != QuadIndices.end(); Index += 4 )
 	{
-		vector<XYZ> Nodes; 
+		Nodes.clear();
 		for ( int j = 0; j < 4; j++ )
 		{
 			Nodes.push_back( Mesh.GetNode( *itIndex++ ));
@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 #include "Mesh.h"
 #include "Domain.h"
 #include "PropertiesYarn.h"
+#include "Parallel.h"
 
 namespace TexGen
 {
@@ -44,6 +45,51 @@ namespace TexGen
 
 	using namespace std;
 
+	/// Scratch buffers used by the point queries of yarns
+	/**
+	Passing the same context to a series of calls to CYarn::PointInsideYarn saves the memory needed
+	by each query from being allocated for every point. Once the buffers have grown to the sizes
+	needed by the yarns queried no more memory is allocated, as long as the sections don't have to
+	be created during the query. This is the case for constant sections and varying sections with a
+	section cache (see CYarn::SetSectionCache), unless the orientation of varying sections is requested
+	without an orientation cache (see CYarn::SetOrientationCache).
+
+	A context may be used for any number of yarns but only by one thread at a time.
+	*/
+	class CLASS_DECLSPEC CYarnQueryContext
+	{
+	friend class CYarn;
+	public:
+		CYarnQueryContext() : m_iNumAllocations(0) {}
+
+		/// Get the number of times the queries using this context have allocated memory
+		/**
+		This counts the buffers of the context growing and the sections or section meshes which
+		had to be created during the queries, it doesn't change once queries run without allocating.
+		*/
+		int GetNumAllocations() const { return m_iNumAllocations; }
+
+	protected:
+		/// Make sure the buffer can hold iSize items without allocating
+		template <typename T>
+		void Reserve(vector<T> &Buffer, size_t iSize)
+		{
+			if (Buffer.capacity() < iSize)
+			{
+				Buffer.reserve(iSize);
+				++m_iNumAllocations;
+			}
+		}
+
+		YARN_POSITION_INFORMATION m_PositionInfo;
+		vector<XY> m_Section;			///< Section interpolated between cached sections or created for the query
+		vector<XY> m_FibreSection;		///< Section scaled for the fibre distribution
+		vector<XYZ> m_ElementNodes;		///< Nodes of the section mesh element being checked
+		CMesh m_SectionMesh;			///< Section mesh at the point
+		CMesh m_EndMeshes[2];			///< Section meshes either side of the point used to find the orientation
+		int m_iNumAllocations;
+	};
+
 	/// Represents a yarn consisting of master nodes, section and interpolation function
 	class CLASS_DECLSPEC CYarn : public CPropertiesYarn
 	{
@@ -145,6 +191,50 @@ namespace TexGen
 		*/
 		void SetEquiSpacedSectionMesh(bool bEquiSpacedSectionMesh);
 
+		/// Set up the cache of section polygons used to speed up point queries
+		/**
+		Sections which don't vary along the yarn are always cached. For varying sections, iSamplesPerSegment
+		sections are sampled along each segment of the yarn (the part between two master nodes) when the
+		yarn is built and point queries interpolate between them instead of regenerating the section.
+		This trades a small geometric approximation for speed.
+		\param iSamplesPerSegment Number of intervals each segment is divided into, 0 disables caching of varying sections
+		\param iMaxMemoryKB The number of samples is reduced so that the cache doesn't use more than this amount of memory
+		*/
+		void SetSectionCache(int iSamplesPerSegment, int iMaxMemoryKB = 65536);
+
+		/// Get the amount of memory used by the section cache in bytes
+		size_t GetSectionCacheMemory() const;
+
+		/// Set up the cache of fibre orientations used by point queries of varying sections
+		/**
+		The orientation at a point in a varying section is found from the section meshes at the point and
+		either side of it, which have to be created for every query. When enabled, the orientation of each
+		element of the section mesh is sampled along each segment when the section meshes are built and queries
+		interpolate between the samples instead. Samples are added until the interpolated orientations half
+		way between neighbouring samples are within dTolerance of the exact ones.
+		\param dTolerance Maximum angle in radians between interpolated and exact orientations, 0 disables the cache
+		\param iMaxSamplesPerSegment Intervals between samples are not split to less than 1/iMaxSamplesPerSegment of a segment
+		*/
+		void SetOrientationCache(double dTolerance, int iMaxSamplesPerSegment = 256);
+
+		/// Get the amount of memory used by the orientation cache in bytes
+		size_t GetOrientationCacheMemory() const;
+
+		/// Set whether only the affected segments of the yarn are rebuilt after the master nodes are moved
+		/**
+		When enabled, ReplaceNode and Translate mark the segments (the parts between two master nodes)
+		which change and only those are rebuilt the next time the yarn is needed. The slave nodes of the
+		rebuilt segments keep their parameter values and the sections already generated for them are reused,
+		so the slave nodes are no longer exactly equispaced along the yarn until it is next fully rebuilt.
+		The whole yarn is still rebuilt if the interpolation or the yarn section depend on all the
+		master nodes, or when nodes are added or removed. This is the case for CInterpolationCubic:
+		the natural and periodic cubic splines are found by solving one system of equations for all the
+		master nodes so moving any node changes every segment of the yarn. Only the Bezier and linear
+		interpolations, where a node only affects the tangents of its neighbours, have a local span.
+		*/
+		void SetIncrementalBuild(bool bIncrementalBuild) { m_bIncrementalBuild = bIncrementalBuild; }
+		bool GetIncrementalBuild() const { return m_bIncrementalBuild; }
+
 		/// Assign a section to the yarn
 		void AssignSection(const CYarnSection &YarnSection);
 
@@ -277,8 +367,9 @@ namespace TexGen
 		A limitation with this function is that it only work for convex sections because
 		of the way the it determines if a point lies within a section or not. Could be updated to work
 		with non-convex sections at the expensive of performance.
+		\param pContext Scratch buffers to use for the query, if NULL they are created for this call only
 		*/
-		bool PointInsideYarn( const XYZ &Point, XYZ *pTangent = NULL, XY *pLoc = NULL, double *pVolumeFraction = NULL, double* pDistanceToSurface = NULL, double dTolerance = 1e-9, XYZ *pOrientation = NULL, XYZ *pUp = NULL, bool bSurface = false ) const;
+		bool PointInsideYarn( const XYZ &Point, XYZ *pTangent = NULL, XY *pLoc = NULL, double *pVolumeFraction = NULL, double* pDistanceToSurface = NULL, double dTolerance = 1e-9, XYZ *pOrientation = NULL, XYZ *pUp = NULL, bool bSurface = false, CYarnQueryContext *pContext = NULL ) const;
 
 		/// Similar to the above function except that this one takes into account repeated yarns.
 		/**
@@ -291,16 +382,18 @@ namespace TexGen
 		pTangent, pLoc, pVolumeFraction and pDistanceToSurface are output pointers, they can be
 		NULL where the information is not needed.
 		\param bSurface Defaults to false. Set to true where points are known to be on surface and simply want to return information without PointInside check
+		\param pContext Scratch buffers to use for the query, pass the same context to a series of queries to avoid allocating memory for each one
 		*/
-		bool PointInsideYarn(const XYZ &Point, const vector<XYZ> &Translations, XYZ *pTangent = NULL, XY* pLoc = NULL, double* pVolumeFraction = NULL, double* pDistanceToSurface = NULL, double dTolerance = 1e-9, XYZ *pOrientation = NULL, XYZ *pUp = NULL, bool bSurface = false) const;
+		bool PointInsideYarn(const XYZ &Point, const vector<XYZ> &Translations, XYZ *pTangent = NULL, XY* pLoc = NULL, double* pVolumeFraction = NULL, double* pDistanceToSurface = NULL, double dTolerance = 1e-9, XYZ *pOrientation = NULL, XYZ *pUp = NULL, bool bSurface = false, CYarnQueryContext *pContext = NULL) const;
 
 		/// Find the plane normal to the yarn which contains a specified point
 		/**
 		Returns false if iterative method doesn't find a plane
 		Returns Planes, a vector of all instances of the normalised distance along the yarn where the plane crosses 
 		the yarn centreline. Where the yarn undulates there may be more than one plane
+		\param dStartU Initial guess for u, e.g. the result for a neighbouring point. Values outside the range (0, 1) are ignored.
 		*/
-		bool FindPlaneContainingPoint( const XYZ &Point, double &u, double dTolerance, int iSeg) const;
+		bool FindPlaneContainingPoint( const XYZ &Point, double &u, double dTolerance, int iSeg, double dStartU = -1) const;
 
 		/// Finds the closest point on the yarn surface to Point
 		/**
@@ -451,8 +544,12 @@ namespace TexGen
 		const CFibreDistribution* GetFibreDistribution() const { return m_pFibreDistribution;}
 		int GetNumNodes() const { return (int)m_MasterNodes.size(); }
 		vector<double> GetSectionLengths() const { return m_SectionLengths; }
+		/// Get a value which changes every time the yarn surface is rebuilt, 0 if it has not been built
+		int GetBuildStamp() const { return m_iBuildStamp; }
 
 		CMesh::ELEMENT_TYPE GetMeshPoint( CMesh &Mesh, const XY &Point, int &Index ) const;
+		/// Same as above using Nodes to hold the nodes of each element checked
+		CMesh::ELEMENT_TYPE GetMeshPoint( const CMesh &Mesh, const XY &Point, int &Index, vector<XYZ> &Nodes ) const;
 
 		//int GetMeshPoint( const XY &Point, int& Index );
 
@@ -474,6 +571,7 @@ namespace TexGen
 		@see AssignInterpolation
 		@see AssignSection
 		@see BUILD_TYPE
+		Building is done while holding a lock so the yarn may be used from several threads at once.
 		\return false if the yarn building failed
 		*/
 		bool BuildYarnIfNeeded(int iBuildType) const;
@@ -481,16 +579,90 @@ namespace TexGen
 		bool BuildSlaveNodes() const;
 		bool BuildSections() const;
 		bool BuildSectionMeshes() const;
+		/// Rebuild the segments marked in m_DirtySegments
+		bool BuildDirtySegments() const;
+
+		/// Mark the segments affected by a change to a master node as needing rebuilding
+		/**
+		\param iNode Index of the modified master node or -1 if all of the nodes were moved without changing the lengths of the segments
+		\return false if the whole yarn needs rebuilding instead
+		*/
+		bool MarkSegmentsDirty(int iNode);
+
+		/// Calculate the lengths of the segments from the slave nodes
+		/**
+		\param pSegments If not NULL only the lengths of the segments set to true are calculated
+		*/
+		void CalculateSectionLengths(const vector<bool> *pSegments = NULL) const;
 
 		/// Add end caps to the mesh
 		void AddEndCapsToMesh(CMesh &Mesh) const;
 
 		/// Create the section Axis aligned bounding boxes
-		void CreateSectionAABBs() const;
+		/**
+		\param pSegments If not NULL only the bounding boxes of the sections set to true are created
+		*/
+		void CreateSectionAABBs(const vector<bool> *pSegments = NULL) const;
+
+		/// Sample the sections stored in the section cache
+		void CreateSectionCache() const;
+
+		/// Orientations of the elements of the section mesh at one position along a segment
+		struct ORIENTATION_SAMPLE
+		{
+			double u;
+			vector<XY> Nodes;			///< Nodes of the 2D section mesh
+			vector<XYZ> Orientations;	///< Fibre direction of each element, triangles followed by quads
+		};
+
+		/// Orientation samples along a segment, the section meshes of which all have the same elements
+		struct ORIENTATION_SEGMENT
+		{
+			vector<int> TriIndices;
+			vector<int> QuadIndices;
+			vector<ORIENTATION_SAMPLE> Samples;	///< Sorted by u, empty if the segment isn't cached
+		};
+
+		/// Sample the orientations stored in the orientation cache
+		/**
+		\param pSegments If not NULL only the segments set to true are sampled again
+		*/
+		void CreateOrientationCache(const vector<bool> *pSegments = NULL) const;
+
+		/// Sample the orientations of the section mesh elements at u along a segment
+		/**
+		The orientations are found from the section meshes at u1 and u2 in the same way as PointInsideYarnSegment.
+		\return false if the elements of the section mesh don't match those of the segment
+		*/
+		bool SampleOrientations(int iSegment, double u, double u1, double u2, ORIENTATION_SEGMENT &Segment, ORIENTATION_SAMPLE &Sample) const;
+
+		/// Get the orientation at a point of a segment from the orientation cache
+		/**
+		\return false if the segment isn't cached or the point isn't inside the cached section mesh
+		*/
+		bool GetCachedOrientation(int iSegment, double u, const XY &Loc, XYZ &Orientation, CYarnQueryContext &Context) const;
+
+		/// Get the 2D section at given position along the yarn along with its bounds
+		/**
+		The section is taken from the cache if possible, otherwise the section of the context is filled in.
+		\return A reference to either the cached section or the section of the context
+		*/
+		const vector<XY> &GetSectionPoints(const YARN_POSITION_INFORMATION &PositionInfo, CYarnQueryContext &Context, XY &Min, XY &Max) const;
 
 		/// Set the yarn parent
 		void SetParent(const CTextile *pParent);
 
+		/// Determine if the given point lies within one segment of the yarn (the part between two master nodes)
+		/**
+		The yarn must already be built. Parameters are the same as for PointInsideYarn.
+		\param pPlaneU If not NULL, on input the value is used as the starting guess for FindPlaneContainingPoint
+			and on output it is set to the u value of the plane containing the point or -1 if no plane was found
+		*/
+		bool PointInsideYarnSegment(const XYZ &Point, int iSegment, XYZ *pTangent, XY *pLoc, double *pVolumeFraction, double* pDistanceToSurface, double dTolerance, XYZ *pOrientation, XYZ *pUp, bool bSurface, double *pPlaneU = NULL, CYarnQueryContext *pContext = NULL) const;
+
+		/// Get a node interpolated from the master nodes using the interpolation data owned by the yarn
+		CSlaveNode GetInterpolatedNode(int iIndex, double t) const;
+
 		vector<CNode> m_MasterNodes;	///< Ordered list of nodes belonging to this Yarn
 		CObjectContainer<CInterpolation> m_pInterpolation;	///< Interpolation applied to smooth the yarn paths
 		CObjectContainer<CYarnSection> m_pYarnSection;	///< Section applied to this yarn, with possibility of a varying cross-section
@@ -504,9 +676,30 @@ namespace TexGen
 		/// Find closest perpendicular distance from point to polygon specified by SectionPoints
 		double FindClosestEdgeDistance( XY &Loc, const vector<XY> &SectionPoints, double dTolerance ) const;
 
-		mutable int m_iNeedsBuilding;	///< Variable used to keep track of wether the yarn needs to be rebuilt or not and what part needs rebuilding
+		/// Value set in m_iNeedsBuilding along with the BUILD_TYPE values when only the segments marked in m_DirtySegments need rebuilding
+		enum { SEGMENTS = 1<<4 };
+
+		/// Variable used to keep track of wether the yarn needs to be rebuilt or not and what part needs rebuilding
+		/**
+		The flags are only cleared once the corresponding part of the yarn has been built, so a yarn which doesn't
+		need building can be used without taking the build lock.
+		*/
+		mutable CCopyableAtomic<int> m_iNeedsBuilding;
+		bool m_bIncrementalBuild;	///< Whether only the segments affected by moving master nodes are rebuilt
+		/// Segments of the yarn changed since it was last built, only valid when m_iNeedsBuilding contains SEGMENTS
+		/**
+		Any change which sets m_iNeedsBuilding to ALL clears the SEGMENTS flag so the whole yarn is rebuilt.
+		*/
+		mutable vector<bool> m_DirtySegments;
 		mutable vector<CSlaveNode> m_SlaveNodes;	///< Ordered list of interpolated slave nodes belonging to this Yarn
 
+		/// Data calculated by the interpolation for the current master nodes
+		/**
+		Created when the slave nodes are built and replaced whenever the line is rebuilt. The data is
+		never modified so copies of the yarn and concurrent queries can share it.
+		*/
+		mutable shared_ptr<const CInterpolationData> m_pInterpolationData;
+
 		/// An axis aligned bounding box containing the full unrepeated yarn
 		/**
 		Will be populated when the yarn surface is built.
@@ -528,6 +721,20 @@ namespace TexGen
 		*/
 		mutable vector<double> m_SectionLengths;
 
+		/// Unique value assigned each time the yarn sections are built, used to detect changes to the geometry
+		mutable int m_iBuildStamp;
+
+		int m_iSectionCacheSamples;	///< Requested number of section samples per segment for varying sections
+		int m_iMaxSectionCacheKB;	///< Maximum memory used by the section cache
+		/// Cached 2D sections, a single section for constant sections otherwise m_iCachedSamples+1 per segment
+		mutable vector<vector<XY> > m_SectionCache;
+		mutable vector<pair<XY, XY> > m_SectionCacheBounds;	///< Min and max of each of the cached sections
+		mutable int m_iCachedSamples;	///< Number of samples per segment actually stored, 0 if the section is constant
+
+		double m_dOrientationCacheTolerance;	///< Maximum angle between cached and exact orientations, 0 if not cached
+		int m_iMaxOrientationSamples;			///< Maximum number of orientation samples per segment
+		mutable vector<ORIENTATION_SEGMENT> m_OrientationCache;	///< Orientation samples of each segment
+
 		/// Stores a pointer to the CTextile it belongs to
 		/**
 		Note: This can be dangerous when a yarn is copy constructed. The copied
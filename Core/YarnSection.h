@@ -96,6 +96,9 @@ namespace TexGen
 		/// Find max value for iNumLayers in section meshes and set iNumLayers to that value
 		virtual void SetSectionMeshLayersEqual( int iNumPoints ) const {return;}
 
+		/// Whether the section depends on the lengths of the yarn segments rather than only on the segment and the position along it
+		virtual bool GetUsesYarnLength() const { return true; }
+
 		bool GetForceMeshLayers() const {return m_bForceEqualMeshLayers;}
 
 		/// Get a pointer of that the inherited class
@@ -0,0 +1,176 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#include "PrecompiledHeaders.h"
+#include "YarnSpatialIndex.h"
+#include "Yarn.h"
+#include "DomainPlanes.h"
+
+using namespace TexGen;
+
+CYarnSpatialIndex::CYarnSpatialIndex()
+: m_bBuilt(false)
+, m_dTolerance(0)
+{
+	for (int i=0; i<3; ++i)
+	{
+		m_InvCellSize[i] = 0;
+		m_iNumCells[i] = 0;
+	}
+}
+
+void CYarnSpatialIndex::Clear()
+{
+	m_bBuilt = false;
+	m_Entries.clear();
+	m_CellStart.clear();
+	m_CellEntries.clear();
+	m_Translations.clear();
+	m_YarnBuildStamps.clear();
+	m_YarnRepeats.clear();
+}
+
+bool CYarnSpatialIndex::IsValid(const vector<CYarn> &Yarns, const XYZ &Min, const XYZ &Max, double dTolerance) const
+{
+	if (!m_bBuilt || dTolerance != m_dTolerance || Yarns.size() != m_YarnBuildStamps.size())
+		return false;
+	if (Min.x < m_Min.x || Min.y < m_Min.y || Min.z < m_Min.z ||
+		Max.x > m_Max.x || Max.y > m_Max.y || Max.z > m_Max.z)
+		return false;
+	for (int i=0; i<(int)Yarns.size(); ++i)
+	{
+		if (Yarns[i].GetBuildStamp() != m_YarnBuildStamps[i] || Yarns[i].GetRepeats() != m_YarnRepeats[i])
+			return false;
+	}
+	return true;
+}
+
+void CYarnSpatialIndex::Build(const vector<CYarn> &Yarns, const XYZ &Min, const XYZ &Max, double dTolerance)
+{
+	Clear();
+	m_dTolerance = dTolerance;
+	m_Min = Min;
+	m_Max = Max;
+
+	// The translations are those which would be used for a linear search over the same box
+	CDomainPlanes Domain(Min, Max);
+	vector<pair<XYZ, XYZ> > Boxes;
+	int i, j, k, iAxis;
+	m_Translations.resize(Yarns.size());
+	for (i=0; i<(int)Yarns.size(); ++i)
+	{
+		m_YarnBuildStamps.push_back(Yarns[i].GetBuildStamp());
+		m_YarnRepeats.push_back(Yarns[i].GetRepeats());
+		m_Translations[i] = Domain.GetTranslations(Yarns[i]);
+		int iNumSegments = Yarns[i].GetNumNodes()-1;
+		for (j=0; j<(int)m_Translations[i].size(); ++j)
+		{
+			for (k=0; k<iNumSegments; ++k)
+			{
+				pair<XYZ, XYZ> AABB = Yarns[i].GetSectionAABB(k);
+				ENTRY Entry = { i, j, k };
+				m_Entries.push_back(Entry);
+				Boxes.push_back(make_pair(AABB.first + m_Translations[i][j], AABB.second + m_Translations[i][j]));
+			}
+		}
+	}
+
+	// Choose the grid resolution so that there are roughly two cells per entry
+	XYZ Size = Max - Min;
+	double dMaxSize = max(Size.x, max(Size.y, Size.z));
+	double dMinSize = dMaxSize > 0 ? dMaxSize*1e-6 : 1;
+	for (iAxis=0; iAxis<3; ++iAxis)
+		Size[iAxis] = max(Size[iAxis], dMinSize);
+	double dTargetCells = min(2.0*max((int)m_Entries.size(), 1), 4.0e6);
+	double dCellSize = pow(Size.x*Size.y*Size.z/dTargetCells, 1.0/3.0);
+	for (iAxis=0; iAxis<3; ++iAxis)
+	{
+		m_iNumCells[iAxis] = max(1, min(1024, (int)(Size[iAxis]/dCellSize)));
+		m_InvCellSize[iAxis] = m_iNumCells[iAxis]/Size[iAxis];
+	}
+
+	// Boxes are grown slightly more than the tolerance so that the grid never rejects
+	// a point which the exact bounding box tests performed on the candidates would accept
+	double dGrow = dTolerance + 1e-9*dMaxSize;
+	int iNumCells = m_iNumCells[0]*m_iNumCells[1]*m_iNumCells[2];
+	vector<int> CellRanges(6*Boxes.size());
+	m_CellStart.assign(iNumCells+1, 0);
+	for (i=0; i<(int)Boxes.size(); ++i)
+	{
+		int *Range = &CellRanges[6*i];
+		for (iAxis=0; iAxis<3; ++iAxis)
+		{
+			Range[iAxis] = GetCell(Boxes[i].first[iAxis]-dGrow, iAxis);
+			Range[iAxis+3] = GetCell(Boxes[i].second[iAxis]+dGrow, iAxis);
+		}
+		// Discard entries which lie entirely outside the grid
+		bool bOutside = false;
+		for (iAxis=0; iAxis<3; ++iAxis)
+		{
+			if (Boxes[i].second[iAxis]+dGrow < m_Min[iAxis] || Boxes[i].first[iAxis]-dGrow > m_Max[iAxis])
+				bOutside = true;
+		}
+		if (bOutside)
+		{
+			Range[0] = 0; Range[3] = -1;
+			continue;
+		}
+		for (int x=Range[0]; x<=Range[3]; ++x)
+			for (int y=Range[1]; y<=Range[4]; ++y)
+				for (int z=Range[2]; z<=Range[5]; ++z)
+					++m_CellStart[(z*m_iNumCells[1]+y)*m_iNumCells[0]+x+1];
+	}
+	for (i=0; i<iNumCells; ++i)
+		m_CellStart[i+1] += m_CellStart[i];
+
+	// Entries are added in ascending order so each cell's list is sorted
+	m_CellEntries.resize(m_CellStart[iNumCells]);
+	vector<int> Fill(m_CellStart.begin(), m_CellStart.end()-1);
+	for (i=0; i<(int)Boxes.size(); ++i)
+	{
+		const int *Range = &CellRanges[6*i];
+		for (int x=Range[0]; x<=Range[3]; ++x)
+			for (int y=Range[1]; y<=Range[4]; ++y)
+				for (int z=Range[2]; z<=Range[5]; ++z)
+					m_CellEntries[Fill[(z*m_iNumCells[1]+y)*m_iNumCells[0]+x]++] = i;
+	}
+	m_bBuilt = true;
+}
+
+int CYarnSpatialIndex::GetCell(double dValue, int iAxis) const
+{
+	int iCell = (int)floor((dValue-m_Min[iAxis])*m_InvCellSize[iAxis]);
+	if (iCell < 0)
+		return 0;
+	if (iCell >= m_iNumCells[iAxis])
+		return m_iNumCells[iAxis]-1;
+	return iCell;
+}
+
+void CYarnSpatialIndex::GetCandidates(const XYZ &Point, const int *&pBegin, const int *&pEnd) const
+{
+	if (m_CellEntries.empty())
+	{
+		pBegin = pEnd = NULL;
+		return;
+	}
+	int iCell = (GetCell(Point.z, 2)*m_iNumCells[1]+GetCell(Point.y, 1))*m_iNumCells[0]+GetCell(Point.x, 0);
+	pBegin = &m_CellEntries[0] + m_CellStart[iCell];
+	pEnd = &m_CellEntries[0] + m_CellStart[iCell+1];
+}
@@ -0,0 +1,101 @@
+/*=============================================================================
+TexGen: Geometric textile modeller.
+Copyright (C) 2006 Martin Sherburn
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+=============================================================================*/
+
+#pragma once
+
+namespace TexGen
+{
+	using namespace std;
+
+	class CYarn;
+
+	/// Uniform grid over the section bounding boxes of a set of yarns and their periodic repeats
+	/**
+	Each entry in the index refers to one segment of one repeat of a yarn (a segment being the part
+	of the yarn between two master nodes). For a given point the index returns the entries whose
+	bounding box may contain it, which avoids testing every yarn, repeat and segment in turn.
+	Entries are returned in ascending order of yarn, translation and segment so that a search
+	over the candidates visits them in the same order as a search over all of them would.
+	The index covers a box given when it is built and remains valid until one of the yarns is
+	rebuilt or has its repeats changed.
+	*/
+	class CLASS_DECLSPEC CYarnSpatialIndex
+	{
+	public:
+		/// A segment of a repeat of a yarn
+		struct ENTRY
+		{
+			int iYarn;			///< Index of the yarn
+			int iTranslation;	///< Index into the list of translations for the yarn
+			int iSegment;		///< Index of the yarn segment
+		};
+
+		CYarnSpatialIndex();
+
+		/// Remove all entries from the index
+		void Clear();
+
+		/// Build the index covering the box between Min and Max
+		/**
+		The yarn surfaces must have been built before calling this function.
+		\param Yarns The yarns to add to the index
+		\param Min Minimum corner of the box which will be queried
+		\param Max Maximum corner of the box which will be queried
+		\param dTolerance Distance by which the bounding boxes are grown, should match the tolerance used for the point queries
+		*/
+		void Build(const vector<CYarn> &Yarns, const XYZ &Min, const XYZ &Max, double dTolerance);
+
+		/// Check whether the index is up to date with the yarns and covers the box between Min and Max
+		bool IsValid(const vector<CYarn> &Yarns, const XYZ &Min, const XYZ &Max, double dTolerance) const;
+
+		/// Get the entries which may contain the point
+		/**
+		\param Point The point to query, must lie within the box the index was built for
+		\param pBegin Set to the first index into the list of entries
+		\param pEnd Set to one past the last index into the list of entries
+		*/
+		void GetCandidates(const XYZ &Point, const int *&pBegin, const int *&pEnd) const;
+
+		/// Get the entry with given index
+		const ENTRY &GetEntry(int iIndex) const { return m_Entries[iIndex]; }
+		/// Get the translations of a yarn which intersect the box the index was built for
+		const vector<XYZ> &GetTranslations(int iYarn) const { return m_Translations[iYarn]; }
+		/// Get the number of entries in the index
+		int GetNumEntries() const { return (int)m_Entries.size(); }
+
+	protected:
+		/// Get the index of the grid cell containing the point along the given axis
+		int GetCell(double dValue, int iAxis) const;
+
+		bool m_bBuilt;
+		double m_dTolerance;
+		XYZ m_Min;	///< Minimum corner of the grid
+		XYZ m_Max;	///< Maximum corner of the grid
+		double m_InvCellSize[3];	///< Inverse of the cell size along each axis
+		int m_iNumCells[3];	///< Number of cells along each axis
+
+		vector<ENTRY> m_Entries;
+		vector<int> m_CellStart;	///< Offset into m_CellEntries for each cell, with one extra value at the end
+		vector<int> m_CellEntries;	///< Entry indices for each cell stored contiguously
+		vector<vector<XYZ> > m_Translations;	///< Translations of each yarn intersecting the grid
+
+		vector<int> m_YarnBuildStamps;	///< Build stamp of each yarn when the index was created
+		vector<vector<XYZ> > m_YarnRepeats;	///< Repeat vectors of each yarn when the index was created
+	};
+};	// namespace TexGen
@@ -7,6 +7,7 @@
 #include "../Renderer/TexGenRenderer.h"
 
 #include "TextileFactory.h"
+#include <chrono>
 
 //#define SHINY_PROFILER TRUE
 
@@ -14,12 +15,80 @@ using namespace TexGen;
 
 //PROFILE_SHARED_EXTERN( ProfileTest )
 
+/// Stream buffer which only counts the characters written to it, so that formatting can be timed without the disk
+class CCountingBuffer : public streambuf
+{
+public:
+	CCountingBuffer() : m_iCount(0) {}
+	long long m_iCount;
+protected:
+	int overflow(int c) { ++m_iCount; return c; }
+	streamsize xsputn(const char *s, streamsize n) { m_iCount += n; return n; }
+};
+
+/// Write a synthetic ABAQUS deck of hex elements with nodes, orientations and element data, returning the time taken
+template <typename OUTPUT>
+double WriteSyntheticDeck(OUTPUT &Output, long long iNumElements)
+{
+	chrono::steady_clock::time_point Start = chrono::steady_clock::now();
+	int iNumX = 1000, iNumY = 1000;
+	long long i;
+	for (i = 0; i < iNumElements; ++i)
+	{
+		long long iNode = i + i/iNumX + (i/(iNumX*iNumY))*(iNumX+1) + 1;
+		Output << i+1 << ", " << iNode+1 << ", " << iNode+iNumX+2 << ", " << iNode+iNumX+1 << ", " << iNode;
+		iNode += (iNumX+1)*(iNumY+1);
+		Output << ", " << iNode+1 << ", " << iNode+iNumX+2 << ", " << iNode+iNumX+1 << ", " << iNode << "\n";
+	}
+	for (i = 0; i < iNumElements; ++i)
+	{
+		XYZ Point(0.001*(i%iNumX), 0.001*((i/iNumX)%iNumY), 0.001*(i/(iNumX*iNumY)));
+		Output << i+1 << ", " << Point << ",   " << XYZ(0.6, 0.8, 0.0) << "\n";
+		Output << i+1 << ", " << (int)(i%3)-1 << ", " << Point.x << ", " << Point.y << ", " << 1.0/(1+i%7) << ", " << -0.5*Point.z << "\n";
+	}
+	return chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+}
+
+/// Report the rate at which a synthetic deck of elements is formatted with the stream operators and with CTextWriter
+/**
+The text is counted rather than written to a file unless a filename is given
+*/
+void BenchmarkTextWriter(long long iNumElements, string Filename)
+{
+	for (int iMethod = 0; iMethod < 2; ++iMethod)
+	{
+		CCountingBuffer Counter;
+		ofstream File;
+		if (!Filename.empty())
+			File.open(Filename.c_str());
+		ostream Output(Filename.empty() ? (streambuf*)&Counter : File.rdbuf());
+		double dTime;
+		if (iMethod == 0)
+			dTime = WriteSyntheticDeck(Output, iNumElements);
+		else
+		{
+			CTextWriter Writer(Output);
+			dTime = WriteSyntheticDeck(Writer, iNumElements);
+		}
+		Output.flush();
+		double dMegaBytes = (Filename.empty() ? Counter.m_iCount : (long long)File.tellp()) / 1e6;
+		cout << (iMethod == 0 ? "ostream:     " : "CTextWriter: ") << dMegaBytes << " MB in " << dTime << " s, " << dMegaBytes/dTime << " MB/s" << endl;
+	}
+}
+
 //int _tmain(int argc, _TCHAR* argv[])
 int main( int argc, char** argv)
 {
 	//PROFILE_SHARED_DEFINE( ProfileTest)
 	//PROFILE_FUNC();
 
+	// TexGenProfile textwriter [NumElements] [Filename]
+	if ( argc > 1 && string(argv[1]) == "textwriter" )
+	{
+		BenchmarkTextWriter( argc > 2 ? atoll(argv[2]) : 100000000, argc > 3 ? argv[3] : "" );
+		return 0;
+	}
+
 	CTextileFactory TextileFactory;
 	
 	// Test voxel output for plain weave
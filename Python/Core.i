@@ -59,6 +59,7 @@ using namespace TexGen;
 #define CLASS_DECLSPEC
 %import "../Core/Singleton.h"
 %include "../Core/Plane.h"
+%include "../Core/VTKWriter.h"
 %include "../Core/MeshData.h"
 
 /*using namespace TexGen;*/
@@ -85,7 +86,6 @@ namespace std
 	%template(DoubleXYZPair) pair<double, TexGen::XYZ>;
 	%template(DoubleXYZPairVector) vector< pair<double, TexGen::XYZ> >;
 	%template(BoolPair) pair<bool, bool>;
-	%template(IntList) list<int>;
 	%template(IntVector) vector<int>;
 	//%template(ElementTypeMap) map<TexGen::CMesh::ELEMENT_TYPE, list<int> >;  // Only used in unoptimised version of MergeNodes. Causes compilation error with Swig 2
 	%template(BoolVector) vector<bool>;
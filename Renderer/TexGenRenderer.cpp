@@ -1239,11 +1239,11 @@ vtkPolyData *CTexGenRenderer::GetPolyData(const CMesh &Mesh)
 	{
 		pPoints->InsertPoint(i, itNode->x, itNode->y, itNode->z);
 	}
-	list<int>::const_iterator itIter;
+	vector<int>::const_iterator itIter;
 	int iNumNodes, iStartIndex, iEndIndex;
 	for (j = 0; j < CMesh::NUM_ELEMENT_TYPES; ++j)
 	{
-		const list<int> &Indices = Mesh.GetIndices((CMesh::ELEMENT_TYPE)j);
+		const vector<int> &Indices = Mesh.GetIndices((CMesh::ELEMENT_TYPE)j);
 		iNumNodes = CMesh::GetNumNodes((CMesh::ELEMENT_TYPE)j);
 		for (itIter = Indices.begin(); itIter != Indices.end(); )
 		{
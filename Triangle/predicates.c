@@ -10,13 +10,17 @@
 #endif /* LINUX */
 
 /* Global constants.                                                         */
+/* They are set by exactinit() at the start of every triangulation, so each  */
+/*   thread has its own copy to allow triangulating in several threads.      */
 
+THREADLOCAL
 REAL splitter;       /* Used to split REAL factors for exact multiplication. */
+THREADLOCAL
 REAL epsilon;                             /* Floating-point machine epsilon. */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
+THREADLOCAL REAL resulterrbound;
+THREADLOCAL REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
+THREADLOCAL REAL iccerrboundA, iccerrboundB, iccerrboundC;
+THREADLOCAL REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
 
 /********* Geometric primitives begin here                           *********/
@@ -209,7 +209,10 @@
 #endif
 
 /* Random number seed is not constant, but I've made it global anyway.       */
+/* Each thread has its own seed so that triangulating in several threads at  */
+/*   once gives the same meshes as triangulating one after the other.       */
 
+THREADLOCAL
 unsigned long randomseed;                     /* Current random number seed. */
 
 /* Fast lookup arrays to speed some of the mesh manipulation primitives.     */
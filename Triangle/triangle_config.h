@@ -103,6 +103,15 @@
 #define INEXACT /* Nothing */
 /* #define INEXACT volatile */
 
+/* Storage class for the globals that are set up for each triangulation, so  */
+/*   that several threads can triangulate at once.                           */
+
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL __thread
+#endif
+
 /* Maximum number of characters in a file name (including the null).         */
 
 #define FILENAMESIZE 2048
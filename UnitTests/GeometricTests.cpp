@@ -19,9 +19,36 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "GeometricTests.h"
 #include "../Core/MatrixUtils.h"
+#include <thread>
+#include <mutex>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CGeometricTests);
 
+namespace
+{
+	/// Logger which counts the number of messages it receives from each thread
+	class CLoggerThreadCount : public CLogger
+	{
+	public:
+		CLoggerThreadCount(map<thread::id, int> &Counts, mutex &CountsMutex)
+		: m_Counts(Counts), m_CountsMutex(CountsMutex) {}
+
+		CLogger *Copy() const { return new CLoggerThreadCount(*this); }
+		void TexGenError(string FileName, int iLineNumber, string Message) { Count(); }
+		void TexGenLog(string FileName, int iLineNumber, string Message) { Count(); }
+
+	protected:
+		void Count()
+		{
+			lock_guard<mutex> Lock(m_CountsMutex);
+			++m_Counts[this_thread::get_id()];
+		}
+
+		map<thread::id, int> &m_Counts;
+		mutex &m_CountsMutex;
+	};
+}
+
 void CGeometricTests::setUp()
 {
 }
@@ -90,6 +117,77 @@ void CGeometricTests::TestHybridHalfSection()
 	CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.5, Point.y, 1e-9);
 }
 
+void CGeometricTests::TestSectionPoints()
+{
+	CSectionEllipse Ellipse(2, 1);
+	CSectionPowerEllipse PowerEllipse(2, 1, 0.6);
+	CSectionRectangle Rectangle(2, 1);
+	vector<const CSection*> Sections;
+	Sections.push_back(&Ellipse);
+	Sections.push_back(&PowerEllipse);
+	Sections.push_back(&Rectangle);
+
+	// Points sampled from copies of the sections one at a time
+	vector<vector<XY> > Expected;
+	int i, j;
+	for (i=0; i<(int)Sections.size(); ++i)
+	{
+		CObjectContainer<CSection> pCopy(*Sections[i]);
+		for (j=0; j<4; ++j)
+			Expected.push_back(pCopy->GetPoints(20+10*(j/2), j%2 == 1));
+	}
+
+	// The same sections sampled by several threads at once must give the same points
+	vector<thread> Threads;
+	// Not vector<bool> as its elements share bytes and can't be written by different threads
+	vector<char> Matches(4, true);
+	for (i=0; i<4; ++i)
+	{
+		Threads.push_back(thread([&Sections, &Expected, &Matches, i]()
+		{
+			for (int iRepeat=0; iRepeat<10; ++iRepeat)
+			{
+				for (int k=0; k<(int)Expected.size(); ++k)
+				{
+					int iNumPoints = 20+10*((k%4)/2);
+					bool bEquiSpaced = k%2 == 1;
+					if (Sections[k/4]->GetPoints(iNumPoints, bEquiSpaced) != Expected[k])
+						Matches[i] = false;
+				}
+			}
+		}));
+	}
+	for (i=0; i<4; ++i)
+	{
+		Threads[i].join();
+		CPPUNIT_ASSERT(Matches[i]);
+	}
+
+	// The points are only sampled once and are shared with copies
+	shared_ptr<const vector<XY> > pPoints = Ellipse.GetSharedPoints(20, true);
+	CPPUNIT_ASSERT(&Ellipse.GetPoints(20, true) == pPoints.get());
+	CSectionEllipse Copy = Ellipse;
+	CPPUNIT_ASSERT(Copy.GetSharedPoints(20, true) == pPoints);
+
+	// Changing the section samples the points again without affecting the points already shared
+	Copy.SetWidth(4);
+	CPPUNIT_ASSERT(Copy.GetSharedPoints(20, true) != pPoints);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, Copy.GetPoints(20)[0].x, 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, (*pPoints)[0].x, 1e-9);
+
+	// Sections save whether their points are equispaced, which isn't the case when the equispaced points
+	// can't be found even if they were requested
+	TiXmlElement Element("Section");
+	Ellipse.GetPoints(20, true);
+	Ellipse.PopulateTiXmlElement(Element, OUTPUT_FULL);
+	CPPUNIT_ASSERT(valueify<bool>(Element.Attribute("EquiSpaced")));
+	CSectionEllipse Point(0, 0);
+	Point.GetPoints(20, true);
+	TiXmlElement PointElement("Section");
+	Point.PopulateTiXmlElement(PointElement, OUTPUT_FULL);
+	CPPUNIT_ASSERT(!valueify<bool>(PointElement.Attribute("EquiSpaced")));
+}
+
 void CGeometricTests::TestPointInsideYarn()
 {
 	// Build a single yarn of diameter 1, going from (0,0,0) to (1,0,0)
@@ -137,6 +235,263 @@ void CGeometricTests::TestPointInsideYarn()
 	}
 }
 
+void CGeometricTests::TestPointInformation()
+{
+	// Check that the point information found using the textile's spatial index agrees
+	// with testing each of the yarns individually
+	CTextileWeave2D Textile = m_TextileFactory.SatinWeave();
+	const CDomain &Domain = *Textile.GetDomain();
+	pair<XYZ, XYZ> DomainSize = Domain.GetMesh().GetAABB();
+	int i, j, k, iYarn;
+	int iGridSize = 12;
+	vector<XYZ> Points;
+	XYZ Point;
+	for (i=0; i<iGridSize; ++i)
+	{
+		for (j=0; j<iGridSize; ++j)
+		{
+			for (k=0; k<iGridSize; ++k)
+			{
+				Point.x = (i+0.5)/iGridSize;
+				Point.y = (j+0.5)/iGridSize;
+				Point.z = (k+0.5)/iGridSize;
+
+				Point *= DomainSize.second - DomainSize.first;
+				Point += DomainSize.first;
+				Points.push_back(Point);
+			}
+		}
+	}
+	vector<POINT_INFO> PointsInfo;
+	Textile.GetPointInformation(Points, PointsInfo);
+	CPPUNIT_ASSERT_EQUAL(Points.size(), PointsInfo.size());
+
+	vector<vector<XYZ> > Translations;
+	for (iYarn=0; iYarn<Textile.GetNumYarns(); ++iYarn)
+		Translations.push_back(Domain.GetTranslations(*Textile.GetYarn(iYarn)));
+	int iNumInside = 0;
+	for (i=0; i<(int)Points.size(); ++i)
+	{
+		bool bInside = false;
+		for (iYarn=0; iYarn<Textile.GetNumYarns(); ++iYarn)
+		{
+			if (Textile.GetYarn(iYarn)->PointInsideYarn(Points[i], Translations[iYarn]))
+				bInside = true;
+		}
+		CPPUNIT_ASSERT_EQUAL(bInside, PointsInfo[i].iYarnIndex != -1);
+		if (bInside)
+		{
+			CPPUNIT_ASSERT(Textile.GetYarn(PointsInfo[i].iYarnIndex)->PointInsideYarn(Points[i], Translations[PointsInfo[i].iYarnIndex]));
+			++iNumInside;
+		}
+	}
+	CPPUNIT_ASSERT(iNumInside > 0);
+
+	// Classifying the same points as rows of a structured grid must give the same yarns
+	vector<POINT_INFO> GridInfo;
+	Textile.GetGridPointInformation(Points, GridInfo, iGridSize);
+	CPPUNIT_ASSERT_EQUAL(Points.size(), GridInfo.size());
+	for (i=0; i<(int)Points.size(); ++i)
+	{
+		CPPUNIT_ASSERT_EQUAL(PointsInfo[i].iYarnIndex, GridInfo[i].iYarnIndex);
+	}
+}
+
+void CGeometricTests::TestParallelLogging()
+{
+	// Yarns built and points classified on the worker threads only log through the calling
+	// thread, and the same number of messages are logged whatever the number of threads
+	int iNumThreads[2] = {1, 4};
+	map<thread::id, int> Counts[2];
+	mutex CountsMutex;
+	int i, j, k, l;
+	for (i=0; i<2; ++i)
+	{
+		TEXGEN.SetNumThreads(iNumThreads[i]);
+		TEXGEN.SetLogger(CLoggerThreadCount(Counts[i], CountsMutex));
+		CTextileWeave2D Textile = m_TextileFactory.SatinWeave();
+		pair<XYZ, XYZ> DomainSize = Textile.GetDomain()->GetMesh().GetAABB();
+		int iGridSize = 8;
+		vector<XYZ> Points;
+		for (j=0; j<iGridSize; ++j)
+		{
+			for (k=0; k<iGridSize; ++k)
+			{
+				for (l=0; l<iGridSize; ++l)
+				{
+					XYZ Point((j+0.5)/iGridSize, (k+0.5)/iGridSize, (l+0.5)/iGridSize);
+					Point *= DomainSize.second - DomainSize.first;
+					Points.push_back(Point + DomainSize.first);
+				}
+			}
+		}
+		vector<POINT_INFO> PointsInfo;
+		Textile.GetPointInformation(Points, PointsInfo);
+		TEXGEN.SetLogger(CLoggerScreen());
+	}
+	TEXGEN.SetNumThreads(0);
+
+	for (i=0; i<2; ++i)
+	{
+		CPPUNIT_ASSERT_EQUAL(1, (int)Counts[i].size());
+		CPPUNIT_ASSERT(Counts[i].begin()->first == this_thread::get_id());
+	}
+	CPPUNIT_ASSERT(Counts[0].begin()->second > 0);
+	CPPUNIT_ASSERT_EQUAL(Counts[0].begin()->second, Counts[1].begin()->second);
+}
+
+void CGeometricTests::TestSectionCache()
+{
+	// Yarn with a section varying between the nodes
+	CYarn Yarn = m_TextileFactory.VaryingSectionYarn();
+
+	CYarn CachedYarn = Yarn;
+	CachedYarn.SetSectionCache(20);
+	CPPUNIT_ASSERT(CachedYarn.GetAABB().second.x > 0);
+	CPPUNIT_ASSERT(CachedYarn.GetSectionCacheMemory() > 0);
+
+	// Points classified using the cached sections should agree apart from very close to the surface
+	int i, j, k;
+	int iNumInside = 0, iNumDifferent = 0;
+	for (i=0; i<50; ++i)
+	{
+		for (j=0; j<20; ++j)
+		{
+			for (k=0; k<20; ++k)
+			{
+				XYZ Point(i*0.2+0.1, j*0.1-1, k*0.1-0.5);
+				bool bInside = Yarn.PointInsideYarn(Point);
+				if (bInside)
+					++iNumInside;
+				if (bInside != CachedYarn.PointInsideYarn(Point))
+					++iNumDifferent;
+			}
+		}
+	}
+	CPPUNIT_ASSERT(iNumInside > 0);
+	CPPUNIT_ASSERT(iNumDifferent <= iNumInside/100);
+
+	// The cache must respect the memory limit
+	CachedYarn.SetSectionCache(1000, 64);
+	CachedYarn.PointInsideYarn(XYZ(5, 0, 1));
+	CPPUNIT_ASSERT(CachedYarn.GetSectionCacheMemory() <= 64*1024);
+}
+
+void CGeometricTests::TestQueryContext()
+{
+	// One yarn with a constant section and one with a cached varying section
+	CTextile Textile = m_TextileFactory.GetSingleYarn(100, 40);
+	const CYarn &ConstantYarn = *Textile.GetYarns().begin();
+	vector<XYZ> Translations = Textile.GetDomain()->GetTranslations(ConstantYarn);
+	CYarn VaryingYarn = m_TextileFactory.VaryingSectionYarn();
+	VaryingYarn.SetSectionCache(20);
+
+	// The results must be the same with or without the context, after the first pass
+	// the buffers of the context are big enough so the second pass mustn't allocate
+	CYarnQueryContext Context;
+	int iPass, i, j, k;
+	int iNumInside = 0;
+	for (iPass=0; iPass<2; ++iPass)
+	{
+		int iNumAllocations = Context.GetNumAllocations();
+		for (i=0; i<20; ++i)
+		{
+			for (j=0; j<10; ++j)
+			{
+				for (k=0; k<10; ++k)
+				{
+					XYZ Point(i*0.05, j*0.1-0.45, k*0.1-0.45);
+					XYZ Tangent, ContextTangent, Orientation, ContextOrientation;
+					XY Loc, ContextLoc;
+					double dDistance = 0, dContextDistance = 0;
+					bool bInside = ConstantYarn.PointInsideYarn(Point, Translations, &Tangent, &Loc, NULL, &dDistance, 1e-9, &Orientation);
+					CPPUNIT_ASSERT_EQUAL(bInside, ConstantYarn.PointInsideYarn(Point, Translations, &ContextTangent, &ContextLoc, NULL, &dContextDistance, 1e-9, &ContextOrientation, NULL, false, &Context));
+					if (bInside)
+					{
+						++iNumInside;
+						CPPUNIT_ASSERT(Tangent == ContextTangent && Orientation == ContextOrientation);
+						CPPUNIT_ASSERT_EQUAL(dDistance, dContextDistance);
+					}
+					Point = XYZ(i*0.5+0.1, j*0.2-1, k*0.1-0.5);
+					bInside = VaryingYarn.PointInsideYarn(Point, &Tangent, &Loc, NULL, &dDistance);
+					CPPUNIT_ASSERT_EQUAL(bInside, VaryingYarn.PointInsideYarn(Point, &ContextTangent, &ContextLoc, NULL, &dContextDistance, 1e-9, NULL, NULL, false, &Context));
+					if (bInside)
+					{
+						++iNumInside;
+						CPPUNIT_ASSERT(Tangent == ContextTangent);
+						CPPUNIT_ASSERT_EQUAL(dDistance, dContextDistance);
+					}
+				}
+			}
+		}
+		if (iPass == 0)
+			CPPUNIT_ASSERT(Context.GetNumAllocations() > 0);
+		else
+			CPPUNIT_ASSERT_EQUAL(iNumAllocations, Context.GetNumAllocations());
+	}
+	CPPUNIT_ASSERT(iNumInside > 0);
+
+	// The section meshes are created for each query when the orientation of a varying section is needed
+	int iNumAllocations = Context.GetNumAllocations();
+	XYZ Orientation;
+	CPPUNIT_ASSERT(VaryingYarn.PointInsideYarn(XYZ(5, 0, 1), NULL, NULL, NULL, NULL, 1e-9, &Orientation, NULL, false, &Context));
+	CPPUNIT_ASSERT(Context.GetNumAllocations() > iNumAllocations);
+	CPPUNIT_ASSERT(Orientation.x > 0.9);
+}
+
+void CGeometricTests::TestOrientationCache()
+{
+	// Yarn with a varying section, the section meshes must have the same elements to be interpolated
+	CYarn Yarn = m_TextileFactory.VaryingSectionYarn(0.75);
+	Yarn.SetSectionCache(20);
+
+	const double dTolerance = 0.01;
+	CYarn CachedYarn = Yarn;
+	CachedYarn.SetOrientationCache(dTolerance);
+	XYZ Orientation;
+	CPPUNIT_ASSERT(CachedYarn.PointInsideYarn(XYZ(5, 0, 1), NULL, NULL, NULL, NULL, 1e-9, &Orientation));
+	CPPUNIT_ASSERT(CachedYarn.GetOrientationCacheMemory() > 0);
+
+	// The interpolated orientations should be within the tolerance of the exact ones apart from very
+	// close to the edges of the elements. Once the context has grown memory is only allocated for the few
+	// points outside the interpolated section mesh, which fall back to the exact orientation
+	CYarnQueryContext Context;
+	int iPass, i, j, k;
+	int iNumInside = 0, iNumDifferent = 0;
+	for (iPass=0; iPass<2; ++iPass)
+	{
+		int iNumAllocations = Context.GetNumAllocations();
+		for (i=0; i<50; ++i)
+		{
+			for (j=0; j<20; ++j)
+			{
+				for (k=0; k<20; ++k)
+				{
+					XYZ Point(i*0.2+0.1, j*0.1-1, k*0.1-0.5);
+					XYZ CachedOrientation;
+					bool bInside = Yarn.PointInsideYarn(Point, NULL, NULL, NULL, NULL, 1e-9, &Orientation);
+					CPPUNIT_ASSERT_EQUAL(bInside, CachedYarn.PointInsideYarn(Point, NULL, NULL, NULL, NULL, 1e-9, &CachedOrientation, NULL, false, &Context));
+					if (bInside && iPass == 0)
+					{
+						++iNumInside;
+						if (acos(min(1.0, DotProduct(Orientation, CachedOrientation))) > dTolerance)
+							++iNumDifferent;
+					}
+				}
+			}
+		}
+		if (iPass == 1)
+			CPPUNIT_ASSERT(Context.GetNumAllocations() - iNumAllocations <= iNumInside/100);
+	}
+	CPPUNIT_ASSERT(iNumInside > 0);
+	CPPUNIT_ASSERT(iNumDifferent <= iNumInside/100);
+
+	// The cache is removed when disabled
+	CachedYarn.SetOrientationCache(0);
+	CachedYarn.PointInsideYarn(XYZ(5, 0, 1), NULL, NULL, NULL, NULL, 1e-9, &Orientation);
+	CPPUNIT_ASSERT_EQUAL((size_t)0, CachedYarn.GetOrientationCacheMemory());
+}
+
 double CGeometricTests::GetDistanceFromEdge(XYZ Point)
 {
 	while (Point.y>0.5)
@@ -301,9 +656,91 @@ void CGeometricTests::TestRotateYarn()
 	}
 }
 
+void CGeometricTests::TestIncrementalBuild()
+{
+	CYarn Yarn;
+	int i;
+	for (i=0; i<7; ++i)
+		Yarn.AddNode(CNode(XYZ(i, 0, 0.2*(i%2))));
+	Yarn.AssignInterpolation(CInterpolationBezier());
+	Yarn.AssignSection(CYarnSectionConstant(CSectionEllipse(0.8, 0.2)));
+	Yarn.SetResolution(70, 20);
+	Yarn.SetIncrementalBuild(true);
+	vector<CSlaveNode> SlaveNodes = Yarn.GetSlaveNodes(CYarn::SURFACE);
+
+	// Moving the middle node only changes the segments next to its neighbours
+	Yarn.ReplaceNode(3, CNode(XYZ(3, 0.5, 1)));
+	const vector<CSlaveNode> &NewSlaveNodes = Yarn.GetSlaveNodes(CYarn::SURFACE);
+	CPPUNIT_ASSERT_EQUAL(SlaveNodes.size(), NewSlaveNodes.size());
+
+	const vector<CNode> &MasterNodes = Yarn.GetMasterNodes();
+	shared_ptr<const CInterpolationData> pData = Yarn.GetInterpolation()->CreateData(MasterNodes);
+	for (i=0; i<(int)NewSlaveNodes.size(); ++i)
+	{
+		int iIndex = NewSlaveNodes[i].GetIndex();
+		if (iIndex == 0 || iIndex == 5)
+		{
+			CPPUNIT_ASSERT(NewSlaveNodes[i].GetPosition() == SlaveNodes[i].GetPosition());
+			continue;
+		}
+		CSlaveNode Expected = Yarn.GetInterpolation()->GetNode(MasterNodes, *pData, iIndex, NewSlaveNodes[i].GetT());
+		CPPUNIT_ASSERT(GetLength(Expected.GetPosition(), NewSlaveNodes[i].GetPosition()) < 1e-9);
+		CPPUNIT_ASSERT_EQUAL(SlaveNodes[i].GetSectionPoints().size(), NewSlaveNodes[i].GetSectionPoints().size());
+	}
+	CPPUNIT_ASSERT(Yarn.PointInsideYarn(XYZ(3, 0.5, 1)));
+	CPPUNIT_ASSERT(!Yarn.PointInsideYarn(XYZ(3, 0, 0)));
+	CPPUNIT_ASSERT(Yarn.GetAABB().second.z > 1);
+}
 
-
-
-
-
-
+void CGeometricTests::TestDetectInterference()
+{
+	// Three yarns, the first two cross and overlap and the third is well away from both
+	CTextile Textile;
+	CYarn Yarn;
+	Yarn.AddNode(CNode(XYZ(0, 0, 0)));
+	Yarn.AddNode(CNode(XYZ(4, 0, 0)));
+	Yarn.AssignSection(CYarnSectionConstant(CSectionEllipse(1, 0.5)));
+	Yarn.SetResolution(20, 20);
+	Textile.AddYarn(Yarn);
+	Yarn.ReplaceNode(0, CNode(XYZ(2, -2, 0.2)));
+	Yarn.ReplaceNode(1, CNode(XYZ(2, 2, 0.2)));
+	Textile.AddYarn(Yarn);
+	Yarn.ReplaceNode(0, CNode(XYZ(0, 0, 5)));
+	Yarn.ReplaceNode(1, CNode(XYZ(4, 0, 5)));
+	Textile.AddYarn(Yarn);
+
+	vector<float> DistanceToSurface;
+	vector<int> YarnIndices;
+	CMesh InterferingPoints;
+	int iIntersections = Textile.DetectInterference(DistanceToSurface, YarnIndices, false, &InterferingPoints);
+
+	// Check every section point against every other yarn
+	vector<XYZ> Expected;
+	vector<int> ExpectedIndices;
+	for (int i = 0; i < Textile.GetNumYarns(); ++i)
+	{
+		const vector<CSlaveNode> &SlaveNodes = Textile.GetYarn(i)->GetSlaveNodes(CYarn::SURFACE);
+		for (int j = 0; j < Textile.GetNumYarns(); ++j)
+		{
+			if (i == j)
+				continue;
+			for (size_t k = 0; k < SlaveNodes.size(); ++k)
+			{
+				const vector<XYZ> &Points = SlaveNodes[k].GetSectionPoints();
+				for (size_t l = 0; l < Points.size(); ++l)
+				{
+					if (Textile.GetYarn(j)->PointInsideYarn(Points[l]))
+					{
+						Expected.push_back(Points[l]);
+						ExpectedIndices.push_back(i);
+					}
+				}
+			}
+		}
+	}
+	CPPUNIT_ASSERT(iIntersections > 0);
+	CPPUNIT_ASSERT_EQUAL((int)Expected.size(), iIntersections);
+	CPPUNIT_ASSERT(ExpectedIndices == YarnIndices);
+	CPPUNIT_ASSERT(Expected == InterferingPoints.GetNodes());
+	CPPUNIT_ASSERT(find(YarnIndices.begin(), YarnIndices.end(), 2) == YarnIndices.end());
+}
@@ -28,15 +28,23 @@ class CGeometricTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(CGeometricTests);
 	CPPUNIT_TEST(TestPointInsideYarn);
+	CPPUNIT_TEST(TestPointInformation);
+	CPPUNIT_TEST(TestParallelLogging);
+	CPPUNIT_TEST(TestSectionCache);
+	CPPUNIT_TEST(TestQueryContext);
+	CPPUNIT_TEST(TestOrientationCache);
 	CPPUNIT_TEST(TestLenticularSection);
 	CPPUNIT_TEST(TestHybridQuarterSection);
 	CPPUNIT_TEST(TestHybridHalfSection);
+	CPPUNIT_TEST(TestSectionPoints);
 	CPPUNIT_TEST(TestQuaternionRotation);
 	CPPUNIT_TEST(TestConvertRotation);
 	CPPUNIT_TEST(TestGetClosestPointFunctions);
 	CPPUNIT_TEST(Test3DGetClosestPointFunctions);
 	CPPUNIT_TEST(TestFindClosestSurfacePoint);
 	CPPUNIT_TEST(TestRotateYarn);
+	CPPUNIT_TEST(TestIncrementalBuild);
+	CPPUNIT_TEST(TestDetectInterference);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -45,9 +53,15 @@ public:
 
 protected:
 	void TestPointInsideYarn();
+	void TestPointInformation();
+	void TestParallelLogging();
+	void TestSectionCache();
+	void TestQueryContext();
+	void TestOrientationCache();
 	void TestLenticularSection();
 	void TestHybridQuarterSection();
 	void TestHybridHalfSection();
+	void TestSectionPoints();
 	void TestQuaternionRotation();
 	void TestConvertRotation();
 
@@ -58,6 +72,8 @@ protected:
 	void TestFindClosestSurfacePoint();
 
 	void TestRotateYarn();
+	void TestIncrementalBuild();
+	void TestDetectInterference();
 
 	CTextileFactory m_TextileFactory;
 };
@@ -47,6 +47,59 @@ void CMesherTests::TestSimpleMesh()
 	CPPUNIT_ASSERT(CompareFiles("vmesh.inp","..\\..\\UnitTests\\vmesh.inp"));
 }
 
+void CMesherTests::TestBinaryVTK()
+{
+	CMesh Mesh;
+	Mesh.AddNode(XYZ(0, 0, 0));
+	Mesh.AddNode(XYZ(1, 0, 0));
+	Mesh.AddNode(XYZ(0, 1, 0));
+	Mesh.AddNode(XYZ(0, 0, 1));
+	Mesh.AddNode(XYZ(1, 1, 1));
+	int Indices[] = {0, 1, 2, 3};
+	Mesh.AddElement(CMesh::TET, vector<int>(Indices, Indices+4));
+	Mesh.AddElement(CMesh::TRI, vector<int>(Indices+1, Indices+4));
+	CMeshData<XYZ> Vectors("Vectors", CMeshDataBase::ELEMENT);
+	Vectors.m_Data.push_back(XYZ(1, 2, 3));
+	Vectors.m_Data.push_back(XYZ(4, 5, 6));
+	vector<CMeshDataBase*> MeshData;
+	MeshData.push_back(&Vectors);
+
+	// Appended raw data follows the underscore, each array is preceded by its size in bytes
+	CPPUNIT_ASSERT(Mesh.SaveToVTK("binary.vtu", &MeshData, VTK_APPENDED_RAW));
+	ifstream Input("binary.vtu", ios::binary);
+	stringstream Contents;
+	Contents << Input.rdbuf();
+	string File = Contents.str();
+	CPPUNIT_ASSERT(File.find("header_type=\"UInt64\"") != string::npos);
+	size_t iStart = File.find("<AppendedData encoding=\"raw\">");
+	CPPUNIT_ASSERT(iStart != string::npos);
+	iStart = File.find('_', iStart) + 1;
+	unsigned long long iNumBytes;
+	memcpy(&iNumBytes, File.data() + iStart, sizeof(iNumBytes));
+	CPPUNIT_ASSERT_EQUAL(5*3*sizeof(double), (size_t)iNumBytes);
+	double Point[3];
+	memcpy(Point, File.data() + iStart + sizeof(iNumBytes) + 4*3*sizeof(double), sizeof(Point));
+	CPPUNIT_ASSERT(XYZ(Point[0], Point[1], Point[2]) == XYZ(1, 1, 1));
+
+	// The connectivity follows the points, with the elements in the order of their types
+	iStart += sizeof(iNumBytes) + iNumBytes;
+	memcpy(&iNumBytes, File.data() + iStart, sizeof(iNumBytes));
+	CPPUNIT_ASSERT_EQUAL(7*sizeof(int), (size_t)iNumBytes);
+	int Connectivity[7];
+	memcpy(Connectivity, File.data() + iStart + sizeof(iNumBytes), sizeof(Connectivity));
+	CPPUNIT_ASSERT_EQUAL(1, Connectivity[0]);
+	CPPUNIT_ASSERT_EQUAL(3, Connectivity[6]);
+	CPPUNIT_ASSERT(File.find("</AppendedData>\n</VTKFile>") != string::npos);
+
+	// Base64 encoding of the same arrays
+	CPPUNIT_ASSERT(Mesh.SaveToVTK("binary64.vtu", &MeshData, VTK_BASE64));
+	ifstream Input64("binary64.vtu");
+	stringstream Contents64;
+	Contents64 << Input64.rdbuf();
+	// The header and the values are encoded together, the 56 bytes being padded to a multiple of 3
+	CPPUNIT_ASSERT(Contents64.str().find("Name=\"Vectors\">MAAAAAAAAAAAAAAAAADwPwAAAAAAAABAAAAAAAAACEAAAAAAAAAQQAAAAAAAABRAAAAAAAAAGEA=</DataArray>") != string::npos);
+}
+
 void CMesherTests::TestInvertedElements()
 {
 	CTextileWeave2D Textile = m_TextileFactory.PlainWeave();
@@ -28,6 +28,7 @@ class CMesherTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(CMesherTests);
 	CPPUNIT_TEST(TestSimpleMesh);
+	CPPUNIT_TEST(TestBinaryVTK);
 //	CPPUNIT_TEST(TestInvertedElements);
 //	CPPUNIT_TEST(TestMatchingFaces);
 	CPPUNIT_TEST_SUITE_END();
@@ -38,6 +39,7 @@ public:
 
 protected:
 	void TestSimpleMesh();
+	void TestBinaryVTK();
 	void TestInvertedElements();
 //	void TestMatchingFaces();
 
@@ -18,6 +18,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 =============================================================================*/
 
 #include "MiscFunctionTests.h"
+#include "../Core/TexGen.h"
+#include "../Core/Parallel.h"
+#include <stdexcept>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CMiscFunctionTests);
 
@@ -43,4 +46,318 @@ void CMiscFunctionTests::TestWriteValues()
 	WriteValues( Output, Values, 3 );
     
 	CPPUNIT_ASSERT( CheckStr.str() == Output.str() );
-}
\ No newline at end of file
+}
+
+void CMiscFunctionTests::TestTextWriter()
+{
+	vector<double> Doubles;
+	Doubles.push_back(0.0);
+	Doubles.push_back(-0.0);
+	Doubles.push_back(1.0);
+	Doubles.push_back(-0.1);
+	Doubles.push_back(1.0/3.0);
+	Doubles.push_back(123456.5);
+	Doubles.push_back(1234567.0);
+	Doubles.push_back(1e-5);
+	Doubles.push_back(-2.5e-300);
+	Doubles.push_back(6.02214076e23);
+	for ( int i = 0; i < 1000; ++i )
+		Doubles.push_back( RandomNumber(-1000.0, 1000.0) * pow(10.0, i%13 - 6) );
+
+	// Text must be identical to writing to the stream directly with each of its formats
+	for ( int iFormat = 0; iFormat < 3; ++iFormat )
+	{
+		ostringstream Expected, Output;
+		if ( iFormat == 1 )
+		{
+			Expected << setprecision(12);
+			Output << setprecision(12);
+		}
+		else if ( iFormat == 2 )
+		{
+			Expected << scientific;
+			Output << scientific;
+		}
+		{
+			CTextWriter Writer(Output);
+			for ( size_t i = 0; i < Doubles.size(); ++i )
+			{
+				Expected << i << ", " << -(int)i << ", " << Doubles[i] << ", " << XYZ(Doubles[i], 1.5, -2) << '\n';
+				Writer << i << ", " << -(int)i << ", " << Doubles[i] << ", " << XYZ(Doubles[i], 1.5, -2) << '\n';
+			}
+			Expected << INT_MIN << " " << INT_MAX << " " << LLONG_MIN << " " << ULLONG_MAX << "\n";
+			Writer << INT_MIN << " " << INT_MAX << " " << LLONG_MIN << " " << ULLONG_MAX << "\n";
+			vector<int> Values(100, 7);
+			WriteValues( Expected, Values, 16 );
+			WriteValues( Writer, Values, 16 );
+		}
+		CPPUNIT_ASSERT_EQUAL( Expected.str(), Output.str() );
+	}
+
+	// Shortest round trip values read back exactly
+	ostringstream Output;
+	{
+		CTextWriter Writer(Output);
+		Writer.SetShortestRoundTrip(true);
+		for ( size_t i = 0; i < Doubles.size(); ++i )
+			Writer << Doubles[i] << "\n";
+	}
+	istringstream Input(Output.str());
+	for ( size_t i = 0; i < Doubles.size(); ++i )
+	{
+		double dValue;
+		Input >> dValue;
+		CPPUNIT_ASSERT( dValue == Doubles[i] );
+	}
+}
+
+void CMiscFunctionTests::TestMeshRemoveElements()
+{
+	CMesh Mesh;
+	int i;
+	for ( i = 0; i < 8; ++i )
+	{
+		Mesh.AddNode(XYZ(i, 0, 0));
+	}
+	// Three quads, the middle one is removed
+	vector<int> &Indices = Mesh.GetIndices(CMesh::QUAD);
+	for ( i = 0; i < 12; ++i )
+	{
+		Indices.push_back(i % 8);
+	}
+	vector<bool> Removed(3, false);
+	Removed[1] = true;
+	Mesh.RemoveElements(CMesh::QUAD, Removed);
+
+	CPPUNIT_ASSERT_EQUAL(8, (int)Indices.size());
+	int Expected[] = { 0, 1, 2, 3, 0, 1, 2, 3 };
+	for ( i = 0; i < 8; ++i )
+	{
+		CPPUNIT_ASSERT_EQUAL(Expected[i], Indices[i]);
+	}
+
+	// Splitting a quad keeps the remaining quads in order
+	vector<int>::iterator itQuad = Mesh.ConvertQuadtoTriangles(Indices.begin());
+	CPPUNIT_ASSERT(itQuad == Indices.begin());
+	CPPUNIT_ASSERT_EQUAL(4, (int)Indices.size());
+	CPPUNIT_ASSERT_EQUAL(6, (int)Mesh.GetIndices(CMesh::TRI).size());
+	CPPUNIT_ASSERT_EQUAL(3, Mesh.GetIndices(CMesh::TRI)[5]);
+}
+
+void CMiscFunctionTests::TestMeshNodePairs()
+{
+	CMesh Mesh;
+	Mesh.BuildGrid(XYZ(0, 0, 0), XYZ(2, 1, 1), 5, 4, 3);
+	// Copies of the first node, one just outside the tolerance and one within it
+	Mesh.AddNode(XYZ(0, 0, 2e-6));
+	Mesh.AddNode(XYZ(0, 0, 5e-7));
+
+	vector<pair<int, int> > NodePairs;
+	Mesh.GetNodePairs(XYZ(2, 0, 0), NodePairs);
+	// One pair for each node on the x = 0 face and the copy within the tolerance
+	CPPUNIT_ASSERT_EQUAL(13, (int)NodePairs.size());
+	vector<pair<int, int> >::iterator itPair;
+	for (itPair = NodePairs.begin(); itPair != NodePairs.end(); ++itPair)
+	{
+		CPPUNIT_ASSERT(GetLength(Mesh.GetNode(itPair->first) + XYZ(2, 0, 0), Mesh.GetNode(itPair->second)) < 1e-6);
+	}
+	// Node 48 at (2, 0, 0) matches nodes 0 and 61. Nodes after 48 are preferred when searching from
+	// the node itself, otherwise the lowest index is used.
+	NodePairs.clear();
+	Mesh.GetNodePairs(XYZ(-2, 0, 0), NodePairs);
+	CPPUNIT_ASSERT(NodePairs[0] == make_pair(48, 61));
+	CPPUNIT_ASSERT(Mesh.GetNodePairs(XYZ(-2, 0, 0))[0] == make_pair(48, 0));
+
+	CPPUNIT_ASSERT(Mesh.GetNodePairs(XYZ(3, 0, 0)).empty());
+}
+
+void CMiscFunctionTests::TestMeshClosestNode()
+{
+	CMesh Mesh;
+	Mesh.BuildGrid(XYZ(0, 0, 0), XYZ(2, 1, 1), 5, 4, 3);
+	// Copy of the first node, ties go to the lowest index
+	Mesh.AddNode(XYZ(0, 0, 0));
+
+	CPPUNIT_ASSERT_EQUAL(0, Mesh.GetClosestNode(XYZ(-0.1, 0, 0)));
+	CPPUNIT_ASSERT_EQUAL(48, Mesh.GetClosestNode(XYZ(2.1, -0.1, 0)));
+	CPPUNIT_ASSERT(!Mesh.HasNodeIndex());
+
+	vector<XYZ> Positions;
+	Positions.push_back(XYZ(-0.1, 0, 0));
+	Positions.push_back(XYZ(2.1, -0.1, 0));
+	Positions.push_back(XYZ(0, 0, 0.01));
+	vector<int> Closest = Mesh.GetClosestNodes(Positions);
+	CPPUNIT_ASSERT(Mesh.HasNodeIndex());
+	CPPUNIT_ASSERT_EQUAL(0, Closest[0]);
+	CPPUNIT_ASSERT_EQUAL(48, Closest[1]);
+	CPPUNIT_ASSERT_EQUAL(0, Closest[2]);
+	// The tolerance is compared with the squared distance
+	Closest = Mesh.GetClosestNodesDistance(Positions, 1e-3);
+	CPPUNIT_ASSERT_EQUAL(-1, Closest[1]);
+	CPPUNIT_ASSERT_EQUAL(0, Closest[2]);
+	CPPUNIT_ASSERT_EQUAL(-1, Mesh.GetClosestNodeDistance(XYZ(0, 0, 0.01), 1e-6));
+	CPPUNIT_ASSERT_EQUAL(0, Mesh.GetClosestNodeDistance(XYZ(0, 0, 0.01), 1e-3));
+
+	vector<int> InRadius = Mesh.GetNodesInRadius(XYZ(0, 0, 0), 0.1);
+	CPPUNIT_ASSERT_EQUAL(2, (int)InRadius.size());
+	CPPUNIT_ASSERT_EQUAL(0, InRadius[0]);
+	CPPUNIT_ASSERT_EQUAL(60, InRadius[1]);
+
+	// Appended nodes are found without discarding the index
+	Mesh.AddNode(XYZ(5, 5, 5));
+	CPPUNIT_ASSERT(Mesh.HasNodeIndex());
+	CPPUNIT_ASSERT_EQUAL(61, Mesh.GetClosestNode(XYZ(4, 4, 4)));
+
+	Mesh.SetNode(0, XYZ(-1, 0, 0));
+	CPPUNIT_ASSERT(!Mesh.HasNodeIndex());
+	CPPUNIT_ASSERT_EQUAL(60, Mesh.GetClosestNode(XYZ(0, 0, 0)));
+}
+
+void CMiscFunctionTests::TestMeshIntersectLine()
+{
+	CMesh Mesh;
+	Mesh.BuildGrid(XYZ(0, 0, 0), XYZ(2, 1, 1), 5, 4, 3);
+	Mesh.ConvertToSurfaceMesh();
+	Mesh.ConvertQuadstoTriangles();
+	CTriangleBVH BVH;
+	BVH.Build(Mesh);
+	CPPUNIT_ASSERT_EQUAL(Mesh.GetNumElements(CMesh::TRI), BVH.GetNumTriangles());
+
+	vector<pair<XYZ, XYZ> > Lines;
+	// Through a face, along an edge shared by two triangles and through a node
+	Lines.push_back(make_pair(XYZ(0.3, 0.3, -1), XYZ(0.3, 0.3, 2)));
+	Lines.push_back(make_pair(XYZ(0.25, 0.25, -1), XYZ(0.75, 0.75, 2)));
+	Lines.push_back(make_pair(XYZ(-1, 0.5, 0.5), XYZ(0, 0.5, 0.5)));
+	Lines.push_back(make_pair(XYZ(3, 3, 3), XYZ(4, 4, 4)));
+	vector<vector<pair<double, XYZ> > > BatchPoints;
+	Mesh.IntersectLines(Lines, BatchPoints, make_pair(true, false));
+	CPPUNIT_ASSERT_EQUAL((int)Lines.size(), (int)BatchPoints.size());
+
+	int i, j;
+	for (i = 0; i < (int)Lines.size(); ++i)
+	{
+		vector<pair<double, XYZ> > Points, BVHPoints;
+		Mesh.IntersectLine(Lines[i].first, Lines[i].second, Points, make_pair(true, false));
+		Mesh.IntersectLine(Lines[i].first, Lines[i].second, BVHPoints, make_pair(true, false), false, &BVH);
+		CPPUNIT_ASSERT_EQUAL(Points.size(), BVHPoints.size());
+		CPPUNIT_ASSERT_EQUAL(Points.size(), BatchPoints[i].size());
+		for (j = 0; j < (int)Points.size(); ++j)
+		{
+			CPPUNIT_ASSERT_EQUAL(Points[j].first, BVHPoints[j].first);
+			CPPUNIT_ASSERT_EQUAL(Points[j].first, BatchPoints[i][j].first);
+		}
+	}
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0/3.0, BatchPoints[0][0].first, 1e-9);
+	CPPUNIT_ASSERT(BatchPoints[3].empty());
+}
+
+void CMiscFunctionTests::TestMeshRemoveDuplicates()
+{
+	CMesh Mesh;
+	Mesh.SetNumNodes(5);
+	int Triangles[] = {0, 1, 2,  1, 0, 2,  2, 0, 1,  2, 1, 0,  0, 1, 2,  1, 2, 3};
+	Mesh.GetIndices(CMesh::TRI).assign(Triangles, Triangles+18);
+	CMesh Opposing = Mesh;
+	// The first two triangles cancel out, as do the third and the fourth
+	Opposing.RemoveOpposingTriangles();
+	CPPUNIT_ASSERT_EQUAL(2, Opposing.GetNumElements(CMesh::TRI));
+	CPPUNIT_ASSERT_EQUAL(0, Opposing.GetIndices(CMesh::TRI)[0]);
+	CPPUNIT_ASSERT_EQUAL(3, Opposing.GetIndices(CMesh::TRI)[5]);
+
+	CMesh Duplicates = Mesh;
+	Duplicates.RemoveDuplicateTriangles();
+	CPPUNIT_ASSERT_EQUAL(5, Duplicates.GetNumElements(CMesh::TRI));
+	Duplicates = Mesh;
+	Duplicates.RemoveDuplicateElements(CMesh::TRI);
+	CPPUNIT_ASSERT_EQUAL(2, Duplicates.GetNumElements(CMesh::TRI));
+
+	// Two hex elements sharing a face leave ten quads on the surface
+	CMesh Grid;
+	Grid.BuildGrid(XYZ(0, 0, 0), XYZ(2, 1, 1), 3, 2, 2);
+	Grid.ConvertToSurfaceMesh();
+	CPPUNIT_ASSERT_EQUAL(10, Grid.GetNumElements(CMesh::QUAD));
+
+	int Segments[] = {0, 1,  2, 3,  1, 0,  0, 1};
+	Mesh.GetIndices(CMesh::LINE).assign(Segments, Segments+8);
+	Mesh.RemoveDuplicateSegments();
+	CPPUNIT_ASSERT_EQUAL(2, Mesh.GetNumElements(CMesh::LINE));
+	CPPUNIT_ASSERT_EQUAL(2, Mesh.GetIndices(CMesh::LINE)[0]);
+}
+
+void CMiscFunctionTests::TestInterpolationData()
+{
+	vector<CNode> MasterNodes;
+	MasterNodes.push_back(CNode(XYZ(0, 0, 0)));
+	MasterNodes.push_back(CNode(XYZ(1, 0, 0.2)));
+	MasterNodes.push_back(CNode(XYZ(2, 0.5, 0)));
+	MasterNodes.push_back(CNode(XYZ(3, 0.5, -0.1)));
+
+	CInterpolationCubic Cubic(false);
+	CInterpolationBezier Bezier(false);
+	CInterpolationLinear Linear(false);
+	CInterpolationAdjusted Adjusted(Cubic);
+	Adjusted.AddAdjustment(1, 0.5, XYZ(0, 0, 0.1));
+	Adjusted.AddAdjustment(2, 0.5, XYZ(0, 0, 0));
+	const CInterpolation *Interpolations[] = {&Cubic, &Bezier, &Linear, &Adjusted};
+	for (int i = 0; i < 4; ++i)
+	{
+		// Nodes obtained with data held outside the interpolation match those it stores itself
+		shared_ptr<const CInterpolationData> pData = Interpolations[i]->CreateData(MasterNodes);
+		Interpolations[i]->Initialise(MasterNodes);
+		for (int j = 0; j < 3; ++j)
+		{
+			CSlaveNode Node = Interpolations[i]->GetNode(MasterNodes, *pData, j, 0.3);
+			CSlaveNode Expected = Interpolations[i]->GetNode(MasterNodes, j, 0.3);
+			CPPUNIT_ASSERT(Node.GetPosition() == Expected.GetPosition());
+			CPPUNIT_ASSERT(Node.GetTangent() == Expected.GetTangent());
+		}
+	}
+	CSlaveNode Node = Adjusted.GetNode(MasterNodes, 1, 0.5);
+	CSlaveNode Unadjusted = Cubic.GetNode(MasterNodes, 1, 0.5);
+	CPPUNIT_ASSERT(Node.GetPosition() == Unadjusted.GetPosition() + XYZ(0, 0, 0.1));
+
+	// A copy of a built yarn shares its interpolation data, moving a node rebuilds it
+	CYarn Yarn;
+	for (int i = 0; i < 4; ++i)
+		Yarn.AddNode(MasterNodes[i]);
+	Yarn.AssignInterpolation(Cubic);
+	Yarn.AssignSection(CYarnSectionConstant(CSectionEllipse(0.4, 0.2)));
+	Yarn.SetResolution(10);
+	XYZ Point(1, 0, 0.2);
+	CPPUNIT_ASSERT(Yarn.PointInsideYarn(Point));
+	CYarn Copy = Yarn;
+	CPPUNIT_ASSERT(Copy.PointInsideYarn(Point));
+	Copy.SetNodes(vector<CNode>(1, CNode(XYZ(0, 2, 0))));
+	Copy.AddNode(CNode(XYZ(3, 2, 0)));
+	CPPUNIT_ASSERT(!Copy.PointInsideYarn(Point));
+	CPPUNIT_ASSERT(Copy.PointInsideYarn(XYZ(1.5, 2, 0)));
+	CPPUNIT_ASSERT(Yarn.PointInsideYarn(Point));
+}
+
+void CMiscFunctionTests::TestParallelFor()
+{
+	// Every task is run exactly once
+	vector<int> Counts(100, 0);
+	ParallelFor((int)Counts.size(), [&Counts](int i) { ++Counts[i]; }, 4);
+	CPPUNIT_ASSERT(Counts == vector<int>(Counts.size(), 1));
+
+	// An exception thrown by a task reaches the caller after all the threads have finished
+	int iNumThreads;
+	for (iNumThreads = 1; iNumThreads <= 4; iNumThreads += 3)
+	{
+		bool bCaught = false;
+		try
+		{
+			ParallelFor(100, [](int i)
+			{
+				if (i == 50)
+					throw runtime_error("Task failed");
+			}, iNumThreads);
+		}
+		catch (const runtime_error &)
+		{
+			bCaught = true;
+		}
+		CPPUNIT_ASSERT(bCaught);
+	}
+}
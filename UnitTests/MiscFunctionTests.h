@@ -31,6 +31,14 @@ class CMiscFunctionTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(CMiscFunctionTests);
 	CPPUNIT_TEST(TestWriteValues);
+	CPPUNIT_TEST(TestTextWriter);
+	CPPUNIT_TEST(TestMeshRemoveElements);
+	CPPUNIT_TEST(TestMeshNodePairs);
+	CPPUNIT_TEST(TestMeshClosestNode);
+	CPPUNIT_TEST(TestMeshIntersectLine);
+	CPPUNIT_TEST(TestMeshRemoveDuplicates);
+	CPPUNIT_TEST(TestInterpolationData);
+	CPPUNIT_TEST(TestParallelFor);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -39,4 +47,12 @@ public:
 
 protected:
 	void TestWriteValues();
+	void TestTextWriter();
+	void TestMeshRemoveElements();
+	void TestMeshNodePairs();
+	void TestMeshClosestNode();
+	void TestMeshIntersectLine();
+	void TestMeshRemoveDuplicates();
+	void TestInterpolationData();
+	void TestParallelFor();
 };
@@ -46,6 +46,82 @@ void CSolverTests::TestGeometrySolver()
 	Solver.SaveToVTK("GeomSolve");
 }
 
+void CSolverTests::TestIterativeSolver()
+{
+	CTextileWeave2D Weave = m_TextileFactory.SatinWeave();
+	CGeometrySolver DirectSolver, IterativeSolver;
+	DirectSolver.SetSeed(0.5);
+	IterativeSolver.SetSeed(0.5);
+	IterativeSolver.SetLinearSolver(CGeometrySolver::SOLVER_ITERATIVE);
+	CPPUNIT_ASSERT(DirectSolver.CreateSystem(Weave));
+	CPPUNIT_ASSERT(IterativeSolver.CreateSystem(Weave));
+	int iIterations = DirectSolver.SolveSystem();
+	CPPUNIT_ASSERT(iIterations != 0);
+	CPPUNIT_ASSERT_EQUAL(iIterations, IterativeSolver.SolveSystem());
+	CPPUNIT_ASSERT_EQUAL(0, DirectSolver.GetSolverStatistics().iNumSolves);
+
+	// Every contact iteration should have been solved iteratively, starting from the previous solution
+	const CGeometrySolver::SOLVER_STATISTICS &Statistics = IterativeSolver.GetSolverStatistics();
+	CPPUNIT_ASSERT_EQUAL(iIterations, Statistics.iNumSolves);
+	CPPUNIT_ASSERT_EQUAL(0, Statistics.iNumFallbacks);
+	CPPUNIT_ASSERT(Statistics.iTotalIterations > 0);
+	CPPUNIT_ASSERT(Statistics.dLastResidual < 1e-10);
+
+	CTextile* pDirect = DirectSolver.GetDeformedCopyOfTextile();
+	CTextile* pIterative = IterativeSolver.GetDeformedCopyOfTextile();
+	CPPUNIT_ASSERT(pDirect && pIterative);
+	CPPUNIT_ASSERT_EQUAL(pDirect->GetNumYarns(), pIterative->GetNumYarns());
+	int i, j;
+	for (i=0; i<pDirect->GetNumYarns(); ++i)
+	{
+		const vector<CNode> &DirectNodes = pDirect->GetYarn(i)->GetMasterNodes();
+		const vector<CNode> &IterativeNodes = pIterative->GetYarn(i)->GetMasterNodes();
+		CPPUNIT_ASSERT_EQUAL(DirectNodes.size(), IterativeNodes.size());
+		for (j=0; j<(int)DirectNodes.size(); ++j)
+		{
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(0, GetLength(DirectNodes[j].GetPosition(), IterativeNodes[j].GetPosition()), 1e-3);
+		}
+	}
+}
+
+void CSolverTests::TestDirectSolver()
+{
+	// Sum and maximum of the slave node displacements of each yarn found before the matrix pattern was
+	// reused between iterations, when the system was assembled from scratch and solved with cs_lusol
+	double dExpectedSums[] = { 16.43118208, 17.32507618, 7.923591916, 7.841380078, 8.507802392, 7.140334933 };
+	double dExpectedMaxima[] = { 0.422084812, 0.3909664548, 0.3053616221, 0.2799002809, 0.3104982923, 0.2882364661 };
+	CTextileWeave2D Weave = m_TextileFactory.SatinWeave();
+	// Partial pivoting is used by default, threshold pivoting preferring the diagonal must agree closely
+	double dPivotTolerances[] = { 1.0, 1e-3 };
+	int i, j, k;
+	for (k=0; k<2; ++k)
+	{
+		CGeometrySolver Solver;
+		Solver.SetSeed(0.5);
+		Solver.SetPivotTolerance(dPivotTolerances[k]);
+		CPPUNIT_ASSERT(Solver.CreateSystem(Weave));
+		CPPUNIT_ASSERT_EQUAL(4, Solver.SolveSystem());
+		CTextile* pDeformed = Solver.GetDeformedCopyOfTextile();
+		CPPUNIT_ASSERT(pDeformed);
+		CPPUNIT_ASSERT_EQUAL(6, pDeformed->GetNumYarns());
+		for (i=0; i<pDeformed->GetNumYarns(); ++i)
+		{
+			const vector<CSlaveNode> &DeformedNodes = pDeformed->GetYarn(i)->GetSlaveNodes(CYarn::LINE);
+			const vector<CSlaveNode> &Nodes = Weave.GetYarn(i)->GetSlaveNodes(CYarn::LINE);
+			CPPUNIT_ASSERT_EQUAL(Nodes.size(), DeformedNodes.size());
+			double dSum = 0, dMax = 0;
+			for (j=0; j<(int)Nodes.size(); ++j)
+			{
+				XYZ Displacement = DeformedNodes[j].GetPosition() - Nodes[j].GetPosition();
+				dSum += Displacement.z;
+				dMax = max(dMax, GetLength(Displacement));
+			}
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(dExpectedSums[i], dSum, 1e-6);
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(dExpectedMaxima[i], dMax, 1e-6);
+		}
+	}
+}
+
 void CSolverTests::TestFineGridSolve()
 {
 	CGeometrySolver Solver;
@@ -30,6 +30,8 @@ class CSolverTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(TestPlateElementArea);
 	CPPUNIT_TEST(TestPlateElement);
 	CPPUNIT_TEST(TestGeometrySolver);
+	CPPUNIT_TEST(TestIterativeSolver);
+	CPPUNIT_TEST(TestDirectSolver);
 //	CPPUNIT_TEST(TestFineGridSolve);
 	CPPUNIT_TEST_SUITE_END();
 
@@ -39,6 +41,8 @@ public:
 
 protected:
 	void TestGeometrySolver();
+	void TestIterativeSolver();
+	void TestDirectSolver();
 	void TestFineGridSolve();
 	void TestPlateElement();
 	void TestPlateElementArea();
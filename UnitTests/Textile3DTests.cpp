@@ -18,6 +18,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 =============================================================================*/
 
 #include "Textile3DTests.h"
+#include <thread>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CTextile3DTests);
 
@@ -41,3 +42,55 @@ void CTextile3DTests::TestGetXYarnIndex()
 	CPPUNIT_ASSERT( Weave->GetXYarnIndex(6) == -1 );
 }
 
+void CTextile3DTests::TestParallelBuild()
+{
+	CTextileLayerToLayer Serial = m_TextileFactory.LayerToLayerWeave();
+	CTextileLayerToLayer Parallel = m_TextileFactory.LayerToLayerWeave();
+	CTextileLayerToLayer Lazy = m_TextileFactory.LayerToLayerWeave();
+
+	CPPUNIT_ASSERT(Serial.BuildYarns(CYarn::VOLUME, 1));
+	CPPUNIT_ASSERT(Parallel.BuildYarns(CYarn::VOLUME, 4));
+	CPPUNIT_ASSERT(SameYarns(Serial, Parallel));
+
+	// Yarns built on demand by several threads querying them at once
+	const CTextile &LazyTextile = Lazy;
+	vector<thread> Threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		Threads.push_back(thread([&LazyTextile]()
+		{
+			for (int j = 0; j < LazyTextile.GetNumYarns(); ++j)
+			{
+				LazyTextile.GetYarn(j)->PointInsideYarn(XYZ(0.5, 0.5, 0.5));
+				LazyTextile.GetYarn(j)->GetSlaveNodes(CYarn::VOLUME);
+			}
+		}));
+	}
+	for (int i = 0; i < 4; ++i)
+		Threads[i].join();
+	CPPUNIT_ASSERT(SameYarns(Serial, Lazy));
+}
+
+bool CTextile3DTests::SameYarns(const CTextile &Textile1, const CTextile &Textile2)
+{
+	if (Textile1.GetNumYarns() != Textile2.GetNumYarns())
+		return false;
+	for (int i = 0; i < Textile1.GetNumYarns(); ++i)
+	{
+		const vector<CSlaveNode> &SlaveNodes1 = Textile1.GetYarn(i)->GetSlaveNodes(CYarn::VOLUME);
+		const vector<CSlaveNode> &SlaveNodes2 = Textile2.GetYarn(i)->GetSlaveNodes(CYarn::VOLUME);
+		if (SlaveNodes1.size() != SlaveNodes2.size())
+			return false;
+		for (size_t j = 0; j < SlaveNodes1.size(); ++j)
+		{
+			if (SlaveNodes1[j].GetSectionPoints() != SlaveNodes2[j].GetSectionPoints())
+				return false;
+			if (SlaveNodes1[j].GetSectionMesh().GetNodes() != SlaveNodes2[j].GetSectionMesh().GetNodes())
+				return false;
+			if (SlaveNodes1[j].GetSectionMesh().GetIndices(CMesh::TRI) != SlaveNodes2[j].GetSectionMesh().GetIndices(CMesh::TRI) ||
+				SlaveNodes1[j].GetSectionMesh().GetIndices(CMesh::QUAD) != SlaveNodes2[j].GetSectionMesh().GetIndices(CMesh::QUAD))
+				return false;
+		}
+	}
+	return true;
+}
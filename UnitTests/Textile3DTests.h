@@ -28,6 +28,7 @@ class CTextile3DTests : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE(CTextile3DTests);
 	CPPUNIT_TEST(TestGetXYarnIndex);
+	CPPUNIT_TEST(TestParallelBuild);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -36,6 +37,9 @@ public:
 
 protected:
 	void TestGetXYarnIndex();
+	void TestParallelBuild();
+
+	bool SameYarns(const CTextile &Textile1, const CTextile &Textile2);
 
 	CTextileFactory m_TextileFactory;
 };
\ No newline at end of file
@@ -288,6 +288,21 @@ CTextile CTextileFactory::GetSingleYarn(int iNumMasterNodes, int iResolution)
 	return Textile;
 }
 
+CYarn CTextileFactory::VaryingSectionYarn(double dMiddleHeight)
+{
+	CYarn Yarn;
+	Yarn.AddNode(CNode(XYZ(0, 0, 0)));
+	Yarn.AddNode(CNode(XYZ(5, 0, 1)));
+	Yarn.AddNode(CNode(XYZ(10, 0, 0)));
+	CYarnSectionInterpNode Section;
+	Section.AddSection(CSectionEllipse(2, 1));
+	Section.AddSection(CSectionEllipse(1.5, dMiddleHeight));
+	Section.AddSection(CSectionEllipse(2, 1));
+	Yarn.AssignSection(Section);
+	Yarn.SetResolution(20, 40);
+	return Yarn;
+}
+
 CTextileWeave2D CTextileFactory::MeshedWeave()
 {
 	CTextileWeave2D Textile(2, 2, 2, 1, false);
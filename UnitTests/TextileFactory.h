@@ -50,6 +50,9 @@ public:
 
 	CTextile GetSingleYarn(int iNumMasterNodes, int iResolution);
 
+	// Curved yarn with an elliptical section which is narrower at the middle node
+	CYarn VaryingSectionYarn(double dMiddleHeight = 0.5);
+
 	// Plain weave with rectangular mesh assigned
 	CTextileWeave2D MeshedWeave();
 
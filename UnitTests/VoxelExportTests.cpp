@@ -19,6 +19,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "VoxelExportTests.h"
 #include "TestUtilities.h"
+#include <thread>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CVoxelExportTests);
 
@@ -64,4 +65,145 @@ void CVoxelExportTests::TestOctreeExport()
 	Vox.SaveVoxelMesh(Textile,"OctreeVoxelMeshTest", 1,1,1,5, 6, true, 10, 0.3, 0.3, false );
 	// Compare to template file
 	CPPUNIT_ASSERT(CompareFiles("OctreeVoxelMeshTest.inp","..\\..\\UnitTests\\OctreeVoxelMeshTest.inp"));
-}
\ No newline at end of file
+}
+
+void CVoxelExportTests::TestOctreeOnDemandExport()
+{
+	// Classifying all the points of the finest grid beforehand or only those needed must give the same mesh
+	// Each export is given its own textile so that both start from the same state
+	CTextileWeave2D DenseTextile = m_TextileFactory.SatinWeave();
+	COctreeVoxelMesh DenseVox("CPeriodicBoundaries");
+	DenseVox.SetOnDemandClassification(false);
+	DenseVox.SaveVoxelMesh(DenseTextile,"OctreeDenseTest", 2,2,1,1, 4, false, 0, 0, 0, false );
+	CTextileWeave2D OnDemandTextile = m_TextileFactory.SatinWeave();
+	COctreeVoxelMesh OnDemandVox("CPeriodicBoundaries");
+	OnDemandVox.SetOnDemandClassification(true);
+	OnDemandVox.SaveVoxelMesh(OnDemandTextile,"OctreeOnDemandTest", 2,2,1,1, 4, false, 0, 0, 0, false );
+
+	CPPUNIT_ASSERT(CompareFiles("OctreeDenseTest.ori","OctreeOnDemandTest.ori"));
+	CPPUNIT_ASSERT(CompareFiles("OctreeDenseTest.eld","OctreeOnDemandTest.eld"));
+}
+
+void CVoxelExportTests::TestOctreeConcurrentExport()
+{
+	// Octree meshes keep all their state in the object so several can be created at the same time
+	CTextileWeave2D SerialTextile = m_TextileFactory.SatinWeave();
+	COctreeVoxelMesh SerialVox("CPeriodicBoundaries");
+	SerialVox.SaveVoxelMesh(SerialTextile,"OctreeSerialTest", 2,2,1,1, 4, false, 0, 0, 0, false );
+
+	CTextileWeave2D Textile0 = m_TextileFactory.SatinWeave();
+	CTextileWeave2D Textile1 = m_TextileFactory.SatinWeave();
+	COctreeVoxelMesh Vox0("CPeriodicBoundaries");
+	COctreeVoxelMesh Vox1("CPeriodicBoundaries");
+	thread Thread0([&]() { Vox0.SaveVoxelMesh(Textile0,"OctreeConcurrentTest0", 2,2,1,1, 4, false, 0, 0, 0, false ); });
+	thread Thread1([&]() { Vox1.SaveVoxelMesh(Textile1,"OctreeConcurrentTest1", 2,2,1,1, 4, false, 0, 0, 0, false ); });
+	Thread0.join();
+	Thread1.join();
+
+	CPPUNIT_ASSERT(CompareFiles("OctreeSerialTest.ori","OctreeConcurrentTest0.ori"));
+	CPPUNIT_ASSERT(CompareFiles("OctreeSerialTest.eld","OctreeConcurrentTest0.eld"));
+	CPPUNIT_ASSERT(CompareFiles("OctreeSerialTest.ori","OctreeConcurrentTest1.ori"));
+	CPPUNIT_ASSERT(CompareFiles("OctreeSerialTest.eld","OctreeConcurrentTest1.eld"));
+}
+
+void CVoxelExportTests::TestParallelExport()
+{
+	CTextileWeave2D Textile = m_TextileFactory.SatinWeave();
+
+	CRectangularVoxelMesh Vox("CPeriodicBoundaries");
+	// Classify voxels serially and then with several threads, results must be identical
+	TEXGEN.SetNumThreads(1);
+	Vox.SaveVoxelMesh(Textile,"VoxelSerialTest",20,20,10,true,true, MATERIAL_CONTINUUM );
+	TEXGEN.SetNumThreads(4);
+	Vox.SaveVoxelMesh(Textile,"VoxelParallelTest",20,20,10,true,true, MATERIAL_CONTINUUM );
+	TEXGEN.SetNumThreads(0);
+
+	CPPUNIT_ASSERT(CompareFiles("VoxelSerialTest.ori","VoxelParallelTest.ori"));
+	CPPUNIT_ASSERT(CompareFiles("VoxelSerialTest.eld","VoxelParallelTest.eld"));
+
+	// Enough voxels in each layer for the elements and element data to be formatted in several blocks,
+	// saved with the same name both times since the .inp file refers to the .ori file
+	const char* Extensions[] = { ".inp", ".ori", ".eld" };
+	string SerialFiles[3];
+	TEXGEN.SetNumThreads(1);
+	Vox.SaveVoxelMesh(Textile,"VoxelBlocksTest",150,150,2,true,true, MATERIAL_CONTINUUM );
+	for (int i = 0; i < 3; ++i)
+	{
+		ifstream Input((string("VoxelBlocksTest") + Extensions[i]).c_str());
+		stringstream Contents;
+		Contents << Input.rdbuf();
+		SerialFiles[i] = Contents.str();
+	}
+	TEXGEN.SetNumThreads(4);
+	Vox.SaveVoxelMesh(Textile,"VoxelBlocksTest",150,150,2,true,true, MATERIAL_CONTINUUM );
+	TEXGEN.SetNumThreads(0);
+	for (int i = 0; i < 3; ++i)
+	{
+		ifstream Input((string("VoxelBlocksTest") + Extensions[i]).c_str());
+		stringstream Contents;
+		Contents << Input.rdbuf();
+		CPPUNIT_ASSERT(!SerialFiles[i].empty());
+		CPPUNIT_ASSERT(SerialFiles[i] == Contents.str());
+	}
+}
+
+void CVoxelExportTests::TestYarnOnlyExport()
+{
+	CTextileWeave2D Textile = m_TextileFactory.SatinWeave();
+
+	CRectangularVoxelMesh Vox("CPeriodicBoundaries");
+	Vox.SaveVoxelMesh(Textile,"VoxelAllTest",20,20,10,true,true, MATERIAL_CONTINUUM );
+	Vox.SaveVoxelMesh(Textile,"VoxelYarnTest",20,20,10,false,true, MATERIAL_CONTINUUM );
+
+	// Elements are written a layer at a time so check that the yarn elements are renumbered
+	// consistently with the yarn element data of the full export
+	ifstream AllData("VoxelAllTest.eld");
+	ifstream YarnData("VoxelYarnTest.eld");
+	CPPUNIT_ASSERT(AllData && YarnData);
+	string AllLine, YarnLine;
+	int iYarnElement = 0;
+	while (getline(AllData, AllLine))
+	{
+		if (AllLine.empty() || AllLine[0] == '*')
+			continue;
+		string Data = AllLine.substr(AllLine.find(','));
+		if (Data.compare(0, 4, ", -1") == 0)
+			continue;
+		do
+		{
+			CPPUNIT_ASSERT(getline(YarnData, YarnLine));
+		} while (YarnLine.empty() || YarnLine[0] == '*');
+		stringstream Expected;
+		Expected << ++iYarnElement << Data;
+		CPPUNIT_ASSERT_EQUAL(Expected.str(), YarnLine);
+	}
+	CPPUNIT_ASSERT(iYarnElement > 0);
+	CPPUNIT_ASSERT(!getline(YarnData, YarnLine));
+}
+
+void CVoxelExportTests::TestImageDataExport()
+{
+	CTextile Textile = m_TextileFactory.GetSingleYarn(3, 20);
+	CRectangularVoxelMesh Vox("CPeriodicBoundaries");
+	Vox.SaveVoxelMesh(Textile,"VoxelImageDataTest",10,10,10,true,true, MATERIAL_CONTINUUM, 0, VTI_EXPORT );
+
+	ifstream Input("VoxelImageDataTest.vti", ios::binary);
+	CPPUNIT_ASSERT(Input);
+	string Contents((istreambuf_iterator<char>(Input)), istreambuf_iterator<char>());
+	CPPUNIT_ASSERT(Contents.find("WholeExtent=\"0 10 0 10 0 10\"") != string::npos);
+	CPPUNIT_ASSERT(Contents.find("Name=\"YarnIndex\"") != string::npos);
+	CPPUNIT_ASSERT(Contents.find("Name=\"SurfaceDistance\"") != string::npos);
+
+	// The yarn indices are the first block of appended data, one value for each voxel
+	size_t iStart = Contents.find("<AppendedData encoding=\"raw\">");
+	CPPUNIT_ASSERT(iStart != string::npos);
+	iStart = Contents.find('_', iStart) + 1;
+	uint64_t iNumBytes;
+	memcpy(&iNumBytes, Contents.data() + iStart, sizeof(iNumBytes));
+	CPPUNIT_ASSERT_EQUAL((uint64_t)(1000*sizeof(int)), iNumBytes);
+	vector<int> YarnIndices(1000);
+	memcpy(&YarnIndices[0], Contents.data() + iStart + sizeof(iNumBytes), iNumBytes);
+	int iNumYarnVoxels = (int)count(YarnIndices.begin(), YarnIndices.end(), 0);
+	CPPUNIT_ASSERT(iNumYarnVoxels > 0 && iNumYarnVoxels < 1000);
+	CPPUNIT_ASSERT_EQUAL(1000, iNumYarnVoxels + (int)count(YarnIndices.begin(), YarnIndices.end(), -1));
+}
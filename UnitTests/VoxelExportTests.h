@@ -30,6 +30,11 @@ class CVoxelExportTests : public CppUnit::TestFixture
 	CPPUNIT_TEST(TestContinuumExport);
 	CPPUNIT_TEST(TestRotatedExport);
 	CPPUNIT_TEST(TestOctreeExport);
+	CPPUNIT_TEST(TestOctreeOnDemandExport);
+	CPPUNIT_TEST(TestOctreeConcurrentExport);
+	CPPUNIT_TEST(TestParallelExport);
+	CPPUNIT_TEST(TestYarnOnlyExport);
+	CPPUNIT_TEST(TestImageDataExport);
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -40,6 +45,11 @@ protected:
 	void TestContinuumExport();
 	void TestRotatedExport();
 	void TestOctreeExport();
+	void TestOctreeOnDemandExport();
+	void TestOctreeConcurrentExport();
+	void TestParallelExport();
+	void TestYarnOnlyExport();
+	void TestImageDataExport();
 
 	CTextileFactory m_TextileFactory;
 };
\ No newline at end of file